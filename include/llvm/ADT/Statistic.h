@@ -21,13 +21,20 @@
 //
 // NOTE: Statistics *must* be declared as global variables.
 //
+// With -stats-per-function, updates made while a StatisticScope is active are
+// also attributed to that scope; the pass managers open one for each function
+// they run passes on.  -stats-json prints everything as JSON instead of text.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef LLVM_ADT_STATISTIC_H
 #define LLVM_ADT_STATISTIC_H
 
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Support/Atomic.h"
+#include "llvm/Support/Compiler.h"
 #include "llvm/Support/Valgrind.h"
+#include <string>
 
 namespace llvm {
 class raw_ostream;
@@ -35,17 +42,23 @@ class raw_ostream;
 class Statistic {
 public:
   const char *Name;
+  const char *VarName;
   const char *Desc;
   volatile llvm::sys::cas_flag Value;
   bool Initialized;
 
+  /// ScopesEnabled - True if updates should also be attributed to the active
+  /// StatisticScope (-stats-per-function).
+  static bool ScopesEnabled;
+
   llvm::sys::cas_flag getValue() const { return Value; }
   const char *getName() const { return Name; }
+  const char *getVarName() const { return VarName; }
   const char *getDesc() const { return Desc; }
 
   /// construct - This should only be called for non-global statistics.
   void construct(const char *name, const char *desc) {
-    Name = name; Desc = desc;
+    Name = name; VarName = ""; Desc = desc;
     Value = 0; Initialized = 0;
   }
 
@@ -58,44 +71,41 @@ public:
     return init();
   }
 
+  // The updates below are atomic, and the postfix forms return the value
+  // the atomic operation replaced, so they are safe to use from several
+  // threads at once.
   const Statistic &operator++() {
-    // FIXME: This function and all those that follow carefully use an
-    // atomic operation to update the value safely in the presence of
-    // concurrent accesses, but not to read the return value, so the
-    // return value is not thread safe.
     sys::AtomicIncrement(&Value);
-    return init();
+    return noteChange(1);
   }
 
   unsigned operator++(int) {
-    init();
-    unsigned OldValue = Value;
-    sys::AtomicIncrement(&Value);
+    unsigned OldValue = sys::AtomicIncrement(&Value) - 1;
+    noteChange(1);
     return OldValue;
   }
 
   const Statistic &operator--() {
     sys::AtomicDecrement(&Value);
-    return init();
+    return noteChange(-1);
   }
 
   unsigned operator--(int) {
-    init();
-    unsigned OldValue = Value;
-    sys::AtomicDecrement(&Value);
+    unsigned OldValue = sys::AtomicDecrement(&Value) + 1;
+    noteChange(-1);
     return OldValue;
   }
 
   const Statistic &operator+=(const unsigned &V) {
     if (!V) return *this;
     sys::AtomicAdd(&Value, V);
-    return init();
+    return noteChange(V);
   }
 
   const Statistic &operator-=(const unsigned &V) {
     if (!V) return *this;
     sys::AtomicAdd(&Value, -V);
-    return init();
+    return noteChange(-(int64_t)V);
   }
 
   const Statistic &operator*=(const unsigned &V) {
@@ -156,13 +166,42 @@ protected:
     TsanHappensAfter(this);
     return *this;
   }
+
+  /// noteChange - Register the statistic and, with -stats-per-function,
+  /// attribute the change to the active StatisticScope.
+  Statistic &noteChange(int64_t Delta) {
+    if (ScopesEnabled)
+      addToCurrentScope(Delta);
+    return init();
+  }
+
   void RegisterStatistic();
+  void addToCurrentScope(int64_t Delta);
 };
 
 // STATISTIC - A macro to make definition of statistics really simple.  This
 // automatically passes the DEBUG_TYPE of the file into the statistic.
 #define STATISTIC(VARNAME, DESC) \
-  static llvm::Statistic VARNAME = { DEBUG_TYPE, DESC, 0, 0 }
+  static llvm::Statistic VARNAME = { DEBUG_TYPE, #VARNAME, DESC, 0, 0 }
+
+/// \brief While alive, attributes statistic updates made on the current
+/// thread to \p Name, usually the name of the function being processed.
+/// Scopes nest; updates go to the innermost one.  Nothing is recorded unless
+/// -stats-per-function is enabled.
+class StatisticScope {
+  std::string Name;
+  const StatisticScope *Parent;
+  bool Active;
+
+  StatisticScope(const StatisticScope &) LLVM_DELETED_FUNCTION;
+  void operator=(const StatisticScope &) LLVM_DELETED_FUNCTION;
+
+public:
+  explicit StatisticScope(StringRef Name);
+  ~StatisticScope();
+
+  StringRef getName() const { return Name; }
+};
 
 /// \brief Enable the collection and printing of statistics.
 void EnableStatistics();
@@ -170,12 +209,24 @@ void EnableStatistics();
 /// \brief Check if statistics are enabled.
 bool AreStatisticsEnabled();
 
+/// \brief Also attribute statistic updates to the active StatisticScope, as
+/// -stats-per-function does.
+void EnableScopedStatistics();
+
 /// \brief Print statistics to the file returned by CreateInfoOutputFile().
 void PrintStatistics();
 
 /// \brief Print statistics to the given output stream.
 void PrintStatistics(raw_ostream &OS);
 
+/// \brief Print statistics to the given output stream as a JSON object with
+/// the totals under "statistics" and the per-scope values under "functions".
+/// Statistics are keyed as "<DEBUG_TYPE>.<variable name>".
+void PrintStatisticsJSON(raw_ostream &OS);
+
+/// \brief Forget all statistics and per-scope values collected so far.
+void ResetStatistics();
+
 } // End llvm namespace
 
 #endif
@@ -48,14 +48,27 @@ public:
   unsigned getKeyLength() const { return StrLen; }
 };
 
+/// StringMapBucket - One slot in the hash table of a StringMap.  The full hash
+/// value of the key is kept next to the entry pointer, so probing only has to
+/// load the entry (and compare strings) when the hash values match.
+///
+/// On 64-bit hosts alignment pads a bucket to 16 bytes, where the old split
+/// pointer and hash arrays needed 12; on 32-bit hosts both layouts use 8.
+struct StringMapBucket {
+  /// Item - The entry in this bucket: null for an empty bucket, or
+  /// StringMapImpl::getTombstoneVal() for a removed one.
+  StringMapEntryBase *Item;
+  /// FullHashValue - StringMapImpl::hash() of the key of Item.
+  unsigned FullHashValue;
+};
+
 /// StringMapImpl - This is the base class of StringMap that is shared among
 /// all of its instantiations.
 class StringMapImpl {
 protected:
-  // Array of NumBuckets pointers to entries, null pointers are holes.
-  // TheTable[NumBuckets] contains a sentinel value for easy iteration. Followed
-  // by an array of the actual hash values as unsigned integers.
-  StringMapEntryBase **TheTable;
+  // Array of NumBuckets buckets, null items are holes.  TheTable[NumBuckets]
+  // contains a sentinel value for easy iteration.
+  StringMapBucket *TheTable;
   unsigned NumBuckets;
   unsigned NumItems;
   unsigned NumTombstones;
@@ -76,12 +89,16 @@ protected:
   /// specified bucket will be non-null.  Otherwise, it will be null.  In either
   /// case, the FullHashValue field of the bucket will be set to the hash value
   /// of the string.
-  unsigned LookupBucketFor(StringRef Key);
+  unsigned LookupBucketFor(StringRef Key) {
+    return LookupBucketFor(Key, hash(Key));
+  }
+  unsigned LookupBucketFor(StringRef Key, unsigned FullHashValue);
 
   /// FindKey - Look up the bucket that contains the specified key. If it exists
   /// in the map, return the bucket number of the key.  Otherwise return -1.
   /// This does not modify the map.
-  int FindKey(StringRef Key) const;
+  int FindKey(StringRef Key) const { return FindKey(Key, hash(Key)); }
+  int FindKey(StringRef Key, unsigned FullHashValue) const;
 
   /// RemoveKey - Remove the specified StringMapEntry from the table, but do not
   /// delete it.  This aborts if the value isn't in the table.
@@ -97,6 +114,11 @@ public:
     return (StringMapEntryBase*)-1;
   }
 
+  /// hash - Return the hash value StringMap uses for Key.  Clients that look
+  /// up the same string several times, possibly in different maps, can
+  /// compute it once and pass it to the prehashed lookup methods.
+  static unsigned hash(StringRef Key);
+
   unsigned getNumBuckets() const { return NumBuckets; }
   unsigned getNumItems() const { return NumItems; }
 
@@ -281,13 +303,22 @@ public:
   }
 
   iterator find(StringRef Key) {
-    int Bucket = FindKey(Key);
+    return find(Key, hash(Key));
+  }
+
+  const_iterator find(StringRef Key) const {
+    return find(Key, hash(Key));
+  }
+
+  /// find - Look up Key, whose hash() is FullHashValue.
+  iterator find(StringRef Key, unsigned FullHashValue) {
+    int Bucket = FindKey(Key, FullHashValue);
     if (Bucket == -1) return end();
     return iterator(TheTable+Bucket, true);
   }
 
-  const_iterator find(StringRef Key) const {
-    int Bucket = FindKey(Key);
+  const_iterator find(StringRef Key, unsigned FullHashValue) const {
+    int Bucket = FindKey(Key, FullHashValue);
     if (Bucket == -1) return end();
     return const_iterator(TheTable+Bucket, true);
   }
@@ -313,8 +344,13 @@ public:
   /// already exists in the map, return false and ignore the request, otherwise
   /// insert it and return true.
   bool insert(MapEntryTy *KeyValue) {
-    unsigned BucketNo = LookupBucketFor(KeyValue->getKey());
-    StringMapEntryBase *&Bucket = TheTable[BucketNo];
+    return insert(KeyValue, hash(KeyValue->getKey()));
+  }
+
+  /// insert - Insert KeyValue, the hash() of whose key is FullHashValue.
+  bool insert(MapEntryTy *KeyValue, unsigned FullHashValue) {
+    unsigned BucketNo = LookupBucketFor(KeyValue->getKey(), FullHashValue);
+    StringMapEntryBase *&Bucket = TheTable[BucketNo].Item;
     if (Bucket && Bucket != getTombstoneVal())
       return false;  // Already exists in map.
 
@@ -335,7 +371,7 @@ public:
     // Zap all values, resetting the keys back to non-present (not tombstone),
     // which is safe because we're removing all elements.
     for (unsigned I = 0, E = NumBuckets; I != E; ++I) {
-      StringMapEntryBase *&Bucket = TheTable[I];
+      StringMapEntryBase *&Bucket = TheTable[I].Item;
       if (Bucket && Bucket != getTombstoneVal()) {
         static_cast<MapEntryTy*>(Bucket)->Destroy(Allocator);
       }
@@ -351,8 +387,16 @@ public:
   /// return.
   template <typename InitTy>
   MapEntryTy &GetOrCreateValue(StringRef Key, InitTy Val) {
-    unsigned BucketNo = LookupBucketFor(Key);
-    StringMapEntryBase *&Bucket = TheTable[BucketNo];
+    return GetOrCreateValue(Key, hash(Key), Val);
+  }
+
+  /// GetOrCreateValue - Look up Key, whose hash() is FullHashValue, creating
+  /// an entry initialized with Val if it is not in the map.
+  template <typename InitTy>
+  MapEntryTy &GetOrCreateValue(StringRef Key, unsigned FullHashValue,
+                               InitTy Val) {
+    unsigned BucketNo = LookupBucketFor(Key, FullHashValue);
+    StringMapEntryBase *&Bucket = TheTable[BucketNo].Item;
     if (Bucket && Bucket != getTombstoneVal())
       return *static_cast<MapEntryTy*>(Bucket);
 
@@ -405,21 +449,21 @@ public:
 template<typename ValueTy>
 class StringMapConstIterator {
 protected:
-  StringMapEntryBase **Ptr;
+  StringMapBucket *Ptr;
 public:
   typedef StringMapEntry<ValueTy> value_type;
 
-  explicit StringMapConstIterator(StringMapEntryBase **Bucket,
+  explicit StringMapConstIterator(StringMapBucket *Bucket,
                                   bool NoAdvance = false)
   : Ptr(Bucket) {
     if (!NoAdvance) AdvancePastEmptyBuckets();
   }
 
   const value_type &operator*() const {
-    return *static_cast<StringMapEntry<ValueTy>*>(*Ptr);
+    return *static_cast<StringMapEntry<ValueTy>*>(Ptr->Item);
   }
   const value_type *operator->() const {
-    return static_cast<StringMapEntry<ValueTy>*>(*Ptr);
+    return static_cast<StringMapEntry<ValueTy>*>(Ptr->Item);
   }
 
   bool operator==(const StringMapConstIterator &RHS) const {
@@ -440,7 +484,7 @@ public:
 
 private:
   void AdvancePastEmptyBuckets() {
-    while (*Ptr == 0 || *Ptr == StringMapImpl::getTombstoneVal())
+    while (Ptr->Item == 0 || Ptr->Item == StringMapImpl::getTombstoneVal())
       ++Ptr;
   }
 };
@@ -448,15 +492,15 @@ private:
 template<typename ValueTy>
 class StringMapIterator : public StringMapConstIterator<ValueTy> {
 public:
-  explicit StringMapIterator(StringMapEntryBase **Bucket,
+  explicit StringMapIterator(StringMapBucket *Bucket,
                              bool NoAdvance = false)
     : StringMapConstIterator<ValueTy>(Bucket, NoAdvance) {
   }
   StringMapEntry<ValueTy> &operator*() const {
-    return *static_cast<StringMapEntry<ValueTy>*>(*this->Ptr);
+    return *static_cast<StringMapEntry<ValueTy>*>(this->Ptr->Item);
   }
   StringMapEntry<ValueTy> *operator->() const {
-    return static_cast<StringMapEntry<ValueTy>*>(*this->Ptr);
+    return static_cast<StringMapEntry<ValueTy>*>(this->Ptr->Item);
   }
 };
 
@@ -0,0 +1,714 @@
+//===- llvm/ADT/SwissMap.h - Group probed hash table ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the SwissMap class, an open addressing hash table with
+// the same interface as DenseMap.
+//
+// Instead of reserving an empty and a tombstone key, SwissMap keeps one
+// control byte per bucket in a separate array.  A full bucket's control byte
+// holds seven bits of its hash, so a lookup compares sixteen control bytes at
+// once (with a single SSE2 compare where available) and only touches the
+// buckets whose hash bits match.  The table is kept at most 7/8 full.
+//
+// Buckets are not default constructed, so keys and values need not be cheap
+// to construct, and keys do not need distinguished empty or tombstone values.
+// KeyInfoT is only used for getHashValue and isEqual.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ADT_SWISSMAP_H
+#define LLVM_ADT_SWISSMAP_H
+
+#include "llvm/ADT/DenseMapInfo.h"
+#include "llvm/Support/AlignOf.h"
+#include "llvm/Support/Compiler.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/type_traits.h"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <new>
+#include <utility>
+
+#if defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define LLVM_SWISSMAP_USE_SSE2 1
+#endif
+
+namespace llvm {
+
+namespace swissmap_detail {
+
+typedef int8_t CtrlT;
+
+/// Special control byte values.  Full buckets store a seven bit hash in the
+/// control byte, so all of these have the sign bit set.  The sentinel marks
+/// the end of the bucket array and stops iteration.
+enum {
+  CtrlEmpty = -128,
+  CtrlDeleted = -2,
+  CtrlSentinel = -1
+};
+
+/// GroupWidth - The number of control bytes examined by each probe.
+enum { GroupWidth = 16 };
+
+inline bool isFull(CtrlT C) { return C >= 0; }
+
+/// BitMask - The set of positions within a group that matched a query, one
+/// bit per control byte.
+class BitMask {
+  uint32_t Mask;
+public:
+  explicit BitMask(uint32_t M) : Mask(M) {}
+
+  bool any() const { return Mask != 0; }
+  unsigned lowest() const { return CountTrailingZeros_32(Mask); }
+  void clearLowest() { Mask &= Mask - 1; }
+
+  /// leadingZeros - The number of unmatched positions at the top of the
+  /// group.
+  unsigned leadingZeros() const {
+    return CountLeadingZeros_32(Mask << (32 - GroupWidth));
+  }
+};
+
+#ifdef LLVM_SWISSMAP_USE_SSE2
+/// Group - GroupWidth consecutive control bytes, matched with SSE2.
+class Group {
+  __m128i Ctrl;
+public:
+  explicit Group(const CtrlT *Pos)
+    : Ctrl(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Pos))) {}
+
+  /// match - Return the positions whose control byte is H.
+  BitMask match(CtrlT H) const {
+    return BitMask(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(H), Ctrl)));
+  }
+
+  BitMask matchEmpty() const { return match(CtrlEmpty); }
+
+  /// matchEmptyOrDeleted - Return the positions that can take a new entry.
+  /// Empty and deleted are the only values below the sentinel.
+  BitMask matchEmptyOrDeleted() const {
+    __m128i Sentinel = _mm_set1_epi8(CtrlSentinel);
+    return BitMask(_mm_movemask_epi8(_mm_cmpgt_epi8(Sentinel, Ctrl)));
+  }
+};
+#else
+/// Group - GroupWidth consecutive control bytes, matched one at a time.
+class Group {
+  const CtrlT *Ctrl;
+public:
+  explicit Group(const CtrlT *Pos) : Ctrl(Pos) {}
+
+  /// match - Return the positions whose control byte is H.
+  BitMask match(CtrlT H) const {
+    uint32_t Mask = 0;
+    for (unsigned i = 0; i != GroupWidth; ++i)
+      Mask |= uint32_t(Ctrl[i] == H) << i;
+    return BitMask(Mask);
+  }
+
+  BitMask matchEmpty() const { return match(CtrlEmpty); }
+
+  /// matchEmptyOrDeleted - Return the positions that can take a new entry.
+  /// Empty and deleted are the only values below the sentinel.
+  BitMask matchEmptyOrDeleted() const {
+    uint32_t Mask = 0;
+    for (unsigned i = 0; i != GroupWidth; ++i)
+      Mask |= uint32_t(Ctrl[i] < CtrlSentinel) << i;
+    return BitMask(Mask);
+  }
+};
+#endif
+
+/// getEmptyGroup - Control bytes shared by all maps that have no buckets.
+/// Lookups stop at the first empty byte and iteration stops at the sentinel,
+/// so an unallocated map needs no special cases on those paths.
+inline const CtrlT *getEmptyGroup() {
+  static const CtrlT EmptyGroup[GroupWidth] = {
+    CtrlSentinel, CtrlEmpty, CtrlEmpty, CtrlEmpty,
+    CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty,
+    CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty,
+    CtrlEmpty, CtrlEmpty, CtrlEmpty, CtrlEmpty
+  };
+  return EmptyGroup;
+}
+
+/// mixHash - Spread the bits of a DenseMapInfo hash, which is often weak in
+/// its high bits, over 64 bits.  The low seven bits become the control byte
+/// and the rest pick the starting group.
+inline uint64_t mixHash(unsigned Hash) {
+  uint64_t H = uint64_t(Hash) * 0x9E3779B97F4A7C15ULL;
+  return H ^ (H >> 32);
+}
+
+} // end namespace swissmap_detail
+
+template<typename KeyT, typename ValueT,
+         typename KeyInfoT = DenseMapInfo<KeyT>,
+         bool IsConst = false>
+class SwissMapIterator;
+
+template<typename KeyT, typename ValueT,
+         typename KeyInfoT = DenseMapInfo<KeyT> >
+class SwissMap {
+  typedef std::pair<KeyT, ValueT> BucketT;
+  typedef swissmap_detail::CtrlT CtrlT;
+  typedef swissmap_detail::Group Group;
+  typedef swissmap_detail::BitMask BitMask;
+
+  /// Ctrl - Capacity control bytes, the sentinel, and a copy of the first
+  /// GroupWidth-1 control bytes so that a group can be loaded starting at
+  /// any bucket without wrapping.
+  CtrlT *Ctrl;
+  BucketT *Buckets;
+  /// Capacity - The number of buckets: zero, or one less than a power of two
+  /// and at least GroupWidth-1.
+  unsigned Capacity;
+  unsigned NumEntries;
+  /// GrowthLeft - The number of empty buckets that may still be filled before
+  /// the table must be rehashed.  Deleted buckets are not counted.
+  unsigned GrowthLeft;
+
+public:
+  typedef KeyT key_type;
+  typedef ValueT mapped_type;
+  typedef BucketT value_type;
+
+  typedef SwissMapIterator<KeyT, ValueT, KeyInfoT> iterator;
+  typedef SwissMapIterator<KeyT, ValueT, KeyInfoT, true> const_iterator;
+
+  /// Create a map with room for at least NumInitBuckets buckets.
+  explicit SwissMap(unsigned NumInitBuckets = 0) {
+    init(NumInitBuckets);
+  }
+
+  SwissMap(const SwissMap &other) {
+    init(0);
+    copyFrom(other);
+  }
+
+#if LLVM_HAS_RVALUE_REFERENCES
+  SwissMap(SwissMap &&other) {
+    init(0);
+    swap(other);
+  }
+#endif
+
+  template<typename InputIt>
+  SwissMap(const InputIt &I, const InputIt &E) {
+    init(NextPowerOf2(std::distance(I, E)));
+    this->insert(I, E);
+  }
+
+  ~SwissMap() {
+    destroyAll();
+    deallocateBuckets();
+  }
+
+  void swap(SwissMap &RHS) {
+    std::swap(Ctrl, RHS.Ctrl);
+    std::swap(Buckets, RHS.Buckets);
+    std::swap(Capacity, RHS.Capacity);
+    std::swap(NumEntries, RHS.NumEntries);
+    std::swap(GrowthLeft, RHS.GrowthLeft);
+  }
+
+  SwissMap &operator=(const SwissMap &other) {
+    if (&other != this)
+      copyFrom(other);
+    return *this;
+  }
+
+#if LLVM_HAS_RVALUE_REFERENCES
+  SwissMap &operator=(SwissMap &&other) {
+    destroyAll();
+    deallocateBuckets();
+    init(0);
+    swap(other);
+    return *this;
+  }
+#endif
+
+  inline iterator begin() {
+    return empty() ? end() : iterator(Ctrl, Buckets);
+  }
+  inline iterator end() {
+    return iterator(Ctrl + Capacity, Buckets + Capacity, true);
+  }
+  inline const_iterator begin() const {
+    return empty() ? end() : const_iterator(Ctrl, Buckets);
+  }
+  inline const_iterator end() const {
+    return const_iterator(Ctrl + Capacity, Buckets + Capacity, true);
+  }
+
+  bool empty() const { return NumEntries == 0; }
+  unsigned size() const { return NumEntries; }
+
+  /// Grow the map so that it has at least Size buckets. Does not shrink.
+  void resize(size_t Size) {
+    if (Size > Capacity)
+      rehash(Size);
+  }
+
+  void clear() {
+    if (NumEntries == 0 && GrowthLeft == growthForCapacity(Capacity))
+      return;
+
+    destroyAll();
+    resetCtrl();
+    NumEntries = 0;
+    GrowthLeft = growthForCapacity(Capacity);
+  }
+
+  /// count - Return true if the specified key is in the map.
+  bool count(const KeyT &Val) const {
+    unsigned Index;
+    return LookupBucketFor(Val, Index);
+  }
+
+  iterator find(const KeyT &Val) {
+    unsigned Index;
+    if (LookupBucketFor(Val, Index))
+      return iterator(Ctrl + Index, Buckets + Index, true);
+    return end();
+  }
+  const_iterator find(const KeyT &Val) const {
+    unsigned Index;
+    if (LookupBucketFor(Val, Index))
+      return const_iterator(Ctrl + Index, Buckets + Index, true);
+    return end();
+  }
+
+  /// Alternate version of find() which allows a different, and possibly
+  /// less expensive, key type.
+  /// The KeyInfoT is responsible for supplying methods
+  /// getHashValue(LookupKeyT) and isEqual(LookupKeyT, KeyT) for each key
+  /// type used.
+  template<class LookupKeyT>
+  iterator find_as(const LookupKeyT &Val) {
+    unsigned Index;
+    if (LookupBucketFor(Val, Index))
+      return iterator(Ctrl + Index, Buckets + Index, true);
+    return end();
+  }
+  template<class LookupKeyT>
+  const_iterator find_as(const LookupKeyT &Val) const {
+    unsigned Index;
+    if (LookupBucketFor(Val, Index))
+      return const_iterator(Ctrl + Index, Buckets + Index, true);
+    return end();
+  }
+
+  /// lookup - Return the entry for the specified key, or a default
+  /// constructed value if no such entry exists.
+  ValueT lookup(const KeyT &Val) const {
+    unsigned Index;
+    if (LookupBucketFor(Val, Index))
+      return Buckets[Index].second;
+    return ValueT();
+  }
+
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(const std::pair<KeyT, ValueT> &KV) {
+    uint64_t Hash = hashOf(KV.first);
+    unsigned Index;
+    if (LookupBucketFor(KV.first, Hash, Index))
+      return std::make_pair(iterator(Ctrl + Index, Buckets + Index, true),
+                            false); // Already in map.
+
+    // Otherwise, insert the new element.
+    Index = InsertIntoBucketImpl(Hash);
+    new (&Buckets[Index]) BucketT(KV);
+    return std::make_pair(iterator(Ctrl + Index, Buckets + Index, true), true);
+  }
+
+#if LLVM_HAS_RVALUE_REFERENCES
+  // Inserts key,value pair into the map if the key isn't already in the map.
+  // If the key is already in the map, it returns false and doesn't update the
+  // value.
+  std::pair<iterator, bool> insert(std::pair<KeyT, ValueT> &&KV) {
+    uint64_t Hash = hashOf(KV.first);
+    unsigned Index;
+    if (LookupBucketFor(KV.first, Hash, Index))
+      return std::make_pair(iterator(Ctrl + Index, Buckets + Index, true),
+                            false); // Already in map.
+
+    // Otherwise, insert the new element.
+    Index = InsertIntoBucketImpl(Hash);
+    new (&Buckets[Index]) BucketT(std::move(KV));
+    return std::make_pair(iterator(Ctrl + Index, Buckets + Index, true), true);
+  }
+#endif
+
+  /// insert - Range insertion of pairs.
+  template<typename InputIt>
+  void insert(InputIt I, InputIt E) {
+    for (; I != E; ++I)
+      insert(*I);
+  }
+
+  bool erase(const KeyT &Val) {
+    unsigned Index;
+    if (!LookupBucketFor(Val, Index))
+      return false; // not in map.
+
+    EraseBucket(Index);
+    return true;
+  }
+  void erase(iterator I) {
+    EraseBucket(&*I - Buckets);
+  }
+
+  value_type& FindAndConstruct(const KeyT &Key) {
+    uint64_t Hash = hashOf(Key);
+    unsigned Index;
+    if (LookupBucketFor(Key, Hash, Index))
+      return Buckets[Index];
+
+    Index = InsertIntoBucketImpl(Hash);
+    return *new (&Buckets[Index]) BucketT(Key, ValueT());
+  }
+
+  ValueT &operator[](const KeyT &Key) {
+    return FindAndConstruct(Key).second;
+  }
+
+  /// isPointerIntoBucketsArray - Return true if the specified pointer points
+  /// somewhere into the SwissMap's array of buckets (i.e. either to a key or
+  /// value in the SwissMap).
+  bool isPointerIntoBucketsArray(const void *Ptr) const {
+    return Ptr >= Buckets && Ptr < Buckets + Capacity;
+  }
+
+  /// getPointerIntoBucketsArray() - Return an opaque pointer into the buckets
+  /// array.  In conjunction with the previous method, this can be used to
+  /// determine whether an insertion caused the SwissMap to reallocate.
+  const void *getPointerIntoBucketsArray() const { return Buckets; }
+
+  /// Return the approximate size (in bytes) of the actual map, including the
+  /// control bytes.
+  /// If entries are pointers to objects, the size of the referenced objects
+  /// are not included.
+  size_t getMemorySize() const {
+    if (Capacity == 0)
+      return 0;
+    return getCtrlSize(Capacity) + Capacity * sizeof(BucketT);
+  }
+
+private:
+  template<typename LookupKeyT>
+  static uint64_t hashOf(const LookupKeyT &Val) {
+    return swissmap_detail::mixHash(KeyInfoT::getHashValue(Val));
+  }
+  static CtrlT getH2(uint64_t Hash) { return CtrlT(Hash & 0x7f); }
+
+  /// growthForCapacity - The number of entries a table with Cap buckets may
+  /// hold, which keeps the load factor at or below 7/8.
+  static unsigned growthForCapacity(unsigned Cap) { return Cap - Cap / 8; }
+
+  /// normalizeCapacity - Round NumBuckets up to a valid capacity.
+  static unsigned normalizeCapacity(unsigned NumBuckets) {
+    if (NumBuckets < swissmap_detail::GroupWidth)
+      return swissmap_detail::GroupWidth - 1;
+    return unsigned(NextPowerOf2(NumBuckets)) - 1;
+  }
+
+  /// getCtrlSize - The number of bytes in front of the buckets: the control
+  /// bytes, padded to the alignment of a bucket.
+  static size_t getCtrlSize(unsigned Cap) {
+    return RoundUpToAlignment(Cap + swissmap_detail::GroupWidth,
+                              AlignOf<BucketT>::Alignment);
+  }
+
+  void init(unsigned InitBuckets) {
+    NumEntries = 0;
+    if (InitBuckets == 0) {
+      Ctrl = const_cast<CtrlT *>(swissmap_detail::getEmptyGroup());
+      Buckets = 0;
+      Capacity = 0;
+      GrowthLeft = 0;
+      return;
+    }
+    allocateBuckets(normalizeCapacity(InitBuckets));
+  }
+
+  /// allocateBuckets - Allocate the control bytes and buckets for a table of
+  /// Cap buckets in one block and mark every bucket empty.
+  void allocateBuckets(unsigned Cap) {
+    char *Mem = static_cast<char *>(
+        operator new(getCtrlSize(Cap) + Cap * sizeof(BucketT)));
+    Ctrl = reinterpret_cast<CtrlT *>(Mem);
+    Buckets = reinterpret_cast<BucketT *>(Mem + getCtrlSize(Cap));
+    Capacity = Cap;
+    GrowthLeft = growthForCapacity(Cap);
+    resetCtrl();
+  }
+
+  void deallocateBuckets() {
+    if (Capacity != 0)
+      operator delete(Ctrl);
+  }
+
+  void resetCtrl() {
+    if (Capacity == 0)
+      return;
+    std::memset(Ctrl, swissmap_detail::CtrlEmpty,
+                Capacity + swissmap_detail::GroupWidth);
+    Ctrl[Capacity] = swissmap_detail::CtrlSentinel;
+  }
+
+  void destroyAll() {
+    if (isPodLike<KeyT>::value && isPodLike<ValueT>::value)
+      return;
+    for (unsigned i = 0; i != Capacity; ++i)
+      if (swissmap_detail::isFull(Ctrl[i]))
+        Buckets[i].~BucketT();
+  }
+
+  void copyFrom(const SwissMap &other) {
+    destroyAll();
+    if (Capacity != other.Capacity) {
+      deallocateBuckets();
+      init(0);
+      if (other.Capacity != 0)
+        allocateBuckets(other.Capacity);
+    }
+
+    NumEntries = other.NumEntries;
+    GrowthLeft = other.GrowthLeft;
+    if (Capacity == 0)
+      return;
+
+    std::memcpy(Ctrl, other.Ctrl, Capacity + swissmap_detail::GroupWidth);
+    if (isPodLike<KeyT>::value && isPodLike<ValueT>::value)
+      std::memcpy(Buckets, other.Buckets, Capacity * sizeof(BucketT));
+    else
+      for (unsigned i = 0; i != Capacity; ++i)
+        if (swissmap_detail::isFull(Ctrl[i]))
+          new (&Buckets[i]) BucketT(other.Buckets[i]);
+  }
+
+  /// setCtrl - Set the control byte of bucket Index, and its copy past the
+  /// sentinel if it is one of the first GroupWidth-1 buckets.
+  void setCtrl(unsigned Index, CtrlT H) {
+    const unsigned NumCloned = swissmap_detail::GroupWidth - 1;
+    Ctrl[Index] = H;
+    Ctrl[((Index - NumCloned) & Capacity) + NumCloned] = H;
+  }
+
+  /// rehash - Move every entry into a new table with at least NumBuckets
+  /// buckets.  This also drops all deleted markers.
+  void rehash(unsigned NumBuckets) {
+    CtrlT *OldCtrl = Ctrl;
+    BucketT *OldBuckets = Buckets;
+    unsigned OldCapacity = Capacity;
+
+    allocateBuckets(normalizeCapacity(NumBuckets));
+    assert(GrowthLeft >= NumEntries && "Rehashed table is too small!");
+    GrowthLeft -= NumEntries;
+
+    for (unsigned i = 0; i != OldCapacity; ++i) {
+      if (!swissmap_detail::isFull(OldCtrl[i]))
+        continue;
+      uint64_t Hash = hashOf(OldBuckets[i].first);
+      unsigned Index = findFirstNonFull(Hash);
+      setCtrl(Index, getH2(Hash));
+      new (&Buckets[Index]) BucketT(llvm_move(OldBuckets[i]));
+      OldBuckets[i].~BucketT();
+    }
+
+    if (OldCapacity != 0)
+      operator delete(OldCtrl);
+  }
+
+  /// rehashAndGrowIfNeeded - Make room for one more entry.  If most of the
+  /// used buckets are deleted markers, rehash in place instead of growing.
+  void rehashAndGrowIfNeeded() {
+    if (Capacity != 0 && NumEntries * 2 <= growthForCapacity(Capacity))
+      rehash(Capacity);
+    else
+      rehash(Capacity * 2 + 1);
+  }
+
+  /// findFirstNonFull - Return the first empty or deleted bucket in the probe
+  /// sequence for Hash.
+  unsigned findFirstNonFull(uint64_t Hash) const {
+    unsigned Pos = unsigned(Hash >> 7) & Capacity;
+    unsigned Step = 0;
+    while (1) {
+      BitMask Mask = Group(Ctrl + Pos).matchEmptyOrDeleted();
+      if (Mask.any())
+        return (Pos + Mask.lowest()) & Capacity;
+      // Triangular probing over groups visits every group exactly once
+      // before repeating, since the table size is a power of two.
+      Step += swissmap_detail::GroupWidth;
+      Pos = (Pos + Step) & Capacity;
+    }
+  }
+
+  /// InsertIntoBucketImpl - Claim a bucket for a new entry with the given
+  /// hash, growing the table if needed, and return its index.  The caller
+  /// must construct the bucket.
+  unsigned InsertIntoBucketImpl(uint64_t Hash) {
+    unsigned Index = findFirstNonFull(Hash);
+    // Reusing a deleted bucket does not use up any growth.  Otherwise make
+    // sure the table stays at most 7/8 full so that every probe sequence
+    // ends at an empty bucket.
+    if (LLVM_UNLIKELY(GrowthLeft == 0 &&
+                      Ctrl[Index] != swissmap_detail::CtrlDeleted)) {
+      rehashAndGrowIfNeeded();
+      Index = findFirstNonFull(Hash);
+    }
+
+    if (Ctrl[Index] == swissmap_detail::CtrlEmpty)
+      --GrowthLeft;
+    ++NumEntries;
+    setCtrl(Index, getH2(Hash));
+    return Index;
+  }
+
+  /// EraseBucket - Destroy the entry in bucket Index.  The bucket can be
+  /// marked empty again if no probe sequence could have passed over it while
+  /// it was full: that is the case when no run of GroupWidth full or deleted
+  /// buckets spans it.
+  void EraseBucket(unsigned Index) {
+    assert(swissmap_detail::isFull(Ctrl[Index]) && "Erasing an empty bucket!");
+    Buckets[Index].~BucketT();
+    --NumEntries;
+
+    unsigned Before = (Index - swissmap_detail::GroupWidth) & Capacity;
+    BitMask EmptyBefore = Group(Ctrl + Before).matchEmpty();
+    BitMask EmptyAfter = Group(Ctrl + Index).matchEmpty();
+    if (EmptyBefore.any() && EmptyAfter.any() &&
+        EmptyBefore.leadingZeros() + EmptyAfter.lowest() <
+            swissmap_detail::GroupWidth) {
+      setCtrl(Index, swissmap_detail::CtrlEmpty);
+      ++GrowthLeft;
+    } else {
+      setCtrl(Index, swissmap_detail::CtrlDeleted);
+    }
+  }
+
+  /// LookupBucketFor - Lookup the appropriate bucket for Val, returning it in
+  /// Index.  Return true if the map contains Val.
+  template<typename LookupKeyT>
+  bool LookupBucketFor(const LookupKeyT &Val, unsigned &Index) const {
+    return LookupBucketFor(Val, hashOf(Val), Index);
+  }
+
+  template<typename LookupKeyT>
+  bool LookupBucketFor(const LookupKeyT &Val, uint64_t Hash,
+                       unsigned &Index) const {
+    CtrlT H2 = getH2(Hash);
+    unsigned Pos = unsigned(Hash >> 7) & Capacity;
+    unsigned Step = 0;
+    while (1) {
+      Group G(Ctrl + Pos);
+      for (BitMask Mask = G.match(H2); Mask.any(); Mask.clearLowest()) {
+        unsigned I = (Pos + Mask.lowest()) & Capacity;
+        if (LLVM_LIKELY(KeyInfoT::isEqual(Val, Buckets[I].first))) {
+          Index = I;
+          return true;
+        }
+      }
+      // An empty bucket ends every probe sequence that could contain Val.
+      if (LLVM_LIKELY(G.matchEmpty().any()))
+        return false;
+      Step += swissmap_detail::GroupWidth;
+      Pos = (Pos + Step) & Capacity;
+    }
+  }
+};
+
+template<typename KeyT, typename ValueT,
+         typename KeyInfoT, bool IsConst>
+class SwissMapIterator {
+  typedef std::pair<KeyT, ValueT> Bucket;
+  typedef SwissMapIterator<KeyT, ValueT,
+                           KeyInfoT, true> ConstIterator;
+  friend class SwissMapIterator<KeyT, ValueT, KeyInfoT, true>;
+public:
+  typedef ptrdiff_t difference_type;
+  typedef typename conditional<IsConst, const Bucket, Bucket>::type value_type;
+  typedef value_type *pointer;
+  typedef value_type &reference;
+  typedef std::forward_iterator_tag iterator_category;
+private:
+  const swissmap_detail::CtrlT *Ctrl;
+  pointer Ptr;
+public:
+  SwissMapIterator() : Ctrl(0), Ptr(0) {}
+
+  SwissMapIterator(const swissmap_detail::CtrlT *C, pointer Pos,
+                   bool NoAdvance = false)
+    : Ctrl(C), Ptr(Pos) {
+    if (!NoAdvance) AdvancePastEmptyBuckets();
+  }
+
+  // If IsConst is true this is a converting constructor from iterator to
+  // const_iterator and the default copy constructor is used.
+  // Otherwise this is a copy constructor for iterator.
+  SwissMapIterator(const SwissMapIterator<KeyT, ValueT,
+                                          KeyInfoT, false>& I)
+    : Ctrl(I.Ctrl), Ptr(I.Ptr) {}
+
+  reference operator*() const {
+    return *Ptr;
+  }
+  pointer operator->() const {
+    return Ptr;
+  }
+
+  bool operator==(const ConstIterator &RHS) const {
+    return Ptr == RHS.operator->();
+  }
+  bool operator!=(const ConstIterator &RHS) const {
+    return Ptr != RHS.operator->();
+  }
+
+  inline SwissMapIterator& operator++() {  // Preincrement
+    ++Ctrl;
+    ++Ptr;
+    AdvancePastEmptyBuckets();
+    return *this;
+  }
+  SwissMapIterator operator++(int) {  // Postincrement
+    SwissMapIterator tmp = *this; ++*this; return tmp;
+  }
+
+private:
+  /// AdvancePastEmptyBuckets - Skip empty and deleted buckets.  Both sort
+  /// below the sentinel, which ends the walk.
+  void AdvancePastEmptyBuckets() {
+    while (*Ctrl < swissmap_detail::CtrlSentinel) {
+      ++Ctrl;
+      ++Ptr;
+    }
+  }
+};
+
+template<typename KeyT, typename ValueT, typename KeyInfoT>
+static inline size_t
+capacity_in_bytes(const SwissMap<KeyT, ValueT, KeyInfoT> &X) {
+  return X.getMemorySize();
+}
+
+} // end namespace llvm
+
+#endif
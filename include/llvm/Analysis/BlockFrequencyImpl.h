@@ -16,13 +16,17 @@
 
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/PostOrderIterator.h"
+#include "llvm/ADT/SmallVector.h"
 #include "llvm/CodeGen/MachineBasicBlock.h"
 #include "llvm/CodeGen/MachineFunction.h"
 #include "llvm/IR/BasicBlock.h"
 #include "llvm/Support/BlockFrequency.h"
 #include "llvm/Support/BranchProbability.h"
+#include "llvm/Support/CFG.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/ScaledNumber.h"
 #include "llvm/Support/raw_ostream.h"
+#include <algorithm>
 #include <string>
 #include <vector>
 
@@ -36,20 +40,93 @@ class MachineBlockFrequencyInfo;
 /// Machine Instructions. Algorithm starts with value 1024 (START_FREQ)
 /// for the entry block and then propagates frequencies using branch weights
 /// from (Machine)BranchProbabilityInfo. LoopInfo is not required because
-/// algorithm can find "backedges" by itself.
+/// algorithm can find the loops, including irreducible ones, by itself.
+///
+/// The blocks are split into a tree of loops.  The root is the whole function
+/// with the entry block as its header.  The loops directly inside a loop are
+/// the strongly connected components of its blocks once the edges back to its
+/// headers are removed, and their headers are the blocks entered from outside
+/// them; an irreducible loop has several.  Loops are then solved innermost
+/// first, each in one topological sweep that treats its inner loops as single
+/// nodes: the mass entering the headers flows along the edges, the mass that
+/// comes back to a header gives the loop scale 1 / (1 - backedge mass), and
+/// the mass leaving the loop is what the loop passes on in its parent.  An
+/// irreducible loop is treated as if it were entered evenly through its
+/// headers.  Every edge is visited a bounded number of times per level of
+/// loop nesting, and masses are ScaledNumbers, so deep nests neither
+/// overflow nor round to zero.
 template<class BlockT, class FunctionT, class BlockProbInfoT>
 class BlockFrequencyImpl {
 
-  DenseMap<const BlockT *, BlockFrequency> Freqs;
+  /// WorkItem - A block, or an inner loop standing for all of its blocks.
+  struct WorkItem {
+    unsigned Index;
+    bool IsLoop;
+    WorkItem(unsigned Index, bool IsLoop) : Index(Index), IsLoop(IsLoop) {}
+  };
+
+  /// LoopData - A node of the loop tree.  Loop 0 is the whole function.
+  struct LoopData {
+    unsigned Parent;
+    unsigned Depth;
+
+    /// Headers - The blocks of the loop entered from outside it, in RPO.
+    SmallVector<unsigned, 1> Headers;
+
+    /// Nodes - All blocks of the loop, until it is split into Items.
+    std::vector<unsigned> Nodes;
+
+    /// Items - The blocks and inner loops directly in this loop, in
+    /// topological order with the backedges removed.
+    std::vector<WorkItem> Items;
+
+    /// Mass - The mass entering this loop, per unit entering its parent.
+    ScaledNumber Mass;
+
+    /// Scale - How many times the loop body runs per entry to the loop.
+    ScaledNumber Scale;
+
+    /// Exits - The mass leaving the loop for each block outside it, per
+    /// entry to the loop.
+    std::vector<std::pair<unsigned, ScaledNumber> > Exits;
+
+    LoopData(unsigned Parent, unsigned Depth) : Parent(Parent), Depth(Depth) {}
+  };
 
   BlockProbInfoT *BPI;
 
   FunctionT *Fn;
 
-  typedef GraphTraits< Inverse<BlockT *> > GT;
-
   const uint32_t EntryFreq;
 
+  /// MaxLoopScale - The scale of a loop that (almost) never exits.
+  static const uint32_t MaxLoopScale = 1024;
+
+  // Reachable blocks in reverse postorder.  Blocks are named by their index
+  // in this vector below.
+  std::vector<BlockT *> Blocks;
+  DenseMap<const BlockT *, unsigned> Index;
+
+  // Successors of each block with their probabilities, parallel edges merged.
+  // The edges of block I are [SuccBegin[I], SuccBegin[I + 1]).
+  std::vector<unsigned> SuccBegin;
+  std::vector<unsigned> SuccNode;
+  std::vector<ScaledNumber> SuccProb;
+
+  // The loop tree, parents before children.
+  std::vector<LoopData> Loops;
+
+  // Innermost loop of each block.
+  std::vector<unsigned> LoopOf;
+
+  // Whether each block is a header of its innermost loop.
+  std::vector<bool> IsHeader;
+
+  // Mass reaching each block, per entry to its innermost loop.
+  std::vector<ScaledNumber> Mass;
+
+  std::vector<BlockFrequency> Freqs;
+
   std::string getBlockName(BasicBlock *BB) const {
     return BB->getName().str();
   }
@@ -65,9 +142,21 @@ class BlockFrequencyImpl {
     return ss.str();
   }
 
-  void setBlockFreq(BlockT *BB, BlockFrequency Freq) {
-    Freqs[BB] = Freq;
-    DEBUG(dbgs() << "Frequency(" << getBlockName(BB) << ") = " << Freq << "\n");
+  /// getSuccWeights - Collect the successors of BB with their edge weights,
+  /// reading each weight once.
+  void getSuccWeights(BasicBlock *BB,
+                      SmallVectorImpl<std::pair<BasicBlock *, uint32_t> > &S) {
+    for (succ_iterator I = succ_begin(BB), E = succ_end(BB); I != E; ++I)
+      S.push_back(std::make_pair(*I, BPI->getEdgeWeight(BB,
+                                                I.getSuccessorIndex())));
+  }
+
+  void getSuccWeights(MachineBasicBlock *MBB,
+                      SmallVectorImpl<std::pair<MachineBasicBlock *,
+                                                uint32_t> > &S) {
+    for (MachineBasicBlock::const_succ_iterator I = MBB->succ_begin(),
+         E = MBB->succ_end(); I != E; ++I)
+      S.push_back(std::make_pair(*I, BPI->getEdgeWeight(MBB, I)));
   }
 
   /// getEdgeFreq - Return edge frequency based on SRC frequency and Src -> Dst
@@ -77,181 +166,257 @@ class BlockFrequencyImpl {
     return getBlockFreq(Src) * Prob;
   }
 
-  /// incBlockFreq - Increase BB block frequency by FREQ.
-  ///
-  void incBlockFreq(BlockT *BB, BlockFrequency Freq) {
-    Freqs[BB] += Freq;
-    DEBUG(dbgs() << "Frequency(" << getBlockName(BB) << ") += " << Freq
-                 << " --> " << Freqs[BB] << "\n");
-  }
-
-  /// divBlockFreq - Divide BB block frequency by PROB. If Prob = 0 do nothing.
-  ///
-  void divBlockFreq(BlockT *BB, BranchProbability Prob) {
-    uint64_t N = Prob.getNumerator();
-    assert(N && "Illegal division by zero!");
-    uint64_t D = Prob.getDenominator();
-    uint64_t Freq = (Freqs[BB].getFrequency() * D) / N;
-
-    // Should we assert it?
-    if (Freq > UINT32_MAX)
-      Freq = UINT32_MAX;
-
-    Freqs[BB] = BlockFrequency(Freq);
-    DEBUG(dbgs() << "Frequency(" << getBlockName(BB) << ") /= (" << Prob
-                 << ") --> " << Freqs[BB] << "\n");
-  }
-
-  // All blocks in postorder.
-  std::vector<BlockT *> POT;
-
-  // Map Block -> Position in reverse-postorder list.
-  DenseMap<BlockT *, unsigned> RPO;
-
-  // Cycle Probability for each bloch.
-  DenseMap<BlockT *, uint32_t> CycleProb;
-
-  // (reverse-)postorder traversal iterators.
-  typedef typename std::vector<BlockT *>::iterator pot_iterator;
-  typedef typename std::vector<BlockT *>::reverse_iterator rpot_iterator;
-
-  pot_iterator pot_begin() { return POT.begin(); }
-  pot_iterator pot_end() { return POT.end(); }
-
-  rpot_iterator rpot_begin() { return POT.rbegin(); }
-  rpot_iterator rpot_end() { return POT.rend(); }
-
-  rpot_iterator rpot_at(BlockT *BB) {
-    rpot_iterator I = rpot_begin();
-    unsigned idx = RPO[BB];
-    assert(idx);
-    std::advance(I, idx - 1);
+  /// initSuccessors - Number the reachable blocks in reverse postorder and
+  /// record the probability of each of their successor edges.
+  void initSuccessors() {
+    BlockT *EntryBlock = Fn->begin();
+    std::copy(po_begin(EntryBlock), po_end(EntryBlock),
+              std::back_inserter(Blocks));
+    std::reverse(Blocks.begin(), Blocks.end());
+
+    unsigned N = Blocks.size();
+    for (unsigned I = 0; I != N; ++I)
+      Index[Blocks[I]] = I;
+
+    // The edge slot of each successor of the block being scanned, so that
+    // parallel edges are merged without a search.
+    std::vector<unsigned> SlotFrom(N, ~0U), Slot(N);
+    std::vector<uint64_t> Weights;
+    SmallVector<std::pair<BlockT *, uint32_t>, 8> Succs;
+
+    SuccBegin.reserve(N + 1);
+    for (unsigned I = 0; I != N; ++I) {
+      unsigned Begin = SuccNode.size();
+      SuccBegin.push_back(Begin);
+
+      Succs.clear();
+      getSuccWeights(Blocks[I], Succs);
+      uint64_t Total = 0;
+      for (unsigned i = 0, e = Succs.size(); i != e; ++i) {
+        assert(Index.count(Succs[i].first) && "Successor is unreachable?");
+        unsigned J = Index.lookup(Succs[i].first);
+        Total += Succs[i].second;
+        if (SlotFrom[J] == I) {
+          Weights[Slot[J]] += Succs[i].second;
+          continue;
+        }
+        SlotFrom[J] = I;
+        Slot[J] = SuccNode.size();
+        SuccNode.push_back(J);
+        Weights.push_back(Succs[i].second);
+      }
 
-    assert(*I == BB);
-    return I;
+      unsigned End = SuccNode.size();
+      for (unsigned S = Begin; S != End; ++S)
+        SuccProb.push_back(Total ? ScaledNumber::getFraction(Weights[S], Total)
+                                 : ScaledNumber::getFraction(1, End - Begin));
+    }
+    SuccBegin.push_back(SuccNode.size());
   }
 
+  /// splitLoop - Split loop L into its blocks and inner loops, creating the
+  /// inner loops.  The inner loops are the strongly connected components of
+  /// L without the edges to its headers, found with Tarjan's algorithm.
+  /// InLoop, Number, Low and OnStack are scratch arrays indexed by block.
+  void splitLoop(unsigned L, std::vector<unsigned> &InLoop,
+                 std::vector<unsigned> &Number, std::vector<unsigned> &Low,
+                 std::vector<bool> &OnStack) {
+    std::vector<unsigned> Members;
+    Members.swap(Loops[L].Nodes);
+    for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+      InLoop[Members[i]] = L;
+      Number[Members[i]] = 0;
+    }
 
-  /// isReachable - Returns if BB block is reachable from the entry.
-  ///
-  bool isReachable(BlockT *BB) {
-    return RPO.count(BB);
-  }
-
-  /// isBackedge - Return if edge Src -> Dst is a backedge.
-  ///
-  bool isBackedge(BlockT *Src, BlockT *Dst) {
-    assert(isReachable(Src));
-    assert(isReachable(Dst));
+    unsigned Counter = 0;
+    std::vector<WorkItem> Items;
+    std::vector<unsigned> Stack;
+    std::vector<std::pair<unsigned, unsigned> > Frames;
+    for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+      unsigned Root = Members[i];
+      if (Number[Root])
+        continue;
+
+      Number[Root] = Low[Root] = ++Counter;
+      Stack.push_back(Root);
+      OnStack[Root] = true;
+      Frames.push_back(std::make_pair(Root, SuccBegin[Root]));
+      while (!Frames.empty()) {
+        unsigned U = Frames.back().first;
+        if (Frames.back().second != SuccBegin[U + 1]) {
+          unsigned V = SuccNode[Frames.back().second++];
+          // Edges leaving the loop or going back to its headers are ignored.
+          if (InLoop[V] != L || IsHeader[V])
+            continue;
+          if (!Number[V]) {
+            Number[V] = Low[V] = ++Counter;
+            Stack.push_back(V);
+            OnStack[V] = true;
+            Frames.push_back(std::make_pair(V, SuccBegin[V]));
+          } else if (OnStack[V]) {
+            Low[U] = std::min(Low[U], Number[V]);
+          }
+          continue;
+        }
+
+        Frames.pop_back();
+        if (!Frames.empty()) {
+          unsigned Parent = Frames.back().first;
+          Low[Parent] = std::min(Low[Parent], Low[U]);
+        }
+        if (Low[U] != Number[U])
+          continue;
+
+        // U is the root of a component, which is on top of the stack.
+        unsigned Begin = Stack.size() - 1;
+        while (Stack[Begin] != U)
+          --Begin;
+        for (unsigned j = Begin, je = Stack.size(); j != je; ++j)
+          OnStack[Stack[j]] = false;
+
+        bool IsCycle = Begin + 1 != Stack.size();
+        if (!IsCycle && !IsHeader[U])
+          for (unsigned E = SuccBegin[U], EE = SuccBegin[U + 1]; E != EE; ++E)
+            IsCycle |= SuccNode[E] == U;
+        if (!IsCycle) {
+          Items.push_back(WorkItem(U, false));
+          Stack.pop_back();
+          continue;
+        }
+
+        unsigned Inner = Loops.size();
+        Loops.push_back(LoopData(L, Loops[L].Depth + 1));
+        std::vector<unsigned> &Nodes = Loops.back().Nodes;
+        Nodes.assign(Stack.begin() + Begin, Stack.end());
+        std::sort(Nodes.begin(), Nodes.end());
+        for (unsigned j = 0, je = Nodes.size(); j != je; ++j)
+          LoopOf[Nodes[j]] = Inner;
+        Items.push_back(WorkItem(Inner, true));
+        Stack.resize(Begin);
+      }
+    }
 
-    unsigned a = RPO[Src];
-    unsigned b = RPO[Dst];
+    // Tarjan's algorithm finds the components in reverse topological order.
+    std::reverse(Items.begin(), Items.end());
+    Loops[L].Items.swap(Items);
+
+    // The headers of an inner loop are its blocks with a predecessor outside
+    // it.  Such predecessors are always in L: anything else would enter L
+    // through one of its own headers.
+    for (unsigned i = 0, e = Members.size(); i != e; ++i) {
+      unsigned U = Members[i];
+      for (unsigned E = SuccBegin[U], EE = SuccBegin[U + 1]; E != EE; ++E) {
+        unsigned V = SuccNode[E];
+        if (InLoop[V] != L || LoopOf[V] == L || LoopOf[V] == LoopOf[U] ||
+            IsHeader[V])
+          continue;
+        IsHeader[V] = true;
+        Loops[LoopOf[V]].Headers.push_back(V);
+      }
+    }
 
-    return a >= b;
+    const std::vector<WorkItem> &LoopItems = Loops[L].Items;
+    for (unsigned i = 0, e = LoopItems.size(); i != e; ++i) {
+      if (!LoopItems[i].IsLoop)
+        continue;
+      LoopData &Inner = Loops[LoopItems[i].Index];
+      std::sort(Inner.Headers.begin(), Inner.Headers.end());
+      DEBUG(dbgs() << (Inner.Headers.size() > 1 ? "irreducible " : "")
+                   << "loop at depth " << Inner.Depth << ", headers:";
+            for (unsigned h = 0, he = Inner.Headers.size(); h != he; ++h)
+              dbgs() << " " << getBlockName(Blocks[Inner.Headers[h]]);
+            dbgs() << "\n");
+    }
   }
 
-  /// getSingleBlockPred - return single BB block predecessor or NULL if
-  /// BB has none or more predecessors.
-  BlockT *getSingleBlockPred(BlockT *BB) {
-    typename GT::ChildIteratorType
-      PI = GraphTraits< Inverse<BlockT *> >::child_begin(BB),
-      PE = GraphTraits< Inverse<BlockT *> >::child_end(BB);
-
-    if (PI == PE)
-      return 0;
-
-    BlockT *Pred = *PI;
-
-    ++PI;
-    if (PI != PE)
-      return 0;
-
-    return Pred;
+  /// findLoops - Build the loop tree.
+  void findLoops() {
+    unsigned N = Blocks.size();
+    LoopOf.assign(N, 0);
+    IsHeader.assign(N, false);
+
+    Loops.push_back(LoopData(0, 0));
+    Loops[0].Headers.push_back(0);
+    IsHeader[0] = true;
+    Loops[0].Nodes.reserve(N);
+    for (unsigned I = 0; I != N; ++I)
+      Loops[0].Nodes.push_back(I);
+
+    std::vector<unsigned> InLoop(N), Number(N), Low(N);
+    std::vector<bool> OnStack(N);
+    for (unsigned L = 0; L != Loops.size(); ++L)
+      splitLoop(L, InLoop, Number, Low, OnStack);
   }
 
-  void doBlock(BlockT *BB, BlockT *LoopHead,
-               SmallPtrSet<BlockT *, 8> &BlocksInLoop) {
-
-    DEBUG(dbgs() << "doBlock(" << getBlockName(BB) << ")\n");
-    setBlockFreq(BB, 0);
-
-    if (BB == LoopHead) {
-      setBlockFreq(BB, EntryFreq);
+  /// addMass - Send Amount of mass along an edge of loop L to block V: to
+  /// V itself, to the inner loop of L containing V, back to a header of L,
+  /// or out of L.
+  void addMass(unsigned L, unsigned V, const ScaledNumber &Amount,
+               ScaledNumber &BackedgeMass) {
+    unsigned Inner = LoopOf[V];
+    if (Inner == L) {
+      if (IsHeader[V])
+        BackedgeMass += Amount;
+      else
+        Mass[V] += Amount;
       return;
     }
 
-    if(BlockT *Pred = getSingleBlockPred(BB)) {
-      if (BlocksInLoop.count(Pred))
-        setBlockFreq(BB, getEdgeFreq(Pred, BB));
-      // TODO: else? irreducible, ignore it for now.
+    unsigned Depth = Loops[L].Depth;
+    while (Loops[Inner].Depth > Depth + 1)
+      Inner = Loops[Inner].Parent;
+    if (Loops[Inner].Depth == Depth + 1 && Loops[Inner].Parent == L) {
+      Loops[Inner].Mass += Amount;
       return;
     }
 
-    bool isInLoop = false;
-    bool isLoopHead = false;
-
-    for (typename GT::ChildIteratorType
-         PI = GraphTraits< Inverse<BlockT *> >::child_begin(BB),
-         PE = GraphTraits< Inverse<BlockT *> >::child_end(BB);
-         PI != PE; ++PI) {
-      BlockT *Pred = *PI;
-
-      if (isReachable(Pred) && isBackedge(Pred, BB)) {
-        isLoopHead = true;
-      } else if (BlocksInLoop.count(Pred)) {
-        incBlockFreq(BB, getEdgeFreq(Pred, BB));
-        isInLoop = true;
-      }
-      // TODO: else? irreducible.
-    }
-
-    if (!isInLoop)
-      return;
-
-    if (!isLoopHead)
-      return;
-
-    assert(EntryFreq >= CycleProb[BB]);
-    uint32_t CProb = CycleProb[BB];
-    uint32_t Numerator = EntryFreq - CProb ? EntryFreq - CProb : 1;
-    divBlockFreq(BB, BranchProbability(Numerator, EntryFreq));
+    Loops[L].Exits.push_back(std::make_pair(V, Amount));
   }
 
-  /// doLoop - Propagate block frequency down through the loop.
-  void doLoop(BlockT *Head, BlockT *Tail) {
-    DEBUG(dbgs() << "doLoop(" << getBlockName(Head) << ", "
-                 << getBlockName(Tail) << ")\n");
-
-    SmallPtrSet<BlockT *, 8> BlocksInLoop;
-
-    for (rpot_iterator I = rpot_at(Head), E = rpot_at(Tail); ; ++I) {
-      BlockT *BB = *I;
-      doBlock(BB, Head, BlocksInLoop);
+  /// solveLoop - Distribute one unit of mass entering loop L over its items
+  /// and compute the scale and exit masses of L.  Inner loops must already
+  /// be solved.
+  void solveLoop(unsigned L) {
+    ScaledNumber BackedgeMass;
+    const SmallVectorImpl<unsigned> &Headers = Loops[L].Headers;
+    ScaledNumber HeaderMass =
+      ScaledNumber::getFraction(1, Headers.size());
+    for (unsigned i = 0, e = Headers.size(); i != e; ++i)
+      Mass[Headers[i]] = HeaderMass;
+
+    const std::vector<WorkItem> &Items = Loops[L].Items;
+    for (unsigned i = 0, e = Items.size(); i != e; ++i) {
+      unsigned I = Items[i].Index;
+      if (!Items[i].IsLoop) {
+        ScaledNumber M = Mass[I];
+        if (M.isZero())
+          continue;
+        for (unsigned E = SuccBegin[I], EE = SuccBegin[I + 1]; E != EE; ++E)
+          addMass(L, SuccNode[E], M * SuccProb[E], BackedgeMass);
+        continue;
+      }
 
-      BlocksInLoop.insert(BB);
-      if (I == E)
-        break;
+      std::vector<std::pair<unsigned, ScaledNumber> > Exits;
+      Exits.swap(Loops[I].Exits);
+      ScaledNumber M = Loops[I].Mass;
+      if (M.isZero())
+        continue;
+      for (unsigned x = 0, xe = Exits.size(); x != xe; ++x)
+        addMass(L, Exits[x].first, M * Exits[x].second, BackedgeMass);
     }
 
-    // Compute loop's cyclic probability using backedges probabilities.
-    for (typename GT::ChildIteratorType
-         PI = GraphTraits< Inverse<BlockT *> >::child_begin(Head),
-         PE = GraphTraits< Inverse<BlockT *> >::child_end(Head);
-         PI != PE; ++PI) {
-      BlockT *Pred = *PI;
-      assert(Pred);
-      if (isReachable(Pred) && isBackedge(Pred, Head)) {
-        uint64_t N = getEdgeFreq(Pred, Head).getFrequency();
-        uint64_t D = getBlockFreq(Head).getFrequency();
-        assert(N <= EntryFreq && "Backedge frequency must be <= EntryFreq!");
-        uint64_t Res = (N * EntryFreq) / D;
-
-        assert(Res <= UINT32_MAX);
-        CycleProb[Head] += (uint32_t) Res;
-        DEBUG(dbgs() << "  CycleProb[" << getBlockName(Head) << "] += " << Res
-                     << " --> " << CycleProb[Head] << "\n");
-      }
-    }
+    LoopData &Loop = Loops[L];
+    ScaledNumber ExitMass = ScaledNumber::getOne() - BackedgeMass;
+    if (ExitMass < ScaledNumber::getFraction(1, MaxLoopScale))
+      Loop.Scale = ScaledNumber(MaxLoopScale);
+    else
+      Loop.Scale = ScaledNumber::getOne() / ExitMass;
+    for (unsigned x = 0, xe = Loop.Exits.size(); x != xe; ++x)
+      Loop.Exits[x].second *= Loop.Scale;
+
+    DEBUG(dbgs() << "loop of " << getBlockName(Blocks[Headers[0]])
+                 << ": backedge mass = " << BackedgeMass
+                 << ", scale = " << Loop.Scale << "\n");
   }
 
   friend class BlockFrequencyInfo;
@@ -264,55 +429,51 @@ class BlockFrequencyImpl {
     BPI = bpi;
 
     // Clear everything.
-    RPO.clear();
-    POT.clear();
-    CycleProb.clear();
+    Blocks.clear();
+    Index.clear();
     Freqs.clear();
 
-    BlockT *EntryBlock = fn->begin();
-
-    std::copy(po_begin(EntryBlock), po_end(EntryBlock), std::back_inserter(POT));
-
-    unsigned RPOidx = 0;
-    for (rpot_iterator I = rpot_begin(), E = rpot_end(); I != E; ++I) {
-      BlockT *BB = *I;
-      RPO[BB] = ++RPOidx;
-      DEBUG(dbgs() << "RPO[" << getBlockName(BB) << "] = " << RPO[BB] << "\n");
-    }
-
-    // Travel over all blocks in postorder.
-    for (pot_iterator I = pot_begin(), E = pot_end(); I != E; ++I) {
-      BlockT *BB = *I;
-      BlockT *LastTail = 0;
-      DEBUG(dbgs() << "POT: " << getBlockName(BB) << "\n");
-
-      for (typename GT::ChildIteratorType
-           PI = GraphTraits< Inverse<BlockT *> >::child_begin(BB),
-           PE = GraphTraits< Inverse<BlockT *> >::child_end(BB);
-           PI != PE; ++PI) {
-
-        BlockT *Pred = *PI;
-        if (isReachable(Pred) && isBackedge(Pred, BB)
-            && (!LastTail || RPO[Pred] > RPO[LastTail]))
-          LastTail = Pred;
-      }
-
-      if (LastTail)
-        doLoop(BB, LastTail);
+    initSuccessors();
+    findLoops();
+
+    unsigned N = Blocks.size();
+    Mass.assign(N, ScaledNumber());
+    for (unsigned L = Loops.size(); L != 0; --L)
+      solveLoop(L - 1);
+
+    // The frequency of a block is its mass times the number of times its
+    // loop runs per call, which follows from the masses entering the
+    // enclosing loops.
+    std::vector<ScaledNumber> LoopFreq(Loops.size());
+    LoopFreq[0] = Loops[0].Scale * ScaledNumber(EntryFreq);
+    for (unsigned L = 1, LE = Loops.size(); L != LE; ++L)
+      LoopFreq[L] = Loops[L].Mass * LoopFreq[Loops[L].Parent] * Loops[L].Scale;
+
+    Freqs.reserve(N);
+    for (unsigned I = 0; I != N; ++I) {
+      ScaledNumber Freq = Mass[I] * LoopFreq[LoopOf[I]];
+      Freqs.push_back((Freq + ScaledNumber(1, -1)).toInt());
+      DEBUG(dbgs() << "Frequency(" << getBlockName(Blocks[I]) << ") = "
+                   << Freqs.back() << "\n");
     }
 
-    // At the end assume the whole function as a loop, and travel over it once
-    // again.
-    doLoop(*(rpot_begin()), *(pot_begin()));
+    // Only the frequencies are needed from now on.
+    std::vector<unsigned>().swap(SuccBegin);
+    std::vector<unsigned>().swap(SuccNode);
+    std::vector<ScaledNumber>().swap(SuccProb);
+    std::vector<LoopData>().swap(Loops);
+    std::vector<unsigned>().swap(LoopOf);
+    std::vector<bool>().swap(IsHeader);
+    std::vector<ScaledNumber>().swap(Mass);
   }
 
 public:
   /// getBlockFreq - Return block frequency. Return 0 if we don't have it.
   BlockFrequency getBlockFreq(const BlockT *BB) const {
-    typename DenseMap<const BlockT *, BlockFrequency>::const_iterator
-      I = Freqs.find(BB);
-    if (I != Freqs.end())
-      return I->second;
+    typename DenseMap<const BlockT *, unsigned>::const_iterator
+      I = Index.find(BB);
+    if (I != Index.end())
+      return Freqs[I->second];
     return 0;
   }
 
@@ -0,0 +1,154 @@
+//===- CounterProfile.h - Counter-based profile data ------------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares what the counter profiling instrumentation, the pass that
+// applies its profiles and the llvm-profdata tool have to agree on: which
+// edges of a function are counted, the structural hash that detects stale
+// profiles, and the indexed profile file.
+//
+// The indexed file is a sequence of little-endian 64-bit words:
+//
+//   Header:   Magic, Version, NumFunctions, NamesSize, NumCounters
+//   Index:    NumFunctions entries of
+//               NameOffset, NameSize, Hash, NumCounters, CounterOffset
+//             sorted by function name
+//   Names:    NamesSize bytes of function names, padded to a multiple of 8
+//   Counters: NumCounters counters; CounterOffset counts words, not bytes
+//
+// runtime/libprofile/CounterProfiling.c writes the same format.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_COUNTERPROFILE_H
+#define LLVM_ANALYSIS_COUNTERPROFILE_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/DataTypes.h"
+#include <map>
+#include <string>
+#include <vector>
+
+namespace llvm {
+
+class Function;
+class MemoryBuffer;
+class Module;
+class TerminatorInst;
+class raw_ostream;
+
+/// CounterProfileEdge - An edge counted by counter profiling: successor
+/// number second of the terminator first.
+typedef std::pair<TerminatorInst *, unsigned> CounterProfileEdge;
+
+/// getCounterProfileEdges - Collect the edges of F that counter profiling
+/// counts, in counter order: counter 0 counts the entries into F and counter
+/// i + 1 counts Edges[i].  Only the successors of conditional branches and
+/// switches are counted, as those are the terminators whose weights
+/// BranchProbabilityInfo reads.
+void getCounterProfileEdges(Function &F,
+                            SmallVectorImpl<CounterProfileEdge> &Edges);
+
+/// getCounterProfileHash - Return a hash of the shape of the CFG of F.  It is
+/// recorded with the counters of F, and a profile whose hash does not match
+/// the function it is applied to is ignored.
+uint64_t getCounterProfileHash(const Function &F);
+
+/// getCounterProfileName - Return the name the counters of F are recorded
+/// under.  Functions with local linkage are qualified with the module
+/// identifier so that statics from different modules do not collide.
+std::string getCounterProfileName(const Function &F);
+
+/// setFunctionEntryCount - Record that F was entered Count times in the
+/// profiled run, in the llvm.function_entry_counts named metadata.
+void setFunctionEntryCount(Function &F, uint64_t Count);
+
+/// getFunctionEntryCounts - Collect the entry counts recorded in M by
+/// setFunctionEntryCount.
+void getFunctionEntryCounts(const Module &M,
+                            DenseMap<const Function *, uint64_t> &Counts);
+
+/// CounterProfileRecord - The counters of one function.
+struct CounterProfileRecord {
+  std::string Name;
+  uint64_t Hash;
+  std::vector<uint64_t> Counts;
+
+  CounterProfileRecord() : Hash(0) {}
+};
+
+/// CounterProfileReader - Reads an indexed counter profile.  Looking a
+/// function up is a binary search of the index; nothing else is decoded
+/// until it is asked for.
+class CounterProfileReader {
+  OwningPtr<MemoryBuffer> Buffer;
+  uint64_t NumFunctions;
+  const char *Index;
+  const char *Names;
+  const char *Counters;
+
+  explicit CounterProfileReader(MemoryBuffer *Buffer);
+  bool parseHeader(std::string &ErrorMsg);
+  StringRef getName(uint64_t I) const;
+
+public:
+  ~CounterProfileReader();
+
+  /// create - Read the profile in Filename.  On error, return null and set
+  /// ErrorMsg.
+  static CounterProfileReader *create(StringRef Filename,
+                                      std::string &ErrorMsg);
+
+  /// create - Read the profile in Buffer, taking ownership of it.  On error,
+  /// return null and set ErrorMsg.
+  static CounterProfileReader *create(MemoryBuffer *Buffer,
+                                      std::string &ErrorMsg);
+
+  /// hasIndexedMagic - Return true if Buffer starts like an indexed profile.
+  static bool hasIndexedMagic(const MemoryBuffer &Buffer);
+
+  uint64_t getNumFunctions() const { return NumFunctions; }
+
+  /// getRecord - Read the I'th function of the profile in name order.
+  void getRecord(uint64_t I, CounterProfileRecord &Record) const;
+
+  /// findFunction - Read the hash and counters of the function called Name.
+  /// Return false if the profile has no such function.
+  bool findFunction(StringRef Name, uint64_t &Hash,
+                    std::vector<uint64_t> &Counts) const;
+};
+
+/// CounterProfileWriter - Accumulates function records, possibly from many
+/// profiled runs, and writes them as an indexed profile.
+class CounterProfileWriter {
+  std::map<std::string, CounterProfileRecord> Records;
+
+public:
+  typedef std::map<std::string, CounterProfileRecord>::const_iterator
+    const_iterator;
+
+  /// begin/end - Iterate over the records in name order.
+  const_iterator begin() const { return Records.begin(); }
+  const_iterator end() const { return Records.end(); }
+
+  /// addRecord - Add the counters of Record, summing them into an existing
+  /// record of the same function.  Return false, leaving the writer
+  /// unchanged, if the existing record has a different hash or number of
+  /// counters.
+  bool addRecord(const CounterProfileRecord &Record);
+
+  /// write - Write the indexed profile to OS, which must be binary.
+  void write(raw_ostream &OS) const;
+};
+
+} // End llvm namespace
+
+#endif
@@ -15,6 +15,7 @@
 #ifndef LLVM_ANALYSIS_DOMINATORS_H
 #define LLVM_ANALYSIS_DOMINATORS_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DepthFirstIterator.h"
 #include "llvm/ADT/GraphTraits.h"
@@ -197,6 +198,21 @@ class DominatorTreeBase : public DominatorBase<NodeT> {
     return IDom != 0;
   }
 
+public:
+  /// UpdateKind - Whether an edge was added to or removed from the CFG.
+  enum UpdateKind { Insert, Delete };
+
+  /// UpdateType - An edge that was added to or removed from the CFG, for
+  /// applyUpdates.
+  struct UpdateType {
+    UpdateKind Kind;
+    NodeT *From;
+    NodeT *To;
+
+    UpdateType(UpdateKind Kind, NodeT *From, NodeT *To)
+      : Kind(Kind), From(From), To(To) {}
+  };
+
 protected:
   typedef DenseMap<NodeT*, DomTreeNodeBase<NodeT>*> DomTreeNodeMapType;
   DomTreeNodeMapType DomTreeNodes;
@@ -296,6 +312,209 @@ protected:
     }
   }
 
+  // Find the nearest common dominator of two tree nodes, or null if it is the
+  // virtual root of a post dominator tree with several exits.
+  DomTreeNodeBase<NodeT> *findNearestCommonDominator(DomTreeNodeBase<NodeT> *A,
+                                                     DomTreeNodeBase<NodeT> *B) {
+    if (!A->getBlock() || !B->getBlock())
+      return 0;
+    return getNode(findNearestCommonDominator(A->getBlock(), B->getBlock()));
+  }
+
+  // Update the tree for the given CFG edge changes.  GraphT gives the edges
+  // the tree is built on (successors for dominators, predecessors for post
+  // dominators) and InvGraphT the reverse ones.  Blocks dominated by the
+  // nearest common dominator of the changed edges can only be entered through
+  // it, so their immediate dominators are recomputed on just that region, with
+  // the iterative algorithm of Cooper, Harvey and Kennedy.  Returns false if
+  // the whole tree must be recalculated instead.
+  template<class GraphT, class InvGraphT>
+  bool UpdateSubtree(ArrayRef<UpdateType> Updates) {
+    typedef typename GraphT::NodeType *NodePtr;
+    if (!RootNode)
+      return false;
+
+    // Blocks that become reachable through an inserted edge, in the direction
+    // of GraphT.
+    SmallVector<NodePtr, 8> NewBlocks;
+    SmallPtrSet<NodePtr, 8> IsNew;
+    DomTreeNodeBase<NodeT> *SubRoot = 0;
+    for (unsigned i = 0, e = Updates.size(); i != e; ++i) {
+      NodePtr Src = Updates[i].From, Dst = Updates[i].To;
+      if (this->IsPostDominators) {
+        std::swap(Src, Dst);
+        // A change to the set of exit blocks changes the roots.
+        for (unsigned j = 0; j != 2; ++j) {
+          NodePtr BB = j ? Updates[i].To : Updates[i].From;
+          bool IsExit = InvGraphT::child_begin(BB) == InvGraphT::child_end(BB);
+          bool IsRoot = std::find(this->Roots.begin(), this->Roots.end(), BB) !=
+                        this->Roots.end();
+          if (IsExit != IsRoot)
+            return false;
+        }
+      }
+
+      DomTreeNodeBase<NodeT> *SrcNode = getNode(Src);
+      if (!SrcNode)
+        continue;
+      DomTreeNodeBase<NodeT> *DstNode = getNode(Dst);
+      if (!DstNode) {
+        if (Updates[i].Kind == Delete)
+          continue;
+        // Everything newly reachable from Dst joins the region.
+        SmallVector<NodePtr, 8> Worklist(1, Dst);
+        while (!Worklist.empty()) {
+          NodePtr BB = Worklist.pop_back_val();
+          if (!IsNew.insert(BB))
+            continue;
+          NewBlocks.push_back(BB);
+          for (typename GraphT::ChildIteratorType SI = GraphT::child_begin(BB),
+               SE = GraphT::child_end(BB); SI != SE; ++SI) {
+            if (DomTreeNodeBase<NodeT> *SuccNode = getNode(*SI)) {
+              SubRoot = SubRoot ? findNearestCommonDominator(SubRoot, SuccNode)
+                                : SuccNode;
+              if (!SubRoot)
+                return false;
+            } else {
+              Worklist.push_back(*SI);
+            }
+          }
+        }
+        DstNode = SrcNode;
+      }
+
+      DomTreeNodeBase<NodeT> *NCD = findNearestCommonDominator(SrcNode,
+                                                               DstNode);
+      SubRoot = SubRoot && NCD ? findNearestCommonDominator(SubRoot, NCD) : NCD;
+      if (!SubRoot)
+        return false;
+    }
+    if (!SubRoot)
+      return true;
+
+    // New blocks start out as children of the region root.
+    for (unsigned i = 0, e = NewBlocks.size(); i != e; ++i)
+      DomTreeNodes[NewBlocks[i]] =
+        SubRoot->addChild(new DomTreeNodeBase<NodeT>(NewBlocks[i], SubRoot));
+
+    SmallVector<NodePtr, 32> Order;
+    DenseMap<NodePtr, unsigned> Number;
+    SmallPtrSet<NodePtr, 32> InRegion;
+    for (;;) {
+      if (!SubRoot->getBlock())
+        return false;
+
+      // Collect the blocks currently dominated by SubRoot.
+      InRegion.clear();
+      SmallVector<DomTreeNodeBase<NodeT>*, 32> Worklist(1, SubRoot);
+      while (!Worklist.empty()) {
+        DomTreeNodeBase<NodeT> *N = Worklist.pop_back_val();
+        InRegion.insert(N->getBlock());
+        Worklist.append(N->begin(), N->end());
+      }
+
+      // Number the blocks reachable from SubRoot within the region in reverse
+      // post order.
+      Order.clear();
+      Number.clear();
+      SmallVector<std::pair<NodePtr, typename GraphT::ChildIteratorType>, 32>
+        Stack;
+      NodePtr RootBB = SubRoot->getBlock();
+      Number[RootBB] = 0;
+      Stack.push_back(std::make_pair(RootBB, GraphT::child_begin(RootBB)));
+      while (!Stack.empty()) {
+        NodePtr BB = Stack.back().first;
+        if (Stack.back().second == GraphT::child_end(BB)) {
+          Order.push_back(BB);
+          Stack.pop_back();
+          continue;
+        }
+        NodePtr Succ = *Stack.back().second++;
+        if (InRegion.count(Succ) && Number.insert(std::make_pair(Succ, 0)).second)
+          Stack.push_back(std::make_pair(Succ, GraphT::child_begin(Succ)));
+      }
+      std::reverse(Order.begin(), Order.end());
+      for (unsigned i = 0, e = Order.size(); i != e; ++i)
+        Number[Order[i]] = i;
+
+      // Blocks of the region that are no longer reachable may have been the
+      // only way into blocks outside it.  Widen the region to cover those.
+      DomTreeNodeBase<NodeT> *Wider = SubRoot;
+      for (typename SmallPtrSet<NodePtr, 32>::iterator I = InRegion.begin(),
+           E = InRegion.end(); I != E && Wider; ++I) {
+        if (Number.count(*I))
+          continue;
+        for (typename GraphT::ChildIteratorType SI = GraphT::child_begin(*I),
+             SE = GraphT::child_end(*I); SI != SE && Wider; ++SI)
+          if (!InRegion.count(*SI))
+            if (DomTreeNodeBase<NodeT> *SuccNode = getNode(*SI)) {
+              DomTreeNodeBase<NodeT> *SuccIDom = SuccNode->getIDom();
+              Wider = SuccIDom ? findNearestCommonDominator(Wider, SuccIDom) : 0;
+            }
+      }
+      if (!Wider)
+        return false;
+      if (Wider == SubRoot)
+        break;
+      SubRoot = Wider;
+    }
+
+    // Compute the immediate dominators, as indices into Order.
+    const unsigned Undef = ~0U;
+    std::vector<unsigned> IDom(Order.size(), Undef);
+    IDom[0] = 0;
+    bool Changed = true;
+    while (Changed) {
+      Changed = false;
+      for (unsigned i = 1, e = Order.size(); i != e; ++i) {
+        unsigned NewIDom = Undef;
+        for (typename InvGraphT::ChildIteratorType PI =
+             InvGraphT::child_begin(Order[i]),
+             PE = InvGraphT::child_end(Order[i]); PI != PE; ++PI) {
+          typename DenseMap<NodePtr, unsigned>::iterator It = Number.find(*PI);
+          if (It == Number.end() || IDom[It->second] == Undef)
+            continue;
+          unsigned P = It->second;
+          if (NewIDom == Undef) {
+            NewIDom = P;
+            continue;
+          }
+          while (P != NewIDom) {
+            while (P > NewIDom) P = IDom[P];
+            while (NewIDom > P) NewIDom = IDom[NewIDom];
+          }
+        }
+        if (IDom[i] != NewIDom) {
+          IDom[i] = NewIDom;
+          Changed = true;
+        }
+      }
+    }
+
+    for (unsigned i = 1, e = Order.size(); i != e; ++i)
+      getNode(Order[i])->setIDom(getNode(Order[IDom[i]]));
+
+    // Whatever is left in the region is unreachable now.
+    SmallVector<DomTreeNodeBase<NodeT>*, 8> Dead;
+    for (typename SmallPtrSet<NodePtr, 32>::iterator I = InRegion.begin(),
+         E = InRegion.end(); I != E; ++I)
+      if (!Number.count(*I))
+        Dead.push_back(getNode(*I));
+    for (unsigned i = 0, e = Dead.size(); i != e; ++i) {
+      DomTreeNodeBase<NodeT> *IDomNode = Dead[i]->getIDom();
+      if (Number.count(IDomNode->getBlock()))
+        IDomNode->Children.erase(std::find(IDomNode->Children.begin(),
+                                           IDomNode->Children.end(), Dead[i]));
+    }
+    for (unsigned i = 0, e = Dead.size(); i != e; ++i) {
+      DomTreeNodes.erase(Dead[i]->getBlock());
+      delete Dead[i];
+    }
+
+    DFSInfoValid = false;
+    return true;
+  }
+
 public:
   explicit DominatorTreeBase(bool isPostDom)
     : DominatorBase<NodeT>(isPostDom), DFSInfoValid(false), SlowQueries(0) {}
@@ -541,6 +760,36 @@ public:
       this->Split<NodeT*, GraphTraits<NodeT*> >(*this, NewBB);
   }
 
+  /// insertEdge - Update the tree after the edge From->To was added to the
+  /// CFG.  To may be a new block that is not in the tree yet.
+  void insertEdge(NodeT *From, NodeT *To) {
+    applyUpdates(UpdateType(Insert, From, To));
+  }
+
+  /// deleteEdge - Update the tree after the last edge From->To was removed
+  /// from the CFG.  Blocks that become unreachable are removed from the tree.
+  void deleteEdge(NodeT *From, NodeT *To) {
+    applyUpdates(UpdateType(Delete, From, To));
+  }
+
+  /// applyUpdates - Update the tree after all of the given edges were added
+  /// to or removed from the CFG, which must already be in its final form.
+  /// Only the subtree of the nearest common dominator of the changed edges is
+  /// recomputed, so a batch of nearby changes costs about as much as one.
+  void applyUpdates(ArrayRef<UpdateType> Updates) {
+    if (Updates.empty())
+      return;
+    bool Done;
+    if (this->IsPostDominators)
+      Done = this->UpdateSubtree<GraphTraits<Inverse<NodeT*> >,
+                                 GraphTraits<NodeT*> >(Updates);
+    else
+      Done = this->UpdateSubtree<GraphTraits<NodeT*>,
+                                 GraphTraits<Inverse<NodeT*> > >(Updates);
+    if (!Done)
+      recalculate(*Updates[0].From->getParent());
+  }
+
   /// print - Convert to human readable form
   ///
   void print(raw_ostream &o) const {
@@ -774,6 +1023,10 @@ public:
 
   virtual void verifyAnalysis() const;
 
+  /// verifyDomTree - Abort with a description of the difference if the tree
+  /// does not match one computed from scratch.
+  void verifyDomTree() const;
+
   virtual void getAnalysisUsage(AnalysisUsage &AU) const {
     AU.setPreservesAll();
   }
@@ -856,6 +1109,29 @@ public:
     DT->splitBlock(NewBB);
   }
 
+  typedef DominatorTreeBase<BasicBlock>::UpdateType UpdateType;
+  static const DominatorTreeBase<BasicBlock>::UpdateKind Insert =
+    DominatorTreeBase<BasicBlock>::Insert;
+  static const DominatorTreeBase<BasicBlock>::UpdateKind Delete =
+    DominatorTreeBase<BasicBlock>::Delete;
+
+  /// insertEdge - Update the tree after the edge From->To was added to the
+  /// CFG.  To may be a new block.
+  void insertEdge(BasicBlock *From, BasicBlock *To) {
+    applyUpdates(UpdateType(Insert, From, To));
+  }
+
+  /// deleteEdge - Update the tree after the last edge From->To was removed
+  /// from the CFG.
+  void deleteEdge(BasicBlock *From, BasicBlock *To) {
+    applyUpdates(UpdateType(Delete, From, To));
+  }
+
+  /// applyUpdates - Update the tree after the given edges were added to or
+  /// removed from the CFG.  With -verify-dom-updates, the result is checked
+  /// against a tree computed from scratch.
+  void applyUpdates(ArrayRef<UpdateType> Updates);
+
   bool isReachableFromEntry(const BasicBlock* A) const {
     return DT->isReachableFromEntry(A);
   }
@@ -23,6 +23,7 @@ namespace llvm {
 class CallSite;
 class DataLayout;
 class Function;
+class InlineCostCache;
 class TargetTransformInfo;
 
 namespace InlineConstants {
@@ -103,6 +104,12 @@ class InlineCostAnalysis : public CallGraphSCCPass {
   const DataLayout *TD;
   const TargetTransformInfo *TTI;
 
+  /// \brief Results of analyzing callee bodies that can be shared between
+  /// call sites. This lives until the SCC walk is finished; functions in the
+  /// SCC being visited are never cached, as the inliner may still change
+  /// them.
+  InlineCostCache *Cache;
+
 public:
   static char ID;
 
@@ -112,6 +119,8 @@ public:
   // Pass interface implementation.
   void getAnalysisUsage(AnalysisUsage &AU) const;
   bool runOnSCC(CallGraphSCC &SCC);
+  using llvm::Pass::doFinalization;
+  bool doFinalization(CallGraph &CG);
 
   /// \brief Get an InlineCost object representing the cost of inlining this
   /// callsite.
@@ -0,0 +1,329 @@
+//===- llvm/Analysis/MemorySSA.h - SSA form for memory ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines the MemorySSA analysis, which puts the memory operations
+// of a function into SSA form.  Every instruction that may write memory gets a
+// MemoryDef, every instruction that only reads memory gets a MemoryUse, and
+// blocks where different memory states merge get a MemoryPhi.  Each use or
+// def points at the access that defines the memory state it sees, so
+// memory is one variable with one SSA name per def:
+//
+//   store i32 0, i32* %a       ; 1 = MemoryDef(liveOnEntry)
+//   store i32 1, i32* %b       ; 2 = MemoryDef(1)
+//   %x = load i32* %a          ; MemoryUse(2)
+//
+// The chain above is conservative: %x does not really depend on the store to
+// %b.  The MemorySSAWalker skips such defs using alias analysis to find the
+// access that actually clobbers a load or store (1 above), and caches what it
+// finds.  Unlike MemoryDependenceAnalysis, the form is built once for the
+// whole function, so a query does not rescan instructions or blocks.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_ANALYSIS_MEMORYSSA_H
+#define LLVM_ANALYSIS_MEMORYSSA_H
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Analysis/AliasAnalysis.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/ValueHandle.h"
+#include <vector>
+
+namespace llvm {
+
+class BasicBlock;
+class DominatorTree;
+class Function;
+class Instruction;
+class MemorySSA;
+class MemorySSAWalker;
+class raw_ostream;
+
+/// MemoryAccess - The common base of the nodes of MemorySSA.
+class MemoryAccess {
+public:
+  enum AccessKind {
+    LiveOnEntryKind,
+    UseKind,
+    DefKind,
+    PhiKind
+  };
+
+  AccessKind getKind() const { return Kind; }
+
+  /// getBlock - Return the block this access is in.  The live-on-entry def
+  /// is in the entry block.
+  BasicBlock *getBlock() const { return Block; }
+
+  /// getID - Return the number that names the memory state defined by a def
+  /// or phi, as printed.  Defs and phis are numbered in program order when
+  /// the form is built; uses have no number of their own.
+  unsigned getID() const { return ID; }
+
+  /// users - The uses, defs and phis that read the memory state this access
+  /// defines.
+  typedef SmallVectorImpl<MemoryAccess*>::const_iterator user_iterator;
+  user_iterator user_begin() const { return Users.begin(); }
+  user_iterator user_end() const { return Users.end(); }
+  bool user_empty() const { return Users.empty(); }
+
+  void print(raw_ostream &OS) const;
+  void dump() const;
+
+protected:
+  friend class MemorySSA;
+
+  MemoryAccess(AccessKind K, BasicBlock *BB, unsigned ID)
+    : Kind(K), Block(BB), ID(ID), Order(0) {}
+  virtual ~MemoryAccess();
+
+  void addUser(MemoryAccess *U) { Users.push_back(U); }
+  void removeUser(MemoryAccess *U);
+
+private:
+  MemoryAccess(const MemoryAccess &) LLVM_DELETED_FUNCTION;
+  void operator=(const MemoryAccess &) LLVM_DELETED_FUNCTION;
+
+  AccessKind Kind;
+  BasicBlock *Block;
+  unsigned ID;
+
+  /// Order - The index of this access in the access list of its block, used
+  /// for dominance queries within a block.
+  unsigned Order;
+
+  SmallVector<MemoryAccess*, 4> Users;
+};
+
+/// MemoryUseOrDef - An access for an instruction: a MemoryUse or MemoryDef.
+class MemoryUseOrDef : public MemoryAccess {
+public:
+  /// getMemoryInst - Return the instruction this access is for.
+  Instruction *getMemoryInst() const { return MemoryInst; }
+
+  /// getDefiningAccess - Return the access that defines the memory state this
+  /// instruction sees, which is the nearest dominating def or phi.
+  MemoryAccess *getDefiningAccess() const { return DefiningAccess; }
+
+  static inline bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == UseKind || MA->getKind() == DefKind;
+  }
+
+protected:
+  friend class MemorySSA;
+
+  MemoryUseOrDef(AccessKind K, Instruction *I, BasicBlock *BB, unsigned ID)
+    : MemoryAccess(K, BB, ID), MemoryInst(I), DefiningAccess(0) {}
+
+private:
+  Instruction *MemoryInst;
+  MemoryAccess *DefiningAccess;
+};
+
+/// MemoryUse - An instruction that reads memory but does not change it.
+class MemoryUse : public MemoryUseOrDef {
+public:
+  static inline bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == UseKind;
+  }
+
+private:
+  friend class MemorySSA;
+
+  MemoryUse(Instruction *I, BasicBlock *BB)
+    : MemoryUseOrDef(UseKind, I, BB, 0) {}
+};
+
+/// MemoryDef - An instruction that may change memory.  Stores, calls that may
+/// write, fences, atomics and ordered loads are all defs.
+class MemoryDef : public MemoryUseOrDef {
+public:
+  static inline bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == DefKind;
+  }
+
+private:
+  friend class MemorySSA;
+
+  MemoryDef(Instruction *I, BasicBlock *BB)
+    : MemoryUseOrDef(DefKind, I, BB, 0) {}
+};
+
+/// MemoryPhi - Merges the memory states reaching a block from its
+/// predecessors.
+class MemoryPhi : public MemoryAccess {
+public:
+  unsigned getNumIncomingValues() const { return Incoming.size(); }
+  MemoryAccess *getIncomingValue(unsigned i) const {
+    return Incoming[i].first;
+  }
+  BasicBlock *getIncomingBlock(unsigned i) const {
+    return Incoming[i].second;
+  }
+
+  static inline bool classof(const MemoryAccess *MA) {
+    return MA->getKind() == PhiKind;
+  }
+
+private:
+  friend class MemorySSA;
+
+  explicit MemoryPhi(BasicBlock *BB) : MemoryAccess(PhiKind, BB, 0) {}
+
+  SmallVector<std::pair<MemoryAccess*, BasicBlock*>, 4> Incoming;
+};
+
+/// MemorySSA - Builds and owns the memory SSA form of a function.  Clients
+/// that delete memory instructions while keeping the analysis alive must call
+/// removeInstruction first.  Instructions created after the analysis was
+/// built have no access; getMemoryAccess returns null for them.
+class MemorySSA : public FunctionPass {
+public:
+  static char ID;
+  MemorySSA();
+  ~MemorySSA();
+
+  /// getMemoryAccess - Return the use or def for I, or null if I does not
+  /// access memory (or was created after the analysis ran).
+  MemoryUseOrDef *getMemoryAccess(const Instruction *I) const {
+    return InstructionAccesses.lookup(I);
+  }
+
+  /// getMemoryAccess - Return the phi at the start of BB, if there is one.
+  MemoryPhi *getMemoryAccess(const BasicBlock *BB) const {
+    return BlockPhis.lookup(BB);
+  }
+
+  /// getLiveOnEntryDef - Return the def of the memory state on entry to the
+  /// function, which every chain of defining accesses ends in.
+  MemoryAccess *getLiveOnEntryDef() const { return LiveOnEntry; }
+  bool isLiveOnEntryDef(const MemoryAccess *MA) const {
+    return MA == LiveOnEntry;
+  }
+
+  /// dominates - Return true if the memory state defined by A is available
+  /// at B, i.e. A comes before B on every path to B.  An access dominates
+  /// itself.
+  bool dominates(const MemoryAccess *A, const MemoryAccess *B) const;
+
+  /// getWalker - Return the walker that finds the accesses that actually
+  /// clobber an instruction.
+  MemorySSAWalker *getWalker() const { return Walker.get(); }
+
+  /// removeInstruction - Forget the access of I, which is about to be
+  /// deleted.  Anything that read the memory state defined by I reads the
+  /// state I read instead.
+  void removeInstruction(Instruction *I);
+
+  /// moveUseToBlockEnd - Record that the instruction of MU was moved to the
+  /// end of BB, just before its terminator, and reads the memory state defined
+  /// by NewDef there.  NewDef must dominate the end of BB and nothing between
+  /// NewDef and the end of BB may clobber what MU reads, as is the case when
+  /// NewDef is the clobbering access of a load hoisted out of a loop.
+  void moveUseToBlockEnd(MemoryUse *MU, BasicBlock *BB, MemoryAccess *NewDef);
+
+  /// recalculate - Rebuild the form from scratch after changes that the
+  /// update methods above cannot describe.  Invalidates all accesses.
+  void recalculate();
+
+  /// verify - Check that every defining access dominates its users.  Aborts
+  /// with a message describing the first problem found.
+  void verify() const;
+
+  virtual bool runOnFunction(Function &F);
+  virtual void releaseMemory();
+  virtual void getAnalysisUsage(AnalysisUsage &AU) const;
+  virtual void print(raw_ostream &OS, const Module *M) const;
+
+private:
+  friend class MemorySSAWalker;
+
+  void buildMemorySSA(Function &F);
+  void placePhis(Function &F, const SmallVectorImpl<BasicBlock*> &DefBlocks);
+  void renamePass(Function &F);
+  MemoryAccess *renameBlock(BasicBlock *BB, MemoryAccess *Incoming);
+  void linkDefiningAccess(MemoryUseOrDef *MA, MemoryAccess *Def);
+  void renumberBlock(const BasicBlock *BB);
+
+  AliasAnalysis *AA;
+  DominatorTree *DT;
+  Function *CurFn;
+
+  /// Accesses - Every access this analysis owns.
+  std::vector<MemoryAccess*> Accesses;
+
+  /// BlockAccesses - The accesses of each block in order, phi first.  Slots
+  /// of removed accesses are null until the block is renumbered.
+  DenseMap<const BasicBlock*, std::vector<MemoryAccess*> > BlockAccesses;
+  DenseMap<const Instruction*, MemoryUseOrDef*> InstructionAccesses;
+  DenseMap<const BasicBlock*, MemoryPhi*> BlockPhis;
+
+  MemoryAccess *LiveOnEntry;
+  unsigned NextID;
+  OwningPtr<MemorySSAWalker> Walker;
+};
+
+/// MemorySSAWalker - Finds the access that clobbers a load or store: the
+/// nearest def or phi above it that may write the location, skipping defs
+/// that alias analysis proves do not.  Results are cached per starting access
+/// and location, so repeated queries along a chain are cheap.
+class MemorySSAWalker {
+public:
+  MemorySSAWalker(MemorySSA &MSSA, AliasAnalysis &AA);
+  ~MemorySSAWalker();
+
+  /// getClobberingMemoryAccess - Return the access that clobbers the memory
+  /// I reads or writes.  For a load this is the nearest def that may change
+  /// the loaded location; for a store it is the nearest def that may change
+  /// the stored location before the store.  For other instructions it is
+  /// their defining access.  Returns null if I has no access.
+  MemoryAccess *getClobberingMemoryAccess(const Instruction *I);
+
+  /// getClobberingMemoryAccess - Return the nearest access at or above Start
+  /// that may clobber Loc.
+  MemoryAccess *getClobberingMemoryAccess(MemoryAccess *Start,
+                                          const AliasAnalysis::Location &Loc);
+
+  /// invalidateInfo - Drop cached results, after the form changed.
+  void invalidateInfo() {
+    Cache.clear();
+    CachePointers.clear();
+  }
+
+private:
+  typedef std::pair<const MemoryAccess*, AliasAnalysis::Location> CacheKey;
+
+  /// PointerVH - Drops the cached results when a pointer they are keyed on is
+  /// deleted, so that they are not found for a new value that happens to be
+  /// allocated at the same address.
+  class PointerVH : public CallbackVH {
+    MemorySSAWalker *Walker;
+    virtual void deleted();
+  public:
+    PointerVH(const Value *V, MemorySSAWalker *Walker)
+      : CallbackVH(const_cast<Value*>(V)), Walker(Walker) {}
+  };
+
+  MemoryAccess *walk(MemoryAccess *Start, const AliasAnalysis::Location &Loc,
+                     SmallVectorImpl<const MemoryPhi*> &PhiStack,
+                     unsigned &Budget, unsigned &LowestPhiSeen);
+
+  MemorySSA &MSSA;
+  AliasAnalysis &AA;
+  DenseMap<CacheKey, MemoryAccess*> Cache;
+
+  /// CachePointers - A handle on the pointer of each location in Cache.
+  DenseMap<const Value*, PointerVH> CachePointers;
+};
+
+} // End llvm namespace
+
+#endif
@@ -74,6 +74,22 @@ struct PostDominatorTree : public FunctionPass {
     return DT->findNearestCommonDominator(A, B);
   }
 
+  typedef DominatorTreeBase<BasicBlock>::UpdateType UpdateType;
+
+  /// applyUpdates - Update the tree after the given edges were added to or
+  /// removed from the CFG.  See DominatorTreeBase::applyUpdates.
+  void applyUpdates(ArrayRef<UpdateType> Updates) {
+    DT->applyUpdates(Updates);
+  }
+
+  void insertEdge(BasicBlock *From, BasicBlock *To) {
+    DT->insertEdge(From, To);
+  }
+
+  void deleteEdge(BasicBlock *From, BasicBlock *To) {
+    DT->deleteEdge(From, To);
+  }
+
   virtual void releaseMemory() {
     DT->releaseMemory();
   }
@@ -23,6 +23,7 @@
 
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/FoldingSet.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/IR/Function.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/Operator.h"
@@ -359,13 +360,22 @@ namespace llvm {
 
     /// ValuesAtScopes - This map contains entries for all the expressions
     /// that we attempt to compute getSCEVAtScope information for, which can
-    /// be expensive in extreme cases.
+    /// be expensive in extreme cases.  An expression is rarely asked about in
+    /// more than a couple of loops, so each keeps a short list.
     DenseMap<const SCEV *,
-             std::map<const Loop *, const SCEV *> > ValuesAtScopes;
+             SmallVector<std::pair<const Loop *, const SCEV *>, 2> >
+      ValuesAtScopes;
 
     /// LoopDispositions - Memoized computeLoopDisposition results.
     DenseMap<const SCEV *,
-             std::map<const Loop *, LoopDisposition> > LoopDispositions;
+             SmallVector<std::pair<const Loop *, LoopDisposition>, 2> >
+      LoopDispositions;
+
+    /// LoopCacheUsers - For each loop, the expressions that have an entry for
+    /// it in ValuesAtScopes or LoopDispositions, so that forgetLoop can drop
+    /// those entries without scanning the whole cache.  forgetMemoizedResults
+    /// keeps it in step with the two caches.
+    DenseMap<const Loop *, SmallPtrSet<const SCEV *, 4> > LoopCacheUsers;
 
     /// computeLoopDisposition - Compute a LoopDisposition value.
     LoopDisposition computeLoopDisposition(const SCEV *S, const Loop *L);
@@ -545,6 +555,16 @@ namespace llvm {
     /// forgetMemoizedResults - Drop memoized information computed for S.
     void forgetMemoizedResults(const SCEV *S);
 
+    /// forgetLoopCacheUser - Remove S from the LoopCacheUsers entry of L.
+    void forgetLoopCacheUser(const Loop *L, const SCEV *S);
+
+    /// getOrCreateAddExpr, getOrCreateMulExpr - Return the unique add or
+    /// multiply node with exactly the operands Ops, without simplifying.
+    const SCEV *getOrCreateAddExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                   SCEV::NoWrapFlags Flags);
+    const SCEV *getOrCreateMulExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                   SCEV::NoWrapFlags Flags);
+
   public:
     static char ID; // Pass identification, replacement for typeid
     ScalarEvolution();
@@ -578,40 +598,48 @@ namespace llvm {
     const SCEV *getZeroExtendExpr(const SCEV *Op, Type *Ty);
     const SCEV *getSignExtendExpr(const SCEV *Op, Type *Ty);
     const SCEV *getAnyExtendExpr(const SCEV *Op, Type *Ty);
+    /// getAddExpr, getMulExpr - Depth is the nesting of the simplifications
+    /// that led to this call.  Beyond -scalar-evolution-max-arith-depth the
+    /// operands are only sorted and their constants folded.
     const SCEV *getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
-                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap);
+                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap,
+                           unsigned Depth = 0);
     const SCEV *getAddExpr(const SCEV *LHS, const SCEV *RHS,
-                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap) {
+                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap,
+                           unsigned Depth = 0) {
       SmallVector<const SCEV *, 2> Ops;
       Ops.push_back(LHS);
       Ops.push_back(RHS);
-      return getAddExpr(Ops, Flags);
+      return getAddExpr(Ops, Flags, Depth);
     }
     const SCEV *getAddExpr(const SCEV *Op0, const SCEV *Op1, const SCEV *Op2,
-                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap) {
+                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap,
+                           unsigned Depth = 0) {
       SmallVector<const SCEV *, 3> Ops;
       Ops.push_back(Op0);
       Ops.push_back(Op1);
       Ops.push_back(Op2);
-      return getAddExpr(Ops, Flags);
+      return getAddExpr(Ops, Flags, Depth);
     }
     const SCEV *getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
-                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap);
+                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap,
+                           unsigned Depth = 0);
     const SCEV *getMulExpr(const SCEV *LHS, const SCEV *RHS,
-                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap)
-    {
+                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap,
+                           unsigned Depth = 0) {
       SmallVector<const SCEV *, 2> Ops;
       Ops.push_back(LHS);
       Ops.push_back(RHS);
-      return getMulExpr(Ops, Flags);
+      return getMulExpr(Ops, Flags, Depth);
     }
     const SCEV *getMulExpr(const SCEV *Op0, const SCEV *Op1, const SCEV *Op2,
-                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap) {
+                           SCEV::NoWrapFlags Flags = SCEV::FlagAnyWrap,
+                           unsigned Depth = 0) {
       SmallVector<const SCEV *, 3> Ops;
       Ops.push_back(Op0);
       Ops.push_back(Op1);
       Ops.push_back(Op2);
-      return getMulExpr(Ops, Flags);
+      return getMulExpr(Ops, Flags, Depth);
     }
     const SCEV *getUDivExpr(const SCEV *LHS, const SCEV *RHS);
     const SCEV *getAddRecExpr(const SCEV *Start, const SCEV *Step,
@@ -791,6 +819,11 @@ namespace llvm {
     /// disconnect it from a def-use chain linking it to a loop.
     void forgetValue(Value *V);
 
+    /// getNumLoopCacheUsers - Return the number of expressions that have a
+    /// cached scope value or loop disposition for L.  Used by the unit tests
+    /// to check that the caches are pruned.
+    unsigned getNumLoopCacheUsers(const Loop *L) const;
+
     /// GetMinTrailingZeros - Determine the minimum number of zero bits that S
     /// is guaranteed to end in (at every loop iteration).  It is, at the same
     /// time, the minimum number of times S is divisible by 2.  For example,
@@ -19,6 +19,7 @@
 #define LLVM_BITCODE_BITCODES_H
 
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/Atomic.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/ErrorHandling.h"
 #include <cassert>
@@ -161,15 +162,19 @@ template <> struct isPodLike<BitCodeAbbrevOp> { static const bool value=true; };
 /// BitCodeAbbrev - This class represents an abbreviation record.  An
 /// abbreviation allows a complex record that has redundancy to be stored in a
 /// specialized format instead of the fully-general, fully-vbr, format.
+///
+/// Abbreviations from the BLOCKINFO block are shared by every cursor reading
+/// the stream, and cursors may live on different threads, so the reference
+/// count is maintained atomically.
 class BitCodeAbbrev {
   SmallVector<BitCodeAbbrevOp, 32> OperandList;
-  unsigned char RefCount; // Number of things using this.
+  volatile sys::cas_flag RefCount; // Number of things using this.
   ~BitCodeAbbrev() {}
 public:
   BitCodeAbbrev() : RefCount(1) {}
 
-  void addRef() { ++RefCount; }
-  void dropRef() { if (--RefCount == 0) delete this; }
+  void addRef() { sys::AtomicIncrement(&RefCount); }
+  void dropRef() { if (sys::AtomicDecrement(&RefCount) == 0) delete this; }
 
   unsigned getNumOperandInfos() const {
     return static_cast<unsigned>(OperandList.size());
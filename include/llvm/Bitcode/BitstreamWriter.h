@@ -18,6 +18,7 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Bitcode/BitCodes.h"
+#include "llvm/Support/raw_ostream.h"
 #include <vector>
 
 namespace llvm {
@@ -25,6 +26,20 @@ namespace llvm {
 class BitstreamWriter {
   SmallVectorImpl<char> &Out;
 
+  /// FS - If non-null, the file the output goes to.  Out then only holds the
+  /// output that has not been written to FS yet, and is flushed once it grows
+  /// past FlushThreshold bytes.  Earlier output is backpatched by seeking.
+  raw_fd_ostream *FS;
+
+  /// FlushThreshold - How large Out may grow before it is written to FS.
+  size_t FlushThreshold;
+
+  /// FSStartOffset - The position in FS where the output starts.
+  uint64_t FSStartOffset;
+
+  /// FlushedBytes - The number of bytes of output already written to FS.
+  uint64_t FlushedBytes;
+
   /// CurBit - Always between 0 and 31 inclusive, specifies the next bit to use.
   unsigned CurBit;
 
@@ -62,7 +77,21 @@ class BitstreamWriter {
 
   // BackpatchWord - Backpatch a 32-bit word in the output with the specified
   // value.
-  void BackpatchWord(unsigned ByteNo, unsigned NewWord) {
+  void BackpatchWord(uint64_t ByteNo, unsigned NewWord) {
+    if (ByteNo < FlushedBytes) {
+      // The word has already been written out; overwrite it in the file.
+      assert(ByteNo + 4 <= FlushedBytes && "Word straddles a flush!");
+      char Bytes[4] = {
+        (char)(NewWord >>  0),
+        (char)(NewWord >>  8),
+        (char)(NewWord >> 16),
+        (char)(NewWord >> 24) };
+      FS->seek(FSStartOffset + ByteNo);
+      FS->write(Bytes, 4);
+      FS->seek(FSStartOffset + FlushedBytes);
+      return;
+    }
+    ByteNo -= FlushedBytes;
     Out[ByteNo++] = (unsigned char)(NewWord >>  0);
     Out[ByteNo++] = (unsigned char)(NewWord >>  8);
     Out[ByteNo++] = (unsigned char)(NewWord >> 16);
@@ -82,24 +111,37 @@ class BitstreamWriter {
     Out.append(&Bytes[0], &Bytes[4]);
   }
 
-  unsigned GetBufferOffset() const {
-    return Out.size();
+  uint64_t GetBufferOffset() const {
+    return FlushedBytes + Out.size();
   }
 
   unsigned GetWordIndex() const {
-    unsigned Offset = GetBufferOffset();
+    uint64_t Offset = GetBufferOffset();
     assert((Offset & 3) == 0 && "Not 32-bit aligned");
     return Offset / 4;
   }
 
 public:
-  explicit BitstreamWriter(SmallVectorImpl<char> &O)
-    : Out(O), CurBit(0), CurValue(0), CurCodeSize(2) {}
+  /// \brief Create a writer that appends its output to \p O.
+  ///
+  /// If \p FS is given, the output is written to it as it is produced, in
+  /// chunks of about \p FlushThreshold bytes, and \p O only buffers the part
+  /// that has not been written yet.  \p FS must support seeking so that block
+  /// sizes can be filled in once the blocks are complete.
+  explicit BitstreamWriter(SmallVectorImpl<char> &O, raw_fd_ostream *FS = 0,
+                           size_t FlushThreshold = 1 << 20)
+    : Out(O), FS(FS), FlushThreshold(FlushThreshold),
+      FSStartOffset(FS ? FS->tell() : 0), FlushedBytes(0), CurBit(0),
+      CurValue(0), CurCodeSize(2) {
+    assert((!FS || O.empty()) && "Buffer must start out empty!");
+  }
 
   ~BitstreamWriter() {
     assert(CurBit == 0 && "Unflused data remaining");
     assert(BlockScope.empty() && CurAbbrevs.empty() && "Block imbalance");
 
+    FlushToFile();
+
     // Free the BlockInfoRecords.
     while (!BlockInfoRecords.empty()) {
       BlockInfo &Info = BlockInfoRecords.back();
@@ -114,6 +156,38 @@ public:
   /// \brief Retrieve the current position in the stream, in bits.
   uint64_t GetCurrentBitNo() const { return GetBufferOffset() * 8 + CurBit; }
 
+  /// \brief Retrieve the width of abbreviation IDs in the current block.
+  unsigned GetAbbrevIDWidth() const { return CurCodeSize; }
+
+  /// \brief Overwrite a 32-bit field that was emitted earlier at bit position
+  /// \p BitNo.  The field must already have been flushed to the output buffer,
+  /// and must be word aligned if it may have been written to the file.
+  void BackpatchWordAtBit(uint64_t BitNo, uint32_t NewWord) {
+    assert(BitNo + 32 <= GetBufferOffset() * 8 && "Field not yet written!");
+    if (BitNo % 32 == 0)
+      return BackpatchWord(BitNo / 8, NewWord);
+
+    assert(BitNo >= FlushedBytes * 8 && "Unaligned field already written!");
+    BitNo -= FlushedBytes * 8;
+    for (unsigned i = 0; i != 32; ++i, ++BitNo) {
+      unsigned char &Byte = (unsigned char &)Out[BitNo / 8];
+      unsigned char Mask = 1 << (BitNo % 8);
+      if (NewWord & (1U << i))
+        Byte |= Mask;
+      else
+        Byte &= ~Mask;
+    }
+  }
+
+  /// \brief Write the buffered output to the file, if there is one.
+  void FlushToFile() {
+    if (!FS || Out.empty())
+      return;
+    FS->write(Out.data(), Out.size());
+    FlushedBytes += Out.size();
+    Out.clear();
+  }
+
   //===--------------------------------------------------------------------===//
   // Basic Primitives for emitting bits to the stream.
   //===--------------------------------------------------------------------===//
@@ -256,7 +330,7 @@ public:
 
     // Compute the size of the block, in words, not counting the size field.
     unsigned SizeInWords = GetWordIndex() - B.StartSizeWord - 1;
-    unsigned ByteNo = B.StartSizeWord*4;
+    uint64_t ByteNo = uint64_t(B.StartSizeWord)*4;
 
     // Update the block size field in the header of this sub-block.
     BackpatchWord(ByteNo, SizeInWords);
@@ -265,6 +339,32 @@ public:
     CurCodeSize = B.PrevCodeSize;
     BlockScope.back().PrevAbbrevs.swap(CurAbbrevs);
     BlockScope.pop_back();
+
+    if (FS && Out.size() >= FlushThreshold)
+      FlushToFile();
+  }
+
+  /// \brief Emit a complete block that was encoded separately.
+  ///
+  /// \p Contents is the output of another writer with the same BLOCKINFO
+  /// for a block with ID \p BlockID and abbrev width \p CodeLen, from its
+  /// size word through its END_BLOCK.  When writing to a file, it is written
+  /// there directly rather than copied into the buffer.
+  void EmitEncodedBlock(unsigned BlockID, unsigned CodeLen,
+                        StringRef Contents) {
+    assert((Contents.size() & 3) == 0 && "Block is not whole words!");
+    EmitCode(bitc::ENTER_SUBBLOCK);
+    EmitVBR(BlockID, bitc::BlockIDWidth);
+    EmitVBR(CodeLen, bitc::CodeLenWidth);
+    FlushToWord();
+
+    if (FS) {
+      FlushToFile();
+      FS->write(Contents.data(), Contents.size());
+      FlushedBytes += Contents.size();
+    } else {
+      Out.append(Contents.begin(), Contents.end());
+    }
   }
 
   //===--------------------------------------------------------------------===//
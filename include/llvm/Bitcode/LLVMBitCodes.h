@@ -71,7 +71,18 @@ namespace bitc {
     // MODULE_CODE_PURGEVALS: [numvals]
     MODULE_CODE_PURGEVALS   = 10,
 
-    MODULE_CODE_GCNAME      = 11   // GCNAME: [strchr x N]
+    MODULE_CODE_GCNAME      = 11,  // GCNAME: [strchr x N]
+
+    // FNINDEXOFFSET: [offset as 8 little-endian bytes]
+    // The bit offset of the FNINDEX record from the start of the module
+    // block's contents, or zero if there is no index.  It is a blob so that
+    // the writer can fill it in with a word-aligned backpatch.
+    MODULE_CODE_FNINDEXOFFSET = 12,
+
+    // FNINDEX: [valueid, bitoffset]*
+    // For each function body, the bit offset (from the start of the module
+    // block's contents) at which its FUNCTION_BLOCK's contents are read.
+    MODULE_CODE_FNINDEX     = 13
   };
 
   /// PARAMATTR blocks have code for defining a parameter attribute set.
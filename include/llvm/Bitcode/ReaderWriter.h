@@ -23,10 +23,13 @@ namespace llvm {
   class LLVMContext;
   class Module;
   class ModulePass;
+  class raw_fd_ostream;
   class raw_ostream;
 
   /// getLazyBitcodeModule - Read the header of the specified bitcode buffer
-  /// and prepare for lazy deserialization of function bodies.  If successful,
+  /// and prepare for lazy deserialization of function bodies.  Module-level
+  /// metadata nodes are also deserialized lazily, when named metadata or a
+  /// materialized function refers to them.  If successful,
   /// this takes ownership of 'buffer' and returns a non-null pointer.  On
   /// error, this returns null, *does not* take ownership of Buffer, and fills
   /// in *ErrMsg with an error description if ErrMsg is non-null.
@@ -63,10 +66,19 @@ namespace llvm {
   /// should be in "binary" mode.
   void WriteBitcodeToFile(const Module *M, raw_ostream &Out);
 
+  /// WriteBitcodeToFile - Write the specified module to the specified file
+  /// stream.  If the stream supports seeking, the bitcode is written to it as
+  /// it is produced rather than being built up in memory first.
+  void WriteBitcodeToFile(const Module *M, raw_fd_ostream &Out);
+
   /// createBitcodeWriterPass - Create and return a pass that writes the module
   /// to the specified ostream.
   ModulePass *createBitcodeWriterPass(raw_ostream &Str);
 
+  /// createBitcodeWriterPass - Create and return a pass that writes the module
+  /// to the specified file stream, as WriteBitcodeToFile does.
+  ModulePass *createBitcodeWriterPass(raw_fd_ostream &Str);
+
 
   /// isBitcodeWrapper - Return true if the given bytes are the magic bytes
   /// for an LLVM IR bitcode wrapper.
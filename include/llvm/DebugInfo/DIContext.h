@@ -33,23 +33,28 @@ class DILineInfo {
   SmallString<16> FunctionName;
   uint32_t Line;
   uint32_t Column;
+  uint32_t StartLine;
 public:
   DILineInfo()
     : FileName("<invalid>"), FunctionName("<invalid>"),
-      Line(0), Column(0) {}
+      Line(0), Column(0), StartLine(0) {}
   DILineInfo(const SmallString<16> &fileName,
              const SmallString<16> &functionName,
-             uint32_t line, uint32_t column)
+             uint32_t line, uint32_t column, uint32_t startLine = 0)
     : FileName(fileName), FunctionName(functionName),
-      Line(line), Column(column) {}
+      Line(line), Column(column), StartLine(startLine) {}
 
   const char *getFileName() { return FileName.c_str(); }
   const char *getFunctionName() { return FunctionName.c_str(); }
   uint32_t getLine() const { return Line; }
   uint32_t getColumn() const { return Column; }
+  /// getStartLine - The line the function is declared on, filled in along
+  /// with the function name; 0 if unknown.
+  uint32_t getStartLine() const { return StartLine; }
 
   bool operator==(const DILineInfo &RHS) const {
     return Line == RHS.Line && Column == RHS.Column &&
+           StartLine == RHS.StartLine &&
            FileName.equals(RHS.FileName) &&
            FunctionName.equals(RHS.FunctionName);
   }
@@ -25,6 +25,7 @@ namespace llvm {
 class Function;
 class GlobalValue;
 class Module;
+class NamedMDNode;
 
 class GVMaterializer {
 protected:
@@ -59,6 +60,16 @@ public:
   /// information about the problem.  If successful, this returns false.
   ///
   virtual bool MaterializeModule(Module *M, std::string *ErrInfo = 0) = 0;
+
+  /// MaterializeNamedMetadata - add the operands of NMD, which were left
+  /// unread by the GVMaterializer.  NamedMDNode calls this the first time its
+  /// operands are accessed.  On error, this returns true and fills in the
+  /// optional string with information about the problem.
+  ///
+  virtual bool MaterializeNamedMetadata(NamedMDNode *NMD,
+                                        std::string *ErrInfo = 0) {
+    return false;
+  }
 };
 
 } // End llvm namespace
@@ -81,6 +81,17 @@ public:
   /// getInlineAsmDiagnosticContext - Return the diagnostic context set by
   /// setInlineAsmDiagnosticHandler.
   void *getInlineAsmDiagnosticContext() const;
+
+  /// setDiscardValueNames - When enabled, setName is a no-op for all values
+  /// other than GlobalValues: arguments, basic blocks and instructions are
+  /// left unnamed and never enter their function's ValueSymbolTable.  Clients
+  /// that never look at local names (e.g. a JIT) can use this to save the
+  /// memory and time spent creating and uniquing them.
+  void setDiscardValueNames(bool Discard);
+
+  /// shouldDiscardValueNames - Return true if local value names are being
+  /// discarded.  See setDiscardValueNames.
+  bool shouldDiscardValueNames() const;
   
   
   /// emitError - Emit an error message to the currently installed error handler
@@ -198,8 +198,10 @@ class NamedMDNode : public ilist_node<NamedMDNode> {
   std::string Name;
   Module *Parent;
   void *Operands; // SmallVector<TrackingVH<MDNode>, 4>
+  bool LazyOperands;
 
   void setParent(Module *M) { Parent = M; }
+  void readLazyOperands() const;
 
   explicit NamedMDNode(const Twine &N);
 
@@ -230,6 +232,16 @@ public:
   /// getName - Return a constant reference to this named metadata's name.
   StringRef getName() const;
 
+  /// setLazyOperands - Mark the operands as not read yet.  The materializer
+  /// of the parent module adds them the first time they are accessed.
+  void setLazyOperands() { LazyOperands = true; }
+
+  /// materializeOperands - Have the materializer of the parent module add
+  /// the operands now if they have not been read yet.  On error, this returns
+  /// true and fills in the optional string with information about the
+  /// problem.
+  bool materializeOperands(std::string *ErrInfo = 0);
+
   /// print - Implement operator<< on NamedMDNode.
   void print(raw_ostream &ROS, AssemblyAnnotationWriter *AAW = 0) const;
 
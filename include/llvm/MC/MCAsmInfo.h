@@ -330,6 +330,11 @@ namespace llvm {
     /// instead of symbolic register names in .cfi_* directives.
     bool DwarfRegNumForCFI;  // Defaults to false;
 
+    /// CompressDebugSections - True if the object writer should compress the
+    /// contents of the .debug_* sections it emits, where the object file
+    /// format has a way to say so.
+    bool CompressDebugSections;  // Defaults to false.
+
     //===--- Prologue State ----------------------------------------------===//
 
     std::vector<MachineMove> InitialFrameState;
@@ -566,6 +571,12 @@ namespace llvm {
     bool useDwarfRegNumForCFI() const {
       return DwarfRegNumForCFI;
     }
+    bool compressDebugSections() const {
+      return CompressDebugSections;
+    }
+    void setCompressDebugSections(bool Value) {
+      CompressDebugSections = Value;
+    }
 
     void addInitialFrameState(MCSymbol *label, const MachineLocation &D,
                               const MachineLocation &S) {
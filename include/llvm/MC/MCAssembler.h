@@ -918,6 +918,16 @@ private:
   /// if any offsets were adjusted.
   bool layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD);
 
+  /// \brief Relax the given fragment if it needs it, and return true if its
+  /// size changed.
+  bool relaxFragment(MCAsmLayout &Layout, MCFragment &F);
+
+  /// \brief Return how many bytes of its own section the fixups of a fragment
+  /// that may still need relaxation span, or 0 if that doesn't depend on the
+  /// layout of the section.
+  uint64_t getRelaxationReach(const MCAsmLayout &Layout,
+                              const MCFragment &F) const;
+
   bool relaxInstruction(MCAsmLayout &Layout, MCRelaxableFragment &IF);
 
   bool relaxLEB(MCAsmLayout &Layout, MCLEBFragment &IF);
@@ -160,7 +160,9 @@ namespace llvm {
     /// Do automatic reset in destructor
     bool AutoReset;
 
-    MCSymbol *CreateSymbol(StringRef Name);
+    /// CreateSymbol - Create a new symbol named Name, or a unique name based
+    /// on it for temporaries.  FullHashValue is StringMapImpl::hash(Name).
+    MCSymbol *CreateSymbol(StringRef Name, unsigned FullHashValue);
 
   public:
     explicit MCContext(const MCAsmInfo &MAI, const MCRegisterInfo &MRI,
@@ -254,6 +256,11 @@ namespace llvm {
 
     const MCSectionELF *CreateELFGroupSection();
 
+    /// renameELFSection - Give an existing ELF section a new, unused name,
+    /// keeping the uniquing map in sync so getELFSection finds it by the new
+    /// name only.
+    void renameELFSection(const MCSectionELF *Section, StringRef Name);
+
     const MCSection *getCOFFSection(StringRef Section, unsigned Characteristics,
                                     int Selection, SectionKind Kind);
 
@@ -116,34 +116,45 @@ public:
     OS << char(Value);
   }
 
+  // The multi-byte writers put the bytes together first and hand them to the
+  // stream in one go, which is a single store when it has room for them.
+
   void WriteLE16(uint16_t Value) {
-    Write8(uint8_t(Value >> 0));
-    Write8(uint8_t(Value >> 8));
+    char Buf[2] = { char(Value >> 0), char(Value >> 8) };
+    OS << StringRef(Buf, sizeof(Buf));
   }
 
   void WriteLE32(uint32_t Value) {
-    WriteLE16(uint16_t(Value >> 0));
-    WriteLE16(uint16_t(Value >> 16));
+    char Buf[4];
+    for (unsigned i = 0; i != 4; ++i)
+      Buf[i] = char(Value >> (i * 8));
+    OS << StringRef(Buf, sizeof(Buf));
   }
 
   void WriteLE64(uint64_t Value) {
-    WriteLE32(uint32_t(Value >> 0));
-    WriteLE32(uint32_t(Value >> 32));
+    char Buf[8];
+    for (unsigned i = 0; i != 8; ++i)
+      Buf[i] = char(Value >> (i * 8));
+    OS << StringRef(Buf, sizeof(Buf));
   }
 
   void WriteBE16(uint16_t Value) {
-    Write8(uint8_t(Value >> 8));
-    Write8(uint8_t(Value >> 0));
+    char Buf[2] = { char(Value >> 8), char(Value >> 0) };
+    OS << StringRef(Buf, sizeof(Buf));
   }
 
   void WriteBE32(uint32_t Value) {
-    WriteBE16(uint16_t(Value >> 16));
-    WriteBE16(uint16_t(Value >> 0));
+    char Buf[4];
+    for (unsigned i = 0; i != 4; ++i)
+      Buf[i] = char(Value >> ((3 - i) * 8));
+    OS << StringRef(Buf, sizeof(Buf));
   }
 
   void WriteBE64(uint64_t Value) {
-    WriteBE32(uint32_t(Value >> 32));
-    WriteBE32(uint32_t(Value >> 0));
+    char Buf[8];
+    for (unsigned i = 0; i != 8; ++i)
+      Buf[i] = char(Value >> ((7 - i) * 8));
+    OS << StringRef(Buf, sizeof(Buf));
   }
 
   void Write16(uint16_t Value) {
@@ -168,12 +179,12 @@ public:
   }
 
   void WriteZeros(unsigned N) {
-    const char Zeros[16] = { 0 };
+    static const char Zeros[256] = { 0 };
 
-    for (unsigned i = 0, e = N / 16; i != e; ++i)
-      OS << StringRef(Zeros, 16);
+    for (unsigned i = 0, e = N / 256; i != e; ++i)
+      OS << StringRef(Zeros, 256);
 
-    OS << StringRef(Zeros, N % 16);
+    OS << StringRef(Zeros, N % 256);
   }
 
   void WriteBytes(const SmallVectorImpl<char> &ByteVec, unsigned ZeroFillSize = 0) {
@@ -0,0 +1,67 @@
+//===-- StringTableBuilder.h - String table building utility ------*- C++ -*-=//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_MC_STRINGTABLEBUILDER_H
+#define LLVM_MC_STRINGTABLEBUILDER_H
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include <cassert>
+
+namespace llvm {
+
+/// StringTableBuilder - Utility for building string tables such as the ELF
+/// .strtab and .shstrtab sections. Each distinct string is stored once, and a
+/// string that is a suffix of another one ("bar" of "foobar") shares its
+/// storage. The layout only depends on the set of strings added, not on the
+/// order they were added in.
+class StringTableBuilder {
+  SmallString<256> StringTable;
+  StringMap<size_t> StringIndexMap;
+
+public:
+  /// add - Add a string to the builder. Returns a StringRef to the internal
+  /// copy of the string, which stays valid as long as the builder does.
+  /// Must not be called after finalize().
+  StringRef add(StringRef S) {
+    assert(!isFinalized());
+    return StringIndexMap.GetOrCreateValue(S, 0).getKey();
+  }
+
+  /// finalize - Lay out the string table. The result starts with an empty
+  /// string, so offset 0 can be used to mean "no name".
+  void finalize();
+
+  /// data - Return the string table contents. Only valid after finalize().
+  StringRef data() const {
+    assert(isFinalized());
+    return StringTable;
+  }
+
+  /// getOffset - Return the offset of a string in the string table. Only
+  /// valid after finalize(), and only for strings that were added.
+  size_t getOffset(StringRef S) const {
+    assert(isFinalized());
+    StringMap<size_t>::const_iterator I = StringIndexMap.find(S);
+    assert(I != StringIndexMap.end() && "String is not in table!");
+    return I->getValue();
+  }
+
+  /// clear - Forget all strings so the builder can be reused.
+  void clear();
+
+private:
+  bool isFinalized() const {
+    return !StringTable.empty();
+  }
+};
+
+} // end llvm namespace
+
+#endif
@@ -268,6 +268,12 @@ public:
   ///
   virtual void initializePass();
 
+  /// releaseCachedInfo - Immutable passes are never invalidated, but this is
+  /// called after a pass that does not preserve this one, or an analysis group
+  /// it implements, has run.  A pass that caches facts about the IR it was
+  /// asked about should drop them here, since they may no longer hold.
+  virtual void releaseCachedInfo() {}
+
   virtual ImmutablePass *getAsImmutablePass() { return this; }
 
   /// ImmutablePasses are never run.
@@ -18,6 +18,7 @@
 #include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
 #include "llvm/Pass.h"
 #include <map>
 #include <vector>
@@ -465,6 +466,39 @@ public:
 
 Timer *getPassTimer(Pass *);
 
+/// PassTraceIsEnabled - This is set by the -pass-trace-file command line
+/// option.
+extern bool PassTraceIsEnabled;
+
+/// PassTraceRegion - When -pass-trace-file is given, this records one Chrome
+/// trace event covering the lifetime of the object, with the wall time and the
+/// change in heap usage over that interval.  Regions nest, so pass managers
+/// open a region for each function or loop they walk and the passes run on it
+/// show up underneath.  When tracing is off this is a single flag test.
+class PassTraceRegion {
+  bool Active;
+
+  PassTraceRegion(const PassTraceRegion &) LLVM_DELETED_FUNCTION;
+  void operator=(const PassTraceRegion &) LLVM_DELETED_FUNCTION;
+
+  void start(StringRef Name, StringRef Category, StringRef Unit);
+  void stop();
+public:
+  /// PassTraceRegion - Trace the execution of \p Name, which is running on the
+  /// IR unit \p Unit (a module, function or loop header name).  \p Category
+  /// is the kind of pass manager doing the work.
+  PassTraceRegion(StringRef Name, StringRef Category, StringRef Unit)
+    : Active(false) {
+    if (PassTraceIsEnabled)
+      start(Name, Category, Unit);
+  }
+
+  ~PassTraceRegion() {
+    if (Active)
+      stop();
+  }
+};
+
 }
 
 #endif
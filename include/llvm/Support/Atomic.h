@@ -28,6 +28,9 @@ namespace llvm {
     cas_flag CompareAndSwap(volatile cas_flag* ptr,
                             cas_flag new_value,
                             cas_flag old_value);
+    void *CompareAndSwap(void *volatile *ptr,
+                         void *new_value,
+                         void *old_value);
     cas_flag AtomicIncrement(volatile cas_flag* ptr);
     cas_flag AtomicDecrement(volatile cas_flag* ptr);
     cas_flag AtomicAdd(volatile cas_flag* ptr, cas_flag val);
@@ -46,6 +46,19 @@ Status compress(StringRef InputBuffer,
                 OwningPtr<MemoryBuffer> &CompressedBuffer,
                 CompressionLevel Level = DefaultCompression);
 
+/// compressInParallel - Same as compress, but split InputBuffer into blocks
+/// of BlockSize bytes and compress them on up to NumThreads threads (0 means
+/// one per hardware thread).  The blocks are joined into one zlib stream, so
+/// the result is read back with uncompress as usual.  Each block is primed
+/// with the 32KB of input before it, so the output is barely larger than
+/// compress would make it.  Inputs of at most one block are passed straight
+/// to compress.
+Status compressInParallel(StringRef InputBuffer,
+                          OwningPtr<MemoryBuffer> &CompressedBuffer,
+                          CompressionLevel Level = DefaultCompression,
+                          size_t BlockSize = 1 << 20,
+                          unsigned NumThreads = 0);
+
 Status uncompress(StringRef InputBuffer,
                   OwningPtr<MemoryBuffer> &UncompressedBuffer,
                   size_t UncompressedSize);
@@ -0,0 +1,304 @@
+//===- ConcurrentAllocator.h - Allocators shared by threads -----*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines allocators that may be used from several threads at once:
+//
+//  - RecyclingSlabAllocator, a thread-safe SlabAllocator that keeps freed
+//    slabs for reuse instead of returning them to malloc.
+//  - ThreadLocalArena, which gives every allocating thread its own
+//    BumpPtrAllocator, all fed from one RecyclingSlabAllocator.
+//  - ConcurrentSpecificBumpPtrAllocator, a lock-free version of
+//    SpecificBumpPtrAllocator.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_CONCURRENTALLOCATOR_H
+#define LLVM_SUPPORT_CONCURRENTALLOCATOR_H
+
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/Atomic.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadLocal.h"
+#include <vector>
+
+namespace llvm {
+
+/// RecyclingSlabAllocator - A SlabAllocator that may be shared between
+/// threads.  Freed slabs whose size is SlabSize times a small power of two
+/// (the sizes a BumpPtrAllocator with that slab size asks for) are kept on
+/// free lists and handed out again, so allocators that are created and reset
+/// often do not pay for a malloc and a free per slab.  Other slabs are
+/// forwarded to malloc.
+class RecyclingSlabAllocator : public SlabAllocator {
+  RecyclingSlabAllocator(const RecyclingSlabAllocator &) LLVM_DELETED_FUNCTION;
+  void operator=(const RecyclingSlabAllocator &) LLVM_DELETED_FUNCTION;
+
+  /// NumSizeClasses - Slabs of SlabSize << 0 up to
+  /// SlabSize << (NumSizeClasses - 1) bytes are recycled.
+  enum { NumSizeClasses = 8 };
+
+  /// SlabSize - The smallest slab size that is recycled.
+  size_t SlabSize;
+
+  /// MaxFreeBytes - Freed slabs are returned to malloc once this many bytes
+  /// are already waiting to be reused.
+  size_t MaxFreeBytes;
+
+  /// Lock - Guards the free lists.
+  sys::Mutex Lock;
+  MemSlab *FreeLists[NumSizeClasses];
+  size_t FreeBytes;
+
+  /// Malloc - Allocates the slabs that are not recycled.
+  MallocSlabAllocator Malloc;
+
+  /// getSizeClass - Return the free list for slabs of Size bytes, or -1 if
+  /// they are not recycled.
+  int getSizeClass(size_t Size) const;
+
+public:
+  explicit RecyclingSlabAllocator(size_t SlabSize = 4096,
+                                  size_t MaxFreeBytes = 64 << 20);
+  virtual ~RecyclingSlabAllocator();
+
+  virtual MemSlab *Allocate(size_t Size) LLVM_OVERRIDE;
+  virtual void Deallocate(MemSlab *Slab) LLVM_OVERRIDE;
+
+  size_t getSlabSize() const { return SlabSize; }
+
+  /// getFreeBytes - Return the number of bytes in slabs waiting to be reused.
+  size_t getFreeBytes();
+
+  /// ReleaseFreeSlabs - Return every slab waiting to be reused to malloc.
+  void ReleaseFreeSlabs();
+
+  /// getGlobalPool - Return the pool that ThreadLocalArena and
+  /// ConcurrentSpecificBumpPtrAllocator use by default.
+  static RecyclingSlabAllocator &getGlobalPool();
+};
+
+/// ThreadLocalArena - Bump pointer allocation from any number of threads.
+/// Every thread that allocates from the arena gets its own BumpPtrAllocator,
+/// so allocation takes no locks once a thread has made its first allocation.
+/// The slabs come from a RecyclingSlabAllocator shared with other arenas.
+///
+/// As with BumpPtrAllocator, memory is only released all at once, by Reset()
+/// or the destructor; neither may run while other threads are still using the
+/// arena.  Memory allocated by one thread may be used by any thread.
+class ThreadLocalArena {
+  ThreadLocalArena(const ThreadLocalArena &) LLVM_DELETED_FUNCTION;
+  void operator=(const ThreadLocalArena &) LLVM_DELETED_FUNCTION;
+
+  /// SlabPool - Where the per-thread allocators get their slabs.
+  RecyclingSlabAllocator &SlabPool;
+
+  /// Current - The allocator of the calling thread, or null if it has not
+  /// allocated from this arena yet.
+  sys::ThreadLocal<BumpPtrAllocator> Current;
+
+  /// Lock - Guards Allocators.
+  sys::Mutex Lock;
+
+  /// Allocators - The allocators of every thread that has used the arena.
+  std::vector<BumpPtrAllocator *> Allocators;
+
+  BumpPtrAllocator &createThreadAllocator();
+
+public:
+  explicit ThreadLocalArena(
+      RecyclingSlabAllocator &Pool = RecyclingSlabAllocator::getGlobalPool());
+  ~ThreadLocalArena();
+
+  /// getThreadAllocator - Return the allocator of the calling thread.  It may
+  /// be used directly, but only by this thread.
+  BumpPtrAllocator &getThreadAllocator() {
+    if (BumpPtrAllocator *A = Current.get())
+      return *A;
+    return createThreadAllocator();
+  }
+
+  /// Allocate - Allocate space at the specified alignment.
+  void *Allocate(size_t Size, size_t Alignment) {
+    return getThreadAllocator().Allocate(Size, Alignment);
+  }
+
+  /// Allocate space, but do not construct, one object.
+  template <typename T>
+  T *Allocate() {
+    return getThreadAllocator().Allocate<T>();
+  }
+
+  /// Allocate space for an array of objects.  This does not construct the
+  /// objects though.
+  template <typename T>
+  T *Allocate(size_t Num) {
+    return getThreadAllocator().Allocate<T>(Num);
+  }
+
+  void Deallocate(const void * /*Ptr*/) {}
+
+  /// Reset - Free everything allocated so far by every thread.  Each thread
+  /// keeps one slab; the rest go back to the pool.
+  void Reset();
+
+  /// Compute the total physical memory allocated by this arena.
+  size_t getTotalMemory();
+};
+
+/// ConcurrentSpecificBumpPtrAllocator - Same as SpecificBumpPtrAllocator, but
+/// Allocate may be called from any number of threads at once without locking.
+/// Threads claim elements from the current slab with an atomic add; when the
+/// slab runs out, the thread that notices installs a new one with a
+/// compare-and-swap.
+///
+/// DestroyAll and the destructor call the destructor of every element that
+/// was handed out, so they must not run while other threads are allocating.
+/// The SlabAllocator must be thread-safe.
+template <typename T>
+class ConcurrentSpecificBumpPtrAllocator {
+  ConcurrentSpecificBumpPtrAllocator(
+      const ConcurrentSpecificBumpPtrAllocator &) LLVM_DELETED_FUNCTION;
+  void operator=(const ConcurrentSpecificBumpPtrAllocator &)
+      LLVM_DELETED_FUNCTION;
+
+  /// SlabHeader - Follows the MemSlab header at the start of every slab.
+  struct SlabHeader {
+    MemSlab Slab;
+    /// Capacity - The number of elements that fit in the slab.
+    sys::cas_flag Capacity;
+    /// Used - The number of elements claimed.  This may run past Capacity
+    /// when several threads find the slab full at the same time.
+    volatile sys::cas_flag Used;
+    /// Limit - The number of elements that were handed out, if a claim ran
+    /// over the end of the slab and left elements [Limit, Capacity) unused.
+    volatile sys::cas_flag Limit;
+  };
+
+  SlabAllocator &Allocator;
+
+  /// SlabSize - The size of a normal slab in bytes.
+  size_t SlabSize;
+
+  /// ElementsPerSlab - The capacity of a normal slab.
+  sys::cas_flag ElementsPerSlab;
+
+  /// CurSlab - The slab that elements are claimed from.  Earlier slabs are
+  /// linked through MemSlab::NextPtr.
+  SlabHeader *volatile CurSlab;
+
+  /// LargeSlabs - Slabs allocated for a single request of more than
+  /// ElementsPerSlab elements.
+  SlabHeader *volatile LargeSlabs;
+
+  static size_t getElementOffset() {
+    return RoundUpToAlignment(sizeof(SlabHeader), AlignOf<T>::Alignment);
+  }
+
+  static T *getElements(SlabHeader *S) {
+    return reinterpret_cast<T *>(reinterpret_cast<char *>(S) +
+                                 getElementOffset());
+  }
+
+  SlabHeader *createSlab(sys::cas_flag Capacity, sys::cas_flag Used) {
+    MemSlab *Slab = Allocator.Allocate(
+        std::max(SlabSize, getElementOffset() + size_t(Capacity) * sizeof(T)));
+    SlabHeader *S = reinterpret_cast<SlabHeader *>(Slab);
+    S->Capacity = Capacity;
+    S->Used = Used;
+    S->Limit = Capacity;
+    return S;
+  }
+
+  /// pushSlab - Link S in front of Head, unless Head is no longer Expected.
+  /// Return true on success.
+  static bool pushSlab(SlabHeader *volatile &Head, SlabHeader *S,
+                       SlabHeader *Expected) {
+    S->Slab.NextPtr = Expected ? &Expected->Slab : 0;
+    return sys::CompareAndSwap(reinterpret_cast<void *volatile *>(&Head), S,
+                               Expected) == Expected;
+  }
+
+  void destroySlabs(SlabHeader *S) {
+    while (S) {
+      sys::cas_flag Used = S->Used, Limit = S->Limit;
+      sys::cas_flag NumElements = std::min(Used, Limit);
+      T *Elements = getElements(S);
+      for (sys::cas_flag i = 0; i != NumElements; ++i)
+        Elements[i].~T();
+      SlabHeader *Next = reinterpret_cast<SlabHeader *>(S->Slab.NextPtr);
+      Allocator.Deallocate(&S->Slab);
+      S = Next;
+    }
+  }
+
+  T *AllocateLarge(sys::cas_flag Num) {
+    SlabHeader *S = createSlab(Num, Num);
+    SlabHeader *Head;
+    do
+      Head = LargeSlabs;
+    while (!pushSlab(LargeSlabs, S, Head));
+    return getElements(S);
+  }
+
+public:
+  explicit ConcurrentSpecificBumpPtrAllocator(
+      size_t size = 4096,
+      SlabAllocator &allocator = RecyclingSlabAllocator::getGlobalPool())
+    : Allocator(allocator), SlabSize(size), CurSlab(0), LargeSlabs(0) {
+    size_t Room = SlabSize > getElementOffset() ?
+                  SlabSize - getElementOffset() : 0;
+    ElementsPerSlab = sys::cas_flag(std::max<size_t>(Room / sizeof(T), 1));
+  }
+
+  ~ConcurrentSpecificBumpPtrAllocator() {
+    DestroyAll();
+  }
+
+  /// Call the destructor of each allocated object and deallocate all slabs.
+  void DestroyAll() {
+    destroySlabs(CurSlab);
+    destroySlabs(LargeSlabs);
+    CurSlab = 0;
+    LargeSlabs = 0;
+  }
+
+  /// Allocate space for a specific count of elements.  This may be called by
+  /// several threads at once.
+  T *Allocate(size_t num = 1) {
+    sys::cas_flag Num = sys::cas_flag(num);
+    assert(Num == num && Num < (sys::cas_flag(1) << 30) &&
+           "Allocation too large!");
+    if (Num > ElementsPerSlab)
+      return AllocateLarge(Num);
+
+    while (1) {
+      SlabHeader *S = CurSlab;
+      if (S) {
+        sys::cas_flag End = sys::AtomicAdd(&S->Used, Num);
+        sys::cas_flag Begin = End - Num;
+        if (End <= S->Capacity)
+          return getElements(S) + Begin;
+        // Only the claim that crosses the end of the slab starts inside it.
+        if (Begin < S->Capacity)
+          S->Limit = Begin;
+      }
+
+      // The slab is full.  Try to install a new one with our elements
+      // already claimed; if another thread got there first, use its slab.
+      SlabHeader *NewSlab = createSlab(ElementsPerSlab, Num);
+      if (pushSlab(CurSlab, NewSlab, S))
+        return getElements(NewSlab);
+      Allocator.Deallocate(&NewSlab->Slab);
+    }
+  }
+};
+
+}  // end namespace llvm
+
+#endif // LLVM_SUPPORT_CONCURRENTALLOCATOR_H
@@ -591,6 +591,16 @@ public:
     priv ///< May modify via data, but changes are lost on destruction.
   };
 
+  /// How the mapped memory is going to be accessed.  These are only hints;
+  /// platforms that cannot act on them ignore them.
+  enum advice {
+    normal,     ///< No particular pattern.
+    sequential, ///< Front to back; read ahead aggressively.
+    random,     ///< In no particular order; do not read ahead.
+    willneed,   ///< Soon; start reading the range in the background now.
+    hugepage    ///< Back the range with huge pages if the system can.
+  };
+
 private:
   /// Platform specific mapping state.
   mapmode Mode;
@@ -602,7 +612,11 @@ private:
   void *FileMappingHandle;
 #endif
 
-  error_code init(int FD, bool CloseFD, uint64_t Offset);
+  /// The platform specific parts of the constructors.  openPath opens \a Path
+  /// for Mode, returning a descriptor that init will close.  init maps Size
+  /// bytes (the whole file if 0) of FD starting at Offset.
+  error_code openPath(const Twine &Path, int &FD);
+  error_code init(int FD, bool CloseFD, uint64_t Offset, bool Populate);
 
 public:
   typedef char char_type;
@@ -642,6 +656,17 @@ public:
                      uint64_t offset,
                      error_code &ec);
 
+  /// Same as above, but if \a populate is true the whole region is read in
+  /// and mapped before the constructor returns, instead of being faulted in
+  /// a page at a time on first access.
+  mapped_file_region(int fd,
+                     bool closefd,
+                     mapmode mode,
+                     uint64_t length,
+                     uint64_t offset,
+                     bool populate,
+                     error_code &ec);
+
   ~mapped_file_region();
 
   mapmode flags() const;
@@ -652,6 +677,10 @@ public:
   /// behaivor.
   const char *const_data() const;
 
+  /// Tell the system how the \a length bytes at \a offset into the region
+  /// will be accessed.  A \a length of 0 means up to the end of the region.
+  error_code advise(advice a, uint64_t offset = 0, uint64_t length = 0) const;
+
   /// \returns The minimum alignment offset must be.
   static int alignment();
 };
@@ -122,6 +122,13 @@ public:
   /// \param NewCol - The column to move to.
   formatted_raw_ostream &PadToColumn(unsigned NewCol);
 
+  /// reserveExtraSpace - Pass the reservation on to the underlying stream,
+  /// which is where the bytes end up.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) LLVM_OVERRIDE {
+    flush();
+    TheStream->reserveExtraSpace(ExtraSize);
+  }
+
 private:
   void releaseStream() {
     // Delete the stream if needed. Otherwise, transfer the buffer
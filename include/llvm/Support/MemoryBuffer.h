@@ -62,17 +62,42 @@ public:
     return "Unknown buffer";
   }
 
+  /// prefetch - Hint that the Length bytes at Offset into the buffer will be
+  /// read soon.  For a memory mapped file this starts reading them in from
+  /// disk in the background; otherwise it does nothing.
+  virtual void prefetch(size_t Offset, size_t Length) const;
+
+  /// MapHint - How a file that is opened as a MemoryBuffer is going to be
+  /// read.  The hints only apply if the file ends up memory mapped, and are
+  /// ignored where the system does not support them.
+  enum MapHint {
+    MH_None       = 0,
+    /// Read front to back; have the system read ahead aggressively.
+    MH_Sequential = 1 << 0,
+    /// Read in no particular order; have the system not read ahead.
+    MH_Random     = 1 << 1,
+    /// Start reading the whole file in the background right away.
+    MH_WillNeed   = 1 << 2,
+    /// Read the whole file in before returning the buffer, so that accessing
+    /// it never page faults.
+    MH_Populate   = 1 << 3,
+    /// Back the mapping with huge pages if the system can.
+    MH_HugePages  = 1 << 4
+  };
+
   /// getFile - Open the specified file as a MemoryBuffer, returning a new
   /// MemoryBuffer if successful, otherwise returning null.  If FileSize is
   /// specified, this means that the client knows that the file exists and that
-  /// it has the specified size.
+  /// it has the specified size.  MapHints is a combination of MapHint flags.
   static error_code getFile(StringRef Filename, OwningPtr<MemoryBuffer> &result,
                             int64_t FileSize = -1,
-                            bool RequiresNullTerminator = true);
+                            bool RequiresNullTerminator = true,
+                            unsigned MapHints = MH_None);
   static error_code getFile(const char *Filename,
                             OwningPtr<MemoryBuffer> &result,
                             int64_t FileSize = -1,
-                            bool RequiresNullTerminator = true);
+                            bool RequiresNullTerminator = true,
+                            unsigned MapHints = MH_None);
 
   /// getOpenFile - Given an already-open file descriptor, read the file and
   /// return a MemoryBuffer.
@@ -81,7 +106,8 @@ public:
                                 uint64_t FileSize = -1,
                                 uint64_t MapSize = -1,
                                 int64_t Offset = 0,
-                                bool RequiresNullTerminator = true);
+                                bool RequiresNullTerminator = true,
+                                unsigned MapHints = MH_None);
 
   /// getMemBuffer - Open the specified memory range as a MemoryBuffer.  Note
   /// that InputData must be null terminated if RequiresNullTerminator is true.
@@ -118,10 +144,12 @@ public:
   /// ec.
   static error_code getFileOrSTDIN(StringRef Filename,
                                    OwningPtr<MemoryBuffer> &result,
-                                   int64_t FileSize = -1);
+                                   int64_t FileSize = -1,
+                                   unsigned MapHints = MH_None);
   static error_code getFileOrSTDIN(const char *Filename,
                                    OwningPtr<MemoryBuffer> &result,
-                                   int64_t FileSize = -1);
+                                   int64_t FileSize = -1,
+                                   unsigned MapHints = MH_None);
   
   
   //===--------------------------------------------------------------------===//
@@ -0,0 +1,103 @@
+//===- llvm/Support/ScaledNumber.h - Scaled integer arithmetic --*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines ScaledNumber, an unsigned number with a 64-bit mantissa
+// and a binary exponent, computed with integer operations only.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_SUPPORT_SCALEDNUMBER_H
+#define LLVM_SUPPORT_SCALEDNUMBER_H
+
+#include "llvm/Support/DataTypes.h"
+
+namespace llvm {
+
+class raw_ostream;
+
+/// ScaledNumber - An unsigned value Digits * 2^Scale.  This gives the range
+/// of a floating point number with 64 bits of precision and deterministic
+/// rounding on every host, which makes it suitable for quantities such as
+/// block frequencies that span many orders of magnitude.  Results that are
+/// too large saturate at getLargest(); results that are too small become
+/// zero.
+class ScaledNumber {
+  uint64_t Digits;
+  int16_t Scale;
+
+  static const int32_t MaxScale = 16383;
+  static const int32_t MinScale = -16382;
+
+  /// get - Build a number from a mantissa and an exponent that may be out of
+  /// range, saturating or flushing to zero as needed.
+  static ScaledNumber get(uint64_t Digits, int32_t Scale);
+
+public:
+  ScaledNumber() : Digits(0), Scale(0) {}
+  explicit ScaledNumber(uint64_t Digits, int16_t Scale = 0)
+    : Digits(Digits), Scale(Scale) {}
+
+  static ScaledNumber getZero() { return ScaledNumber(); }
+  static ScaledNumber getOne() { return ScaledNumber(1); }
+  static ScaledNumber getLargest() {
+    return ScaledNumber(UINT64_MAX, MaxScale);
+  }
+
+  /// getFraction - Return N / D.  D must not be zero.
+  static ScaledNumber getFraction(uint64_t N, uint64_t D);
+
+  uint64_t getDigits() const { return Digits; }
+  int16_t getScale() const { return Scale; }
+  bool isZero() const { return Digits == 0; }
+
+  /// toInt - Return the value rounded down to an integer, or UINT64_MAX if it
+  /// does not fit.
+  uint64_t toInt() const;
+
+  /// compare - Return -1, 0 or 1 as this is less than, equal to or greater
+  /// than X.
+  int compare(const ScaledNumber &X) const;
+
+  bool operator==(const ScaledNumber &X) const { return compare(X) == 0; }
+  bool operator!=(const ScaledNumber &X) const { return compare(X) != 0; }
+  bool operator<(const ScaledNumber &X) const { return compare(X) < 0; }
+  bool operator>(const ScaledNumber &X) const { return compare(X) > 0; }
+  bool operator<=(const ScaledNumber &X) const { return compare(X) <= 0; }
+  bool operator>=(const ScaledNumber &X) const { return compare(X) >= 0; }
+
+  ScaledNumber &operator+=(const ScaledNumber &X);
+  /// operator-= - Subtract X, which saturates at zero if X is larger.
+  ScaledNumber &operator-=(const ScaledNumber &X);
+  ScaledNumber &operator*=(const ScaledNumber &X);
+  /// operator/= - Divide by X.  Dividing by zero gives getLargest().
+  ScaledNumber &operator/=(const ScaledNumber &X);
+
+  ScaledNumber operator+(const ScaledNumber &X) const {
+    ScaledNumber R(*this); return R += X;
+  }
+  ScaledNumber operator-(const ScaledNumber &X) const {
+    ScaledNumber R(*this); return R -= X;
+  }
+  ScaledNumber operator*(const ScaledNumber &X) const {
+    ScaledNumber R(*this); return R *= X;
+  }
+  ScaledNumber operator/(const ScaledNumber &X) const {
+    ScaledNumber R(*this); return R /= X;
+  }
+
+  /// print - Print an approximate decimal value, for debugging.
+  void print(raw_ostream &OS) const;
+  void dump() const;
+};
+
+raw_ostream &operator<<(raw_ostream &OS, const ScaledNumber &X);
+
+}
+
+#endif
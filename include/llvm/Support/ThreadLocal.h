@@ -49,7 +49,7 @@ namespace llvm {
 
       /// get - Fetches a pointer to the object associated with the current
       /// thread.  If no object has yet been associated, it returns NULL;
-      T* get() { return static_cast<T*>(getInstance()); }
+      T* get() { return static_cast<T*>(const_cast<void*>(getInstance())); }
 
       // set - Associates a pointer to an object with the current thread.
       void set(T* d) { setInstance(d); }
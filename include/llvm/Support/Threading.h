@@ -54,6 +54,28 @@ namespace llvm {
   /// the thread stack.
   void llvm_execute_on_thread(void (*UserFn)(void*), void *UserData,
                               unsigned RequestedStackSize = 0);
+
+  /// llvm_execute_in_parallel - Call \p UserFn once for every index in
+  /// [0, \p NumTasks), spreading the calls over at most \p NumThreads threads
+  /// (the calling thread included) and returning once all calls are done.
+  ///
+  /// Indices are handed out dynamically in increasing order, so tasks of
+  /// uneven cost balance across the threads.  When thread support is not
+  /// available, or \p NumThreads is at most one, every call is made on the
+  /// calling thread in index order.
+  ///
+  /// \param UserFn - The callback to execute; it is passed \p UserData and
+  /// the task index.
+  /// \param UserData - An argument to pass to the callback function.
+  /// \param NumTasks - The number of times to call \p UserFn.
+  /// \param NumThreads - The maximum number of threads to use.
+  void llvm_execute_in_parallel(void (*UserFn)(void*, unsigned),
+                                void *UserData, unsigned NumTasks,
+                                unsigned NumThreads);
+
+  /// llvm_get_hardware_concurrency - Return the number of hardware threads the
+  /// host can run concurrently, or 1 if it cannot be determined.
+  unsigned llvm_get_hardware_concurrency();
 }
 
 #endif
@@ -23,6 +23,12 @@ namespace llvm {
   template <typename T>
   class SmallVectorImpl;
 
+  namespace sys {
+    namespace fs {
+      class mapped_file_region;
+    }
+  }
+
 /// raw_ostream - This class implements an extremely fast bulk output stream
 /// that can *only* output to a stream.  It does not support seeking, reopening,
 /// rewinding, line buffered disciplines etc. It is a simple buffer that outputs
@@ -207,6 +213,10 @@ public:
   /// indent - Insert 'NumSpaces' spaces.
   raw_ostream &indent(unsigned NumSpaces);
 
+  /// reserveExtraSpace - Tell the stream that about \p ExtraSize more bytes
+  /// are about to be written, so that it can make room for them all at once.
+  /// Streams that can't make use of this ignore it.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) { (void)ExtraSize; }
 
   /// Changes the foreground color of text that will be output from this point
   /// forward.
@@ -320,6 +330,25 @@ class raw_fd_ostream : public raw_ostream {
 
   uint64_t pos;
 
+  /// CanMap - True if the file is a regular file opened with F_Map, for
+  /// reading and writing, so that reserveExtraSpace can map it.
+  bool CanMap;
+
+  /// WasUnbuffered - Whether the stream was unbuffered before Mapping was
+  /// installed as its buffer.
+  bool WasUnbuffered;
+
+  /// Mapping - The region of the file being written in place, or null.
+  /// See reserveExtraSpace.
+  sys::fs::mapped_file_region *Mapping;
+
+  /// MapStart, MapEnd - The file offsets of the start and the end of Mapping.
+  uint64_t MapStart, MapEnd;
+
+  /// SizeBeforeMapping - The size of the file before it was grown to make
+  /// room for Mapping.
+  uint64_t SizeBeforeMapping;
+
   /// write_impl - See raw_ostream::write_impl.
   virtual void write_impl(const char *Ptr, size_t Size) LLVM_OVERRIDE;
 
@@ -334,6 +363,10 @@ class raw_fd_ostream : public raw_ostream {
   /// been encountered.
   void error_detected() { Error = true; }
 
+  /// endMapping - Stop writing into Mapping, and give the file back its
+  /// real size.  The buffer must be empty.
+  void endMapping();
+
 public:
 
   enum {
@@ -348,7 +381,11 @@ public:
 
     /// F_Binary - The file should be opened in binary mode on platforms that
     /// make this distinction.
-    F_Binary = 4
+    F_Binary = 4,
+
+    /// F_Map - If the file is a regular file, open it for reading as well as
+    /// writing, so that reserveExtraSpace can map it.
+    F_Map = 8
   };
 
   /// raw_fd_ostream - Open the specified file for writing. If an error occurs,
@@ -378,6 +415,23 @@ public:
   /// position to the offset specified from the beginning of the file.
   uint64_t seek(uint64_t off);
 
+  /// supportsSeeking - Return true if seek can be used to overwrite earlier
+  /// output, i.e. the stream is a regular file that is not in append mode.
+  bool supportsSeeking() const;
+
+  /// reserveExtraSpace - If the stream is a file opened by name with F_Map and
+  /// at least MinMappedSize bytes are coming, allocate the space in the file
+  /// and map it, so the output is written straight into the page cache rather
+  /// than copied by write(2).  If the space can't be allocated, the output is
+  /// written as usual.  The file is cut back to the bytes actually written
+  /// when the mapping is used up, or the stream is seeked, closed or
+  /// destroyed.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) LLVM_OVERRIDE;
+
+  /// MinMappedSize - Below this size, reserveExtraSpace does nothing: the
+  /// page faults would cost more than the copies they save.
+  static const uint64_t MinMappedSize = 256 * 1024;
+
   /// SetUseAtomicWrite - Set the stream to attempt to use atomic writes for
   /// individual output routines where possible.
   ///
@@ -484,6 +538,9 @@ public:
   /// if the raw_svector_ostream has previously been flushed.
   void resync();
 
+  /// reserveExtraSpace - Grow the vector once to hold \p ExtraSize more bytes.
+  virtual void reserveExtraSpace(uint64_t ExtraSize) LLVM_OVERRIDE;
+
   /// str - Flushes the stream contents to the target vector and return a
   /// StringRef for the vector contents.
   StringRef str();
@@ -50,7 +50,8 @@ namespace llvm {
           GuaranteedTailCallOpt(false), DisableTailCalls(false),
           StackAlignmentOverride(0), RealignStack(true), SSPBufferSize(0),
           EnableFastISel(false), PositionIndependentExecutable(false),
-          EnableSegmentedStacks(false), UseInitArray(false), TrapFuncName(""),
+          EnableSegmentedStacks(false), UseInitArray(false),
+          CompressDebugSections(false), TrapFuncName(""),
           FloatABIType(FloatABI::Default), AllowFPOpFusion(FPOpFusion::Standard)
     {}
 
@@ -176,6 +177,10 @@ namespace llvm {
     /// constructors.
     unsigned UseInitArray : 1;
 
+    /// CompressDebugSections - Compress the DWARF sections of emitted object
+    /// files, on object formats that support it.
+    unsigned CompressDebugSections : 1;
+
     /// getTrapFunctionName - If this returns a non-empty string, this means
     /// isel should lower Intrinsic::trap to a call to the specified function
     /// name instead of an ISD::TRAP node.
@@ -17,6 +17,7 @@
 #ifndef LLVM_TRANSFORMS_IPO_INLINERPASS_H
 #define LLVM_TRANSFORMS_IPO_INLINERPASS_H
 
+#include "llvm/ADT/ValueMap.h"
 #include "llvm/Analysis/CallGraphSCCPass.h"
 
 namespace llvm {
@@ -38,6 +39,11 @@ struct Inliner : public CallGraphSCCPass {
   /// always explicitly call the implementation here.
   virtual void getAnalysisUsage(AnalysisUsage &Info) const;
 
+  using llvm::Pass::doInitialization;
+  /// doInitialization - Read the function entry counts that a profile-guided
+  /// build recorded in the module, if any.
+  virtual bool doInitialization(CallGraph &CG);
+
   // Main run interface method, this implements the interface required by the
   // Pass class.
   virtual bool runOnSCC(CallGraphSCC &SCC);
@@ -55,7 +61,8 @@ struct Inliner : public CallGraphSCCPass {
   /// Calculate the inline threshold for given Caller. This threshold is lower
   /// if the caller is marked with OptimizeForSize and -inline-threshold is not
   /// given on the comand line. It is higher if the callee is marked with the
-  /// inlinehint attribute.
+  /// inlinehint attribute.  With a profile, it is also lower if the callee was
+  /// never entered in the profiled run and higher if the callee is hot.
   ///
   unsigned getInlineThreshold(CallSite CS) const;
 
@@ -81,6 +88,17 @@ private:
   // InsertLifetime - Insert @llvm.lifetime intrinsics.
   bool InsertLifetime;
 
+  // EntryCountsConfig - Drop the entry count of a function when it is deleted,
+  // but do not hand it to whatever replaces the function.
+  struct EntryCountsConfig : public ValueMapConfig<const Function *> {
+    enum { FollowRAUW = false };
+  };
+
+  // EntryCounts - The profiled entry count of each function, from
+  // setFunctionEntryCount, and the largest of them.
+  ValueMap<const Function *, uint64_t, EntryCountsConfig> EntryCounts;
+  uint64_t MaxEntryCount;
+
   /// shouldInline - Return true if the inliner should attempt to
   /// inline at the given CallSite.
   bool shouldInline(CallSite CS);
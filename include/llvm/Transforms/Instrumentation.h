@@ -30,6 +30,13 @@ ModulePass *createOptimalEdgeProfilerPass();
 // Insert path profiling instrumentation
 ModulePass *createPathProfilerPass();
 
+// Insert counter profiling instrumentation, which writes an indexed profile
+ModulePass *createCounterProfilerPass();
+
+// Annotate branch weights and function entry counts from an indexed counter
+// profile; an empty Filename means the file given with -counter-profile-file
+ModulePass *createCounterProfileUsePass(StringRef Filename = StringRef());
+
 // Insert GCOV profiling instrumentation
 struct GCOVOptions {
   static GCOVOptions getDefault();
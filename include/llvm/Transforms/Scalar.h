@@ -15,6 +15,8 @@
 #ifndef LLVM_TRANSFORMS_SCALAR_H
 #define LLVM_TRANSFORMS_SCALAR_H
 
+#include "llvm/ADT/StringRef.h"
+
 namespace llvm {
 
 class FunctionPass;
@@ -346,6 +348,13 @@ extern char &InstructionSimplifierID;
 // "block_weights" metadata.
 FunctionPass *createLowerExpectIntrinsicPass();
 
+//===----------------------------------------------------------------------===//
+//
+// SampleProfilePass - Loads a sample profile (for instance one converted from
+// Linux perf data) and annotates branches with "branch_weights" metadata.  An
+// empty Name means the file given with -sample-profile-file.
+FunctionPass *createSampleProfileLoaderPass(StringRef Name = "");
+
 
 } // End llvm namespace
 
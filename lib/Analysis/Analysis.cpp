@@ -52,6 +52,7 @@ void llvm::initializeAnalysis(PassRegistry &Registry) {
   initializeLoopInfoPass(Registry);
   initializeMemDepPrinterPass(Registry);
   initializeMemoryDependenceAnalysisPass(Registry);
+  initializeMemorySSAPass(Registry);
   initializeModuleDebugInfoPrinterPass(Registry);
   initializePostDominatorTreePass(Registry);
   initializeProfileEstimatorPassPass(Registry);
@@ -13,9 +13,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#define DEBUG_TYPE "basicaa"
 #include "llvm/Analysis/Passes.h"
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
 #include "llvm/Analysis/CaptureTracking.h"
 #include "llvm/Analysis/InstructionSimplify.h"
@@ -32,12 +34,24 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/GetElementPtrTypeIterator.h"
+#include "llvm/Support/ValueHandle.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include <algorithm>
+#include <map>
 using namespace llvm;
 
+STATISTIC(NumQueryCacheHits, "Number of alias queries answered from the cache");
+STATISTIC(NumQueryCacheMisses, "Number of alias queries not in the cache");
+
+static cl::opt<bool>
+EnableQueryCache("basicaa-query-cache", cl::Hidden, cl::init(true),
+                 cl::desc("Remember alias query results across passes that "
+                          "preserve alias analysis, until the pointers "
+                          "involved are changed"));
+
 //===----------------------------------------------------------------------===//
 // Useful predicates
 //===----------------------------------------------------------------------===//
@@ -433,10 +447,9 @@ static void GetIndexDifference(SmallVectorImpl<VariableGEPIndex> &Dest,
 // BasicAliasAnalysis Pass
 //===----------------------------------------------------------------------===//
 
-#ifndef NDEBUG
 static const Function *getParent(const Value *V) {
   if (const Instruction *inst = dyn_cast<Instruction>(V))
-    return inst->getParent()->getParent();
+    return inst->getParent() ? inst->getParent()->getParent() : NULL;
 
   if (const Argument *arg = dyn_cast<Argument>(V))
     return arg->getParent();
@@ -444,6 +457,7 @@ static const Function *getParent(const Value *V) {
   return NULL;
 }
 
+#ifndef NDEBUG
 static bool notDifferentParent(const Value *O1, const Value *O2) {
 
   const Function *F1 = getParent(O1);
@@ -457,10 +471,22 @@ namespace {
   /// BasicAliasAnalysis - This is the primary alias analysis implementation.
   struct BasicAliasAnalysis : public ImmutablePass, public AliasAnalysis {
     static char ID; // Class identification, replacement for typeinfo
-    BasicAliasAnalysis() : ImmutablePass(ID) {
+    BasicAliasAnalysis() : ImmutablePass(ID), QueryCacheFn(0) {
       initializeBasicAliasAnalysisPass(*PassRegistry::getPassRegistry());
     }
 
+    virtual bool doFinalization(Module &M) {
+      clearQueryCache();
+      return false;
+    }
+
+    /// releaseCachedInfo - A pass that does not preserve alias analysis may
+    /// have changed the operands of cached pointers in place, which no value
+    /// handle sees, so drop all cached results.
+    virtual void releaseCachedInfo() {
+      clearQueryCache();
+    }
+
     virtual void initializePass() {
       InitializeAliasAnalysis(this);
     }
@@ -475,16 +501,48 @@ namespace {
       assert(AliasCache.empty() && "AliasCache must be cleared after use!");
       assert(notDifferentParent(LocA.Ptr, LocB.Ptr) &&
              "BasicAliasAnalysis doesn't support interprocedural queries.");
-      AliasResult Alias = aliasCheck(LocA.Ptr, LocA.Size, LocA.TBAATag,
-                                     LocB.Ptr, LocB.Size, LocB.TBAATag);
-      // AliasCache rarely has more than 1 or 2 elements, always use
-      // shrink_and_clear so it quickly returns to the inline capacity of the
-      // SmallDenseMap if it ever grows larger.
-      // FIXME: This should really be shrink_to_inline_capacity_and_clear().
-      AliasCache.shrink_and_clear();
+      if (!EnableQueryCache)
+        return aliasUncached(LocA, LocB);
+
+      // The cache only ever holds queries from one function.
+      const Function *F = getParent(LocA.Ptr);
+      if (!F)
+        F = getParent(LocB.Ptr);
+      if (F && F != QueryCacheFn) {
+        clearQueryCache();
+        QueryCacheFn = F;
+      }
+
+      LocPair Locs(LocA, LocB);
+      if (Locs.first.Ptr > Locs.second.Ptr)
+        std::swap(Locs.first, Locs.second);
+      DenseMap<LocPair, AliasResult>::iterator I = QueryCache.find(Locs);
+      if (I != QueryCache.end()) {
+        ++NumQueryCacheHits;
+        return I->second;
+      }
+      ++NumQueryCacheMisses;
+
+      AliasResult Alias = aliasUncached(LocA, LocB);
+      QueryCache[Locs] = Alias;
+      addQueryCacheUser(Locs.first.Ptr, Locs);
+      if (Locs.second.Ptr != Locs.first.Ptr)
+        addQueryCacheUser(Locs.second.Ptr, Locs);
       return Alias;
     }
 
+    virtual void deleteValue(Value *V) {
+      forgetQueryCacheUser(V);
+      AliasAnalysis::deleteValue(V);
+    }
+
+    virtual void addEscapingUse(Use &U) {
+      // A pointer that was known not to escape may now escape, which can
+      // invalidate any NoAlias result, so start over.
+      clearQueryCache();
+      AliasAnalysis::addEscapingUse(U);
+    }
+
     virtual ModRefResult getModRefInfo(ImmutableCallSite CS,
                                        const Location &Loc);
 
@@ -522,6 +580,72 @@ namespace {
     typedef SmallDenseMap<LocPair, AliasResult, 8> AliasCacheTy;
     AliasCacheTy AliasCache;
 
+    /// QueryCacheVH - Drops the cached results that mention a pointer when
+    /// the pointer is deleted or replaced.
+    struct QueryCacheVH : public CallbackVH {
+      BasicAliasAnalysis *Parent;
+
+      QueryCacheVH(Value *V, BasicAliasAnalysis *P)
+        : CallbackVH(V), Parent(P) {}
+
+      virtual void deleted() {
+        Parent->forgetQueryCacheUser(getValPtr());
+      }
+      virtual void allUsesReplacedWith(Value *) {
+        deleted();
+      }
+    };
+
+    // QueryCache - Results of complete alias queries, kept across passes that
+    // preserve alias analysis for the function QueryCacheFn until the
+    // pointers involved change.
+    DenseMap<LocPair, AliasResult> QueryCache;
+    const Function *QueryCacheFn;
+
+    // QueryCacheUsers - For each pointer in QueryCache, the queries it is part
+    // of, along with the handle that tells us when it changes.
+    typedef std::map<QueryCacheVH, SmallVector<LocPair, 4> > QueryCacheUsersTy;
+    QueryCacheUsersTy QueryCacheUsers;
+
+    void addQueryCacheUser(const Value *V, const LocPair &Locs) {
+      QueryCacheUsersTy::iterator I =
+        QueryCacheUsers.find(QueryCacheVH(const_cast<Value *>(V), this));
+      if (I == QueryCacheUsers.end())
+        I = QueryCacheUsers.insert(std::make_pair(
+              QueryCacheVH(const_cast<Value *>(V), this),
+              SmallVector<LocPair, 4>())).first;
+      I->second.push_back(Locs);
+    }
+
+    void forgetQueryCacheUser(Value *V) {
+      QueryCacheUsersTy::iterator I =
+        QueryCacheUsers.find(QueryCacheVH(V, this));
+      if (I == QueryCacheUsers.end())
+        return;
+      for (unsigned i = 0, e = I->second.size(); i != e; ++i)
+        QueryCache.erase(I->second[i]);
+      // This may be called from I's own handle, so it must come last.
+      QueryCacheUsers.erase(I);
+    }
+
+    void clearQueryCache() {
+      QueryCache.clear();
+      QueryCacheUsers.clear();
+      QueryCacheFn = 0;
+    }
+
+    // aliasUncached - Answer a query without consulting QueryCache.
+    AliasResult aliasUncached(const Location &LocA, const Location &LocB) {
+      AliasResult Alias = aliasCheck(LocA.Ptr, LocA.Size, LocA.TBAATag,
+                                     LocB.Ptr, LocB.Size, LocB.TBAATag);
+      // AliasCache rarely has more than 1 or 2 elements, always use
+      // shrink_and_clear so it quickly returns to the inline capacity of the
+      // SmallDenseMap if it ever grows larger.
+      // FIXME: This should really be shrink_to_inline_capacity_and_clear().
+      AliasCache.shrink_and_clear();
+      return Alias;
+    }
+
     // Visited - Track instructions visited by pointsToConstantMemory.
     SmallPtrSet<const Value*, 16> Visited;
 
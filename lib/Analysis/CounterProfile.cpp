@@ -0,0 +1,284 @@
+//===- CounterProfile.cpp - Counter-based profile data --------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the counter layout, the structural hash and the indexed
+// file format shared by counter profiling and its users.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Analysis/CounterProfile.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+using namespace llvm;
+
+/// Magic - "\xfflprofdc", the first word of an indexed counter profile.
+static const uint64_t Magic = 0xff6c70726f666463ULL;
+static const uint64_t Version = 1;
+
+static const unsigned HeaderWords = 5;
+static const unsigned IndexEntryWords = 5;
+
+static const char *const EntryCountsName = "llvm.function_entry_counts";
+
+static uint64_t readWord(const char *P, uint64_t I = 0) {
+  return support::endian::read<uint64_t, support::little,
+                               support::unaligned>(P + I * 8);
+}
+
+static void writeWord(raw_ostream &OS, uint64_t V) {
+  char Bytes[8];
+  support::endian::write<uint64_t, support::little,
+                         support::unaligned>(Bytes, V);
+  OS.write(Bytes, sizeof(Bytes));
+}
+
+//===----------------------------------------------------------------------===//
+// Counter layout
+//===----------------------------------------------------------------------===//
+
+void llvm::getCounterProfileEdges(Function &F,
+                                  SmallVectorImpl<CounterProfileEdge> &Edges) {
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    TerminatorInst *TI = BB->getTerminator();
+    if (TI->getNumSuccessors() < 2 ||
+        (!isa<BranchInst>(TI) && !isa<SwitchInst>(TI)))
+      continue;
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i)
+      Edges.push_back(CounterProfileEdge(TI, i));
+  }
+}
+
+uint64_t llvm::getCounterProfileHash(const Function &F) {
+  // FNV-1a over the number of blocks and the successor count of each block;
+  // unlike hash_combine it gives the same result in every process.
+  uint64_t Hash = 0xcbf29ce484222325ULL;
+  SmallVector<uint64_t, 32> Words;
+  Words.push_back(F.size());
+  for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    Words.push_back(BB->getTerminator()->getNumSuccessors());
+  for (unsigned i = 0, e = Words.size(); i != e; ++i)
+    for (unsigned Byte = 0; Byte != 8; ++Byte) {
+      Hash ^= (Words[i] >> (Byte * 8)) & 0xff;
+      Hash *= 0x100000001b3ULL;
+    }
+  return Hash;
+}
+
+std::string llvm::getCounterProfileName(const Function &F) {
+  if (!F.hasLocalLinkage())
+    return F.getName();
+  return F.getParent()->getModuleIdentifier() + ":" + F.getName().str();
+}
+
+void llvm::setFunctionEntryCount(Function &F, uint64_t Count) {
+  LLVMContext &Ctx = F.getContext();
+  Value *Ops[] = { &F, ConstantInt::get(Type::getInt64Ty(Ctx), Count) };
+  F.getParent()->getOrInsertNamedMetadata(EntryCountsName)
+    ->addOperand(MDNode::get(Ctx, Ops));
+}
+
+void
+llvm::getFunctionEntryCounts(const Module &M,
+                              DenseMap<const Function *, uint64_t> &Counts) {
+  NamedMDNode *NMD = M.getNamedMetadata(EntryCountsName);
+  if (!NMD)
+    return;
+  for (unsigned i = 0, e = NMD->getNumOperands(); i != e; ++i) {
+    MDNode *N = NMD->getOperand(i);
+    if (N->getNumOperands() != 2)
+      continue;
+    // The function operand is null once the function has been deleted.
+    Function *F = dyn_cast_or_null<Function>(N->getOperand(0));
+    ConstantInt *Count = dyn_cast_or_null<ConstantInt>(N->getOperand(1));
+    if (F && Count)
+      Counts[F] = Count->getZExtValue();
+  }
+}
+
+//===----------------------------------------------------------------------===//
+// CounterProfileReader
+//===----------------------------------------------------------------------===//
+
+CounterProfileReader::CounterProfileReader(MemoryBuffer *Buffer)
+  : Buffer(Buffer), NumFunctions(0), Index(0), Names(0), Counters(0) {}
+
+CounterProfileReader::~CounterProfileReader() {}
+
+CounterProfileReader *CounterProfileReader::create(StringRef Filename,
+                                                   std::string &ErrorMsg) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFileOrSTDIN(Filename, Buffer)) {
+    ErrorMsg = Filename.str() + ": " + EC.message();
+    return 0;
+  }
+  CounterProfileReader *Reader = create(Buffer.take(), ErrorMsg);
+  if (!Reader)
+    ErrorMsg = Filename.str() + ": " + ErrorMsg;
+  return Reader;
+}
+
+CounterProfileReader *CounterProfileReader::create(MemoryBuffer *Buffer,
+                                                   std::string &ErrorMsg) {
+  OwningPtr<CounterProfileReader> Reader(new CounterProfileReader(Buffer));
+  if (!Reader->parseHeader(ErrorMsg))
+    return 0;
+  return Reader.take();
+}
+
+bool CounterProfileReader::hasIndexedMagic(const MemoryBuffer &Buffer) {
+  return Buffer.getBufferSize() >= 8 &&
+         readWord(Buffer.getBufferStart()) == Magic;
+}
+
+/// parseHeader - Validate the header and the index, so that later lookups
+/// need no bounds checks.
+bool CounterProfileReader::parseHeader(std::string &ErrorMsg) {
+  const char *Start = Buffer->getBufferStart();
+  uint64_t Size = Buffer->getBufferSize();
+  if (!hasIndexedMagic(*Buffer) || Size < HeaderWords * 8) {
+    ErrorMsg = "not an indexed counter profile";
+    return false;
+  }
+  if (readWord(Start, 1) != Version) {
+    ErrorMsg = "unsupported counter profile version";
+    return false;
+  }
+
+  NumFunctions = readWord(Start, 2);
+  uint64_t NamesSize = readWord(Start, 3);
+  uint64_t NumCounters = readWord(Start, 4);
+  uint64_t Words = Size / 8;
+  if (Size % 8 != 0 || NamesSize % 8 != 0 ||
+      NumFunctions > Words / IndexEntryWords ||
+      NumCounters > Words ||
+      HeaderWords + NumFunctions * IndexEntryWords + NamesSize / 8 +
+        NumCounters != Words) {
+    ErrorMsg = "malformed counter profile";
+    return false;
+  }
+
+  Index = Start + HeaderWords * 8;
+  Names = Index + NumFunctions * IndexEntryWords * 8;
+  Counters = Names + NamesSize;
+
+  for (uint64_t I = 0; I != NumFunctions; ++I) {
+    const char *Entry = Index + I * IndexEntryWords * 8;
+    uint64_t NameOffset = readWord(Entry, 0), NameSize = readWord(Entry, 1);
+    uint64_t Count = readWord(Entry, 3), CounterOffset = readWord(Entry, 4);
+    if (NameOffset > NamesSize || NameSize > NamesSize - NameOffset ||
+        CounterOffset > NumCounters || Count > NumCounters - CounterOffset) {
+      ErrorMsg = "malformed counter profile index";
+      return false;
+    }
+  }
+  return true;
+}
+
+StringRef CounterProfileReader::getName(uint64_t I) const {
+  const char *Entry = Index + I * IndexEntryWords * 8;
+  return StringRef(Names + readWord(Entry, 0), readWord(Entry, 1));
+}
+
+void CounterProfileReader::getRecord(uint64_t I,
+                                     CounterProfileRecord &Record) const {
+  assert(I < NumFunctions && "Function index out of range!");
+  const char *Entry = Index + I * IndexEntryWords * 8;
+  Record.Name = getName(I);
+  Record.Hash = readWord(Entry, 2);
+  uint64_t Count = readWord(Entry, 3), CounterOffset = readWord(Entry, 4);
+  Record.Counts.resize(Count);
+  for (uint64_t C = 0; C != Count; ++C)
+    Record.Counts[C] = readWord(Counters, CounterOffset + C);
+}
+
+bool CounterProfileReader::findFunction(StringRef Name, uint64_t &Hash,
+                                        std::vector<uint64_t> &Counts) const {
+  uint64_t Lo = 0, Hi = NumFunctions;
+  while (Lo < Hi) {
+    uint64_t Mid = Lo + (Hi - Lo) / 2;
+    int Cmp = getName(Mid).compare(Name);
+    if (Cmp == 0) {
+      CounterProfileRecord Record;
+      getRecord(Mid, Record);
+      Hash = Record.Hash;
+      Counts.swap(Record.Counts);
+      return true;
+    }
+    if (Cmp < 0)
+      Lo = Mid + 1;
+    else
+      Hi = Mid;
+  }
+  return false;
+}
+
+//===----------------------------------------------------------------------===//
+// CounterProfileWriter
+//===----------------------------------------------------------------------===//
+
+bool CounterProfileWriter::addRecord(const CounterProfileRecord &Record) {
+  std::pair<std::map<std::string, CounterProfileRecord>::iterator, bool> R =
+    Records.insert(std::make_pair(Record.Name, Record));
+  if (R.second)
+    return true;
+
+  CounterProfileRecord &Existing = R.first->second;
+  if (Existing.Hash != Record.Hash ||
+      Existing.Counts.size() != Record.Counts.size())
+    return false;
+  for (unsigned i = 0, e = Record.Counts.size(); i != e; ++i) {
+    // Saturate rather than wrap when merging very long runs.
+    uint64_t Sum = Existing.Counts[i] + Record.Counts[i];
+    Existing.Counts[i] = Sum < Record.Counts[i] ? UINT64_MAX : Sum;
+  }
+  return true;
+}
+
+void CounterProfileWriter::write(raw_ostream &OS) const {
+  typedef std::map<std::string, CounterProfileRecord>::const_iterator iterator;
+
+  uint64_t NamesSize = 0, NumCounters = 0;
+  for (iterator I = Records.begin(), E = Records.end(); I != E; ++I) {
+    NamesSize += I->first.size();
+    NumCounters += I->second.Counts.size();
+  }
+  uint64_t Padding = (8 - NamesSize % 8) % 8;
+
+  writeWord(OS, Magic);
+  writeWord(OS, Version);
+  writeWord(OS, Records.size());
+  writeWord(OS, NamesSize + Padding);
+  writeWord(OS, NumCounters);
+
+  uint64_t NameOffset = 0, CounterOffset = 0;
+  for (iterator I = Records.begin(), E = Records.end(); I != E; ++I) {
+    writeWord(OS, NameOffset);
+    writeWord(OS, I->first.size());
+    writeWord(OS, I->second.Hash);
+    writeWord(OS, I->second.Counts.size());
+    writeWord(OS, CounterOffset);
+    NameOffset += I->first.size();
+    CounterOffset += I->second.Counts.size();
+  }
+
+  for (iterator I = Records.begin(), E = Records.end(); I != E; ++I)
+    OS << I->first;
+  OS.indent(Padding);
+
+  for (iterator I = Records.begin(), E = Records.end(); I != E; ++I)
+    for (unsigned i = 0, e = I->second.Counts.size(); i != e; ++i)
+      writeWord(OS, I->second.Counts[i]);
+}
@@ -121,6 +121,9 @@ bool CGPassManager::RunPassOnSCC(Pass *P, CallGraphSCC &CurSCC,
 
     {
       TimeRegion PassTimer(getPassTimer(CGSP));
+      Function *F = (*CurSCC.begin())->getFunction();
+      PassTraceRegion PassTrace(CGSP->getPassName(), "cgscc",
+                                F ? F->getName() : "<external node>");
       Changed = CGSP->runOnSCC(CurSCC);
     }
     
@@ -28,13 +28,106 @@
 #include "llvm/IR/Operator.h"
 #include "llvm/InstVisitor.h"
 #include "llvm/Support/CallSite.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/GetElementPtrTypeIterator.h"
+#include "llvm/Support/ValueHandle.h"
 #include "llvm/Support/raw_ostream.h"
+#include <map>
 
 using namespace llvm;
 
 STATISTIC(NumCallsAnalyzed, "Number of call sites analyzed");
+STATISTIC(NumCalleeCacheHits,
+          "Number of call sites whose callee analysis was reused");
+
+static cl::opt<bool>
+EnableCalleeCache("inline-cost-callee-cache", cl::Hidden, cl::init(true),
+                  cl::desc("Reuse the analysis of a callee's body across "
+                           "call sites that pass it nothing to simplify"));
+
+namespace llvm {
+
+/// \brief The outcome of walking a callee's body, which depends only on the
+/// callee and the state the walk started from when the call site passes no
+/// constants, allocas or related pointers.
+struct CalleeBodySummary {
+  // The state the walk started from.
+  int RequestedThreshold, StartCost, StartThreshold;
+  bool IsCallerRecursive;
+
+  // The state the walk ended in.
+  int Cost, Threshold, VectorBonus;
+  bool Viable, ContainsNoDuplicateCall;
+  unsigned NumConstantPtrCmps, NumConstantPtrDiffs, NumInstructionsSimplified;
+};
+
+/// \brief Memoized CalleeBodySummary results for the callees of the SCCs
+/// that InlineCostAnalysis has visited.
+class InlineCostCache {
+  /// CalleeVH - Drops a callee's summaries when it is deleted or replaced.
+  struct CalleeVH : public CallbackVH {
+    InlineCostCache *Parent;
+
+    CalleeVH(Value *V, InlineCostCache *P) : CallbackVH(V), Parent(P) {}
+
+    void deleted() {
+      // This erasure deallocates *this, so it must be the last thing done.
+      Parent->Summaries.erase(*this);
+    }
+    void allUsesReplacedWith(Value *) {
+      deleted();
+    }
+  };
+
+  std::map<CalleeVH, SmallVector<CalleeBodySummary, 2> > Summaries;
+
+  /// CurrentSCC - The functions the inliner is currently working on.  They
+  /// may still change, so their bodies are never cached.
+  SmallPtrSet<const Function *, 8> CurrentSCC;
+
+public:
+  void enterSCC(CallGraphSCC &SCC) {
+    CurrentSCC.clear();
+    for (CallGraphSCC::iterator I = SCC.begin(), E = SCC.end(); I != E; ++I)
+      if (Function *F = (*I)->getFunction()) {
+        CurrentSCC.insert(F);
+        Summaries.erase(CalleeVH(F, this));
+      }
+  }
+
+  bool isCacheable(const Function &F) const {
+    return !CurrentSCC.count(&F);
+  }
+
+  const CalleeBodySummary *lookup(Function &F, int RequestedThreshold,
+                                  int StartCost, int StartThreshold,
+                                  bool IsCallerRecursive) {
+    std::map<CalleeVH, SmallVector<CalleeBodySummary, 2> >::iterator I =
+      Summaries.find(CalleeVH(&F, this));
+    if (I == Summaries.end())
+      return 0;
+    for (unsigned i = 0, e = I->second.size(); i != e; ++i) {
+      const CalleeBodySummary &S = I->second[i];
+      if (S.RequestedThreshold == RequestedThreshold &&
+          S.StartCost == StartCost && S.StartThreshold == StartThreshold &&
+          S.IsCallerRecursive == IsCallerRecursive)
+        return &S;
+    }
+    return 0;
+  }
+
+  void insert(Function &F, const CalleeBodySummary &S) {
+    Summaries[CalleeVH(&F, this)].push_back(S);
+  }
+
+  void clear() {
+    Summaries.clear();
+    CurrentSCC.clear();
+  }
+};
+
+}
 
 namespace {
 
@@ -51,6 +144,9 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
   // The called function.
   Function &F;
 
+  // Summaries of previously analyzed callee bodies, or null.
+  InlineCostCache *Cache;
+
   int Threshold;
   int Cost;
 
@@ -105,6 +201,8 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
 
   // Custom analysis routines.
   bool analyzeBlock(BasicBlock *BB);
+  bool analyzeBody(int SingleBBBonus);
+  bool hasArgumentSimplifications();
 
   // Disable several entry points to the visitor so we don't accidentally use
   // them by declaring but not defining them here.
@@ -135,8 +233,9 @@ class CallAnalyzer : public InstVisitor<CallAnalyzer, bool> {
 
 public:
   CallAnalyzer(const DataLayout *TD, const TargetTransformInfo &TTI,
-               Function &Callee, int Threshold)
-      : TD(TD), TTI(TTI), F(Callee), Threshold(Threshold), Cost(0),
+               Function &Callee, int Threshold, InlineCostCache *Cache = 0)
+      : TD(TD), TTI(TTI), F(Callee), Cache(Cache), Threshold(Threshold),
+        Cost(0),
         IsCallerRecursive(false), IsRecursiveCall(false),
         ExposesReturnsTwice(false), HasDynamicAlloca(false),
         ContainsNoDuplicateCall(false), AllocatedSize(0), NumInstructions(0),
@@ -898,7 +997,7 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
   // Track whether the post-inlining function would have more than one basic
   // block. A single basic block is often intended for inlining. Balloon the
   // threshold by 50% until we pass the single-BB phase.
-  bool SingleBB = true;
+  int RequestedThreshold = Threshold;
   int SingleBBBonus = Threshold / 2;
   Threshold += SingleBBBonus;
 
@@ -985,10 +1084,6 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
     }
   }
 
-  // Track whether we've seen a return instruction. The first return
-  // instruction is free, as at least one will usually disappear in inlining.
-  bool HasReturn = false;
-
   // Populate our simplified values by mapping from function arguments to call
   // arguments with known important simplifications.
   CallSite::arg_iterator CAI = CS.arg_begin();
@@ -1013,6 +1108,88 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
   NumConstantOffsetPtrArgs = ConstantOffsetPtrs.size();
   NumAllocaArgs = SROAArgValues.size();
 
+  // Walk the callee body, or reuse an earlier walk that started from the same
+  // state.
+  bool Viable;
+  bool UseCache = Cache && Cache->isCacheable(F) &&
+    !hasArgumentSimplifications();
+  if (const CalleeBodySummary *S =
+        UseCache ? Cache->lookup(F, RequestedThreshold, Cost, Threshold,
+                                 IsCallerRecursive) : 0) {
+    ++NumCalleeCacheHits;
+    Cost = S->Cost;
+    Threshold = S->Threshold;
+    VectorBonus = S->VectorBonus;
+    Viable = S->Viable;
+    ContainsNoDuplicateCall = S->ContainsNoDuplicateCall;
+    NumConstantPtrCmps = S->NumConstantPtrCmps;
+    NumConstantPtrDiffs = S->NumConstantPtrDiffs;
+    NumInstructionsSimplified = S->NumInstructionsSimplified;
+  } else {
+    CalleeBodySummary Summary;
+    Summary.RequestedThreshold = RequestedThreshold;
+    Summary.StartCost = Cost;
+    Summary.StartThreshold = Threshold;
+    Summary.IsCallerRecursive = IsCallerRecursive;
+    Viable = analyzeBody(SingleBBBonus);
+    if (UseCache) {
+      Summary.Cost = Cost;
+      Summary.Threshold = Threshold;
+      Summary.VectorBonus = VectorBonus;
+      Summary.Viable = Viable;
+      Summary.ContainsNoDuplicateCall = ContainsNoDuplicateCall;
+      Summary.NumConstantPtrCmps = NumConstantPtrCmps;
+      Summary.NumConstantPtrDiffs = NumConstantPtrDiffs;
+      Summary.NumInstructionsSimplified = NumInstructionsSimplified;
+      Cache->insert(F, Summary);
+    }
+  }
+  if (!Viable)
+    return false;
+
+  // If this is a noduplicate call, we can still inline as long as 
+  // inlining this would cause the removal of the caller (so the instruction
+  // is not actually duplicated, just moved).
+  if (!OnlyOneCallAndLocalLinkage && ContainsNoDuplicateCall)
+    return false;
+
+  Threshold += VectorBonus;
+
+  return Cost < Threshold;
+}
+
+/// \brief Test whether the arguments of the call site being analyzed give
+/// the callee body anything to simplify.
+///
+/// If they do not, walking the body depends only on the callee and the cost
+/// and threshold the walk starts from, so its result can be shared by every
+/// such call site.  Pointer arguments are always tracked, so they must have
+/// distinct bases and no offset to be indistinguishable from opaque values.
+bool CallAnalyzer::hasArgumentSimplifications() {
+  if (!SimplifiedValues.empty() || !SROAArgValues.empty())
+    return true;
+  SmallPtrSet<Value *, 8> Bases;
+  for (DenseMap<Value *, std::pair<Value *, APInt> >::iterator
+       I = ConstantOffsetPtrs.begin(), E = ConstantOffsetPtrs.end();
+       I != E; ++I)
+    if (I->second.second != 0 || !Bases.insert(I->second.first))
+      return true;
+  return false;
+}
+
+/// \brief Walk the basic blocks of the callee that are live for this call
+/// site, accumulating their cost.
+///
+/// SingleBBBonus is the part of the threshold that is taken away again once
+/// the callee turns out to have more than one live block.  Returns false if
+/// inlining is not viable.
+bool CallAnalyzer::analyzeBody(int SingleBBBonus) {
+  bool SingleBB = true;
+
+  // Track whether we've seen a return instruction. The first return
+  // instruction is free, as at least one will usually disappear in inlining.
+  bool HasReturn = false;
+
   // The worklist of live basic blocks in the callee *after* inlining. We avoid
   // adding basic blocks of the callee which can be proven to be dead for this
   // particular call site in order to get more accurate cost estimates. This
@@ -1111,15 +1288,7 @@ bool CallAnalyzer::analyzeCall(CallSite CS) {
     }
   }
 
-  // If this is a noduplicate call, we can still inline as long as 
-  // inlining this would cause the removal of the caller (so the instruction
-  // is not actually duplicated, just moved).
-  if (!OnlyOneCallAndLocalLinkage && ContainsNoDuplicateCall)
-    return false;
-
-  Threshold += VectorBonus;
-
-  return Cost < Threshold;
+  return true;
 }
 
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_DUMP)
@@ -1147,9 +1316,12 @@ INITIALIZE_PASS_END(InlineCostAnalysis, "inline-cost", "Inline Cost Analysis",
 
 char InlineCostAnalysis::ID = 0;
 
-InlineCostAnalysis::InlineCostAnalysis() : CallGraphSCCPass(ID), TD(0) {}
+InlineCostAnalysis::InlineCostAnalysis()
+  : CallGraphSCCPass(ID), TD(0), Cache(new InlineCostCache()) {}
 
-InlineCostAnalysis::~InlineCostAnalysis() {}
+InlineCostAnalysis::~InlineCostAnalysis() {
+  delete Cache;
+}
 
 void InlineCostAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.setPreservesAll();
@@ -1160,6 +1332,12 @@ void InlineCostAnalysis::getAnalysisUsage(AnalysisUsage &AU) const {
 bool InlineCostAnalysis::runOnSCC(CallGraphSCC &SCC) {
   TD = getAnalysisIfAvailable<DataLayout>();
   TTI = &getAnalysis<TargetTransformInfo>();
+  Cache->enterSCC(SCC);
+  return false;
+}
+
+bool InlineCostAnalysis::doFinalization(CallGraph &CG) {
+  Cache->clear();
   return false;
 }
 
@@ -1194,7 +1372,8 @@ InlineCost InlineCostAnalysis::getInlineCost(CallSite CS, Function *Callee,
   DEBUG(llvm::dbgs() << "      Analyzing call of " << Callee->getName()
         << "...\n");
 
-  CallAnalyzer CA(TD, *TTI, *Callee, Threshold);
+  CallAnalyzer CA(TD, *TTI, *Callee, Threshold,
+                  EnableCalleeCache ? Cache : 0);
   bool ShouldInline = CA.analyzeCall(CS);
 
   DEBUG(CA.dump());
@@ -14,8 +14,11 @@
 
 #define DEBUG_TYPE "lazy-value-info"
 #include "llvm/Analysis/LazyValueInfo.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/ConstantFolding.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
@@ -23,17 +26,29 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ConstantRange.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/PatternMatch.h"
 #include "llvm/Support/ValueHandle.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetLibraryInfo.h"
-#include <map>
 #include <stack>
 using namespace llvm;
 using namespace PatternMatch;
 
+STATISTIC(NumBlockValuesComputed, "Number of block values computed");
+STATISTIC(NumQueriesAbandoned,
+          "Number of queries that exceeded the solver step budget");
+STATISTIC(NumBlockValuesAbandoned,
+          "Number of block values made overdefined by abandoned queries");
+
+static cl::opt<unsigned>
+MaxBlockValueSteps("lvi-max-block-value-steps", cl::Hidden,
+                   cl::desc("Maximum number of block values the lazy value "
+                            "solver visits for a single query"),
+                   cl::init(500));
+
 char LazyValueInfo::ID = 0;
 INITIALIZE_PASS_BEGIN(LazyValueInfo, "lazy-value-info",
                 "Lazy Value Information Analysis", false, true)
@@ -314,20 +329,34 @@ namespace {
   /// LazyValueInfoCache - This is the cache kept by LazyValueInfo which
   /// maintains information about queries across the clients' queries.
   class LazyValueInfoCache {
+    /// BlockValsTy - The lattice values of one Value* at the end of the blocks
+    /// it has been queried in.  Most values are only live in a handful of
+    /// blocks, so the first few entries are stored inline.
+    typedef SmallDenseMap<AssertingVH<BasicBlock>, LVILatticeVal, 4>
+      BlockValsTy;
+
     /// ValueCacheEntryTy - This is all of the cached block information for
-    /// exactly one Value*.  The entries are sorted by the BasicBlock* of the
-    /// entries, allowing us to do a lookup with a binary search.
-    typedef std::map<AssertingVH<BasicBlock>, LVILatticeVal> ValueCacheEntryTy;
+    /// exactly one Value*, along with the handle that drops it when the value
+    /// is deleted or replaced.
+    struct ValueCacheEntryTy {
+      ValueCacheEntryTy(Value *V, LazyValueInfoCache *P) : Handle(V, P) {}
+
+      LVIValueHandle Handle;
+      BlockValsTy BlockVals;
+    };
 
     /// ValueCache - This is all of the cached information for all values,
-    /// mapped from Value* to key information.
-    std::map<LVIValueHandle, ValueCacheEntryTy> ValueCache;
+    /// mapped from Value* to key information.  The entries are allocated
+    /// separately so that they stay put while the map grows.
+    typedef DenseMap<Value*, ValueCacheEntryTy*> ValueCacheTy;
+    ValueCacheTy ValueCache;
     
     /// OverDefinedCache - This tracks, on a per-block basis, the set of 
     /// values that are over-defined at the end of that block.  This is required
     /// for cache updating.
-    typedef std::pair<AssertingVH<BasicBlock>, Value*> OverDefinedPairTy;
-    DenseSet<OverDefinedPairTy> OverDefinedCache;
+    typedef DenseMap<AssertingVH<BasicBlock>, SmallPtrSet<Value*, 4> >
+      OverDefinedCacheTy;
+    OverDefinedCacheTy OverDefinedCache;
 
     /// SeenBlocks - Keep track of all blocks that we have ever seen, so we
     /// don't spend time removing unused blocks from our caches.
@@ -340,8 +369,9 @@ namespace {
     
     friend struct LVIValueHandle;
     
-    /// OverDefinedCacheUpdater - A helper object that ensures that the
-    /// OverDefinedCache is updated whenever solveBlockValue returns.
+    /// OverDefinedCacheUpdater - A helper object that stores the result of
+    /// solveBlockValue in the cache, and ensures that the OverDefinedCache is
+    /// updated, whenever solveBlockValue returns.
     struct OverDefinedCacheUpdater {
       LazyValueInfoCache *Parent;
       Value *Val;
@@ -353,8 +383,12 @@ namespace {
         : Parent(P), Val(V), BB(B), BBLV(LV) { }
       
       bool markResult(bool changed) { 
-        if (changed && BBLV.isOverdefined())
-          Parent->OverDefinedCache.insert(std::make_pair(BB, Val));
+        if (changed) {
+          ++NumBlockValuesComputed;
+          Parent->lookup(Val)[BB] = BBLV;
+          if (BBLV.isOverdefined())
+            Parent->OverDefinedCache[BB].insert(Val);
+        }
         return changed;
       }
     };
@@ -378,12 +412,18 @@ namespace {
                                       Instruction *BBI, BasicBlock *BB);
 
     void solve();
+    void abandonQuery();
     
-    ValueCacheEntryTy &lookup(Value *V) {
-      return ValueCache[LVIValueHandle(V, this)];
+    BlockValsTy &lookup(Value *V) {
+      ValueCacheEntryTy *&Entry = ValueCache[V];
+      if (!Entry)
+        Entry = new ValueCacheEntryTy(V, this);
+      return Entry->BlockVals;
     }
 
   public:
+    ~LazyValueInfoCache() { clear(); }
+
     /// getValueInBlock - This is the query interface to determine the lattice
     /// value for the specified Value* at the end of the specified block.
     LVILatticeVal getValueInBlock(Value *V, BasicBlock *BB);
@@ -404,31 +444,28 @@ namespace {
     /// clear - Empty the cache.
     void clear() {
       SeenBlocks.clear();
-      ValueCache.clear();
+      DeleteContainerSeconds(ValueCache);
       OverDefinedCache.clear();
     }
   };
 } // end anonymous namespace
 
 void LVIValueHandle::deleted() {
-  typedef std::pair<AssertingVH<BasicBlock>, Value*> OverDefinedPairTy;
-  
-  SmallVector<OverDefinedPairTy, 4> ToErase;
-  for (DenseSet<OverDefinedPairTy>::iterator 
+  for (LazyValueInfoCache::OverDefinedCacheTy::iterator
        I = Parent->OverDefinedCache.begin(),
        E = Parent->OverDefinedCache.end();
-       I != E; ++I) {
-    if (I->second == getValPtr())
-      ToErase.push_back(*I);
-  }
-  
-  for (SmallVector<OverDefinedPairTy, 4>::iterator I = ToErase.begin(),
-       E = ToErase.end(); I != E; ++I)
-    Parent->OverDefinedCache.erase(*I);
+       I != E; ++I)
+    I->second.erase(getValPtr());
   
-  // This erasure deallocates *this, so it MUST happen after we're done
-  // using any and all members of *this.
-  Parent->ValueCache.erase(*this);
+  LazyValueInfoCache::ValueCacheTy::iterator I =
+    Parent->ValueCache.find(getValPtr());
+  assert(I != Parent->ValueCache.end() && "Handle without a cache entry?");
+  LazyValueInfoCache::ValueCacheEntryTy *Entry = I->second;
+  Parent->ValueCache.erase(I);
+
+  // This deallocates *this, so it MUST happen after we're done using any and
+  // all members of *this.
+  delete Entry;
 }
 
 void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
@@ -438,24 +475,24 @@ void LazyValueInfoCache::eraseBlock(BasicBlock *BB) {
     return;
   SeenBlocks.erase(I);
 
-  SmallVector<OverDefinedPairTy, 4> ToErase;
-  for (DenseSet<OverDefinedPairTy>::iterator  I = OverDefinedCache.begin(),
-       E = OverDefinedCache.end(); I != E; ++I) {
-    if (I->first == BB)
-      ToErase.push_back(*I);
-  }
-  
-  for (SmallVector<OverDefinedPairTy, 4>::iterator I = ToErase.begin(),
-       E = ToErase.end(); I != E; ++I)
-    OverDefinedCache.erase(*I);
+  OverDefinedCache.erase(BB);
 
-  for (std::map<LVIValueHandle, ValueCacheEntryTy>::iterator
-       I = ValueCache.begin(), E = ValueCache.end(); I != E; ++I)
-    I->second.erase(BB);
+  for (ValueCacheTy::iterator I = ValueCache.begin(), E = ValueCache.end();
+       I != E; ++I)
+    I->second->BlockVals.erase(BB);
 }
 
 void LazyValueInfoCache::solve() {
+  // Give every query a fixed budget.  Without one, a query in a function
+  // with long chains of blocks or large switches can visit most of the
+  // function, and JumpThreading and CorrelatedValuePropagation make a query
+  // for nearly every branch.
+  unsigned Steps = 0;
   while (!BlockValueStack.empty()) {
+    if (++Steps > MaxBlockValueSteps) {
+      abandonQuery();
+      return;
+    }
     std::pair<BasicBlock*, Value*> &e = BlockValueStack.top();
     if (solveBlockValue(e.second, e.first)) {
       assert(BlockValueStack.top() == e);
@@ -464,16 +501,37 @@ void LazyValueInfoCache::solve() {
   }
 }
 
+/// abandonQuery - Empty the solver stack, giving every pending block value
+/// the answer that is always safe: overdefined.  Blocks the solver already
+/// started on hold an overdefined placeholder, the others get one now, so
+/// that the query can read its result as if the solver had finished.
+void LazyValueInfoCache::abandonQuery() {
+  DEBUG(dbgs() << "LVI giving up after " << MaxBlockValueSteps
+               << " steps\n");
+  ++NumQueriesAbandoned;
+  while (!BlockValueStack.empty()) {
+    std::pair<BasicBlock*, Value*> e = BlockValueStack.top();
+    BlockValueStack.pop();
+
+    SeenBlocks.insert(e.first);
+    LVILatticeVal &BBLV = lookup(e.second)[e.first];
+    // The same block value may have been pushed more than once, and solved
+    // since.  Keep what was found.
+    if (BBLV.isUndefined())
+      BBLV.markOverdefined();
+    if (BBLV.isOverdefined() && OverDefinedCache[e.first].insert(e.second))
+      ++NumBlockValuesAbandoned;
+  }
+}
+
 bool LazyValueInfoCache::hasBlockValue(Value *Val, BasicBlock *BB) {
   // If already a constant, there is nothing to compute.
   if (isa<Constant>(Val))
     return true;
 
-  LVIValueHandle ValHandle(Val, this);
-  std::map<LVIValueHandle, ValueCacheEntryTy>::iterator I =
-    ValueCache.find(ValHandle);
+  ValueCacheTy::const_iterator I = ValueCache.find(Val);
   if (I == ValueCache.end()) return false;
-  return I->second.count(BB);
+  return I->second->BlockVals.count(BB);
 }
 
 LVILatticeVal LazyValueInfoCache::getBlockValue(Value *Val, BasicBlock *BB) {
@@ -489,31 +547,35 @@ bool LazyValueInfoCache::solveBlockValue(Value *Val, BasicBlock *BB) {
   if (isa<Constant>(Val))
     return true;
 
-  ValueCacheEntryTy &Cache = lookup(Val);
   SeenBlocks.insert(BB);
-  LVILatticeVal &BBLV = Cache[BB];
-  
-  // OverDefinedCacheUpdater is a helper object that will update
-  // the OverDefinedCache for us when this method exits.  Make sure to
-  // call markResult on it as we exist, passing a bool to indicate if the
-  // cache needs updating, i.e. if we have solve a new value or not.
-  OverDefinedCacheUpdater ODCacheUpdater(Val, BB, BBLV, this);
+  LVILatticeVal &CachedLV = lookup(Val)[BB];
 
   // If we've already computed this block's value, return it.
-  if (!BBLV.isUndefined()) {
-    DEBUG(dbgs() << "  reuse BB '" << BB->getName() << "' val=" << BBLV <<'\n');
+  if (!CachedLV.isUndefined()) {
+    DEBUG(dbgs() << "  reuse BB '" << BB->getName() << "' val=" << CachedLV
+                 << '\n');
     
     // Since we're reusing a cached value here, we don't need to update the 
-    // OverDefinedCahce.  The cache will have been properly updated 
+    // OverDefinedCache.  The cache will have been properly updated 
     // whenever the cached value was inserted.
-    ODCacheUpdater.markResult(false);
     return true;
   }
 
   // Otherwise, this is the first time we're seeing this block.  Reset the
   // lattice value to overdefined, so that cycles will terminate and be
   // conservatively correct.
+  CachedLV.markOverdefined();
+
+  // The value is computed in a local, as the lookups below may grow the
+  // cache and move the entry.
+  LVILatticeVal BBLV;
   BBLV.markOverdefined();
+
+  // OverDefinedCacheUpdater is a helper object that will store BBLV and
+  // update the OverDefinedCache for us when this method exits.  Make sure to
+  // call markResult on it as we exit, passing a bool to indicate if the
+  // cache needs updating, i.e. if we have solved a new value or not.
+  OverDefinedCacheUpdater ODCacheUpdater(Val, BB, BBLV, this);
   
   Instruction *BBI = dyn_cast<Instruction>(Val);
   if (BBI == 0 || BBI->getParent() != BB) {
@@ -950,16 +1012,16 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
   // for all values that were marked overdefined in OldSucc, and for those same
   // values in any successor of OldSucc (except NewSucc) in which they were
   // also marked overdefined.
+  OverDefinedCacheTy::iterator OldI = OverDefinedCache.find(OldSucc);
+  if (OldI == OverDefinedCache.end())
+    return;
+
+  // Copy the values out, as the loop below erases them from the set.
+  SmallVector<Value*, 8> ClearSet(OldI->second.begin(), OldI->second.end());
+
   std::vector<BasicBlock*> worklist;
   worklist.push_back(OldSucc);
   
-  DenseSet<Value*> ClearSet;
-  for (DenseSet<OverDefinedPairTy>::iterator I = OverDefinedCache.begin(),
-       E = OverDefinedCache.end(); I != E; ++I) {
-    if (I->first == OldSucc)
-      ClearSet.insert(I->second);
-  }
-  
   // Use a worklist to perform a depth-first search of OldSucc's successors.
   // NOTE: We do not need a visited list since any blocks we have already
   // visited will have had their overdefined markers cleared already, and we
@@ -971,21 +1033,21 @@ void LazyValueInfoCache::threadEdge(BasicBlock *PredBB, BasicBlock *OldSucc,
     // Skip blocks only accessible through NewSucc.
     if (ToUpdate == NewSucc) continue;
     
+    OverDefinedCacheTy::iterator OI = OverDefinedCache.find(ToUpdate);
+    if (OI == OverDefinedCache.end()) continue;
+
     bool changed = false;
-    for (DenseSet<Value*>::iterator I = ClearSet.begin(), E = ClearSet.end();
-         I != E; ++I) {
+    for (SmallVectorImpl<Value*>::iterator I = ClearSet.begin(),
+         E = ClearSet.end(); I != E; ++I) {
       // If a value was marked overdefined in OldSucc, and is here too...
-      DenseSet<OverDefinedPairTy>::iterator OI =
-        OverDefinedCache.find(std::make_pair(ToUpdate, *I));
-      if (OI == OverDefinedCache.end()) continue;
+      if (!OI->second.erase(*I)) continue;
 
       // Remove it from the caches.
-      ValueCacheEntryTy &Entry = ValueCache[LVIValueHandle(*I, this)];
-      ValueCacheEntryTy::iterator CI = Entry.find(ToUpdate);
+      BlockValsTy &Entry = lookup(*I);
+      BlockValsTy::iterator CI = Entry.find(ToUpdate);
 
       assert(CI != Entry.end() && "Couldn't find entry to update?");
       Entry.erase(CI);
-      OverDefinedCache.erase(OI);
 
       // If we removed anything, then we potentially need to update 
       // blocks successors too.
@@ -224,6 +224,8 @@ bool LPPassManager::runOnFunction(Function &F) {
       {
         PassManagerPrettyStackEntry X(P, *CurrentLoop->getHeader());
         TimeRegion PassTimer(getPassTimer(P));
+        PassTraceRegion PassTrace(P->getPassName(), "loop",
+                                  CurrentLoop->getHeader()->getName());
 
         Changed |= P->runOnLoop(CurrentLoop, *this);
       }
@@ -0,0 +1,677 @@
+//===- MemorySSA.cpp - SSA form for memory --------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file builds the MemorySSA form of a function and implements the walker
+// that uses alias analysis to find the access clobbering a load or store.
+//
+// Construction is the textbook SSA algorithm applied to a single variable,
+// "memory": every MemoryDef defines it, MemoryPhis are placed at the iterated
+// dominance frontier of the blocks containing defs, and a walk over the
+// dominator tree links every use and def to the nearest dominating def.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "memoryssa"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/ADT/SmallPtrSet.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/Dominators.h"
+#include "llvm/Assembly/AssemblyAnnotationWriter.h"
+#include "llvm/Assembly/Writer.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/Support/CFG.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FormattedStream.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <queue>
+using namespace llvm;
+
+STATISTIC(NumMemoryDefs, "Number of MemoryDefs built");
+STATISTIC(NumMemoryUses, "Number of MemoryUses built");
+STATISTIC(NumMemoryPhis, "Number of MemoryPhis built");
+STATISTIC(NumWalkerCacheHits, "Number of walker queries answered from cache");
+STATISTIC(NumWalkerLimitHits, "Number of walker queries that hit the limit");
+
+// Walking past defs costs one alias query each, so bound the work a single
+// query may do.  When the limit is hit the walker answers with the access it
+// stopped at, which is conservative.
+static cl::opt<unsigned>
+WalkLimit("memssa-walk-limit", cl::init(1000), cl::Hidden,
+          cl::desc("Maximum number of accesses the MemorySSA walker visits "
+                   "per query"));
+
+static cl::opt<bool>
+VerifyMemorySSA("verify-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Verify MemorySSA after building it"));
+
+char MemorySSA::ID = 0;
+INITIALIZE_PASS_BEGIN(MemorySSA, "memoryssa", "Memory SSA", false, true)
+INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
+INITIALIZE_PASS_DEPENDENCY(DominatorTree)
+INITIALIZE_PASS_END(MemorySSA, "memoryssa", "Memory SSA", false, true)
+
+//===----------------------------------------------------------------------===//
+// MemoryAccess
+//===----------------------------------------------------------------------===//
+
+MemoryAccess::~MemoryAccess() {}
+
+void MemoryAccess::removeUser(MemoryAccess *U) {
+  SmallVectorImpl<MemoryAccess*>::iterator I =
+    std::find(Users.begin(), Users.end(), U);
+  assert(I != Users.end() && "Not a user of this access!");
+  Users.erase(I);
+}
+
+static void printAccessName(raw_ostream &OS, const MemoryAccess *MA) {
+  if (MA->getKind() == MemoryAccess::LiveOnEntryKind)
+    OS << "liveOnEntry";
+  else
+    OS << MA->getID();
+}
+
+void MemoryAccess::print(raw_ostream &OS) const {
+  switch (getKind()) {
+  case LiveOnEntryKind:
+    OS << "liveOnEntry";
+    break;
+  case UseKind:
+    OS << "MemoryUse(";
+    printAccessName(OS, cast<MemoryUse>(this)->getDefiningAccess());
+    OS << ')';
+    break;
+  case DefKind:
+    OS << getID() << " = MemoryDef(";
+    printAccessName(OS, cast<MemoryDef>(this)->getDefiningAccess());
+    OS << ')';
+    break;
+  case PhiKind: {
+    const MemoryPhi *Phi = cast<MemoryPhi>(this);
+    OS << getID() << " = MemoryPhi(";
+    for (unsigned i = 0, e = Phi->getNumIncomingValues(); i != e; ++i) {
+      if (i)
+        OS << ',';
+      OS << '{';
+      WriteAsOperand(OS, Phi->getIncomingBlock(i), false);
+      OS << ',';
+      printAccessName(OS, Phi->getIncomingValue(i));
+      OS << '}';
+    }
+    OS << ')';
+    break;
+  }
+  }
+}
+
+void MemoryAccess::dump() const {
+  print(dbgs());
+  dbgs() << '\n';
+}
+
+//===----------------------------------------------------------------------===//
+// MemorySSA construction
+//===----------------------------------------------------------------------===//
+
+MemorySSA::MemorySSA()
+  : FunctionPass(ID), AA(0), DT(0), CurFn(0), LiveOnEntry(0), NextID(0) {
+  initializeMemorySSAPass(*PassRegistry::getPassRegistry());
+}
+
+MemorySSA::~MemorySSA() {
+  releaseMemory();
+}
+
+void MemorySSA::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.setPreservesAll();
+  AU.addRequiredTransitive<AliasAnalysis>();
+  AU.addRequiredTransitive<DominatorTree>();
+}
+
+bool MemorySSA::runOnFunction(Function &F) {
+  AA = &getAnalysis<AliasAnalysis>();
+  DT = &getAnalysis<DominatorTree>();
+  buildMemorySSA(F);
+  if (VerifyMemorySSA)
+    verify();
+  return false;
+}
+
+void MemorySSA::releaseMemory() {
+  for (unsigned i = 0, e = Accesses.size(); i != e; ++i)
+    delete Accesses[i];
+  Accesses.clear();
+  BlockAccesses.clear();
+  InstructionAccesses.clear();
+  BlockPhis.clear();
+  LiveOnEntry = 0;
+  Walker.reset();
+}
+
+void MemorySSA::recalculate() {
+  assert(CurFn && "MemorySSA was never built!");
+  releaseMemory();
+  buildMemorySSA(*CurFn);
+}
+
+void MemorySSA::buildMemorySSA(Function &F) {
+  CurFn = &F;
+  NextID = 1;
+  LiveOnEntry = new MemoryAccess(MemoryAccess::LiveOnEntryKind,
+                                 &F.getEntryBlock(), 0);
+  Accesses.push_back(LiveOnEntry);
+
+  // Create the uses and defs.
+  SmallVector<BasicBlock*, 32> DefBlocks;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    std::vector<MemoryAccess*> *List = 0;
+    bool HasDef = false;
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      MemoryUseOrDef *MA;
+      if (I->mayWriteToMemory()) {
+        MA = new MemoryDef(I, BB);
+        HasDef = true;
+        ++NumMemoryDefs;
+      } else if (I->mayReadFromMemory()) {
+        MA = new MemoryUse(I, BB);
+        ++NumMemoryUses;
+      } else {
+        continue;
+      }
+      if (!List)
+        List = &BlockAccesses[BB];
+      List->push_back(MA);
+      Accesses.push_back(MA);
+      InstructionAccesses[I] = MA;
+    }
+    if (HasDef)
+      DefBlocks.push_back(BB);
+  }
+
+  placePhis(F, DefBlocks);
+  renamePass(F);
+
+  // Number the phis and defs in program order and record the position of
+  // each access in its block.
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    DenseMap<const BasicBlock*, std::vector<MemoryAccess*> >::iterator It =
+      BlockAccesses.find(BB);
+    if (It == BlockAccesses.end())
+      continue;
+    std::vector<MemoryAccess*> &List = It->second;
+    for (unsigned i = 0, e = List.size(); i != e; ++i) {
+      List[i]->Order = i;
+      if (!isa<MemoryUse>(List[i]))
+        List[i]->ID = NextID++;
+    }
+  }
+
+  Walker.reset(new MemorySSAWalker(*this, *AA));
+}
+
+namespace {
+  typedef std::pair<DomTreeNode*, unsigned> DomTreeNodePair;
+
+  struct DomTreeNodeCompare {
+    bool operator()(const DomTreeNodePair &LHS, const DomTreeNodePair &RHS) {
+      return LHS.second < RHS.second;
+    }
+  };
+}
+
+/// placePhis - Insert a MemoryPhi at the start of every block in the iterated
+/// dominance frontier of DefBlocks.  This is the algorithm PromoteMem2Reg uses
+/// for allocas, without the liveness pruning: memory is live everywhere.
+void MemorySSA::placePhis(Function &F,
+                          const SmallVectorImpl<BasicBlock*> &DefBlocks) {
+  if (DefBlocks.empty())
+    return;
+
+  DenseMap<DomTreeNode*, unsigned> DomLevels;
+  SmallVector<DomTreeNode*, 32> Worklist;
+  DomTreeNode *Root = DT->getRootNode();
+  DomLevels[Root] = 0;
+  Worklist.push_back(Root);
+  while (!Worklist.empty()) {
+    DomTreeNode *Node = Worklist.pop_back_val();
+    unsigned ChildLevel = DomLevels[Node] + 1;
+    for (DomTreeNode::iterator CI = Node->begin(), CE = Node->end(); CI != CE;
+         ++CI) {
+      DomLevels[*CI] = ChildLevel;
+      Worklist.push_back(*CI);
+    }
+  }
+
+  SmallPtrSet<BasicBlock*, 32> DefBlockSet;
+  DefBlockSet.insert(DefBlocks.begin(), DefBlocks.end());
+
+  typedef std::priority_queue<DomTreeNodePair, SmallVector<DomTreeNodePair, 32>,
+                              DomTreeNodeCompare> IDFPriorityQueue;
+  IDFPriorityQueue PQ;
+  for (unsigned i = 0, e = DefBlocks.size(); i != e; ++i)
+    if (DomTreeNode *Node = DT->getNode(DefBlocks[i]))
+      PQ.push(std::make_pair(Node, DomLevels[Node]));
+
+  SmallPtrSet<DomTreeNode*, 32> Visited;
+  SmallPtrSet<BasicBlock*, 32> PhiBlocks;
+  while (!PQ.empty()) {
+    DomTreeNodePair RootPair = PQ.top();
+    PQ.pop();
+    DomTreeNode *Root = RootPair.first;
+    unsigned RootLevel = RootPair.second;
+
+    Worklist.clear();
+    Worklist.push_back(Root);
+    while (!Worklist.empty()) {
+      DomTreeNode *Node = Worklist.pop_back_val();
+      BasicBlock *BB = Node->getBlock();
+
+      for (succ_iterator SI = succ_begin(BB), SE = succ_end(BB); SI != SE;
+           ++SI) {
+        DomTreeNode *SuccNode = DT->getNode(*SI);
+        if (SuccNode->getIDom() == Node)
+          continue;
+        unsigned SuccLevel = DomLevels[SuccNode];
+        if (SuccLevel > RootLevel)
+          continue;
+        if (!Visited.insert(SuccNode))
+          continue;
+
+        BasicBlock *SuccBB = SuccNode->getBlock();
+        PhiBlocks.insert(SuccBB);
+        if (!DefBlockSet.count(SuccBB))
+          PQ.push(std::make_pair(SuccNode, SuccLevel));
+      }
+
+      for (DomTreeNode::iterator CI = Node->begin(), CE = Node->end(); CI != CE;
+           ++CI)
+        if (!Visited.count(*CI))
+          Worklist.push_back(*CI);
+    }
+  }
+
+  // Create the phis in function order so that their numbering is stable.
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    if (!PhiBlocks.count(BB))
+      continue;
+    MemoryPhi *Phi = new MemoryPhi(BB);
+    std::vector<MemoryAccess*> &List = BlockAccesses[BB];
+    List.insert(List.begin(), Phi);
+    Accesses.push_back(Phi);
+    BlockPhis[BB] = Phi;
+    ++NumMemoryPhis;
+  }
+}
+
+void MemorySSA::linkDefiningAccess(MemoryUseOrDef *MA, MemoryAccess *Def) {
+  MA->DefiningAccess = Def;
+  Def->addUser(MA);
+}
+
+/// renameBlock - Link the uses and defs of BB, which sees the memory state
+/// Incoming on entry.  Returns the state BB leaves.
+MemoryAccess *MemorySSA::renameBlock(BasicBlock *BB, MemoryAccess *Incoming) {
+  MemoryAccess *Cur = Incoming;
+  DenseMap<const BasicBlock*, std::vector<MemoryAccess*> >::iterator It =
+    BlockAccesses.find(BB);
+  if (It != BlockAccesses.end()) {
+    std::vector<MemoryAccess*> &List = It->second;
+    for (unsigned i = 0, e = List.size(); i != e; ++i) {
+      MemoryAccess *MA = List[i];
+      if (!isa<MemoryPhi>(MA))
+        linkDefiningAccess(cast<MemoryUseOrDef>(MA), Cur);
+      if (!isa<MemoryUse>(MA))
+        Cur = MA;
+    }
+  }
+  return Cur;
+}
+
+/// renamePass - Link every use and def to the nearest dominating def or phi
+/// and fill in the phi operands, walking the dominator tree from the entry.
+/// Blocks not reachable from the entry see the live-on-entry state.
+void MemorySSA::renamePass(Function &F) {
+  DenseMap<BasicBlock*, MemoryAccess*> Outgoing;
+  SmallVector<std::pair<DomTreeNode*, MemoryAccess*>, 32> Worklist;
+  Worklist.push_back(std::make_pair(DT->getRootNode(), LiveOnEntry));
+  while (!Worklist.empty()) {
+    DomTreeNode *Node = Worklist.back().first;
+    MemoryAccess *Incoming = Worklist.back().second;
+    Worklist.pop_back();
+
+    BasicBlock *BB = Node->getBlock();
+    MemoryAccess *Out = renameBlock(BB, Incoming);
+    Outgoing[BB] = Out;
+    for (DomTreeNode::iterator CI = Node->begin(), CE = Node->end(); CI != CE;
+         ++CI)
+      Worklist.push_back(std::make_pair(*CI, Out));
+  }
+
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    if (!DT->isReachableFromEntry(BB))
+      Outgoing[BB] = renameBlock(BB, LiveOnEntry);
+
+  // Fill in the phi operands in predecessor order, like the IR's phis.
+  for (DenseMap<const BasicBlock*, MemoryPhi*>::iterator I = BlockPhis.begin(),
+       E = BlockPhis.end(); I != E; ++I) {
+    MemoryPhi *Phi = I->second;
+    BasicBlock *BB = Phi->getBlock();
+    for (pred_iterator PI = pred_begin(BB), PE = pred_end(BB); PI != PE; ++PI) {
+      MemoryAccess *In = Outgoing.lookup(*PI);
+      Phi->Incoming.push_back(std::make_pair(In, *PI));
+      In->addUser(Phi);
+    }
+  }
+}
+
+/// renumberBlock - Drop the slots of removed accesses from BB's list and
+/// recompute the order of the rest.
+void MemorySSA::renumberBlock(const BasicBlock *BB) {
+  std::vector<MemoryAccess*> &List = BlockAccesses[BB];
+  List.erase(std::remove(List.begin(), List.end(), (MemoryAccess*)0),
+             List.end());
+  for (unsigned i = 0, e = List.size(); i != e; ++i)
+    List[i]->Order = i;
+}
+
+//===----------------------------------------------------------------------===//
+// MemorySSA queries and updates
+//===----------------------------------------------------------------------===//
+
+bool MemorySSA::dominates(const MemoryAccess *A, const MemoryAccess *B) const {
+  if (A == B || A == LiveOnEntry)
+    return true;
+  if (B == LiveOnEntry)
+    return false;
+  if (A->getBlock() != B->getBlock())
+    return DT->dominates(A->getBlock(), B->getBlock());
+  return A->Order < B->Order;
+}
+
+void MemorySSA::removeInstruction(Instruction *I) {
+  DenseMap<const Instruction*, MemoryUseOrDef*>::iterator It =
+    InstructionAccesses.find(I);
+  if (It == InstructionAccesses.end())
+    return;
+  MemoryUseOrDef *MA = It->second;
+  InstructionAccesses.erase(It);
+
+  MemoryAccess *Def = MA->getDefiningAccess();
+  Def->removeUser(MA);
+
+  // Whatever read the state MA defined now reads the state MA read.
+  for (unsigned i = 0, e = MA->Users.size(); i != e; ++i) {
+    MemoryAccess *U = MA->Users[i];
+    if (MemoryUseOrDef *UD = dyn_cast<MemoryUseOrDef>(U)) {
+      UD->DefiningAccess = Def;
+    } else {
+      MemoryPhi *Phi = cast<MemoryPhi>(U);
+      for (unsigned j = 0, je = Phi->Incoming.size(); j != je; ++j)
+        if (Phi->Incoming[j].first == MA) {
+          Phi->Incoming[j].first = Def;
+          break;
+        }
+    }
+    Def->addUser(U);
+  }
+  MA->Users.clear();
+
+  // Uses are never on a chain of defining accesses, so only the removal of a
+  // def can change what the walker would answer.
+  if (isa<MemoryDef>(MA))
+    Walker->invalidateInfo();
+
+  // Leave a hole in the block's list so that the order of the other accesses
+  // stays valid; the access itself is freed with the rest of the form.
+  BlockAccesses[MA->getBlock()][MA->Order] = 0;
+}
+
+void MemorySSA::moveUseToBlockEnd(MemoryUse *MU, BasicBlock *BB,
+                                  MemoryAccess *NewDef) {
+  assert(dominates(NewDef, MU) && "Moved use does not see its new def!");
+  MU->getDefiningAccess()->removeUser(MU);
+  linkDefiningAccess(MU, NewDef);
+
+  BlockAccesses[MU->getBlock()][MU->Order] = 0;
+  MU->Block = BB;
+
+  // Keep the use before the access of the terminator, if it has one.
+  std::vector<MemoryAccess*> &List = BlockAccesses[BB];
+  std::vector<MemoryAccess*>::iterator InsertPt = List.end();
+  while (InsertPt != List.begin() && !InsertPt[-1])
+    --InsertPt;
+  if (InsertPt != List.begin())
+    if (MemoryUseOrDef *Last = dyn_cast<MemoryUseOrDef>(InsertPt[-1]))
+      if (Last->getMemoryInst() == BB->getTerminator())
+        --InsertPt;
+  List.insert(InsertPt, MU);
+  renumberBlock(BB);
+}
+
+void MemorySSA::verify() const {
+  for (Function::iterator BB = CurFn->begin(), E = CurFn->end(); BB != E;
+       ++BB) {
+    if (!DT->isReachableFromEntry(BB))
+      continue;
+    DenseMap<const BasicBlock*, std::vector<MemoryAccess*> >::const_iterator
+      It = BlockAccesses.find(BB);
+    if (It == BlockAccesses.end())
+      continue;
+    const std::vector<MemoryAccess*> &List = It->second;
+    for (unsigned i = 0, e = List.size(); i != e; ++i) {
+      const MemoryAccess *MA = List[i];
+      if (!MA)
+        continue;
+      if (MA->getBlock() != BB || MA->Order != i)
+        report_fatal_error("MemorySSA access list of block '" + BB->getName() +
+                           "' is out of order");
+      if (const MemoryUseOrDef *UD = dyn_cast<MemoryUseOrDef>(MA)) {
+        if (!dominates(UD->getDefiningAccess(), UD))
+          report_fatal_error("MemorySSA defining access does not dominate its "
+                             "use in block '" + BB->getName() + "'");
+        continue;
+      }
+      const MemoryPhi *Phi = cast<MemoryPhi>(MA);
+      for (unsigned j = 0, je = Phi->getNumIncomingValues(); j != je; ++j) {
+        const MemoryAccess *In = Phi->getIncomingValue(j);
+        BasicBlock *Pred = Phi->getIncomingBlock(j);
+        if (In != LiveOnEntry && DT->isReachableFromEntry(Pred) &&
+            !DT->dominates(In->getBlock(), Pred))
+          report_fatal_error("MemorySSA phi operand does not dominate its "
+                             "incoming edge in block '" + BB->getName() + "'");
+      }
+    }
+  }
+}
+
+namespace {
+  /// MemorySSAAnnotatedWriter - Prints the accesses as comments above the
+  /// instructions and blocks they belong to.
+  class MemorySSAAnnotatedWriter : public AssemblyAnnotationWriter {
+    const MemorySSA &MSSA;
+
+  public:
+    explicit MemorySSAAnnotatedWriter(const MemorySSA &M) : MSSA(M) {}
+
+    virtual void emitBasicBlockStartAnnot(const BasicBlock *BB,
+                                          formatted_raw_ostream &OS) {
+      if (MemoryPhi *Phi = MSSA.getMemoryAccess(BB)) {
+        OS << "; ";
+        Phi->print(OS);
+        OS << '\n';
+      }
+    }
+
+    virtual void emitInstructionAnnot(const Instruction *I,
+                                      formatted_raw_ostream &OS) {
+      if (MemoryUseOrDef *MA = MSSA.getMemoryAccess(I)) {
+        OS << "; ";
+        MA->print(OS);
+        OS << '\n';
+      }
+    }
+  };
+}
+
+void MemorySSA::print(raw_ostream &OS, const Module *) const {
+  if (!CurFn)
+    return;
+  MemorySSAAnnotatedWriter Writer(*this);
+  CurFn->print(OS, &Writer);
+}
+
+//===----------------------------------------------------------------------===//
+// MemorySSAWalker
+//===----------------------------------------------------------------------===//
+
+MemorySSAWalker::MemorySSAWalker(MemorySSA &M, AliasAnalysis &A)
+  : MSSA(M), AA(A) {}
+
+MemorySSAWalker::~MemorySSAWalker() {}
+
+MemoryAccess *
+MemorySSAWalker::getClobberingMemoryAccess(const Instruction *I) {
+  MemoryUseOrDef *MA = MSSA.getMemoryAccess(I);
+  if (!MA)
+    return 0;
+
+  AliasAnalysis::Location Loc;
+  if (const LoadInst *LI = dyn_cast<LoadInst>(I)) {
+    if (!LI->isUnordered())
+      return MA->getDefiningAccess();
+    Loc = AA.getLocation(LI);
+  } else if (const StoreInst *SI = dyn_cast<StoreInst>(I)) {
+    if (!SI->isUnordered())
+      return MA->getDefiningAccess();
+    Loc = AA.getLocation(SI);
+  } else {
+    return MA->getDefiningAccess();
+  }
+  return getClobberingMemoryAccess(MA->getDefiningAccess(), Loc);
+}
+
+MemoryAccess *
+MemorySSAWalker::getClobberingMemoryAccess(MemoryAccess *Start,
+                                           const AliasAnalysis::Location &Loc) {
+  SmallVector<const MemoryPhi*, 8> PhiStack;
+  unsigned Budget = WalkLimit;
+  unsigned LowestPhiSeen = ~0U;
+  MemoryAccess *Result = walk(Start, Loc, PhiStack, Budget, LowestPhiSeen);
+  if (Budget == 0)
+    ++NumWalkerLimitHits;
+  assert(Result && "Walk from outside any phi cannot be left open!");
+  return Result;
+}
+
+/// walk - Find the nearest access at or above Start that may clobber Loc.
+///
+/// At a phi, every incoming path is walked; if they all reach the same access
+/// that is the answer, otherwise the phi itself is.  A path that comes back to
+/// a phi already being walked (a loop) does not contribute, and returns null.
+/// LowestPhiSeen records the outermost such phi, since results that relied on
+/// it are only known once that phi is finished and so are not cached.
+MemoryAccess *
+MemorySSAWalker::walk(MemoryAccess *Start, const AliasAnalysis::Location &Loc,
+                      SmallVectorImpl<const MemoryPhi*> &PhiStack,
+                      unsigned &Budget, unsigned &LowestPhiSeen) {
+  SmallVector<MemoryAccess*, 16> Skipped;
+  MemoryAccess *Cur = Start;
+  MemoryAccess *Result;
+  bool Cacheable = true;
+
+  while (true) {
+    DenseMap<CacheKey, MemoryAccess*>::iterator CI =
+      Cache.find(std::make_pair(Cur, Loc));
+    if (CI != Cache.end()) {
+      ++NumWalkerCacheHits;
+      Result = CI->second;
+      break;
+    }
+
+    if (MSSA.isLiveOnEntryDef(Cur)) {
+      Result = Cur;
+      break;
+    }
+
+    if (Budget == 0) {
+      Result = Cur;
+      Cacheable = false;
+      break;
+    }
+    --Budget;
+
+    if (MemoryDef *MD = dyn_cast<MemoryDef>(Cur)) {
+      if (AA.getModRefInfo(MD->getMemoryInst(), Loc) & AliasAnalysis::Mod) {
+        Result = MD;
+        break;
+      }
+      Skipped.push_back(MD);
+      Cur = MD->getDefiningAccess();
+      continue;
+    }
+
+    MemoryPhi *Phi = cast<MemoryPhi>(Cur);
+    unsigned Depth = PhiStack.size();
+    for (unsigned i = 0; i != Depth; ++i)
+      if (PhiStack[i] == Phi) {
+        LowestPhiSeen = std::min(LowestPhiSeen, i);
+        return 0;
+      }
+
+    PhiStack.push_back(Phi);
+    unsigned PhiLowest = ~0U;
+    MemoryAccess *Common = 0;
+    bool Differ = false;
+    for (unsigned i = 0, e = Phi->getNumIncomingValues(); i != e; ++i) {
+      MemoryAccess *R = walk(Phi->getIncomingValue(i), Loc, PhiStack, Budget,
+                             PhiLowest);
+      if (!R)
+        continue;
+      if (!Common)
+        Common = R;
+      else if (Common != R) {
+        Differ = true;
+        break;
+      }
+    }
+    PhiStack.pop_back();
+
+    // Cycles back to this phi itself are resolved now; cycles to phis further
+    // out are not.
+    if (PhiLowest < Depth) {
+      LowestPhiSeen = std::min(LowestPhiSeen, PhiLowest);
+      Cacheable = false;
+    }
+
+    if (Differ)
+      Result = Phi;
+    else if (Common)
+      Result = Common;
+    else
+      return 0;
+    Skipped.push_back(Phi);
+    break;
+  }
+
+  if (Cacheable && Budget != 0 && !Skipped.empty()) {
+    if (Loc.Ptr && !CachePointers.count(Loc.Ptr))
+      CachePointers.insert(std::make_pair(Loc.Ptr, PointerVH(Loc.Ptr, this)));
+    for (unsigned i = 0, e = Skipped.size(); i != e; ++i)
+      Cache[std::make_pair(Skipped[i], Loc)] = Result;
+  }
+  return Result;
+}
+
+void MemorySSAWalker::PointerVH::deleted() {
+  Walker->invalidateInfo();
+  // this now dangles!
+}
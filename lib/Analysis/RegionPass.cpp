@@ -93,6 +93,8 @@ bool RGPassManager::runOnFunction(Function &F) {
         PassManagerPrettyStackEntry X(P, *CurrentRegion->getEntry());
 
         TimeRegion PassTimer(getPassTimer(P));
+        PassTraceRegion PassTrace(P->getPassName(), "region",
+                                  CurrentRegion->getNameStr());
         Changed |= P->runOnRegion(CurrentRegion, *this);
       }
 
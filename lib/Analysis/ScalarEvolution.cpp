@@ -98,6 +98,10 @@ STATISTIC(NumTripCountsNotComputed,
           "Number of loops without predictable loop counts");
 STATISTIC(NumBruteForceTripCountsComputed,
           "Number of loops with trip counts computed by force");
+STATISTIC(NumArithDepthCutoffs,
+          "Number of add/mul expressions not simplified due to depth limit");
+STATISTIC(NumOpsNotInlined,
+          "Number of nested add/mul operand lists not flattened due to size");
 
 static cl::opt<unsigned>
 MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
@@ -106,6 +110,24 @@ MaxBruteForceIterations("scalar-evolution-max-iterations", cl::ReallyHidden,
                                  "derived loop"),
                         cl::init(100));
 
+static cl::opt<unsigned>
+MaxArithDepth("scalar-evolution-max-arith-depth", cl::Hidden,
+              cl::desc("Maximum depth of recursive arithmetic "
+                       "simplification in getAddExpr and getMulExpr"),
+              cl::init(32));
+
+static cl::opt<unsigned>
+AddOpsInlineThreshold("scev-addops-inline-threshold", cl::Hidden,
+                      cl::desc("Threshold for inlining addition operands "
+                               "into a SCEV"),
+                      cl::init(500));
+
+static cl::opt<unsigned>
+MulOpsInlineThreshold("scev-mulops-inline-threshold", cl::Hidden,
+                      cl::desc("Threshold for inlining multiplication "
+                               "operands into a SCEV"),
+                      cl::init(1000));
+
 // FIXME: Enable this with XDEBUG when the test suite is clean.
 static cl::opt<bool>
 VerifySCEV("verify-scev",
@@ -1456,7 +1478,8 @@ namespace {
 /// getAddExpr - Get a canonical add expression, or something simpler if
 /// possible.
 const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
-                                        SCEV::NoWrapFlags Flags) {
+                                        SCEV::NoWrapFlags Flags,
+                                        unsigned Depth) {
   assert(!(Flags & ~(SCEV::FlagNUW | SCEV::FlagNSW)) &&
          "only nuw or nsw allowed");
   assert(!Ops.empty() && "Cannot get empty add!");
@@ -1509,6 +1532,13 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
     if (Ops.size() == 1) return Ops[0];
   }
 
+  // Don't keep simplifying once the recursion gets too deep; huge expressions
+  // can otherwise take exponential time to build.
+  if (Depth > MaxArithDepth) {
+    ++NumArithDepthCutoffs;
+    return getOrCreateAddExpr(Ops, Flags);
+  }
+
   // Okay, check to see if the same value occurs in the operand list more than
   // once.  If so, merge them together into an multiply expression.  Since we
   // sorted the list, these values are required to be adjacent.
@@ -1522,7 +1552,8 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
         ++Count;
       // Merge the values into a multiply.
       const SCEV *Scale = getConstant(Ty, Count);
-      const SCEV *Mul = getMulExpr(Scale, Ops[i]);
+      const SCEV *Mul = getMulExpr(Scale, Ops[i], SCEV::FlagAnyWrap,
+                                   Depth + 1);
       if (Ops.size() == Count)
         return Mul;
       Ops[i] = Mul;
@@ -1531,7 +1562,7 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
       FoundMatch = true;
     }
   if (FoundMatch)
-    return getAddExpr(Ops, Flags);
+    return getAddExpr(Ops, Flags, Depth + 1);
 
   // Check for truncates. If all the operands are truncated from the same
   // type, see if factoring out the truncate would permit the result to be
@@ -1573,7 +1604,8 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
           }
         }
         if (Ok)
-          LargeOps.push_back(getMulExpr(LargeMulOps));
+          LargeOps.push_back(getMulExpr(LargeMulOps, SCEV::FlagAnyWrap,
+                                          Depth + 1));
       } else {
         Ok = false;
         break;
@@ -1581,7 +1613,7 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
     }
     if (Ok) {
       // Evaluate the expression in the larger type.
-      const SCEV *Fold = getAddExpr(LargeOps, Flags);
+      const SCEV *Fold = getAddExpr(LargeOps, Flags, Depth + 1);
       // If it folds to something simple, use it. Otherwise, don't.
       if (isa<SCEVConstant>(Fold) || isa<SCEVUnknown>(Fold))
         return getTruncateExpr(Fold, DstType);
@@ -1596,6 +1628,13 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
   if (Idx < Ops.size()) {
     bool DeletedAdd = false;
     while (const SCEVAddExpr *Add = dyn_cast<SCEVAddExpr>(Ops[Idx])) {
+      // Leave very large adds alone rather than flattening them into an even
+      // larger operand list.
+      if (Ops.size() > AddOpsInlineThreshold ||
+          Add->getNumOperands() > AddOpsInlineThreshold) {
+        ++NumOpsNotInlined;
+        break;
+      }
       // If we have an add, expand the add operands onto the end of the operands
       // list.
       Ops.erase(Ops.begin()+Idx);
@@ -1607,7 +1646,7 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
     // and they are not necessarily sorted.  Recurse to resort and resimplify
     // any operands we just acquired.
     if (DeletedAdd)
-      return getAddExpr(Ops);
+      return getAddExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
   }
 
   // Skip over the add expression until we get to a multiply.
@@ -1639,12 +1678,14 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
            I = MulOpLists.begin(), E = MulOpLists.end(); I != E; ++I)
         if (I->first != 0)
           Ops.push_back(getMulExpr(getConstant(I->first),
-                                   getAddExpr(I->second)));
+                                   getAddExpr(I->second, SCEV::FlagAnyWrap,
+                                              Depth + 1),
+                                   SCEV::FlagAnyWrap, Depth + 1));
       if (Ops.empty())
         return getConstant(Ty, 0);
       if (Ops.size() == 1)
         return Ops[0];
-      return getAddExpr(Ops);
+      return getAddExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
     }
   }
 
@@ -1667,11 +1708,13 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
             SmallVector<const SCEV *, 4> MulOps(Mul->op_begin(),
                                                 Mul->op_begin()+MulOp);
             MulOps.append(Mul->op_begin()+MulOp+1, Mul->op_end());
-            InnerMul = getMulExpr(MulOps);
+            InnerMul = getMulExpr(MulOps, SCEV::FlagAnyWrap, Depth + 1);
           }
           const SCEV *One = getConstant(Ty, 1);
-          const SCEV *AddOne = getAddExpr(One, InnerMul);
-          const SCEV *OuterMul = getMulExpr(AddOne, MulOpSCEV);
+          const SCEV *AddOne = getAddExpr(One, InnerMul, SCEV::FlagAnyWrap,
+                                          Depth + 1);
+          const SCEV *OuterMul = getMulExpr(AddOne, MulOpSCEV,
+                                            SCEV::FlagAnyWrap, Depth + 1);
           if (Ops.size() == 2) return OuterMul;
           if (AddOp < Idx) {
             Ops.erase(Ops.begin()+AddOp);
@@ -1681,7 +1724,7 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
             Ops.erase(Ops.begin()+AddOp-1);
           }
           Ops.push_back(OuterMul);
-          return getAddExpr(Ops);
+          return getAddExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
         }
 
       // Check this multiply against other multiplies being added together.
@@ -1700,22 +1743,24 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
               SmallVector<const SCEV *, 4> MulOps(Mul->op_begin(),
                                                   Mul->op_begin()+MulOp);
               MulOps.append(Mul->op_begin()+MulOp+1, Mul->op_end());
-              InnerMul1 = getMulExpr(MulOps);
+              InnerMul1 = getMulExpr(MulOps, SCEV::FlagAnyWrap, Depth + 1);
             }
             const SCEV *InnerMul2 = OtherMul->getOperand(OMulOp == 0);
             if (OtherMul->getNumOperands() != 2) {
               SmallVector<const SCEV *, 4> MulOps(OtherMul->op_begin(),
                                                   OtherMul->op_begin()+OMulOp);
               MulOps.append(OtherMul->op_begin()+OMulOp+1, OtherMul->op_end());
-              InnerMul2 = getMulExpr(MulOps);
+              InnerMul2 = getMulExpr(MulOps, SCEV::FlagAnyWrap, Depth + 1);
             }
-            const SCEV *InnerMulSum = getAddExpr(InnerMul1,InnerMul2);
-            const SCEV *OuterMul = getMulExpr(MulOpSCEV, InnerMulSum);
+            const SCEV *InnerMulSum = getAddExpr(InnerMul1, InnerMul2,
+                                                 SCEV::FlagAnyWrap, Depth + 1);
+            const SCEV *OuterMul = getMulExpr(MulOpSCEV, InnerMulSum,
+                                              SCEV::FlagAnyWrap, Depth + 1);
             if (Ops.size() == 2) return OuterMul;
             Ops.erase(Ops.begin()+Idx);
             Ops.erase(Ops.begin()+OtherMulIdx-1);
             Ops.push_back(OuterMul);
-            return getAddExpr(Ops);
+            return getAddExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
           }
       }
     }
@@ -1748,7 +1793,7 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
 
       SmallVector<const SCEV *, 4> AddRecOps(AddRec->op_begin(),
                                              AddRec->op_end());
-      AddRecOps[0] = getAddExpr(LIOps);
+      AddRecOps[0] = getAddExpr(LIOps, SCEV::FlagAnyWrap, Depth + 1);
 
       // Build the new addrec. Propagate the NUW and NSW flags if both the
       // outer add and the inner addrec are guaranteed to have no overflow.
@@ -1765,7 +1810,7 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
           Ops[i] = NewRec;
           break;
         }
-      return getAddExpr(Ops);
+      return getAddExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
     }
 
     // Okay, if there weren't any loop invariants to be folded, check to see if
@@ -1791,13 +1836,14 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
                   break;
                 }
                 AddRecOps[i] = getAddExpr(AddRecOps[i],
-                                          OtherAddRec->getOperand(i));
+                                          OtherAddRec->getOperand(i),
+                                          SCEV::FlagAnyWrap, Depth + 1);
               }
               Ops.erase(Ops.begin() + OtherIdx); --OtherIdx;
             }
         // Step size has changed, so we cannot guarantee no self-wraparound.
         Ops[Idx] = getAddRecExpr(AddRecOps, AddRecLoop, SCEV::FlagAnyWrap);
-        return getAddExpr(Ops);
+        return getAddExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
       }
 
     // Otherwise couldn't fold anything into this recurrence.  Move onto the
@@ -1806,6 +1852,12 @@ const SCEV *ScalarEvolution::getAddExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   // Okay, it looks like we really DO need an add expr.  Check to see if we
   // already have one, otherwise create a new one.
+  return getOrCreateAddExpr(Ops, Flags);
+}
+
+const SCEV *
+ScalarEvolution::getOrCreateAddExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                    SCEV::NoWrapFlags Flags) {
   FoldingSetNodeID ID;
   ID.AddInteger(scAddExpr);
   for (unsigned i = 0, e = Ops.size(); i != e; ++i)
@@ -1859,7 +1911,8 @@ static uint64_t Choose(uint64_t n, uint64_t k, bool &Overflow) {
 /// getMulExpr - Get a canonical multiply expression, or something simpler if
 /// possible.
 const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
-                                        SCEV::NoWrapFlags Flags) {
+                                        SCEV::NoWrapFlags Flags,
+                                        unsigned Depth) {
   assert(Flags == maskFlags(Flags, SCEV::FlagNUW | SCEV::FlagNSW) &&
          "only nuw or nsw allowed");
   assert(!Ops.empty() && "Cannot get empty mul!");
@@ -1898,8 +1951,11 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
       if (const SCEVAddExpr *Add = dyn_cast<SCEVAddExpr>(Ops[1]))
         if (Add->getNumOperands() == 2 &&
             isa<SCEVConstant>(Add->getOperand(0)))
-          return getAddExpr(getMulExpr(LHSC, Add->getOperand(0)),
-                            getMulExpr(LHSC, Add->getOperand(1)));
+          return getAddExpr(getMulExpr(LHSC, Add->getOperand(0),
+                                       SCEV::FlagAnyWrap, Depth + 1),
+                            getMulExpr(LHSC, Add->getOperand(1),
+                                       SCEV::FlagAnyWrap, Depth + 1),
+                            SCEV::FlagAnyWrap, Depth + 1);
 
     ++Idx;
     while (const SCEVConstant *RHSC = dyn_cast<SCEVConstant>(Ops[Idx])) {
@@ -1929,12 +1985,13 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
           bool AnyFolded = false;
           for (SCEVAddRecExpr::op_iterator I = Add->op_begin(),
                  E = Add->op_end(); I != E; ++I) {
-            const SCEV *Mul = getMulExpr(Ops[0], *I);
+            const SCEV *Mul = getMulExpr(Ops[0], *I, SCEV::FlagAnyWrap,
+                                         Depth + 1);
             if (!isa<SCEVMulExpr>(Mul)) AnyFolded = true;
             NewOps.push_back(Mul);
           }
           if (AnyFolded)
-            return getAddExpr(NewOps);
+            return getAddExpr(NewOps, SCEV::FlagAnyWrap, Depth + 1);
         }
         else if (const SCEVAddRecExpr *
                  AddRec = dyn_cast<SCEVAddRecExpr>(Ops[1])) {
@@ -1942,7 +1999,8 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
           SmallVector<const SCEV *, 4> Operands;
           for (SCEVAddRecExpr::op_iterator I = AddRec->op_begin(),
                  E = AddRec->op_end(); I != E; ++I) {
-            Operands.push_back(getMulExpr(Ops[0], *I));
+            Operands.push_back(getMulExpr(Ops[0], *I, SCEV::FlagAnyWrap,
+                                          Depth + 1));
           }
           return getAddRecExpr(Operands, AddRec->getLoop(),
                                AddRec->getNoWrapFlags(SCEV::FlagNW));
@@ -1954,6 +2012,12 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
       return Ops[0];
   }
 
+  // Don't keep simplifying once the recursion gets too deep.
+  if (Depth > MaxArithDepth) {
+    ++NumArithDepthCutoffs;
+    return getOrCreateMulExpr(Ops, Flags);
+  }
+
   // Skip over the add expression until we get to a multiply.
   while (Idx < Ops.size() && Ops[Idx]->getSCEVType() < scMulExpr)
     ++Idx;
@@ -1962,6 +2026,13 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
   if (Idx < Ops.size()) {
     bool DeletedMul = false;
     while (const SCEVMulExpr *Mul = dyn_cast<SCEVMulExpr>(Ops[Idx])) {
+      // Leave very large muls alone rather than flattening them into an even
+      // larger operand list.
+      if (Ops.size() > MulOpsInlineThreshold ||
+          Mul->getNumOperands() > MulOpsInlineThreshold) {
+        ++NumOpsNotInlined;
+        break;
+      }
       // If we have an mul, expand the mul operands onto the end of the operands
       // list.
       Ops.erase(Ops.begin()+Idx);
@@ -1973,7 +2044,7 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
     // and they are not necessarily sorted.  Recurse to resort and resimplify
     // any operands we just acquired.
     if (DeletedMul)
-      return getMulExpr(Ops);
+      return getMulExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
   }
 
   // If there are any add recurrences in the operands list, see if any other
@@ -2001,9 +2072,10 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
       //  NLI * LI * {Start,+,Step}  -->  NLI * {LI*Start,+,LI*Step}
       SmallVector<const SCEV *, 4> NewOps;
       NewOps.reserve(AddRec->getNumOperands());
-      const SCEV *Scale = getMulExpr(LIOps);
+      const SCEV *Scale = getMulExpr(LIOps, SCEV::FlagAnyWrap, Depth + 1);
       for (unsigned i = 0, e = AddRec->getNumOperands(); i != e; ++i)
-        NewOps.push_back(getMulExpr(Scale, AddRec->getOperand(i)));
+        NewOps.push_back(getMulExpr(Scale, AddRec->getOperand(i),
+                                    SCEV::FlagAnyWrap, Depth + 1));
 
       // Build the new addrec. Propagate the NUW and NSW flags if both the
       // outer mul and the inner addrec are guaranteed to have no overflow.
@@ -2022,7 +2094,7 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
           Ops[i] = NewRec;
           break;
         }
-      return getMulExpr(Ops);
+      return getMulExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
     }
 
     // Okay, if there weren't any loop invariants to be folded, check to see if
@@ -2073,7 +2145,10 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
               const SCEV *CoeffTerm = getConstant(Ty, Coeff);
               const SCEV *Term1 = AddRec->getOperand(y-z);
               const SCEV *Term2 = OtherAddRec->getOperand(z);
-              Term = getAddExpr(Term, getMulExpr(CoeffTerm, Term1,Term2));
+              Term = getAddExpr(Term,
+                                getMulExpr(CoeffTerm, Term1, Term2,
+                                           SCEV::FlagAnyWrap, Depth + 1),
+                                SCEV::FlagAnyWrap, Depth + 1);
             }
           }
           AddRecOps.push_back(Term);
@@ -2091,7 +2166,7 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
         }
       }
       if (OpsModified)
-        return getMulExpr(Ops);
+        return getMulExpr(Ops, SCEV::FlagAnyWrap, Depth + 1);
     }
 
     // Otherwise couldn't fold anything into this recurrence.  Move onto the
@@ -2100,6 +2175,12 @@ const SCEV *ScalarEvolution::getMulExpr(SmallVectorImpl<const SCEV *> &Ops,
 
   // Okay, it looks like we really DO need an mul expr.  Check to see if we
   // already have one, otherwise create a new one.
+  return getOrCreateMulExpr(Ops, Flags);
+}
+
+const SCEV *
+ScalarEvolution::getOrCreateMulExpr(SmallVectorImpl<const SCEV *> &Ops,
+                                    SCEV::NoWrapFlags Flags) {
   FoldingSetNodeID ID;
   ID.AddInteger(scMulExpr);
   for (unsigned i = 0, e = Ops.size(); i != e; ++i)
@@ -4153,6 +4234,47 @@ void ScalarEvolution::forgetLoop(const Loop *L) {
     PushDefUseChildren(I, Worklist);
   }
 
+  // Drop the cached scope values and dispositions that refer to L, visiting
+  // only the expressions that were queried against it.
+  DenseMap<const Loop *, SmallPtrSet<const SCEV *, 4> >::iterator CU =
+    LoopCacheUsers.find(L);
+  if (CU != LoopCacheUsers.end()) {
+    const SmallPtrSet<const SCEV *, 4> &Users = CU->second;
+    for (SmallPtrSet<const SCEV *, 4>::const_iterator UI = Users.begin(),
+         UE = Users.end(); UI != UE; ++UI) {
+      const SCEV *S = *UI;
+      DenseMap<const SCEV *,
+               SmallVector<std::pair<const Loop *, const SCEV *>, 2> >::iterator
+        VI = ValuesAtScopes.find(S);
+      if (VI != ValuesAtScopes.end()) {
+        SmallVectorImpl<std::pair<const Loop *, const SCEV *> > &V =
+          VI->second;
+        for (unsigned j = 0; j != V.size(); )
+          if (V[j].first == L)
+            V.erase(V.begin() + j);
+          else
+            ++j;
+        if (V.empty())
+          ValuesAtScopes.erase(VI);
+      }
+      DenseMap<const SCEV *,
+               SmallVector<std::pair<const Loop *, LoopDisposition>, 2> >::
+        iterator DI = LoopDispositions.find(S);
+      if (DI != LoopDispositions.end()) {
+        SmallVectorImpl<std::pair<const Loop *, LoopDisposition> > &D =
+          DI->second;
+        for (unsigned j = 0; j != D.size(); )
+          if (D[j].first == L)
+            D.erase(D.begin() + j);
+          else
+            ++j;
+        if (D.empty())
+          LoopDispositions.erase(DI);
+      }
+    }
+    LoopCacheUsers.erase(CU);
+  }
+
   // Forget all contained loops too, to avoid dangling entries in the
   // ValuesAtScopes map.
   for (Loop::iterator I = L->begin(), E = L->end(); I != E; ++I)
@@ -5031,15 +5153,24 @@ const SCEV *ScalarEvolution::ComputeExitCountExhaustively(const Loop *L,
 /// original value V is returned.
 const SCEV *ScalarEvolution::getSCEVAtScope(const SCEV *V, const Loop *L) {
   // Check to see if we've folded this expression at this loop before.
-  std::map<const Loop *, const SCEV *> &Values = ValuesAtScopes[V];
-  std::pair<std::map<const Loop *, const SCEV *>::iterator, bool> Pair =
-    Values.insert(std::make_pair(L, static_cast<const SCEV *>(0)));
-  if (!Pair.second)
-    return Pair.first->second ? Pair.first->second : V;
-
-  // Otherwise compute it.
+  SmallVector<std::pair<const Loop *, const SCEV *>, 2> &Values =
+    ValuesAtScopes[V];
+  for (unsigned i = 0, e = Values.size(); i != e; ++i)
+    if (Values[i].first == L)
+      return Values[i].second ? Values[i].second : V;
+  Values.push_back(std::make_pair(L, static_cast<const SCEV *>(0)));
+  LoopCacheUsers[L].insert(V);
+
+  // Otherwise compute it.  The recursion may have grown the cache, so look
+  // the placeholder up again.
   const SCEV *C = computeSCEVAtScope(V, L);
-  ValuesAtScopes[V][L] = C;
+  SmallVector<std::pair<const Loop *, const SCEV *>, 2> &Values2 =
+    ValuesAtScopes[V];
+  for (unsigned i = Values2.size(); i != 0; --i)
+    if (Values2[i - 1].first == L) {
+      Values2[i - 1].second = C;
+      break;
+    }
   return C;
 }
 
@@ -6678,6 +6809,7 @@ void ScalarEvolution::releaseMemory() {
   ConstantEvolutionLoopExitValue.clear();
   ValuesAtScopes.clear();
   LoopDispositions.clear();
+  LoopCacheUsers.clear();
   BlockDispositions.clear();
   UnsignedRanges.clear();
   SignedRanges.clear();
@@ -6780,14 +6912,23 @@ void ScalarEvolution::print(raw_ostream &OS, const Module *) const {
 
 ScalarEvolution::LoopDisposition
 ScalarEvolution::getLoopDisposition(const SCEV *S, const Loop *L) {
-  std::map<const Loop *, LoopDisposition> &Values = LoopDispositions[S];
-  std::pair<std::map<const Loop *, LoopDisposition>::iterator, bool> Pair =
-    Values.insert(std::make_pair(L, LoopVariant));
-  if (!Pair.second)
-    return Pair.first->second;
+  SmallVector<std::pair<const Loop *, LoopDisposition>, 2> &Values =
+    LoopDispositions[S];
+  for (unsigned i = 0, e = Values.size(); i != e; ++i)
+    if (Values[i].first == L)
+      return Values[i].second;
+  Values.push_back(std::make_pair(L, LoopVariant));
+  LoopCacheUsers[L].insert(S);
 
   LoopDisposition D = computeLoopDisposition(S, L);
-  return LoopDispositions[S][L] = D;
+  SmallVector<std::pair<const Loop *, LoopDisposition>, 2> &Values2 =
+    LoopDispositions[S];
+  for (unsigned i = Values2.size(); i != 0; --i)
+    if (Values2[i - 1].first == L) {
+      Values2[i - 1].second = D;
+      break;
+    }
+  return D;
 }
 
 ScalarEvolution::LoopDisposition
@@ -6984,9 +7125,42 @@ bool ScalarEvolution::hasOperand(const SCEV *S, const SCEV *Op) const {
   return Search.IsFound;
 }
 
+/// forgetLoopCacheUser - Remove S from the LoopCacheUsers entry of L.
+void ScalarEvolution::forgetLoopCacheUser(const Loop *L, const SCEV *S) {
+  DenseMap<const Loop *, SmallPtrSet<const SCEV *, 4> >::iterator CU =
+    LoopCacheUsers.find(L);
+  if (CU == LoopCacheUsers.end())
+    return;
+  CU->second.erase(S);
+  if (CU->second.empty())
+    LoopCacheUsers.erase(CU);
+}
+
+/// getNumLoopCacheUsers - Return the number of expressions that have a cached
+/// scope value or loop disposition for L.
+unsigned ScalarEvolution::getNumLoopCacheUsers(const Loop *L) const {
+  DenseMap<const Loop *, SmallPtrSet<const SCEV *, 4> >::const_iterator CU =
+    LoopCacheUsers.find(L);
+  return CU == LoopCacheUsers.end() ? 0 : CU->second.size();
+}
+
 void ScalarEvolution::forgetMemoizedResults(const SCEV *S) {
-  ValuesAtScopes.erase(S);
-  LoopDispositions.erase(S);
+  DenseMap<const SCEV *,
+           SmallVector<std::pair<const Loop *, const SCEV *>, 2> >::iterator
+    VI = ValuesAtScopes.find(S);
+  if (VI != ValuesAtScopes.end()) {
+    for (unsigned i = 0, e = VI->second.size(); i != e; ++i)
+      forgetLoopCacheUser(VI->second[i].first, S);
+    ValuesAtScopes.erase(VI);
+  }
+  DenseMap<const SCEV *,
+           SmallVector<std::pair<const Loop *, LoopDisposition>, 2> >::iterator
+    DI = LoopDispositions.find(S);
+  if (DI != LoopDispositions.end()) {
+    for (unsigned i = 0, e = DI->second.size(); i != e; ++i)
+      forgetLoopCacheUser(DI->second[i].first, S);
+    LoopDispositions.erase(DI);
+  }
   BlockDispositions.erase(S);
   UnsignedRanges.erase(S);
   SignedRanges.erase(S);
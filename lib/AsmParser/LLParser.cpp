@@ -35,11 +35,37 @@ static std::string getTypeString(Type *T) {
 
 /// Run: module ::= toplevelentity*
 bool LLParser::Run() {
+  // Local names are how the textual IR refers to values, so they have to be
+  // kept while parsing even if the context discards them.  Drop them once the
+  // module is complete instead.
+  bool DiscardNames = Context.shouldDiscardValueNames();
+  Context.setDiscardValueNames(false);
+
   // Prime the lexer.
   Lex.Lex();
 
-  return ParseTopLevelEntities() ||
-         ValidateEndOfModule();
+  bool Failed = ParseTopLevelEntities() ||
+                ValidateEndOfModule();
+
+  Context.setDiscardValueNames(DiscardNames);
+  if (!Failed && DiscardNames)
+    DiscardLocalNames();
+  return Failed;
+}
+
+/// DiscardLocalNames - Remove the names of all arguments, basic blocks and
+/// instructions in the module, for contexts that discard value names.
+void LLParser::DiscardLocalNames() {
+  for (Module::iterator F = M->begin(), FE = M->end(); F != FE; ++F) {
+    for (Function::arg_iterator A = F->arg_begin(), AE = F->arg_end();
+         A != AE; ++A)
+      A->setName("");
+    for (Function::iterator BB = F->begin(), BE = F->end(); BB != BE; ++BB) {
+      BB->setName("");
+      for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I)
+        I->setName("");
+    }
+  }
 }
 
 /// ValidateEndOfModule - Do final validity and sanity checks at the end of the
@@ -220,6 +220,7 @@ namespace llvm {
     // Top-Level Entities
     bool ParseTopLevelEntities();
     bool ValidateEndOfModule();
+    void DiscardLocalNames();
     bool ParseTargetDefinition();
     bool ParseModuleAsm();
     bool ParseDepLibs();        // FIXME: Remove in 4.0.
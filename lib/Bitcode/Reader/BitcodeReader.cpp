@@ -9,6 +9,7 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "BitcodeReader.h"
+#include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/AutoUpgrade.h"
@@ -19,11 +20,18 @@
 #include "llvm/IR/Module.h"
 #include "llvm/IR/OperandTraits.h"
 #include "llvm/IR/Operator.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/DataStream.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
 using namespace llvm;
 
+static cl::opt<unsigned>
+MaterializeThreadsOpt("bitcode-materialize-threads", cl::init(1),
+  cl::desc("Number of threads used to decode function bodies when a whole "
+           "bitcode module is read (0 = one per hardware thread)"));
+
 enum {
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
 };
@@ -48,6 +56,8 @@ void BitcodeReader::FreeState() {
   std::vector<Function*>().swap(FunctionsWithBodies);
   DeferredFunctionInfo.clear();
   MDKindMap.clear();
+  std::vector<BitstreamCursor>().swap(LazyMDCursors);
+  std::vector<std::pair<unsigned, uint64_t> >().swap(LazyMDRecords);
 
   assert(BlockAddrFwdRefs.empty() && "Unresolved blockaddress fwd references");
 }
@@ -808,7 +818,7 @@ bool BitcodeReader::ParseTypeTableBody() {
 }
 
 bool BitcodeReader::ParseValueSymbolTable() {
-  if (Stream.EnterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
+  if (enterSubBlock(bitc::VALUE_SYMTAB_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
@@ -816,7 +826,7 @@ bool BitcodeReader::ParseValueSymbolTable() {
   // Read all the records for this value table.
   SmallString<128> ValueName;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -831,7 +841,7 @@ bool BitcodeReader::ParseValueSymbolTable() {
 
     // Read a record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (readRecord(Entry.ID, Record)) {
     default:  // Default behavior: unknown type.
       break;
     case bitc::VST_CODE_ENTRY: {  // VST_ENTRY: [valueid, namechar x N]
@@ -864,14 +874,14 @@ bool BitcodeReader::ParseValueSymbolTable() {
 bool BitcodeReader::ParseMetadata() {
   unsigned NextMDValueNo = MDValueList.size();
 
-  if (Stream.EnterSubBlock(bitc::METADATA_BLOCK_ID))
+  if (enterSubBlock(bitc::METADATA_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
 
   // Read all the records.
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -885,10 +895,9 @@ bool BitcodeReader::ParseMetadata() {
       break;
     }
 
-    bool IsFunctionLocal = false;
     // Read a record.
     Record.clear();
-    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    unsigned Code = readRecord(Entry.ID, Record);
     switch (Code) {
     default:  // Default behavior: ignore.
       break;
@@ -896,17 +905,17 @@ bool BitcodeReader::ParseMetadata() {
       // Read name of the named metadata.
       SmallString<8> Name(Record.begin(), Record.end());
       Record.clear();
-      Code = Stream.ReadCode();
+      Code = readCode();
 
       // METADATA_NAME is always followed by METADATA_NAMED_NODE.
-      unsigned NextBitCode = Stream.readRecord(Code, Record);
+      unsigned NextBitCode = readRecord(Code, Record);
       assert(NextBitCode == bitc::METADATA_NAMED_NODE); (void)NextBitCode;
 
       // Read named metadata elements.
       unsigned Size = Record.size();
       NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
       for (unsigned i = 0; i != Size; ++i) {
-        MDNode *MD = dyn_cast<MDNode>(MDValueList.getValueFwdRef(Record[i]));
+        MDNode *MD = dyn_cast_or_null<MDNode>(getMDValueFwdRef(Record[i]));
         if (MD == 0)
           return Error("Malformed metadata record");
         NMD->addOperand(MD);
@@ -914,35 +923,145 @@ bool BitcodeReader::ParseMetadata() {
       break;
     }
     case bitc::METADATA_FN_NODE:
-      IsFunctionLocal = true;
-      // fall-through
-    case bitc::METADATA_NODE: {
-      if (Record.size() % 2 == 1)
-        return Error("Invalid METADATA_NODE record");
+    case bitc::METADATA_NODE:
+    case bitc::METADATA_STRING:
+      if (ParseMetadataValue(Code, Record, NextMDValueNo++, 0))
+        return true;
+      break;
+    case bitc::METADATA_KIND: {
+      if (Record.size() < 2)
+        return Error("Invalid METADATA_KIND record");
 
-      unsigned Size = Record.size();
-      SmallVector<Value*, 8> Elts;
-      for (unsigned i = 0; i != Size; i += 2) {
-        Type *Ty = getTypeByID(Record[i]);
-        if (!Ty) return Error("Invalid METADATA_NODE record");
-        if (Ty->isMetadataTy())
-          Elts.push_back(MDValueList.getValueFwdRef(Record[i+1]));
-        else if (!Ty->isVoidTy())
-          Elts.push_back(ValueList.getValueFwdRef(Record[i+1], Ty));
-        else
-          Elts.push_back(NULL);
+      unsigned Kind = Record[0];
+      SmallString<8> Name(Record.begin()+1, Record.end());
+
+      unsigned NewKind = TheModule->getMDKindID(Name.str());
+      if (!MDKindMap.insert(std::make_pair(Kind, NewKind)).second)
+        return Error("Conflicting METADATA_KIND records");
+      break;
+    }
+    }
+  }
+}
+
+/// ParseMetadataValue - Create the MDNode or MDString for a METADATA_NODE,
+/// METADATA_FN_NODE or METADATA_STRING record and assign it the specified ID.
+/// Operands that refer to deferred metadata are parsed first, unless Deferred
+/// is non-null, in which case they are left as forward references and their
+/// IDs are added to Deferred for the caller to parse.
+bool BitcodeReader::ParseMetadataValue(unsigned Code,
+                                       SmallVectorImpl<uint64_t> &Record,
+                                       unsigned ID,
+                                       SmallVectorImpl<unsigned> *Deferred) {
+  if (Code == bitc::METADATA_STRING) {
+    SmallString<8> String(Record.begin(), Record.end());
+    Value *V = MDString::get(Context, String);
+    MDValueList.AssignValue(V, ID);
+    return false;
+  }
+
+  assert((Code == bitc::METADATA_NODE || Code == bitc::METADATA_FN_NODE) &&
+         "Not a metadata value record!");
+  if (Record.size() % 2 == 1)
+    return Error("Invalid METADATA_NODE record");
+
+  unsigned Size = Record.size();
+  SmallVector<Value*, 8> Elts;
+  for (unsigned i = 0; i != Size; i += 2) {
+    Type *Ty = getTypeByID(Record[i]);
+    if (!Ty) return Error("Invalid METADATA_NODE record");
+    if (Ty->isMetadataTy()) {
+      unsigned OpID = Record[i+1];
+      if (isLazyMetadata(OpID)) {
+        if (Deferred)
+          Deferred->push_back(OpID);
+        else if (materializeMetadata(OpID))
+          return true;
+      }
+      Elts.push_back(MDValueList.getValueFwdRef(OpID));
+    } else if (!Ty->isVoidTy())
+      Elts.push_back(ValueList.getValueFwdRef(Record[i+1], Ty));
+    else
+      Elts.push_back(NULL);
+  }
+  bool IsFunctionLocal = Code == bitc::METADATA_FN_NODE;
+  Value *V = MDNode::getWhenValsUnresolved(Context, Elts, IsFunctionLocal);
+  MDValueList.AssignValue(V, ID);
+  return false;
+}
+
+/// ParseMetadataLazily - Scan a module-level metadata block, remembering where
+/// each node and string record is instead of parsing it.  Metadata kinds are
+/// still handled here.  Named metadata is created with lazy operands, which
+/// MaterializeNamedMetadata adds when the node is first accessed.
+bool BitcodeReader::ParseMetadataLazily() {
+  unsigned NextMDValueNo = MDValueList.size();
+
+  if (Stream.EnterSubBlock(bitc::METADATA_BLOCK_ID))
+    return Error("Malformed block record");
+
+  unsigned CursorID = LazyMDCursors.size();
+  bool HasDeferredRecords = false;
+  SmallVector<uint64_t, 64> Record;
+
+  while (1) {
+    // Handle abbreviations ourselves, so that RecordBit is the start of the
+    // record itself.  Stay in the block at the end so that the cursor used to
+    // read the deferred records can be copied with all of its abbreviations.
+    uint64_t RecordBit = Stream.GetCurrentBitNo();
+    BitstreamEntry Entry =
+      Stream.advance(BitstreamCursor::AF_DontPopBlockAtEnd |
+                     BitstreamCursor::AF_DontAutoprocessAbbrevs);
+
+    switch (Entry.Kind) {
+    case BitstreamEntry::SubBlock:
+    case BitstreamEntry::Error:
+      return Error("malformed metadata block");
+    case BitstreamEntry::EndBlock: {
+      if (HasDeferredRecords)
+        LazyMDCursors.push_back(Stream);
+      if (Stream.ReadBlockEnd())
+        return Error("malformed metadata block");
+
+      // Function-level metadata IDs are numbered after all of these.
+      if (NextMDValueNo > MDValueList.size())
+        MDValueList.resize(NextMDValueNo);
+      return false;
+    }
+    case BitstreamEntry::Record:
+      if (Entry.ID == bitc::DEFINE_ABBREV) {
+        Stream.ReadAbbrevRecord();
+        continue;
       }
-      Value *V = MDNode::getWhenValsUnresolved(Context, Elts, IsFunctionLocal);
-      IsFunctionLocal = false;
-      MDValueList.AssignValue(V, NextMDValueNo++);
       break;
     }
-    case bitc::METADATA_STRING: {
-      SmallString<8> String(Record.begin(), Record.end());
-      Value *V = MDString::get(Context, String);
-      MDValueList.AssignValue(V, NextMDValueNo++);
+
+    Record.clear();
+    unsigned Code = Stream.readRecord(Entry.ID, Record);
+    switch (Code) {
+    default:  // Default behavior: ignore.
+      break;
+    case bitc::METADATA_NAME: {
+      std::string Name(Record.begin(), Record.end());
+      Record.clear();
+      Code = Stream.ReadCode();
+
+      // METADATA_NAME is always followed by METADATA_NAMED_NODE.
+      if (Stream.readRecord(Code, Record) != bitc::METADATA_NAMED_NODE)
+        return Error("Malformed metadata record");
+      NamedMDNode *NMD = TheModule->getOrInsertNamedMetadata(Name);
+      LazyNamedMD[Name].append(Record.begin(), Record.end());
+      NMD->setLazyOperands();
       break;
     }
+    case bitc::METADATA_FN_NODE:
+    case bitc::METADATA_NODE:
+    case bitc::METADATA_STRING:
+      if (NextMDValueNo >= LazyMDRecords.size())
+        LazyMDRecords.resize(NextMDValueNo + 1);
+      LazyMDRecords[NextMDValueNo++] = std::make_pair(CursorID, RecordBit);
+      HasDeferredRecords = true;
+      break;
     case bitc::METADATA_KIND: {
       if (Record.size() < 2)
         return Error("Invalid METADATA_KIND record");
@@ -959,6 +1078,49 @@ bool BitcodeReader::ParseMetadata() {
   }
 }
 
+/// materializeMetadata - Parse the deferred metadata record with the
+/// specified ID, along with any deferred metadata it refers to.
+bool BitcodeReader::materializeMetadata(unsigned ID) {
+  SmallVector<unsigned, 16> Worklist(1, ID);
+  SmallVector<uint64_t, 64> Record;
+  while (!Worklist.empty()) {
+    unsigned MDID = Worklist.pop_back_val();
+    if (!isLazyMetadata(MDID))
+      continue;  // Already parsed through another reference.
+
+    BitstreamCursor &Cursor = LazyMDCursors[LazyMDRecords[MDID].first];
+    Cursor.JumpToBit(LazyMDRecords[MDID].second);
+    LazyMDRecords[MDID].second = 0;
+
+    BitstreamEntry Entry =
+      Cursor.advance(BitstreamCursor::AF_DontPopBlockAtEnd |
+                     BitstreamCursor::AF_DontAutoprocessAbbrevs);
+    if (Entry.Kind != BitstreamEntry::Record)
+      return Error("malformed metadata block");
+    Record.clear();
+    unsigned Code = Cursor.readRecord(Entry.ID, Record);
+    if (ParseMetadataValue(Code, Record, MDID, &Worklist))
+      return true;
+  }
+  return false;
+}
+
+/// materializeAllMetadata - Parse any deferred metadata records that nothing
+/// has referred to yet.
+bool BitcodeReader::materializeAllMetadata() {
+  for (unsigned ID = 0, e = LazyMDRecords.size(); ID != e; ++ID)
+    if (isLazyMetadata(ID) && materializeMetadata(ID))
+      return true;
+  for (Module::named_metadata_iterator I = TheModule->named_metadata_begin(),
+       E = TheModule->named_metadata_end(); I != E; ++I)
+    if (I->materializeOperands())
+      return true;
+  LazyNamedMD.clear();
+  std::vector<BitstreamCursor>().swap(LazyMDCursors);
+  std::vector<std::pair<unsigned, uint64_t> >().swap(LazyMDRecords);
+  return false;
+}
+
 /// decodeSignRotatedValue - Decode a signed value stored with the sign bit in
 /// the LSB for dense VBR encoding.
 uint64_t BitcodeReader::decodeSignRotatedValue(uint64_t V) {
@@ -1017,7 +1179,7 @@ static APInt ReadWideAPInt(ArrayRef<uint64_t> Vals, unsigned TypeBits) {
 }
 
 bool BitcodeReader::ParseConstants() {
-  if (Stream.EnterSubBlock(bitc::CONSTANTS_BLOCK_ID))
+  if (enterSubBlock(bitc::CONSTANTS_BLOCK_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
@@ -1026,7 +1188,7 @@ bool BitcodeReader::ParseConstants() {
   Type *CurTy = Type::getInt32Ty(Context);
   unsigned NextCstNo = ValueList.size();
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1048,7 +1210,7 @@ bool BitcodeReader::ParseConstants() {
     // Read a record.
     Record.clear();
     Value *V = 0;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = readRecord(Entry.ID, Record);
     switch (BitCode) {
     default:  // Default behavior: unknown constant
     case bitc::CST_CODE_UNDEF:     // UNDEF
@@ -1469,6 +1631,33 @@ bool BitcodeReader::RememberAndSkipFunctionBody() {
   return false;
 }
 
+/// ParseFunctionIndex - Read the FNINDEX record at the end of the module block
+/// to find all of the function bodies at once, instead of skipping over them
+/// one by one.  This leaves the stream just before the module's END_BLOCK.
+bool BitcodeReader::ParseFunctionIndex() {
+  Stream.JumpToBit(ModuleStartBit + FunctionIndexBit);
+
+  SmallVector<uint64_t, 64> Record;
+  BitstreamEntry Entry = Stream.advance();
+  if (Entry.Kind != BitstreamEntry::Record ||
+      Stream.readRecord(Entry.ID, Record) != bitc::MODULE_CODE_FNINDEX ||
+      Record.size() != 2 * FunctionsWithBodies.size())
+    return Error("Invalid function index");
+
+  SmallPtrSet<Function*, 32> Pending(FunctionsWithBodies.begin(),
+                                     FunctionsWithBodies.end());
+  for (unsigned i = 0, e = Record.size(); i != e; i += 2) {
+    Function *F = 0;
+    if (Record[i] < ValueList.size())
+      F = dyn_cast_or_null<Function>(ValueList[Record[i]]);
+    if (!F || !Pending.erase(F))
+      return Error("Invalid function index");
+    DeferredFunctionInfo[F] = ModuleStartBit + Record[i+1];
+  }
+  FunctionsWithBodies.clear();
+  return false;
+}
+
 bool BitcodeReader::GlobalCleanup() {
   // Patch the initializers for globals and aliases up.
   ResolveGlobalAndAliasInits();
@@ -1500,6 +1689,8 @@ bool BitcodeReader::ParseModule(bool Resume) {
     Stream.JumpToBit(NextUnreadBit);
   else if (Stream.EnterSubBlock(bitc::MODULE_BLOCK_ID))
     return Error("Malformed block record");
+  else
+    ModuleStartBit = Stream.GetCurrentBitNo();
 
   SmallVector<uint64_t, 64> Record;
   std::vector<std::string> SectionTable;
@@ -1548,7 +1739,7 @@ bool BitcodeReader::ParseModule(bool Resume) {
           return true;
         break;
       case bitc::METADATA_BLOCK_ID:
-        if (ParseMetadata())
+        if (LazyMetadata ? ParseMetadataLazily() : ParseMetadata())
           return true;
         break;
       case bitc::FUNCTION_BLOCK_ID:
@@ -1559,6 +1750,15 @@ bool BitcodeReader::ParseModule(bool Resume) {
           if (GlobalCleanup())
             return true;
           SeenFirstFunctionBody = true;
+
+          // If there is an index of the function bodies, use it rather than
+          // visiting every one.  Streaming readers can't jump ahead, so they
+          // carry on finding the bodies as they arrive.
+          if (FunctionIndexBit && !LazyStreamer) {
+            if (ParseFunctionIndex())
+              return true;
+            continue;
+          }
         }
 
         if (RememberAndSkipFunctionBody())
@@ -1770,6 +1970,14 @@ bool BitcodeReader::ParseModule(bool Resume) {
       AliasInits.push_back(std::make_pair(NewGA, Record[1]));
       break;
     }
+    /// MODULE_CODE_FNINDEXOFFSET: [offset as 8 little-endian bytes]
+    case bitc::MODULE_CODE_FNINDEXOFFSET:
+      if (Record.size() < 8)
+        return Error("Invalid MODULE_CODE_FNINDEXOFFSET record");
+      FunctionIndexBit = 0;
+      for (unsigned i = 0; i != 8; ++i)
+        FunctionIndexBit |= (Record[i] & 0xFF) << (i * 8);
+      break;
     /// MODULE_CODE_PURGEVALS: [numvals]
     case bitc::MODULE_CODE_PURGEVALS:
       // Trim down the value list to the specified size.
@@ -1929,12 +2137,12 @@ bool BitcodeReader::ParseTriple(std::string &Triple) {
 
 /// ParseMetadataAttachment - Parse metadata attachments.
 bool BitcodeReader::ParseMetadataAttachment() {
-  if (Stream.EnterSubBlock(bitc::METADATA_ATTACHMENT_ID))
+  if (enterSubBlock(bitc::METADATA_ATTACHMENT_ID))
     return Error("Malformed block record");
 
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advanceSkippingSubblocks();
+    BitstreamEntry Entry = advanceSkippingSubblocks();
 
     switch (Entry.Kind) {
     case BitstreamEntry::SubBlock: // Handled for us already.
@@ -1949,7 +2157,7 @@ bool BitcodeReader::ParseMetadataAttachment() {
 
     // Read a metadata attachment record.
     Record.clear();
-    switch (Stream.readRecord(Entry.ID, Record)) {
+    switch (readRecord(Entry.ID, Record)) {
     default:  // Default behavior: ignore.
       break;
     case bitc::METADATA_ATTACHMENT: {
@@ -1963,8 +2171,10 @@ bool BitcodeReader::ParseMetadataAttachment() {
           MDKindMap.find(Kind);
         if (I == MDKindMap.end())
           return Error("Invalid metadata kind ID");
-        Value *Node = MDValueList.getValueFwdRef(Record[i+1]);
-        Inst->setMetadata(I->second, cast<MDNode>(Node));
+        MDNode *Node = dyn_cast_or_null<MDNode>(getMDValueFwdRef(Record[i+1]));
+        if (!Node)
+          return Error("Invalid METADATA_ATTACHMENT record");
+        Inst->setMetadata(I->second, Node);
       }
       break;
     }
@@ -1972,9 +2182,127 @@ bool BitcodeReader::ParseMetadataAttachment() {
   }
 }
 
+//===----------------------------------------------------------------------===//
+// Function block decoding
+//===----------------------------------------------------------------------===//
+
+bool DecodedFunctionBlock::decode(BitstreamCursor &Cursor) {
+  SmallVector<uint64_t, 64> Record;
+  unsigned Depth = 0;
+  while (1) {
+    BitstreamEntry BE = Cursor.advance();
+    unsigned NumOps = static_cast<unsigned>(Ops.size());
+    Entry E = { BE.Kind, BE.ID, 0, NumOps, NumOps };
+
+    switch (BE.Kind) {
+    case BitstreamEntry::Error:
+      return true;
+    case BitstreamEntry::SubBlock:
+      if (Cursor.EnterSubBlock(BE.ID))
+        return true;
+      ++Depth;
+      break;
+    case BitstreamEntry::EndBlock:
+      break;
+    case BitstreamEntry::Record:
+      Record.clear();
+      E.Code = Cursor.readRecord(BE.ID, Record);
+      Ops.insert(Ops.end(), Record.begin(), Record.end());
+      E.OpEnd = static_cast<unsigned>(Ops.size());
+      break;
+    }
+
+    Entries.push_back(E);
+    if (BE.Kind == BitstreamEntry::EndBlock && Depth-- == 0)
+      return false;
+  }
+}
+
+bool BitcodeReader::enterSubBlock(unsigned BlockID) {
+  // The entry that introduced the block was consumed by advance(), and a
+  // replayed function starts inside its block.
+  if (FunctionTape)
+    return false;
+  return Stream.EnterSubBlock(BlockID);
+}
+
+bool BitcodeReader::skipBlock() {
+  if (!FunctionTape)
+    return Stream.SkipBlock();
+
+  unsigned Depth = 0;
+  while (FunctionTapePos != FunctionTape->Entries.size()) {
+    unsigned Kind =
+      FunctionTape->Entries[FunctionTapePos++].Kind;
+    if (Kind == BitstreamEntry::SubBlock)
+      ++Depth;
+    else if (Kind == BitstreamEntry::EndBlock && Depth-- == 0)
+      return false;
+  }
+  return true;
+}
+
+BitstreamEntry BitcodeReader::advance() {
+  if (!FunctionTape)
+    return Stream.advance();
+
+  if (FunctionTapePos == FunctionTape->Entries.size())
+    return BitstreamEntry::getError();
+  const DecodedFunctionBlock::Entry &E =
+    FunctionTape->Entries[FunctionTapePos++];
+  switch (E.Kind) {
+  case BitstreamEntry::SubBlock:
+    return BitstreamEntry::getSubBlock(E.ID);
+  case BitstreamEntry::EndBlock:
+    return BitstreamEntry::getEndBlock();
+  case BitstreamEntry::Record:
+    return BitstreamEntry::getRecord(E.ID);
+  default:
+    return BitstreamEntry::getError();
+  }
+}
+
+BitstreamEntry BitcodeReader::advanceSkippingSubblocks() {
+  if (!FunctionTape)
+    return Stream.advanceSkippingSubblocks();
+
+  while (1) {
+    BitstreamEntry Entry = advance();
+    if (Entry.Kind != BitstreamEntry::SubBlock)
+      return Entry;
+    if (skipBlock())
+      return BitstreamEntry::getError();
+  }
+}
+
+unsigned BitcodeReader::readCode() {
+  if (!FunctionTape)
+    return Stream.ReadCode();
+
+  // The code is the abbrev ID of the record that follows; readRecord picks
+  // the record itself up from the entry advance() leaves behind.
+  BitstreamEntry Entry = advance();
+  return Entry.Kind == BitstreamEntry::Record ? Entry.ID : 0;
+}
+
+unsigned BitcodeReader::readRecord(unsigned AbbrevID,
+                                   SmallVectorImpl<uint64_t> &Vals) {
+  if (!FunctionTape)
+    return Stream.readRecord(AbbrevID, Vals);
+
+  assert(FunctionTapePos != 0 && "No record to read!");
+  const DecodedFunctionBlock::Entry &E =
+    FunctionTape->Entries[FunctionTapePos-1];
+  assert(E.Kind == BitstreamEntry::Record && E.ID == AbbrevID &&
+         "Reading a record out of order!");
+  Vals.append(FunctionTape->Ops.begin() + E.OpBegin,
+              FunctionTape->Ops.begin() + E.OpEnd);
+  return E.Code;
+}
+
 /// ParseFunctionBody - Lazily parse the specified function body block.
 bool BitcodeReader::ParseFunctionBody(Function *F) {
-  if (Stream.EnterSubBlock(bitc::FUNCTION_BLOCK_ID))
+  if (enterSubBlock(bitc::FUNCTION_BLOCK_ID))
     return Error("Malformed block record");
 
   InstructionList.clear();
@@ -1994,7 +2322,7 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
   // Read all the records.
   SmallVector<uint64_t, 64> Record;
   while (1) {
-    BitstreamEntry Entry = Stream.advance();
+    BitstreamEntry Entry = advance();
 
     switch (Entry.Kind) {
     case BitstreamEntry::Error:
@@ -2005,7 +2333,7 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
     case BitstreamEntry::SubBlock:
       switch (Entry.ID) {
       default:  // Skip unknown content.
-        if (Stream.SkipBlock())
+        if (skipBlock())
           return Error("Malformed block record");
         break;
       case bitc::CONSTANTS_BLOCK_ID:
@@ -2032,7 +2360,7 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
     // Read a record.
     Record.clear();
     Instruction *I = 0;
-    unsigned BitCode = Stream.readRecord(Entry.ID, Record);
+    unsigned BitCode = readRecord(Entry.ID, Record);
     switch (BitCode) {
     default: // Default behavior: reject
       return Error("Unknown instruction");
@@ -2077,8 +2405,14 @@ bool BitcodeReader::ParseFunctionBody(Function *F) {
       unsigned ScopeID = Record[2], IAID = Record[3];
 
       MDNode *Scope = 0, *IA = 0;
-      if (ScopeID) Scope = cast<MDNode>(MDValueList.getValueFwdRef(ScopeID-1));
-      if (IAID)    IA = cast<MDNode>(MDValueList.getValueFwdRef(IAID-1));
+      if (ScopeID) {
+        Scope = dyn_cast_or_null<MDNode>(getMDValueFwdRef(ScopeID-1));
+        if (!Scope) return Error("Invalid FUNC_CODE_DEBUG_LOC record");
+      }
+      if (IAID) {
+        IA = dyn_cast_or_null<MDNode>(getMDValueFwdRef(IAID-1));
+        if (!IA) return Error("Invalid FUNC_CODE_DEBUG_LOC record");
+      }
       LastLoc = DebugLoc::get(Line, Col, Scope, IA);
       I->setDebugLoc(LastLoc);
       I = 0;
@@ -2872,6 +3206,28 @@ bool BitcodeReader::FindFunctionInStream(Function *F,
 //===----------------------------------------------------------------------===//
 
 
+bool BitcodeReader::MaterializeNamedMetadata(NamedMDNode *NMD,
+                                             std::string *ErrInfo) {
+  StringMap<SmallVector<uint64_t, 8> >::iterator I =
+    LazyNamedMD.find(NMD->getName());
+  if (I == LazyNamedMD.end())
+    return false;
+  SmallVector<uint64_t, 8> Ops;
+  Ops.swap(I->second);
+  LazyNamedMD.erase(I);
+
+  for (unsigned i = 0, e = Ops.size(); i != e; ++i) {
+    MDNode *MD = dyn_cast_or_null<MDNode>(getMDValueFwdRef(Ops[i]));
+    if (MD == 0) {
+      Error("Malformed metadata record");
+      if (ErrInfo) *ErrInfo = ErrorString;
+      return true;
+    }
+    NMD->addOperand(MD);
+  }
+  return false;
+}
+
 bool BitcodeReader::isMaterializable(const GlobalValue *GV) const {
   if (const Function *F = dyn_cast<Function>(GV)) {
     return F->isDeclaration() &&
@@ -2935,9 +3291,99 @@ void BitcodeReader::Dematerialize(GlobalValue *GV) {
 }
 
 
+unsigned BitcodeReader::getDefaultMaterializeThreads() {
+  return MaterializeThreadsOpt;
+}
+
+namespace {
+/// FunctionDecodeJob - A function block to decode on a worker thread, with a
+/// private cursor onto the stream.
+struct FunctionDecodeJob {
+  Function *F;
+  BitstreamCursor Cursor;
+  DecodedFunctionBlock Block;
+  bool Failed;
+};
+}
+
+static void DecodeFunctionJob(void *UserData, unsigned Index) {
+  FunctionDecodeJob &Job = (*static_cast<std::vector<FunctionDecodeJob>*>(
+      UserData))[Index];
+  Job.Failed = Job.Cursor.EnterSubBlock(bitc::FUNCTION_BLOCK_ID) ||
+               Job.Block.decode(Job.Cursor);
+}
+
+/// MaterializeInParallel - Materialize every function whose body position is
+/// known, decoding the function blocks on MaterializeThreads threads and then
+/// building each function's IR in module order.  A function whose block does
+/// not decode is left for the caller to parse off the stream, so that any
+/// error is reported exactly as it would be otherwise.
+bool BitcodeReader::MaterializeInParallel(std::string *ErrInfo) {
+  unsigned NumThreads = MaterializeThreads;
+  if (NumThreads == 0)
+    NumThreads = llvm_get_hardware_concurrency();
+
+  SmallVector<Function*, 64> Pending;
+  for (Module::iterator F = TheModule->begin(), E = TheModule->end();
+       F != E; ++F)
+    if (F->isMaterializable() && DeferredFunctionInfo.lookup(F))
+      Pending.push_back(F);
+
+  // Decode a window of functions at a time so the decoded records of only a
+  // bounded number of functions are held in memory at once.
+  const unsigned WindowSize = NumThreads * 8;
+  std::vector<FunctionDecodeJob> Jobs;
+  for (unsigned Begin = 0, End = Pending.size(); Begin != End; ) {
+    unsigned WindowEnd = std::min(End, Begin + WindowSize);
+
+    // The cursors are set up here rather than on the workers so that copying
+    // the abbreviations from Stream is not racing with the other workers.
+    Jobs.clear();
+    Jobs.resize(WindowEnd - Begin);
+    for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+      FunctionDecodeJob &Job = Jobs[i];
+      Job.F = Pending[Begin + i];
+      Job.Cursor = Stream;
+      Job.Cursor.JumpToBit(DeferredFunctionInfo[Job.F]);
+      Job.Failed = true;
+    }
+
+    llvm_execute_in_parallel(DecodeFunctionJob, &Jobs, Jobs.size(),
+                             NumThreads);
+
+    for (unsigned i = 0, e = Jobs.size(); i != e; ++i) {
+      FunctionDecodeJob &Job = Jobs[i];
+      if (Job.Failed)
+        continue;
+      FunctionTape = &Job.Block;
+      FunctionTapePos = 0;
+      bool Failed = Materialize(Job.F, ErrInfo);
+      FunctionTape = 0;
+      if (Failed)
+        return true;
+      std::vector<DecodedFunctionBlock::Entry>().swap(Job.Block.Entries);
+      std::vector<uint64_t>().swap(Job.Block.Ops);
+    }
+    Begin = WindowEnd;
+  }
+  return false;
+}
+
 bool BitcodeReader::MaterializeModule(Module *M, std::string *ErrInfo) {
   assert(M == TheModule &&
          "Can only Materialize the Module this BitcodeReader is attached to.");
+  // Every remaining function body is about to be read.  The buffer may have
+  // been opened for random access by a lazy load, so start reading the rest
+  // of it in now rather than a page fault at a time.
+  if (Buffer)
+    Buffer->prefetch(0, Buffer->getBufferSize());
+
+  // Decode what we can in parallel first; the loop below picks up whatever is
+  // left.
+  if (MaterializeThreads != 1 && !LazyStreamer &&
+      MaterializeInParallel(ErrInfo))
+    return true;
+
   // Iterate over the module, deserializing any functions that are still on
   // disk.
   for (Module::iterator F = TheModule->begin(), E = TheModule->end();
@@ -2952,6 +3398,12 @@ bool BitcodeReader::MaterializeModule(Module *M, std::string *ErrInfo) {
   if (NextUnreadBit)
     ParseModule(true);
 
+  // Parse any metadata that nothing referred to.
+  if (materializeAllMetadata()) {
+    if (ErrInfo) *ErrInfo = ErrorString;
+    return true;
+  }
+
   // Upgrade any intrinsic calls that slipped through (should not happen!) and
   // delete the old functions to clean up. We can't do this unless the entire
   // module is materialized because there could always be another function body
@@ -3030,13 +3482,16 @@ bool BitcodeReader::InitLazyStream() {
 // External interface
 //===----------------------------------------------------------------------===//
 
-/// getLazyBitcodeModule - lazy function-at-a-time loading from a file.
-///
-Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
-                                   LLVMContext& Context,
-                                   std::string *ErrMsg) {
+/// getLazyBitcodeModuleImpl - Set up a reader for Buffer, reading the module
+/// header but leaving function bodies, and optionally the module-level
+/// metadata, to be materialized on demand.
+static Module *getLazyBitcodeModuleImpl(MemoryBuffer *Buffer,
+                                        LLVMContext &Context,
+                                        std::string *ErrMsg,
+                                        bool LazyMetadata) {
   Module *M = new Module(Buffer->getBufferIdentifier(), Context);
   BitcodeReader *R = new BitcodeReader(Buffer, Context);
+  R->setLazyMetadata(LazyMetadata);
   M->setMaterializer(R);
   if (R->ParseBitcodeInto(M)) {
     if (ErrMsg)
@@ -3053,6 +3508,16 @@ Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
   return M;
 }
 
+/// getLazyBitcodeModule - lazy function-at-a-time loading from a file.
+/// Module-level metadata is also parsed lazily, as functions refer to it.
+///
+Module *llvm::getLazyBitcodeModule(MemoryBuffer *Buffer,
+                                   LLVMContext& Context,
+                                   std::string *ErrMsg) {
+  return getLazyBitcodeModuleImpl(Buffer, Context, ErrMsg,
+                                  /*LazyMetadata=*/true);
+}
+
 
 Module *llvm::getStreamedBitcodeModule(const std::string &name,
                                        DataStreamer *streamer,
@@ -3075,7 +3540,9 @@ Module *llvm::getStreamedBitcodeModule(const std::string &name,
 /// If an error occurs, return null and fill in *ErrMsg if non-null.
 Module *llvm::ParseBitcodeFile(MemoryBuffer *Buffer, LLVMContext& Context,
                                std::string *ErrMsg){
-  Module *M = getLazyBitcodeModule(Buffer, Context, ErrMsg);
+  // Everything is about to be read, so don't bother deferring the metadata.
+  Module *M = getLazyBitcodeModuleImpl(Buffer, Context, ErrMsg,
+                                       /*LazyMetadata=*/false);
   if (!M) return 0;
 
   // Don't let the BitcodeReader dtor delete 'Buffer', regardless of whether
@@ -15,6 +15,7 @@
 #define BITCODE_READER_H
 
 #include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringMap.h"
 #include "llvm/Bitcode/BitstreamReader.h"
 #include "llvm/Bitcode/LLVMBitCodes.h"
 #include "llvm/GVMaterializer.h"
@@ -121,6 +122,33 @@ public:
   void AssignValue(Value *V, unsigned Idx);
 };
 
+//===----------------------------------------------------------------------===//
+//                          DecodedFunctionBlock Class
+//===----------------------------------------------------------------------===//
+
+/// DecodedFunctionBlock - The entries of a function block, read off the
+/// bitstream ahead of time.  Decoding only touches the bitstream, so the blocks
+/// of several functions can be decoded on different threads; the IR is then
+/// built from them one function at a time.  Nested blocks are recorded inline
+/// between their SubBlock and EndBlock entries.
+class DecodedFunctionBlock {
+public:
+  struct Entry {
+    unsigned Kind;      // The BitstreamEntry kind.
+    unsigned ID;        // Block ID for SubBlock, abbrev ID for Record.
+    unsigned Code;      // Record code.
+    unsigned OpBegin;   // Record operands are Ops[OpBegin, OpEnd).
+    unsigned OpEnd;
+  };
+
+  std::vector<Entry> Entries;
+  std::vector<uint64_t> Ops;
+
+  /// decode - Read the entries of the function block \p Cursor has just
+  /// entered, up to and including its END_BLOCK.  Returns true on error.
+  bool decode(BitstreamCursor &Cursor);
+};
+
 class BitcodeReader : public GVMaterializer {
   LLVMContext &Context;
   Module *TheModule;
@@ -177,6 +205,34 @@ class BitcodeReader : public GVMaterializer {
   /// stream.
   DenseMap<Function*, uint64_t> DeferredFunctionInfo;
 
+  /// ModuleStartBit - The position of the start of the module block's
+  /// contents, which the function index offsets are relative to.
+  uint64_t ModuleStartBit;
+
+  /// FunctionIndexBit - If the module has a function index, the offset of the
+  /// FNINDEX record from ModuleStartBit, otherwise zero.
+  uint64_t FunctionIndexBit;
+
+  /// LazyMetadata - If true, module-level metadata records are only scanned
+  /// when the module is read, and each node is parsed the first time a
+  /// function body or named metadata refers to it.
+  bool LazyMetadata;
+
+  /// LazyMDCursors - For each module-level metadata block that has deferred
+  /// records, a cursor positioned inside it with all of its abbreviations.
+  std::vector<BitstreamCursor> LazyMDCursors;
+
+  /// LazyMDRecords - For each metadata ID whose record has not been parsed
+  /// yet, the index of its block in LazyMDCursors and the bit position of the
+  /// record.  The position is zero once the record has been parsed.
+  std::vector<std::pair<unsigned, uint64_t> > LazyMDRecords;
+
+  /// LazyNamedMD - The operand IDs of each named metadata node whose operands
+  /// have not been added yet.  They are added when the node is first
+  /// accessed, so that debug info that llvm.dbg.cu reaches is not parsed just
+  /// because the module was loaded.
+  StringMap<SmallVector<uint64_t, 8> > LazyNamedMD;
+
   /// BlockAddrFwdRefs - These are blockaddr references to basic blocks.  These
   /// are resolved lazily when functions are loaded.
   typedef std::pair<unsigned, GlobalVariable*> BlockAddrRefTy;
@@ -191,18 +247,34 @@ class BitcodeReader : public GVMaterializer {
   /// not need this flag.
   bool UseRelativeIDs;
 
+  /// MaterializeThreads - The number of threads MaterializeModule decodes
+  /// function blocks on, or 1 to parse each function straight off the stream.
+  unsigned MaterializeThreads;
+
+  /// FunctionTape - While a function body is being built from a
+  /// DecodedFunctionBlock, the block, and the index of the next entry to read.
+  /// The function-level parsers read it instead of Stream.
+  const DecodedFunctionBlock *FunctionTape;
+  unsigned FunctionTapePos;
+
 public:
   explicit BitcodeReader(MemoryBuffer *buffer, LLVMContext &C)
     : Context(C), TheModule(0), Buffer(buffer), BufferOwned(false),
       LazyStreamer(0), NextUnreadBit(0), SeenValueSymbolTable(false),
       ErrorString(0), ValueList(C), MDValueList(C),
-      SeenFirstFunctionBody(false), UseRelativeIDs(false) {
+      SeenFirstFunctionBody(false), ModuleStartBit(0), FunctionIndexBit(0),
+      LazyMetadata(false), UseRelativeIDs(false),
+      MaterializeThreads(getDefaultMaterializeThreads()), FunctionTape(0),
+      FunctionTapePos(0) {
   }
   explicit BitcodeReader(DataStreamer *streamer, LLVMContext &C)
     : Context(C), TheModule(0), Buffer(0), BufferOwned(false),
       LazyStreamer(streamer), NextUnreadBit(0), SeenValueSymbolTable(false),
       ErrorString(0), ValueList(C), MDValueList(C),
-      SeenFirstFunctionBody(false), UseRelativeIDs(false) {
+      SeenFirstFunctionBody(false), ModuleStartBit(0), FunctionIndexBit(0),
+      LazyMetadata(false), UseRelativeIDs(false),
+      MaterializeThreads(getDefaultMaterializeThreads()), FunctionTape(0),
+      FunctionTapePos(0) {
   }
   ~BitcodeReader() {
     FreeState();
@@ -212,6 +284,16 @@ public:
 
   void FreeState();
 
+  /// setLazyMetadata - If this is true, module-level metadata nodes are parsed
+  /// on demand rather than when the module is read.  Must be set before
+  /// ParseBitcodeInto.
+  void setLazyMetadata(bool Lazy) { LazyMetadata = Lazy; }
+
+  /// setMaterializeThreads - Set the number of threads MaterializeModule uses
+  /// to decode function blocks; zero means one per hardware thread.  Has no
+  /// effect when reading from a DataStreamer.
+  void setMaterializeThreads(unsigned N) { MaterializeThreads = N; }
+
   /// setBufferOwned - If this is true, the reader will destroy the MemoryBuffer
   /// when the reader is destroyed.
   void setBufferOwned(bool Owned) { BufferOwned = Owned; }
@@ -221,6 +303,8 @@ public:
   virtual bool Materialize(GlobalValue *GV, std::string *ErrInfo = 0);
   virtual bool MaterializeModule(Module *M, std::string *ErrInfo = 0);
   virtual void Dematerialize(GlobalValue *GV);
+  virtual bool MaterializeNamedMetadata(NamedMDNode *NMD,
+                                        std::string *ErrInfo = 0);
 
   bool Error(const char *Str) {
     ErrorString = Str;
@@ -239,12 +323,35 @@ public:
   static uint64_t decodeSignRotatedValue(uint64_t V);
 
 private:
+  static unsigned getDefaultMaterializeThreads();
+
+  // The function-level parsers read their entries through these, which
+  // forward to Stream unless a DecodedFunctionBlock is being replayed.
+  bool enterSubBlock(unsigned BlockID);
+  bool skipBlock();
+  BitstreamEntry advance();
+  BitstreamEntry advanceSkippingSubblocks();
+  unsigned readCode();
+  unsigned readRecord(unsigned AbbrevID, SmallVectorImpl<uint64_t> &Vals);
+
   Type *getTypeByID(unsigned ID);
   Value *getFnValueByID(unsigned ID, Type *Ty) {
     if (Ty && Ty->isMetadataTy())
-      return MDValueList.getValueFwdRef(ID);
+      return getMDValueFwdRef(ID);
     return ValueList.getValueFwdRef(ID, Ty);
   }
+
+  bool isLazyMetadata(unsigned ID) const {
+    return ID < LazyMDRecords.size() && LazyMDRecords[ID].second;
+  }
+
+  /// getMDValueFwdRef - Return the metadata with the specified ID, parsing it
+  /// first if it was deferred.  Returns null if that fails.
+  Value *getMDValueFwdRef(unsigned ID) {
+    if (isLazyMetadata(ID) && materializeMetadata(ID))
+      return 0;
+    return MDValueList.getValueFwdRef(ID);
+  }
   BasicBlock *getBasicBlock(unsigned ID) const {
     if (ID >= FunctionBBs.size()) return 0; // Invalid ID
     return FunctionBBs[ID];
@@ -330,10 +437,17 @@ private:
   bool ParseValueSymbolTable();
   bool ParseConstants();
   bool RememberAndSkipFunctionBody();
+  bool ParseFunctionIndex();
   bool ParseFunctionBody(Function *F);
+  bool MaterializeInParallel(std::string *ErrInfo);
   bool GlobalCleanup();
   bool ResolveGlobalAndAliasInits();
   bool ParseMetadata();
+  bool ParseMetadataLazily();
+  bool ParseMetadataValue(unsigned Code, SmallVectorImpl<uint64_t> &Record,
+                          unsigned ID, SmallVectorImpl<unsigned> *Deferred);
+  bool materializeMetadata(unsigned ID);
+  bool materializeAllMetadata();
   bool ParseMetadataAttachment();
   bool ParseModuleTriple(std::string &Triple);
   bool ParseUseLists();
@@ -248,17 +248,17 @@ unsigned BitstreamCursor::readRecord(unsigned AbbrevID,
       break;
     }
 
-    // Otherwise, inform the streamer that we need these bytes in memory.
-    const char *Ptr = (const char*)
-      BitStream->getBitcodeBytes().getPointer(CurBitPos/8, NumElts);
-
     // If we can return a reference to the data, do so to avoid copying it.
+    // This needs the bytes in memory, which streaming readers can't provide.
     if (Blob) {
+      const char *Ptr = (const char*)
+        BitStream->getBitcodeBytes().getPointer(CurBitPos/8, NumElts);
       *Blob = StringRef(Ptr, NumElts);
     } else {
-      // Otherwise, unpack into Vals with zero extension.
+      // Otherwise, unpack into Vals with zero extension.  The blob starts on
+      // a word boundary, so this reads the bytes in order.
       for (; NumElts; --NumElts)
-        Vals.push_back((unsigned char)*Ptr++);
+        Vals.push_back(Read(8));
     }
     // Skip over tail padding.
     JumpToBit(NewEnd);
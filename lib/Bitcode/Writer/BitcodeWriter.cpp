@@ -26,7 +26,9 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Mutex.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cctype>
 #include <map>
@@ -38,6 +40,23 @@ EnablePreserveUseListOrdering("enable-bc-uselist-preserve",
                                        "use-list order preservation."),
                               cl::init(false), cl::Hidden);
 
+static cl::opt<bool>
+DisableFunctionIndex("disable-bc-function-index",
+                     cl::desc("Don't emit the index of function body offsets "
+                              "used for lazy loading."),
+                     cl::init(false), cl::Hidden);
+
+static cl::opt<unsigned>
+WriterThreads("bitcode-writer-threads", cl::init(1),
+              cl::desc("Number of threads used to encode function bodies "
+                       "when writing bitcode (0 = one per hardware thread)"));
+
+static cl::opt<unsigned>
+FileFlushThreshold("bitcode-file-flush-threshold", cl::init(1 << 20),
+                   cl::desc("Bytes of bitcode to buffer before writing them "
+                            "out, when writing to a seekable file"),
+                   cl::Hidden);
+
 /// These are manifest constants used by the bitcode writer. They do not need to
 /// be kept in sync with the reader, but need to be consistent within this file.
 enum {
@@ -62,6 +81,9 @@ enum {
   FUNCTION_INST_RET_VAL_ABBREV,
   FUNCTION_INST_UNREACHABLE_ABBREV,
 
+  // Abbrev ID width within FUNCTION_BLOCKs.
+  FUNCTION_BLOCK_ABBREV_WIDTH = 4,
+
   // SwitchInst Magic
   SWITCH_INST_MAGIC = 0x4B5 // May 2012 => 1205 => Hex
 };
@@ -850,10 +872,9 @@ static void WriteConstants(unsigned FirstVal, unsigned LastVal,
 
   SmallVector<uint64_t, 64> Record;
 
-  const ValueEnumerator::ValueList &Vals = VE.getValues();
   Type *LastTy = 0;
   for (unsigned i = FirstVal; i != LastVal; ++i) {
-    const Value *V = Vals[i].first;
+    const Value *V = VE.getValueByID(i);
     // If we need to switch types, do so now.
     if (V->getType() != LastTy) {
       LastTy = V->getType();
@@ -1532,7 +1553,7 @@ static void WriteValueSymbolTable(const ValueSymbolTable &VST,
 /// WriteFunction - Emit a function body to the module stream.
 static void WriteFunction(const Function &F, ValueEnumerator &VE,
                           BitstreamWriter &Stream) {
-  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, 4);
+  Stream.EnterSubblock(bitc::FUNCTION_BLOCK_ID, FUNCTION_BLOCK_ABBREV_WIDTH);
   VE.incorporateFunction(F);
 
   SmallVector<unsigned, 64> Vals;
@@ -1859,9 +1880,179 @@ static void WriteModuleUseLists(const Module *M, ValueEnumerator &VE,
   Stream.ExitBlock();
 }
 
+/// EmitFunctionIndexOffset - Emit a MODULE_CODE_FNINDEXOFFSET record with a
+/// zero offset, to be filled in by WriteFunctionIndex.  Returns the bit
+/// position of the offset so it can be backpatched.
+static uint64_t EmitFunctionIndexOffset(BitstreamWriter &Stream) {
+  // The offset is emitted as an 8-byte blob so that it has a known size and
+  // position, whatever its final value.  Blobs are word aligned, so it can be
+  // filled in with whole-word backpatches.
+  BitCodeAbbrev *Abbv = new BitCodeAbbrev();
+  Abbv->Add(BitCodeAbbrevOp(bitc::MODULE_CODE_FNINDEXOFFSET));
+  Abbv->Add(BitCodeAbbrevOp(BitCodeAbbrevOp::Blob));
+  unsigned FnIndexOffsetAbbrev = Stream.EmitAbbrev(Abbv);
+
+  // The literal record code is still passed as the first value.
+  SmallVector<unsigned, 1> Vals;
+  Vals.push_back(bitc::MODULE_CODE_FNINDEXOFFSET);
+  Stream.EmitRecordWithBlob(FnIndexOffsetAbbrev, Vals,
+                            StringRef("\0\0\0\0\0\0\0\0", 8));
+  return Stream.GetCurrentBitNo() - 64;
+}
+
+/// WriteFunctionIndex - Emit the MODULE_CODE_FNINDEX record mapping each
+/// function body to its position, and point the FNINDEXOFFSET record at it.
+/// All offsets are relative to ModuleStartBit, the start of the module block's
+/// contents, so they don't depend on any wrapper header.
+static void WriteFunctionIndex(SmallVectorImpl<uint64_t> &Index,
+                               uint64_t ModuleStartBit,
+                               uint64_t FnIndexOffsetBit,
+                               BitstreamWriter &Stream) {
+  uint64_t FnIndexBit = Stream.GetCurrentBitNo() - ModuleStartBit;
+  Stream.BackpatchWordAtBit(FnIndexOffsetBit, (uint32_t)FnIndexBit);
+  Stream.BackpatchWordAtBit(FnIndexOffsetBit + 32,
+                            (uint32_t)(FnIndexBit >> 32));
+  Stream.EmitRecord(bitc::MODULE_CODE_FNINDEX, Index);
+}
+
+/// EmitFunctionBodyOffset - Add the function index entry for F, whose block
+/// is about to be emitted.  The offset is where the reader will pick the body
+/// up: just after the ENTER_SUBBLOCK abbrev ID and the (single VBR chunk)
+/// block ID.
+static void EmitFunctionBodyOffset(const Function &F,
+                                   const ValueEnumerator &VE,
+                                   uint64_t ModuleStartBit,
+                                   SmallVectorImpl<uint64_t> &Index,
+                                   BitstreamWriter &Stream) {
+  assert(bitc::FUNCTION_BLOCK_ID < (1U << (bitc::BlockIDWidth - 1)) &&
+         "Function block ID no longer fits in one VBR chunk");
+  Index.push_back(VE.getValueID(&F));
+  Index.push_back(Stream.GetCurrentBitNo() + Stream.GetAbbrevIDWidth() +
+                  bitc::BlockIDWidth - ModuleStartBit);
+}
+
+namespace {
+/// FunctionWriterSlot - What one thread needs to encode function blocks: an
+/// enumerator for function-level values that shares the module enumerator's
+/// tables, and a writer with the module's BLOCKINFO abbrevs that buffers the
+/// blocks it encodes.
+struct FunctionWriterSlot {
+  ValueEnumerator VE;
+  SmallVector<char, 0> Buffer;
+  BitstreamWriter Stream;
+
+  explicit FunctionWriterSlot(const ValueEnumerator &ModuleVE)
+    : VE(&ModuleVE), Stream(Buffer) {
+    // Only the abbrevs are wanted; the main writer emits the BLOCKINFO block.
+    WriteBlockInfo(VE, Stream);
+    Buffer.clear();
+  }
+};
+
+/// EncodedFunction - A function whose block is encoded in a slot's buffer.
+struct EncodedFunction {
+  const Function *F;
+  unsigned Slot;
+  size_t Begin, End;
+};
+
+/// ParallelFunctionWriter - The state shared by the threads encoding a window
+/// of function blocks.  There is a slot per thread; a task claims a free one
+/// for as long as it runs.
+struct ParallelFunctionWriter {
+  const ValueEnumerator &ModuleVE;
+  std::vector<FunctionWriterSlot*> Slots;
+  std::vector<unsigned> FreeSlots;
+  sys::Mutex FreeSlotsLock;
+  std::vector<EncodedFunction> Window;
+
+  ParallelFunctionWriter(const ValueEnumerator &VE, unsigned NumSlots)
+    : ModuleVE(VE), Slots(NumSlots) {
+    for (unsigned i = 0; i != NumSlots; ++i)
+      FreeSlots.push_back(i);
+  }
+  ~ParallelFunctionWriter() {
+    for (unsigned i = 0, e = Slots.size(); i != e; ++i)
+      delete Slots[i];
+  }
+};
+}
+
+static void EncodeFunctionTask(void *UserData, unsigned Index) {
+  ParallelFunctionWriter &PW = *static_cast<ParallelFunctionWriter*>(UserData);
+  unsigned SlotNo;
+  {
+    sys::ScopedLock Guard(PW.FreeSlotsLock);
+    SlotNo = PW.FreeSlots.back();
+    PW.FreeSlots.pop_back();
+  }
+
+  // Slots are set up lazily so that copying the enumerator is done in
+  // parallel too.
+  FunctionWriterSlot *&Slot = PW.Slots[SlotNo];
+  if (!Slot)
+    Slot = new FunctionWriterSlot(PW.ModuleVE);
+
+  EncodedFunction &EF = PW.Window[Index];
+  EF.Slot = SlotNo;
+  EF.Begin = Slot->Buffer.size();
+  WriteFunction(*EF.F, Slot->VE, Slot->Stream);
+  EF.End = Slot->Buffer.size();
+
+  sys::ScopedLock Guard(PW.FreeSlotsLock);
+  PW.FreeSlots.push_back(SlotNo);
+}
+
+/// WriteFunctionsInParallel - Emit the function bodies of M, encoding them on
+/// NumThreads threads.  The blocks are encoded a window at a time into
+/// per-thread buffers and then emitted in module order, so the output is the
+/// same as writing them one after the other.
+static void WriteFunctionsInParallel(const Module *M, const ValueEnumerator &VE,
+                                     unsigned NumThreads,
+                                     uint64_t ModuleStartBit,
+                                     SmallVectorImpl<uint64_t> &Index,
+                                     BitstreamWriter &Stream) {
+  SmallVector<const Function*, 64> Bodies;
+  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+    if (!F->isDeclaration())
+      Bodies.push_back(F);
+
+  ParallelFunctionWriter PW(VE, NumThreads);
+  const unsigned WindowSize = NumThreads * 16;
+  for (unsigned Begin = 0, End = Bodies.size(); Begin != End; ) {
+    unsigned WindowEnd = std::min(End, Begin + WindowSize);
+    PW.Window.clear();
+    for (unsigned i = Begin; i != WindowEnd; ++i) {
+      EncodedFunction EF = { Bodies[i], 0, 0, 0 };
+      PW.Window.push_back(EF);
+    }
+
+    llvm_execute_in_parallel(EncodeFunctionTask, &PW, PW.Window.size(),
+                             NumThreads);
+
+    for (unsigned i = 0, e = PW.Window.size(); i != e; ++i) {
+      const EncodedFunction &EF = PW.Window[i];
+      // A slot's writer is at the top level, where abbrev IDs are 2 bits
+      // wide, so the block's ENTER_SUBBLOCK header fills exactly one word
+      // before the size word.
+      const char *Block = PW.Slots[EF.Slot]->Buffer.data() + EF.Begin;
+      EmitFunctionBodyOffset(*EF.F, VE, ModuleStartBit, Index, Stream);
+      Stream.EmitEncodedBlock(bitc::FUNCTION_BLOCK_ID,
+                              FUNCTION_BLOCK_ABBREV_WIDTH,
+                              StringRef(Block + 4, EF.End - EF.Begin - 4));
+    }
+
+    for (unsigned i = 0; i != NumThreads; ++i)
+      if (PW.Slots[i])
+        PW.Slots[i]->Buffer.clear();
+    Begin = WindowEnd;
+  }
+}
+
 /// WriteModule - Emit the specified module to the bitstream.
 static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   Stream.EnterSubblock(bitc::MODULE_BLOCK_ID, 3);
+  uint64_t ModuleStartBit = Stream.GetCurrentBitNo();
 
   SmallVector<unsigned, 1> Vals;
   unsigned CurVersion = 1;
@@ -1903,10 +2094,27 @@ static void WriteModule(const Module *M, BitstreamWriter &Stream) {
   if (EnablePreserveUseListOrdering)
     WriteModuleUseLists(M, VE, Stream);
 
-  // Emit function bodies.
-  for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
-    if (!F->isDeclaration())
-      WriteFunction(*F, VE, Stream);
+  uint64_t FnIndexOffsetBit = 0;
+  if (!DisableFunctionIndex)
+    FnIndexOffsetBit = EmitFunctionIndexOffset(Stream);
+
+  // Emit function bodies, remembering where each one is.
+  SmallVector<uint64_t, 64> Index;
+  unsigned NumThreads = WriterThreads;
+  if (NumThreads == 0)
+    NumThreads = llvm_get_hardware_concurrency();
+  if (NumThreads > 1) {
+    WriteFunctionsInParallel(M, VE, NumThreads, ModuleStartBit, Index, Stream);
+  } else {
+    for (Module::const_iterator F = M->begin(), E = M->end(); F != E; ++F)
+      if (!F->isDeclaration()) {
+        EmitFunctionBodyOffset(*F, VE, ModuleStartBit, Index, Stream);
+        WriteFunction(*F, VE, Stream);
+      }
+  }
+
+  if (!DisableFunctionIndex)
+    WriteFunctionIndex(Index, ModuleStartBit, FnIndexOffsetBit, Stream);
 
   Stream.ExitBlock();
 }
@@ -1984,6 +2192,16 @@ static void EmitDarwinBCHeaderAndTrailer(SmallVectorImpl<char> &Buffer,
     Buffer.push_back(0);
 }
 
+/// WriteBitcodeHeader - Emit the magic number that starts a bitcode file.
+static void WriteBitcodeHeader(BitstreamWriter &Stream) {
+  Stream.Emit((unsigned)'B', 8);
+  Stream.Emit((unsigned)'C', 8);
+  Stream.Emit(0x0, 4);
+  Stream.Emit(0xC, 4);
+  Stream.Emit(0xE, 4);
+  Stream.Emit(0xD, 4);
+}
+
 /// WriteBitcodeToFile - Write the specified module to the specified output
 /// stream.
 void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
@@ -2001,12 +2219,7 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
     BitstreamWriter Stream(Buffer);
 
     // Emit the file header.
-    Stream.Emit((unsigned)'B', 8);
-    Stream.Emit((unsigned)'C', 8);
-    Stream.Emit(0x0, 4);
-    Stream.Emit(0xC, 4);
-    Stream.Emit(0xE, 4);
-    Stream.Emit(0xD, 4);
+    WriteBitcodeHeader(Stream);
 
     // Emit the module.
     WriteModule(M, Stream);
@@ -2018,3 +2231,19 @@ void llvm::WriteBitcodeToFile(const Module *M, raw_ostream &Out) {
   // Write the generated bitstream to "Out".
   Out.write((char*)&Buffer.front(), Buffer.size());
 }
+
+/// WriteBitcodeToFile - Write the specified module to the specified file.  If
+/// the file can be seeked in, the bitcode is written out as it is produced
+/// instead of being built up in memory first.
+void llvm::WriteBitcodeToFile(const Module *M, raw_fd_ostream &Out) {
+  // The Darwin wrapper needs the size of the whole bitcode up front, so build
+  // it in memory.
+  Triple TT(M->getTargetTriple());
+  if (TT.isOSDarwin() || !Out.supportsSeeking())
+    return WriteBitcodeToFile(M, static_cast<raw_ostream&>(Out));
+
+  SmallVector<char, 0> Buffer;
+  BitstreamWriter Stream(Buffer, &Out, FileFlushThreshold);
+  WriteBitcodeHeader(Stream);
+  WriteModule(M, Stream);
+}
@@ -13,20 +13,27 @@
 
 #include "llvm/Bitcode/ReaderWriter.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/raw_ostream.h"
 using namespace llvm;
 
 namespace {
   class WriteBitcodePass : public ModulePass {
     raw_ostream &OS; // raw_ostream to print on
+    raw_fd_ostream *FDOS; // OS, if it is known to be a file stream
   public:
     static char ID; // Pass identification, replacement for typeid
     explicit WriteBitcodePass(raw_ostream &o)
-      : ModulePass(ID), OS(o) {}
+      : ModulePass(ID), OS(o), FDOS(0) {}
+    explicit WriteBitcodePass(raw_fd_ostream &o)
+      : ModulePass(ID), OS(o), FDOS(&o) {}
 
     const char *getPassName() const { return "Bitcode Writer"; }
 
     bool runOnModule(Module &M) {
-      WriteBitcodeToFile(&M, OS);
+      if (FDOS)
+        WriteBitcodeToFile(&M, *FDOS);
+      else
+        WriteBitcodeToFile(&M, OS);
       return false;
     }
   };
@@ -39,3 +46,9 @@ char WriteBitcodePass::ID = 0;
 ModulePass *llvm::createBitcodeWriterPass(raw_ostream &Str) {
   return new WriteBitcodePass(Str);
 }
+
+/// createBitcodeWriterPass - Create and return a pass that writes the module
+/// to the specified file stream.
+ModulePass *llvm::createBitcodeWriterPass(raw_fd_ostream &Str) {
+  return new WriteBitcodePass(Str);
+}
@@ -29,7 +29,8 @@ static bool isIntOrIntVectorValue(const std::pair<const Value*, unsigned> &V) {
 }
 
 /// ValueEnumerator - Enumerate module-level information.
-ValueEnumerator::ValueEnumerator(const Module *M) {
+ValueEnumerator::ValueEnumerator(const Module *M)
+  : ModuleVE(0), FirstValueID(0), FirstMDValueID(0) {
   // Enumerate the global variables.
   for (Module::const_global_iterator I = M->global_begin(),
          E = M->global_end(); I != E; ++I)
@@ -109,6 +110,12 @@ ValueEnumerator::ValueEnumerator(const Module *M) {
   OptimizeConstants(FirstConstant, Values.size());
 }
 
+ValueEnumerator::ValueEnumerator(const ValueEnumerator *Module)
+  : ModuleVE(Module), FirstValueID(Module->Values.size()),
+    FirstMDValueID(Module->MDValues.size()) {
+  assert(!Module->ModuleVE && "Function-level enumerators do not nest");
+}
+
 unsigned ValueEnumerator::getInstructionID(const Instruction *Inst) const {
   InstructionMapType::const_iterator I = InstructionMap.find(Inst);
   assert(I != InstructionMap.end() && "Instruction is not mapped!");
@@ -122,11 +129,13 @@ void ValueEnumerator::setInstructionID(const Instruction *I) {
 unsigned ValueEnumerator::getValueID(const Value *V) const {
   if (isa<MDNode>(V) || isa<MDString>(V)) {
     ValueMapType::const_iterator I = MDValueMap.find(V);
+    if (ModuleVE && I == MDValueMap.end()) return ModuleVE->getValueID(V);
     assert(I != MDValueMap.end() && "Value not in slotcalculator!");
     return I->second-1;
   }
 
   ValueMapType::const_iterator I = ValueMap.find(V);
+  if (ModuleVE && I == ValueMap.end()) return ModuleVE->getValueID(V);
   assert(I != ValueMap.end() && "Value not in slotcalculator!");
   return I->second-1;
 }
@@ -185,10 +194,13 @@ namespace {
   };
 }
 
-/// OptimizeConstants - Reorder constant pool for denser encoding.
+/// OptimizeConstants - Reorder constant pool for denser encoding.  CstStart and
+/// CstEnd are value IDs.
 void ValueEnumerator::OptimizeConstants(unsigned CstStart, unsigned CstEnd) {
   if (CstStart == CstEnd || CstStart+1 == CstEnd) return;
 
+  CstStart -= FirstValueID;
+  CstEnd -= FirstValueID;
   CstSortPredicate P(*this);
   std::stable_sort(Values.begin()+CstStart, Values.begin()+CstEnd, P);
 
@@ -200,7 +212,7 @@ void ValueEnumerator::OptimizeConstants(unsigned CstStart, unsigned CstEnd) {
 
   // Rebuild the modified portion of ValueMap.
   for (; CstStart != CstEnd; ++CstStart)
-    ValueMap[Values[CstStart].first] = CstStart+1;
+    ValueMap[Values[CstStart].first] = FirstValueID+CstStart+1;
 }
 
 
@@ -282,11 +294,11 @@ void ValueEnumerator::EnumerateFunctionLocalMetadata(const MDNode *N) {
   unsigned &MDValueID = MDValueMap[N];
   if (MDValueID) {
     // Increment use count.
-    MDValues[MDValueID-1].second++;
+    MDValues[MDValueID-FirstMDValueID-1].second++;
     return;
   }
   MDValues.push_back(std::make_pair(N, 1U));
-  MDValueID = MDValues.size();
+  MDValueID = FirstMDValueID+MDValues.size();
 
   // To incoroporate function-local information visit all function-local
   // MDNodes and all function-local values they reference.
@@ -308,11 +320,16 @@ void ValueEnumerator::EnumerateValue(const Value *V) {
   assert(!isa<MDNode>(V) && !isa<MDString>(V) &&
          "EnumerateValue doesn't handle Metadata!");
 
+  // Values of the module enumerator are shared with it, and are not counted
+  // again for each function.
+  if (ModuleVE && ModuleVE->ValueMap.count(V))
+    return;
+
   // Check to see if it's already in!
   unsigned &ValueID = ValueMap[V];
   if (ValueID) {
     // Increment use count.
-    Values[ValueID-1].second++;
+    Values[ValueID-FirstValueID-1].second++;
     return;
   }
 
@@ -339,18 +356,24 @@ void ValueEnumerator::EnumerateValue(const Value *V) {
       // Finally, add the value.  Doing this could make the ValueID reference be
       // dangling, don't reuse it.
       Values.push_back(std::make_pair(V, 1U));
-      ValueMap[V] = Values.size();
+      ValueMap[V] = FirstValueID+Values.size();
       return;
     }
   }
 
   // Add the value.
   Values.push_back(std::make_pair(V, 1U));
-  ValueID = Values.size();
+  ValueID = FirstValueID+Values.size();
 }
 
 
 void ValueEnumerator::EnumerateType(Type *Ty) {
+  // The module enumerator has already seen every type used in the module.
+  if (ModuleVE) {
+    assert(ModuleVE->TypeMap.count(Ty) && "Type not enumerated by module!");
+    return;
+  }
+
   unsigned *TypeID = &TypeMap[Ty];
 
   // We've already seen this type.
@@ -420,6 +443,11 @@ void ValueEnumerator::EnumerateOperandType(const Value *V) {
 
 void ValueEnumerator::EnumerateAttributes(AttributeSet PAL) {
   if (PAL.isEmpty()) return;  // null is always 0.
+  if (ModuleVE) {
+    assert(ModuleVE->AttributeMap.count(PAL) &&
+           "Attributes not enumerated by module!");
+    return;
+  }
 
   // Do a lookup.
   unsigned &Entry = AttributeMap[PAL];
@@ -442,15 +470,15 @@ void ValueEnumerator::EnumerateAttributes(AttributeSet PAL) {
 
 void ValueEnumerator::incorporateFunction(const Function &F) {
   InstructionCount = 0;
-  NumModuleValues = Values.size();
-  NumModuleMDValues = MDValues.size();
+  NumModuleValues = FirstValueID+Values.size();
+  NumModuleMDValues = FirstMDValueID+MDValues.size();
 
   // Adding function arguments to the value table.
   for (Function::const_arg_iterator I = F.arg_begin(), E = F.arg_end();
        I != E; ++I)
     EnumerateValue(I);
 
-  FirstFuncConstantID = Values.size();
+  FirstFuncConstantID = FirstValueID+Values.size();
 
   // Add all function-level constants to the value table.
   for (Function::const_iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
@@ -466,13 +494,13 @@ void ValueEnumerator::incorporateFunction(const Function &F) {
   }
 
   // Optimize the constant layout.
-  OptimizeConstants(FirstFuncConstantID, Values.size());
+  OptimizeConstants(FirstFuncConstantID, FirstValueID+Values.size());
 
   // Add the function's parameter attributes so they are available for use in
   // the function's instruction.
   EnumerateAttributes(F.getAttributes());
 
-  FirstInstID = Values.size();
+  FirstInstID = FirstValueID+Values.size();
 
   SmallVector<MDNode *, 8> FnLocalMDVector;
   // Add all of the instructions.
@@ -505,16 +533,19 @@ void ValueEnumerator::incorporateFunction(const Function &F) {
 }
 
 void ValueEnumerator::purgeFunction() {
+  unsigned NumKeptValues = NumModuleValues-FirstValueID;
+  unsigned NumKeptMDValues = NumModuleMDValues-FirstMDValueID;
+
   /// Remove purged values from the ValueMap.
-  for (unsigned i = NumModuleValues, e = Values.size(); i != e; ++i)
+  for (unsigned i = NumKeptValues, e = Values.size(); i != e; ++i)
     ValueMap.erase(Values[i].first);
-  for (unsigned i = NumModuleMDValues, e = MDValues.size(); i != e; ++i)
+  for (unsigned i = NumKeptMDValues, e = MDValues.size(); i != e; ++i)
     MDValueMap.erase(MDValues[i].first);
   for (unsigned i = 0, e = BasicBlocks.size(); i != e; ++i)
     ValueMap.erase(BasicBlocks[i]);
 
-  Values.resize(NumModuleValues);
-  MDValues.resize(NumModuleMDValues);
+  Values.resize(NumKeptValues);
+  MDValues.resize(NumKeptMDValues);
   BasicBlocks.clear();
   FunctionLocalMDs.clear();
 }
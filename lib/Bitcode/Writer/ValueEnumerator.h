@@ -41,6 +41,15 @@ public:
   // For each value, we remember its Value* and occurrence frequency.
   typedef std::vector<std::pair<const Value*, unsigned> > ValueList;
 private:
+  /// ModuleVE - For an enumerator of function-level values only, the module
+  /// enumerator that holds everything else.  Null for a module enumerator.
+  const ValueEnumerator *ModuleVE;
+
+  /// FirstValueID/FirstMDValueID - The IDs of Values[0] and MDValues[0].  A
+  /// function-level enumerator numbers its values after those of ModuleVE.
+  unsigned FirstValueID;
+  unsigned FirstMDValueID;
+
   typedef DenseMap<Type*, unsigned> TypeMapType;
   TypeMapType TypeMap;
   TypeList Types;
@@ -88,12 +97,20 @@ private:
 public:
   ValueEnumerator(const Module *M);
 
+  /// ValueEnumerator - Create an enumerator that only holds the function-level
+  /// values of the functions it incorporates, and looks everything else up in
+  /// the module enumerator Module.  Module is only read, so several threads
+  /// can each have their own function-level enumerator over one module
+  /// enumerator, as long as it is not changed meanwhile.
+  explicit ValueEnumerator(const ValueEnumerator *Module);
+
   void dump() const;
   void print(raw_ostream &OS, const ValueMapType &Map, const char *Name) const;
 
   unsigned getValueID(const Value *V) const;
 
   unsigned getTypeID(Type *T) const {
+    if (ModuleVE) return ModuleVE->getTypeID(T);
     TypeMapType::const_iterator I = TypeMap.find(T);
     assert(I != TypeMap.end() && "Type not in ValueEnumerator!");
     return I->second-1;
@@ -104,6 +121,7 @@ public:
 
   unsigned getAttributeID(AttributeSet PAL) const {
     if (PAL.isEmpty()) return 0;  // Null maps to zero.
+    if (ModuleVE) return ModuleVE->getAttributeID(PAL);
     AttributeMapType::const_iterator I = AttributeMap.find(PAL);
     assert(I != AttributeMap.end() && "Attribute not in ValueEnumerator!");
     return I->second;
@@ -111,6 +129,7 @@ public:
 
   unsigned getAttributeGroupID(AttributeSet PAL) const {
     if (PAL.isEmpty()) return 0;  // Null maps to zero.
+    if (ModuleVE) return ModuleVE->getAttributeGroupID(PAL);
     AttributeGroupMapType::const_iterator I = AttributeGroupMap.find(PAL);
     assert(I != AttributeGroupMap.end() && "Attribute not in ValueEnumerator!");
     return I->second;
@@ -123,12 +142,27 @@ public:
     End = FirstInstID;
   }
 
-  const ValueList &getValues() const { return Values; }
-  const ValueList &getMDValues() const { return MDValues; }
+  /// getValueByID - Return the value with the specified ID.
+  const Value *getValueByID(unsigned ID) const {
+    if (ID < FirstValueID) return ModuleVE->getValueByID(ID);
+    return Values[ID - FirstValueID].first;
+  }
+
+  /// getValues - Return the values of a module enumerator.
+  const ValueList &getValues() const {
+    assert(!ModuleVE && "Function-level enumerators only hold local values");
+    return Values;
+  }
+  const ValueList &getMDValues() const {
+    assert(!ModuleVE && "Function-level enumerators only hold local values");
+    return MDValues;
+  }
   const SmallVector<const MDNode *, 8> &getFunctionLocalMDValues() const {
     return FunctionLocalMDs;
   }
-  const TypeList &getTypes() const { return Types; }
+  const TypeList &getTypes() const {
+    return ModuleVE ? ModuleVE->getTypes() : Types;
+  }
   const std::vector<const BasicBlock*> &getBasicBlocks() const {
     return BasicBlocks;
   }
@@ -354,6 +354,7 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
   std::string FunctionName = "<invalid>";
   uint32_t Line = 0;
   uint32_t Column = 0;
+  uint32_t StartLine = 0;
   if (Specifier.needs(DILineInfoSpecifier::FunctionName)) {
     // The address may correspond to instruction in some inlined function,
     // so we have to build the chain of inlined functions and take the
@@ -364,6 +365,7 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
       const DWARFDebugInfoEntryMinimal &TopFunctionDIE = InlinedChain[0];
       if (const char *Name = TopFunctionDIE.getSubroutineName(CU))
         FunctionName = Name;
+      StartLine = TopFunctionDIE.getSubroutineDeclLine(CU);
     }
   }
   if (Specifier.needs(DILineInfoSpecifier::FileLineInfo)) {
@@ -375,7 +377,7 @@ DILineInfo DWARFContext::getLineInfoForAddress(uint64_t Address,
                                   FileName, Line, Column);
   }
   return DILineInfo(StringRef(FileName), StringRef(FunctionName),
-                    Line, Column);
+                    Line, Column, StartLine);
 }
 
 DILineInfoTable DWARFContext::getLineInfoForAddressRange(uint64_t Address,
@@ -456,10 +458,12 @@ DIInliningInfo DWARFContext::getInliningInfoForAddress(uint64_t Address,
     std::string FunctionName = "<invalid>";
     uint32_t Line = 0;
     uint32_t Column = 0;
+    uint32_t StartLine = 0;
     // Get function name if necessary.
     if (Specifier.needs(DILineInfoSpecifier::FunctionName)) {
       if (const char *Name = FunctionDIE.getSubroutineName(CU))
         FunctionName = Name;
+      StartLine = FunctionDIE.getSubroutineDeclLine(CU);
     }
     if (Specifier.needs(DILineInfoSpecifier::FileLineInfo)) {
       const bool NeedsAbsoluteFilePath =
@@ -486,7 +490,7 @@ DIInliningInfo DWARFContext::getInliningInfoForAddress(uint64_t Address,
       }
     }
     DILineInfo Frame(StringRef(FileName), StringRef(FunctionName),
-                     Line, Column);
+                     Line, Column, StartLine);
     InliningInfo.addFrame(Frame);
   }
   return InliningInfo;
@@ -573,8 +577,9 @@ DWARFContextInMemory::DWARFContextInMemory(object::ObjectFile *Obj) :
       continue;
 
     if (i->begin_relocations() != i->end_relocations()) {
-      uint64_t SectionSize;
-      i->getSize(SectionSize);
+      // Relocations in a compressed section apply to its uncompressed
+      // contents, so check them against the size of those.
+      uint64_t SectionSize = data.size();
       for (object::relocation_iterator reloc_i = i->begin_relocations(),
              reloc_e = i->end_relocations();
            reloc_i != reloc_e; reloc_i.increment(ec)) {
@@ -357,6 +357,34 @@ DWARFDebugInfoEntryMinimal::getSubroutineName(const DWARFCompileUnit *CU)
   return 0;
 }
 
+uint32_t
+DWARFDebugInfoEntryMinimal::getSubroutineDeclLine(const DWARFCompileUnit *CU)
+                                                                         const {
+  if (!isSubroutineDIE())
+    return 0;
+  if (uint32_t Line = getAttributeValueAsUnsigned(CU, DW_AT_decl_line, 0))
+    return Line;
+  // Try to get the line from specification DIE.
+  uint32_t spec_ref =
+      getAttributeValueAsReference(CU, DW_AT_specification, -1U);
+  if (spec_ref != -1U) {
+    DWARFDebugInfoEntryMinimal spec_die;
+    if (spec_die.extract(CU, &spec_ref))
+      if (uint32_t Line = spec_die.getSubroutineDeclLine(CU))
+        return Line;
+  }
+  // Try to get the line from abstract origin DIE.
+  uint32_t abs_origin_ref =
+      getAttributeValueAsReference(CU, DW_AT_abstract_origin, -1U);
+  if (abs_origin_ref != -1U) {
+    DWARFDebugInfoEntryMinimal abs_origin_die;
+    if (abs_origin_die.extract(CU, &abs_origin_ref))
+      if (uint32_t Line = abs_origin_die.getSubroutineDeclLine(CU))
+        return Line;
+  }
+  return 0;
+}
+
 void DWARFDebugInfoEntryMinimal::getCallerFrame(const DWARFCompileUnit *CU,
                                                 uint32_t &CallFile,
                                                 uint32_t &CallLine,
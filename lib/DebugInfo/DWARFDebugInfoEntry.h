@@ -157,6 +157,11 @@ public:
   /// for this subprogram. Returns null if no name is found.
   const char* getSubroutineName(const DWARFCompileUnit *CU) const;
 
+  /// If a DIE represents a subprogram (or inlined subroutine), returns the
+  /// value of its DW_AT_decl_line, which may be fetched from specification
+  /// or abstract origin for this subprogram. Returns 0 if it is missing.
+  uint32_t getSubroutineDeclLine(const DWARFCompileUnit *CU) const;
+
   /// Retrieves values of DW_AT_call_file, DW_AT_call_line and
   /// DW_AT_call_column from DIE (or zeroes if they are missing).
   void getCallerFrame(const DWARFCompileUnit *CU, uint32_t &CallFile,
@@ -39,6 +39,11 @@ static cl::opt<bool,true>
 VerifyDomInfoX("verify-dom-info", cl::location(VerifyDomInfo),
                cl::desc("Verify dominator info (time consuming)"));
 
+static cl::opt<bool>
+VerifyDomUpdates("verify-dom-updates", cl::Hidden,
+                 cl::desc("Check every incremental dominator tree update "
+                          "against a tree computed from scratch (slow)"));
+
 bool BasicBlockEdge::isSingleEdge() const {
   const TerminatorInst *TI = Start->getTerminator();
   unsigned NumEdgesToEnd = 0;
@@ -73,9 +78,18 @@ bool DominatorTree::runOnFunction(Function &F) {
   return false;
 }
 
+void DominatorTree::applyUpdates(ArrayRef<UpdateType> Updates) {
+  DT->applyUpdates(Updates);
+  if (VerifyDomUpdates)
+    verifyDomTree();
+}
+
 void DominatorTree::verifyAnalysis() const {
   if (!VerifyDomInfo) return;
+  verifyDomTree();
+}
 
+void DominatorTree::verifyDomTree() const {
   Function &F = *getRoot()->getParent();
 
   DominatorTree OtherDT;
@@ -37,6 +37,7 @@ LLVMContextImpl::LLVMContextImpl(LLVMContext &C)
     Int64Ty(C, 64) {
   InlineAsmDiagHandler = 0;
   InlineAsmDiagContext = 0;
+  DiscardValueNames = false;
   NamedStructTypesUniqueID = 0;
 }
 
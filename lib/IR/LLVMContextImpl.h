@@ -238,6 +238,9 @@ public:
   
   LLVMContext::InlineAsmDiagHandlerTy InlineAsmDiagHandler;
   void *InlineAsmDiagContext;
+
+  /// DiscardValueNames - Set by LLVMContext::setDiscardValueNames.
+  bool DiscardValueNames;
   
   typedef DenseMap<DenseMapAPIntKeyInfo::KeyTy, ConstantInt*, 
                          DenseMapAPIntKeyInfo> IntMapTy;
@@ -18,10 +18,12 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
+#include "llvm/GVMaterializer.h"
 #include "llvm/IR/Instruction.h"
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/Support/ConstantRange.h"
+#include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/LeakDetector.h"
 #include "llvm/Support/ValueHandle.h"
 using namespace llvm;
@@ -526,7 +528,7 @@ static SmallVector<TrackingVH<MDNode>, 4> &getNMDOps(void *Operands) {
 
 NamedMDNode::NamedMDNode(const Twine &N)
   : Name(N.str()), Parent(0),
-    Operands(new SmallVector<TrackingVH<MDNode>, 4>()) {
+    Operands(new SmallVector<TrackingVH<MDNode>, 4>()), LazyOperands(false) {
 }
 
 NamedMDNode::~NamedMDNode() {
@@ -534,13 +536,37 @@ NamedMDNode::~NamedMDNode() {
   delete &getNMDOps(Operands);
 }
 
+/// materializeOperands - Have the materializer of the parent module add the
+/// operands that were left unread when the module was loaded lazily.
+bool NamedMDNode::materializeOperands(std::string *ErrInfo) {
+  if (!LazyOperands)
+    return false;
+  LazyOperands = false;
+  GVMaterializer *GVM = Parent ? Parent->getMaterializer() : 0;
+  assert(GVM && "Lazy named metadata without a materializer!");
+  return GVM->MaterializeNamedMetadata(this, ErrInfo);
+}
+
+/// readLazyOperands - Materialize the operands on first access.  The
+/// accessors have no way to report an error, so a failure is fatal.
+void NamedMDNode::readLazyOperands() const {
+  std::string ErrInfo;
+  if (const_cast<NamedMDNode*>(this)->materializeOperands(&ErrInfo))
+    report_fatal_error("Error reading named metadata '" + getName() + "': " +
+                       ErrInfo);
+}
+
 /// getNumOperands - Return number of NamedMDNode operands.
 unsigned NamedMDNode::getNumOperands() const {
+  if (LazyOperands)
+    readLazyOperands();
   return (unsigned)getNMDOps(Operands).size();
 }
 
 /// getOperand - Return specified operand.
 MDNode *NamedMDNode::getOperand(unsigned i) const {
+  if (LazyOperands)
+    readLazyOperands();
   assert(i < getNumOperands() && "Invalid Operand number!");
   return dyn_cast<MDNode>(&*getNMDOps(Operands)[i]);
 }
@@ -549,6 +575,8 @@ MDNode *NamedMDNode::getOperand(unsigned i) const {
 void NamedMDNode::addOperand(MDNode *M) {
   assert(!M->isFunctionLocal() &&
          "NamedMDNode operands must not be function-local!");
+  if (LazyOperands)
+    readLazyOperands();
   getNMDOps(Operands).push_back(TrackingVH<MDNode>(M));
 }
 
@@ -560,6 +588,7 @@ void NamedMDNode::eraseFromParent() {
 
 /// dropAllReferences - Remove all uses and clear node vector.
 void NamedMDNode::dropAllReferences() {
+  LazyOperands = false;
   getNMDOps(Operands).clear();
 }
 
@@ -13,6 +13,7 @@
 
 
 #include "llvm/PassManagers.h"
+#include "llvm/ADT/Statistic.h"
 #include "llvm/Assembly/PrintModulePass.h"
 #include "llvm/Assembly/Writer.h"
 #include "llvm/IR/Module.h"
@@ -20,9 +21,12 @@
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
 #include "llvm/Support/PassNameParser.h"
+#include "llvm/Support/Process.h"
+#include "llvm/Support/TimeValue.h"
 #include "llvm/Support/Timer.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
@@ -488,6 +492,80 @@ public:
 
 static TimingInfo *TheTimeInfo;
 
+bool llvm::PassTraceIsEnabled = false;
+
+static cl::opt<std::string>
+PassTraceFile("pass-trace-file", cl::value_desc("filename"),
+              cl::desc("Record each pass execution with its wall time and "
+                       "heap usage, writing a Chrome trace-event JSON file"));
+
+namespace {
+
+static ManagedStatic<sys::SmartMutex<true> > PassTraceMutex;
+
+/// PassTraceInfo - This collects the events recorded by PassTraceRegion and
+/// writes them out as a Chrome trace-event file ("chrome://tracing") when it
+/// is destroyed.  Only created when -pass-trace-file is specified.
+class PassTraceInfo {
+  struct Event {
+    std::string Name, Category, Unit;
+    double Start, Duration;   // In microseconds since tracing began.
+    size_t StartMem;          // Heap in use when the region began.
+    int64_t MemDelta;         // Change in heap usage over the region.
+  };
+
+  /// Open - The stack of regions which have started but not stopped yet.
+  std::vector<Event> Open;
+  std::vector<Event> Done;
+  sys::TimeValue Epoch;
+
+  double now() const {
+    sys::TimeValue Elapsed = sys::TimeValue::now() - Epoch;
+    return Elapsed.seconds() * 1000000.0 + Elapsed.microseconds();
+  }
+
+  static void writeEscaped(raw_ostream &OS, StringRef Str);
+  void write(raw_ostream &OS) const;
+
+public:
+  PassTraceInfo() : Epoch(sys::TimeValue::now()) {}
+  ~PassTraceInfo();
+
+  static void createThePassTraceInfo();
+
+  void start(StringRef Name, StringRef Category, StringRef Unit) {
+    sys::SmartScopedLock<true> Lock(*PassTraceMutex);
+    Event E;
+    E.Name = Name;
+    E.Category = Category;
+    E.Unit = Unit;
+    E.StartMem = sys::Process::GetMallocUsage();
+    E.MemDelta = 0;
+    E.Duration = 0;
+    E.Start = now();
+    Open.push_back(E);
+  }
+
+  void stop() {
+    sys::SmartScopedLock<true> Lock(*PassTraceMutex);
+    closeInnermost();
+  }
+
+private:
+  void closeInnermost() {
+    assert(!Open.empty() && "Unbalanced pass trace regions!");
+    Event &E = Open.back();
+    E.Duration = now() - E.Start;
+    E.MemDelta = int64_t(sys::Process::GetMallocUsage()) - int64_t(E.StartMem);
+    Done.push_back(E);
+    Open.pop_back();
+  }
+};
+
+} // End of anon namespace
+
+static PassTraceInfo *ThePassTraceInfo;
+
 //===----------------------------------------------------------------------===//
 // PMTopLevelManager implementation
 
@@ -867,6 +945,26 @@ void PMDataManager::verifyPreservedAnalysis(Pass *P) {
   }
 }
 
+/// isPreservedImmutablePass - Return true if PreservedSet lists IP or one of
+/// the analysis groups it implements.
+static bool
+isPreservedImmutablePass(ImmutablePass *IP,
+                         const AnalysisUsage::VectorType &PreservedSet) {
+  AnalysisID PI = IP->getPassID();
+  if (std::find(PreservedSet.begin(), PreservedSet.end(), PI) !=
+      PreservedSet.end())
+    return true;
+
+  const PassInfo *PInf = PassRegistry::getPassRegistry()->getPassInfo(PI);
+  if (PInf == 0) return false;
+  const std::vector<const PassInfo*> &II = PInf->getInterfacesImplemented();
+  for (unsigned i = 0, e = II.size(); i != e; ++i)
+    if (std::find(PreservedSet.begin(), PreservedSet.end(),
+                  II[i]->getTypeInfo()) != PreservedSet.end())
+      return true;
+  return false;
+}
+
 /// Remove Analysis not preserved by Pass P
 void PMDataManager::removeNotPreservedAnalysis(Pass *P) {
   AnalysisUsage *AnUsage = TPM->findAnalysisUsage(P);
@@ -874,6 +972,14 @@ void PMDataManager::removeNotPreservedAnalysis(Pass *P) {
     return;
 
   const AnalysisUsage::VectorType &PreservedSet = AnUsage->getPreservedSet();
+
+  // Immutable passes stay available, but let those that P does not preserve
+  // drop what they cached about the IR.
+  SmallVectorImpl<ImmutablePass *> &IPV = TPM->getImmutablePasses();
+  for (SmallVectorImpl<ImmutablePass *>::iterator I = IPV.begin(),
+       E = IPV.end(); I != E; ++I)
+    if (!isPreservedImmutablePass(*I, PreservedSet))
+      (*I)->releaseCachedInfo();
   for (DenseMap<AnalysisID, Pass*>::iterator I = AvailableAnalysis.begin(),
          E = AvailableAnalysis.end(); I != E; ) {
     DenseMap<AnalysisID, Pass*>::iterator Info = I++;
@@ -1299,6 +1405,8 @@ bool BBPassManager::runOnFunction(Function &F) {
         // If the pass crashes, remember this.
         PassManagerPrettyStackEntry X(BP, *I);
         TimeRegion PassTimer(getPassTimer(BP));
+        PassTraceRegion PassTrace(BP->getPassName(), "basicblock",
+                                  I->getName());
 
         LocalChanged |= BP->runOnBasicBlock(*I);
       }
@@ -1475,6 +1583,7 @@ void FunctionPassManagerImpl::releaseMemoryOnTheFly() {
 bool FunctionPassManagerImpl::run(Function &F) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassTraceInfo::createThePassTraceInfo();
 
   initializeAllAnalysisInfo();
   for (unsigned Index = 0; Index < getNumContainedManagers(); ++Index)
@@ -1514,6 +1623,12 @@ bool FPPassManager::runOnFunction(Function &F) {
   // Collect inherited analysis from Module level pass manager.
   populateInheritedAnalysis(TPM->activeStack);
 
+  // Group the passes run on this function under one region in the trace.
+  PassTraceRegion FunctionTrace(F.getName(), "function", F.getName());
+
+  // Attribute statistics bumped by these passes to F (-stats-per-function).
+  StatisticScope FunctionStats(F.getName());
+
   for (unsigned Index = 0; Index < getNumContainedPasses(); ++Index) {
     FunctionPass *FP = getContainedPass(Index);
     bool LocalChanged = false;
@@ -1526,6 +1641,7 @@ bool FPPassManager::runOnFunction(Function &F) {
     {
       PassManagerPrettyStackEntry X(FP, F);
       TimeRegion PassTimer(getPassTimer(FP));
+      PassTraceRegion PassTrace(FP->getPassName(), "function", F.getName());
 
       LocalChanged |= FP->runOnFunction(F);
     }
@@ -1604,6 +1720,8 @@ MPPassManager::runOnModule(Module &M) {
     {
       PassManagerPrettyStackEntry X(MP, M);
       TimeRegion PassTimer(getPassTimer(MP));
+      PassTraceRegion PassTrace(MP->getPassName(), "module",
+                                M.getModuleIdentifier());
 
       LocalChanged |= MP->runOnModule(M);
     }
@@ -1688,6 +1806,7 @@ Pass* MPPassManager::getOnTheFlyPass(Pass *MP, AnalysisID PI, Function &F){
 bool PassManagerImpl::run(Module &M) {
   bool Changed = false;
   TimingInfo::createTheTimeInfo();
+  PassTraceInfo::createThePassTraceInfo();
 
   dumpArguments();
   dumpPasses();
@@ -1766,6 +1885,83 @@ Timer *llvm::getPassTimer(Pass *P) {
   return 0;
 }
 
+//===----------------------------------------------------------------------===//
+// PassTraceInfo implementation
+
+void PassTraceInfo::writeEscaped(raw_ostream &OS, StringRef Str) {
+  for (StringRef::iterator I = Str.begin(), E = Str.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+}
+
+void PassTraceInfo::write(raw_ostream &OS) const {
+  // Events are emitted as "complete" events; the viewer reconstructs the
+  // nesting from the timestamps, so the order they finished in is fine.
+  OS << "{\"traceEvents\":[\n";
+  for (unsigned i = 0, e = Done.size(); i != e; ++i) {
+    const Event &E = Done[i];
+    OS << "{\"name\":\"";
+    writeEscaped(OS, E.Name);
+    OS << "\",\"cat\":\"" << E.Category << "\",\"ph\":\"X\",\"pid\":1,\"tid\":1,"
+       << format("\"ts\":%.0f,\"dur\":%.0f,", E.Start, E.Duration)
+       << "\"args\":{\"unit\":\"";
+    writeEscaped(OS, E.Unit);
+    OS << "\",\"heap_start\":" << (uint64_t)E.StartMem
+       << ",\"heap_delta\":" << E.MemDelta << "}}";
+    if (i + 1 != e)
+      OS << ',';
+    OS << '\n';
+  }
+  OS << "],\"displayTimeUnit\":\"ms\"}\n";
+}
+
+PassTraceInfo::~PassTraceInfo() {
+  // Close anything still open (e.g. if we are torn down by llvm_shutdown while
+  // a pass manager is still running) so the trace is well formed.
+  while (!Open.empty())
+    closeInnermost();
+
+  std::string ErrorInfo;
+  raw_fd_ostream OS(PassTraceFile.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) {
+    errs() << "Error opening pass trace file '" << PassTraceFile << "': "
+           << ErrorInfo << '\n';
+    return;
+  }
+  write(OS);
+}
+
+// createThePassTraceInfo - This method either initializes the ThePassTraceInfo
+// pointer to a non null value (if -pass-trace-file is given) or leaves it null.
+// It may be called multiple times.
+void PassTraceInfo::createThePassTraceInfo() {
+  if (PassTraceFile.empty() || ThePassTraceInfo) return;
+
+  // Like TimingInfo, constructing this lazily ensures it is destroyed (and the
+  // trace written) before the static globals it depends on.
+  static ManagedStatic<PassTraceInfo> PTI;
+  ThePassTraceInfo = &*PTI;
+  PassTraceIsEnabled = true;
+}
+
+void PassTraceRegion::start(StringRef Name, StringRef Category,
+                            StringRef Unit) {
+  if (!ThePassTraceInfo)
+    return;
+  ThePassTraceInfo->start(Name, Category, Unit);
+  Active = true;
+}
+
+void PassTraceRegion::stop() {
+  ThePassTraceInfo->stop();
+}
+
 //===----------------------------------------------------------------------===//
 // PMStack implementation
 //
@@ -177,12 +177,17 @@ void Value::setName(const Twine &NewName) {
   assert(SubclassID != MDStringVal &&
          "Cannot set the name of MDString with this method!");
 
+  // If the context is discarding local names, the only thing left to do is
+  // clear a name the value picked up before discarding was turned on.
+  bool Discard = !isa<GlobalValue>(this) &&
+                 getContext().shouldDiscardValueNames();
+
   // Fast path for common IRBuilder case of setName("") when there is no name.
-  if (NewName.isTriviallyEmpty() && !hasName())
+  if ((Discard || NewName.isTriviallyEmpty()) && !hasName())
     return;
 
   SmallString<256> NameData;
-  StringRef NameRef = NewName.toStringRef(NameData);
+  StringRef NameRef = Discard ? StringRef() : NewName.toStringRef(NameData);
 
   // Name isn't changing?
   if (getName() == NameRef)
@@ -18,6 +18,7 @@
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCAsmLayout.h"
 #include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCContext.h"
@@ -28,9 +29,13 @@
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/MC/StringTableBuilder.h"
+#include "llvm/Support/Compression.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/ELF.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <string>
 #include <vector>
 using namespace llvm;
 
@@ -50,10 +55,10 @@ class ELFObjectWriter : public MCObjectWriter {
                         bool isUsedInReloc);
     static bool IsELFMetaDataSection(const MCSectionData &SD);
     static uint64_t DataSectionSize(const MCSectionData &SD);
-    static uint64_t GetSectionFileSize(const MCAsmLayout &Layout,
-                                       const MCSectionData &SD);
-    static uint64_t GetSectionAddressSize(const MCAsmLayout &Layout,
-                                          const MCSectionData &SD);
+    uint64_t GetSectionFileSize(const MCAsmLayout &Layout,
+                                const MCSectionData &SD) const;
+    uint64_t GetSectionAddressSize(const MCAsmLayout &Layout,
+                                   const MCSectionData &SD) const;
 
     void WriteDataSectionData(MCAssembler &Asm,
                               const MCAsmLayout &Layout,
@@ -68,6 +73,7 @@ class ELFObjectWriter : public MCObjectWriter {
     /// information on symbols.
     struct ELFSymbolData {
       MCSymbolData *SymbolData;
+      StringRef Name;
       uint64_t StringIndex;
       uint32_t SectionIndex;
 
@@ -89,6 +95,12 @@ class ELFObjectWriter : public MCObjectWriter {
     SmallPtrSet<const MCSymbol *, 16> WeakrefUsedInReloc;
     DenseMap<const MCSymbol *, const MCSymbol *> Renames;
 
+    /// CompressedSections - The bytes to emit for each .debug_* section that
+    /// was compressed: the "ZLIB" magic, the uncompressed size as a 64-bit
+    /// big-endian number and the zlib stream. The fragments are left alone,
+    /// so symbols and relocations keep referring to the uncompressed data.
+    DenseMap<const MCSectionData *, std::string> CompressedSections;
+
     llvm::DenseMap<const MCSectionData*,
                    std::vector<ELFRelocationEntry> > Relocations;
     DenseMap<const MCSection*, uint64_t> SectionStringTableIndex;
@@ -97,7 +109,7 @@ class ELFObjectWriter : public MCObjectWriter {
     /// @name Symbol Table Data
     /// @{
 
-    SmallString<256> StringTable;
+    StringTableBuilder StrTabBuilder;
     std::vector<ELFSymbolData> LocalSymbolData;
     std::vector<ELFSymbolData> ExternalSymbolData;
     std::vector<ELFSymbolData> UndefinedSymbolData;
@@ -288,6 +300,10 @@ class ELFObjectWriter : public MCObjectWriter {
     void CreateRelocationSections(MCAssembler &Asm, MCAsmLayout &Layout,
                                   RelMapTy &RelMap);
 
+    /// CompressDebugSections - Compress the .debug_* sections and rename them
+    /// to .zdebug_*, if the assembler was asked to and zlib is available.
+    void CompressDebugSections(MCAssembler &Asm, MCAsmLayout &Layout);
+
     void WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
                           const RelMapTy &RelMap);
 
@@ -583,7 +599,7 @@ void ELFObjectWriter::WriteSymbolTable(MCDataFragment *SymtabF,
                                     const SectionIndexMapTy &SectionIndexMap) {
   // The string table must be emitted first because we need the index
   // into the string table for all the symbol names.
-  assert(StringTable.size() && "Missing string table");
+  assert(StrTabBuilder.data().size() && "Missing string table");
 
   // FIXME: Make sure the start of the symbol table is aligned.
 
@@ -876,12 +892,7 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
     MCELF::SetBinding(Data, ELF::STB_GLOBAL);
   }
 
-  // Index 0 is always the empty string.
-  StringMap<uint64_t> StringIndexMap;
-  StringTable += '\x00';
-
-  // FIXME: We could optimize suffixes in strtab in the same way we
-  // optimize them in shstrtab.
+  StrTabBuilder.clear();
 
   // Add the data for the symbols.
   for (MCAssembler::symbol_iterator it = Asm.symbol_begin(),
@@ -945,13 +956,8 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
       Name = Buf;
     }
 
-    uint64_t &Entry = StringIndexMap[Name];
-    if (!Entry) {
-      Entry = StringTable.size();
-      StringTable += Name;
-      StringTable += '\x00';
-    }
-    MSD.StringIndex = Entry;
+    MSD.Name = StrTabBuilder.add(Name);
+
     if (MSD.SectionIndex == ELF::SHN_UNDEF)
       UndefinedSymbolData.push_back(MSD);
     else if (Local)
@@ -960,6 +966,18 @@ void ELFObjectWriter::ComputeSymbolTable(MCAssembler &Asm,
       ExternalSymbolData.push_back(MSD);
   }
 
+  StrTabBuilder.finalize();
+
+  for (unsigned i = 0, e = LocalSymbolData.size(); i != e; ++i)
+    LocalSymbolData[i].StringIndex =
+      StrTabBuilder.getOffset(LocalSymbolData[i].Name);
+  for (unsigned i = 0, e = ExternalSymbolData.size(); i != e; ++i)
+    ExternalSymbolData[i].StringIndex =
+      StrTabBuilder.getOffset(ExternalSymbolData[i].Name);
+  for (unsigned i = 0, e = UndefinedSymbolData.size(); i != e; ++i)
+    UndefinedSymbolData[i].StringIndex =
+      StrTabBuilder.getOffset(UndefinedSymbolData[i].Name);
+
   // Symbols are required to be in lexicographic order.
   array_pod_sort(LocalSymbolData.begin(), LocalSymbolData.end());
   array_pod_sort(ExternalSymbolData.begin(), ExternalSymbolData.end());
@@ -1015,6 +1033,115 @@ void ELFObjectWriter::CreateRelocationSections(MCAssembler &Asm,
   }
 }
 
+/// getUncompressedSectionData - Render the contents of a debug section into
+/// Data. Returns false if the section has a fragment whose bytes can't be
+/// produced without the object writer, in which case it is left uncompressed.
+static bool getUncompressedSectionData(const MCAssembler &Asm,
+                                       const MCAsmLayout &Layout,
+                                       const MCSectionData &SD,
+                                       SmallVectorImpl<char> &Data) {
+  for (MCSectionData::const_iterator I = SD.begin(), E = SD.end(); I != E;
+       ++I) {
+    const MCFragment &F = *I;
+    switch (F.getKind()) {
+    case MCFragment::FT_Data:
+    case MCFragment::FT_Relaxable:
+    case MCFragment::FT_CompactEncodedInst: {
+      const MCEncodedFragment &EF = cast<MCEncodedFragment>(F);
+      if (EF.getBundlePadding())
+        return false;
+      Data.append(EF.getContents().begin(), EF.getContents().end());
+      break;
+    }
+    case MCFragment::FT_LEB: {
+      const SmallString<8> &Contents = cast<MCLEBFragment>(F).getContents();
+      Data.append(Contents.begin(), Contents.end());
+      break;
+    }
+    case MCFragment::FT_Dwarf: {
+      const SmallString<8> &Contents =
+        cast<MCDwarfLineAddrFragment>(F).getContents();
+      Data.append(Contents.begin(), Contents.end());
+      break;
+    }
+    case MCFragment::FT_DwarfFrame: {
+      const SmallString<8> &Contents =
+        cast<MCDwarfCallFrameFragment>(F).getContents();
+      Data.append(Contents.begin(), Contents.end());
+      break;
+    }
+    case MCFragment::FT_Align: {
+      const MCAlignFragment &AF = cast<MCAlignFragment>(F);
+      if (AF.hasEmitNops() || AF.getValue() != 0)
+        return false;
+      Data.append(Asm.computeFragmentSize(Layout, F), '\0');
+      break;
+    }
+    case MCFragment::FT_Fill:
+      if (cast<MCFillFragment>(F).getValue() != 0)
+        return false;
+      Data.append(Asm.computeFragmentSize(Layout, F), '\0');
+      break;
+    default:
+      return false;
+    }
+  }
+  return Data.size() == Layout.getSectionAddressSize(&SD);
+}
+
+void ELFObjectWriter::CompressDebugSections(MCAssembler &Asm,
+                                            MCAsmLayout &Layout) {
+  CompressedSections.clear();
+  if (!Asm.getContext().getAsmInfo().compressDebugSections() ||
+      !zlib::isAvailable())
+    return;
+
+  // Sections that other objects may refer to by a global symbol keep their
+  // name and contents.
+  SmallPtrSet<const MCSection*, 4> HasGlobalSymbols;
+  for (MCAssembler::const_symbol_iterator I = Asm.symbol_begin(),
+         E = Asm.symbol_end(); I != E; ++I) {
+    const MCSymbol &Symbol = I->getSymbol();
+    if (!Symbol.isTemporary() && Symbol.isInSection())
+      HasGlobalSymbols.insert(&Symbol.getSection());
+  }
+
+  SmallVector<char, 0> Uncompressed;
+  for (MCAssembler::iterator I = Asm.begin(), E = Asm.end(); I != E; ++I) {
+    MCSectionData &SD = *I;
+    const MCSectionELF &Section =
+      static_cast<const MCSectionELF&>(SD.getSection());
+    StringRef Name = Section.getSectionName();
+    if (!Name.startswith(".debug_") || (Section.getFlags() & ELF::SHF_ALLOC) ||
+        Section.isVirtualSection() || HasGlobalSymbols.count(&Section))
+      continue;
+
+    Uncompressed.clear();
+    if (!getUncompressedSectionData(Asm, Layout, SD, Uncompressed))
+      continue;
+
+    OwningPtr<MemoryBuffer> Compressed;
+    StringRef Input(Uncompressed.data(), Uncompressed.size());
+    if (zlib::compressInParallel(Input, Compressed) != zlib::StatusOK)
+      continue;
+
+    // Only keep the compressed form if it, with its 12 byte header, is
+    // actually smaller.
+    const size_t HeaderSize = 12;
+    if (Compressed->getBufferSize() + HeaderSize >= Uncompressed.size())
+      continue;
+
+    std::string &Data = CompressedSections[&SD];
+    Data.reserve(HeaderSize + Compressed->getBufferSize());
+    Data += "ZLIB";
+    for (int Shift = 56; Shift >= 0; Shift -= 8)
+      Data += char(uint64_t(Uncompressed.size()) >> Shift);
+    Data += Compressed->getBuffer();
+
+    Asm.getContext().renameELFSection(&Section, (".z" + Name.substr(1)).str());
+  }
+}
+
 void ELFObjectWriter::WriteRelocations(MCAssembler &Asm, MCAsmLayout &Layout,
                                        const RelMapTy &RelMap) {
   for (MCAssembler::const_iterator it = Asm.begin(),
@@ -1100,24 +1227,6 @@ void ELFObjectWriter::WriteRelocationsFragment(const MCAssembler &Asm,
   }
 }
 
-static int compareBySuffix(const void *a, const void *b) {
-  const MCSectionELF *secA = *static_cast<const MCSectionELF* const *>(a);
-  const MCSectionELF *secB = *static_cast<const MCSectionELF* const *>(b);
-  const StringRef &NameA = secA->getSectionName();
-  const StringRef &NameB = secB->getSectionName();
-  const unsigned sizeA = NameA.size();
-  const unsigned sizeB = NameB.size();
-  const unsigned len = std::min(sizeA, sizeB);
-  for (unsigned int i = 0; i < len; ++i) {
-    char ca = NameA[sizeA - i - 1];
-    char cb = NameB[sizeB - i - 1];
-    if (ca != cb)
-      return cb - ca;
-  }
-
-  return sizeB - sizeA;
-}
-
 void ELFObjectWriter::CreateMetadataSections(MCAssembler &Asm,
                                              MCAsmLayout &Layout,
                                              SectionIndexMapTy &SectionIndexMap,
@@ -1172,44 +1281,31 @@ void ELFObjectWriter::CreateMetadataSections(MCAssembler &Asm,
   WriteSymbolTable(F, ShndxF, Asm, Layout, SectionIndexMap);
 
   F = new MCDataFragment(&StrtabSD);
-  F->getContents().append(StringTable.begin(), StringTable.end());
+  F->getContents().append(StrTabBuilder.data().begin(),
+                          StrTabBuilder.data().end());
 
   F = new MCDataFragment(&ShstrtabSD);
 
-  std::vector<const MCSectionELF*> Sections;
+  // Section header string table.
+  StringTableBuilder ShStrTabBuilder;
   for (MCAssembler::const_iterator it = Asm.begin(),
          ie = Asm.end(); it != ie; ++it) {
     const MCSectionELF &Section =
       static_cast<const MCSectionELF&>(it->getSection());
-    Sections.push_back(&Section);
+    ShStrTabBuilder.add(Section.getSectionName());
   }
-  array_pod_sort(Sections.begin(), Sections.end(), compareBySuffix);
-
-  // Section header string table.
-  //
-  // The first entry of a string table holds a null character so skip
-  // section 0.
-  uint64_t Index = 1;
-  F->getContents().push_back('\x00');
-
-  for (unsigned int I = 0, E = Sections.size(); I != E; ++I) {
-    const MCSectionELF &Section = *Sections[I];
+  ShStrTabBuilder.finalize();
+  F->getContents().append(ShStrTabBuilder.data().begin(),
+                          ShStrTabBuilder.data().end());
 
-    StringRef Name = Section.getSectionName();
-    if (I != 0) {
-      StringRef PreviousName = Sections[I - 1]->getSectionName();
-      if (PreviousName.endswith(Name)) {
-        SectionStringTableIndex[&Section] = Index - Name.size() - 1;
-        continue;
-      }
-    }
-    // Remember the index into the string table so we can write it
-    // into the sh_name field of the section header table.
-    SectionStringTableIndex[&Section] = Index;
-
-    Index += Name.size() + 1;
-    F->getContents().append(Name.begin(), Name.end());
-    F->getContents().push_back('\x00');
+  // Remember the index into the string table so we can write it into the
+  // sh_name field of the section header table.
+  for (MCAssembler::const_iterator it = Asm.begin(),
+         ie = Asm.end(); it != ie; ++it) {
+    const MCSectionELF &Section =
+      static_cast<const MCSectionELF&>(it->getSection());
+    SectionStringTableIndex[&Section] =
+      ShStrTabBuilder.getOffset(Section.getSectionName());
   }
 }
 
@@ -1378,16 +1474,24 @@ uint64_t ELFObjectWriter::DataSectionSize(const MCSectionData &SD) {
 }
 
 uint64_t ELFObjectWriter::GetSectionFileSize(const MCAsmLayout &Layout,
-                                             const MCSectionData &SD) {
+                                             const MCSectionData &SD) const {
   if (IsELFMetaDataSection(SD))
     return DataSectionSize(SD);
+  DenseMap<const MCSectionData*, std::string>::const_iterator It =
+    CompressedSections.find(&SD);
+  if (It != CompressedSections.end())
+    return It->second.size();
   return Layout.getSectionFileSize(&SD);
 }
 
 uint64_t ELFObjectWriter::GetSectionAddressSize(const MCAsmLayout &Layout,
-                                                const MCSectionData &SD) {
+                                                const MCSectionData &SD) const {
   if (IsELFMetaDataSection(SD))
     return DataSectionSize(SD);
+  DenseMap<const MCSectionData*, std::string>::const_iterator It =
+    CompressedSections.find(&SD);
+  if (It != CompressedSections.end())
+    return It->second.size();
   return Layout.getSectionAddressSize(&SD);
 }
 
@@ -1406,9 +1510,15 @@ void ELFObjectWriter::WriteDataSectionData(MCAssembler &Asm,
       assert(F.getKind() == MCFragment::FT_Data);
       WriteBytes(cast<MCDataFragment>(F).getContents());
     }
-  } else {
-    Asm.writeSectionData(&SD, Layout);
+    return;
   }
+
+  DenseMap<const MCSectionData*, std::string>::const_iterator It =
+    CompressedSections.find(&SD);
+  if (It != CompressedSections.end())
+    WriteBytes(It->second);
+  else
+    Asm.writeSectionData(&SD, Layout);
 }
 
 void ELFObjectWriter::WriteSectionHeader(MCAssembler &Asm,
@@ -1490,6 +1600,10 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
 
   unsigned NumUserSections = Asm.size();
 
+  // Compress first, so the relocation sections are named after the
+  // compressed sections.
+  CompressDebugSections(Asm, const_cast<MCAsmLayout&>(Layout));
+
   DenseMap<const MCSectionELF*, const MCSectionELF*> RelMap;
   CreateRelocationSections(Asm, const_cast<MCAsmLayout&>(Layout), RelMap);
 
@@ -1555,6 +1669,9 @@ void ELFObjectWriter::WriteObject(MCAssembler &Asm,
     FileOff += GetSectionFileSize(Layout, SD);
   }
 
+  // The layout is known now, so let the stream make room for all of it.
+  OS.reserveExtraSpace(FileOff);
+
   // Write out the ELF header ...
   WriteHeader(Asm, SectionHeaderOffset, NumSections + 1);
 
@@ -934,46 +934,96 @@ bool MCAssembler::relaxDwarfCallFrameFragment(MCAsmLayout &Layout,
   return OldSize != Data.size();
 }
 
-bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
-  // Holds the first fragment which needed relaxing during this layout. It will
-  // remain NULL if none were relaxed.
-  // When a fragment is relaxed, all the fragments following it should get
-  // invalidated because their offset is going to change.
-  MCFragment *FirstRelaxedFragment = NULL;
+bool MCAssembler::relaxFragment(MCAsmLayout &Layout, MCFragment &F) {
+  switch(F.getKind()) {
+  default:
+    return false;
+  case MCFragment::FT_Relaxable:
+    assert(!getRelaxAll() &&
+           "Did not expect a MCRelaxableFragment in RelaxAll mode");
+    return relaxInstruction(Layout, cast<MCRelaxableFragment>(F));
+  case MCFragment::FT_Dwarf:
+    return relaxDwarfLineAddr(Layout, cast<MCDwarfLineAddrFragment>(F));
+  case MCFragment::FT_DwarfFrame:
+    return relaxDwarfCallFrameFragment(Layout,
+                                       cast<MCDwarfCallFrameFragment>(F));
+  case MCFragment::FT_LEB:
+    return relaxLEB(Layout, cast<MCLEBFragment>(F));
+  }
+}
+
+uint64_t MCAssembler::getRelaxationReach(const MCAsmLayout &Layout,
+                                         const MCFragment &F) const {
+  const MCRelaxableFragment *RF = dyn_cast<MCRelaxableFragment>(&F);
+  if (!RF || !getBackend().mayNeedRelaxation(RF->getInst()))
+    return 0;
+
+  const MCSection &Section = RF->getParent()->getSection();
+  uint64_t Offset = Layout.getFragmentOffset(RF);
+  uint64_t Reach = 0;
+  for (MCRelaxableFragment::const_fixup_iterator it = RF->fixup_begin(),
+       ie = RF->fixup_end(); it != ie; ++it) {
+    MCValue Target;
+    uint64_t Value;
+    evaluateFixup(Layout, *it, RF, Target, Value);
+    const MCSymbolRefExpr *A = Target.getSymA();
+    if (!A)
+      continue;
+    const MCSymbol &Sym = A->getSymbol().AliasedSymbol();
+    if (!Sym.isInSection() || &Sym.getSection() != &Section)
+      continue;
+    uint64_t SymOffset = Layout.getSymbolOffset(&getSymbolData(Sym));
+    uint64_t Distance = SymOffset > Offset ? SymOffset - Offset
+                                           : Offset - SymOffset;
+    Reach = std::max(Reach, Distance + RF->getContents().size());
+  }
+  return Reach;
+}
 
-  // Attempt to relax all the fragments in the section.
+bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSectionData &SD) {
+  // Relax the fragments in a single forward sweep. A relaxed fragment
+  // invalidates the layout from itself onwards, so every later fragment is
+  // checked against the up to date size of everything before it.
+  //
+  // Growing a fragment can also push the targets of fragments we have
+  // already passed out of range. Rather than sweeping the whole section again
+  // for those, re-check only the fragments around the grown one that are
+  // close enough to reach across it. MaxReach is the furthest any fragment
+  // that could still relax has been seen to reach. Anything this misses
+  // (e.g. LEB fragments whose value depends on this section) is caught by the
+  // caller, which repeats the sweep until nothing relaxes.
+  bool WasRelaxed = false;
+  uint64_t MaxReach = 0;
+  SmallVector<MCFragment*, 8> Worklist;
   for (MCSectionData::iterator I = SD.begin(), IE = SD.end(); I != IE; ++I) {
-    // Check if this is a fragment that needs relaxation.
-    bool RelaxedFrag = false;
-    switch(I->getKind()) {
-    default:
-      break;
-    case MCFragment::FT_Relaxable:
-      assert(!getRelaxAll() &&
-             "Did not expect a MCRelaxableFragment in RelaxAll mode");
-      RelaxedFrag = relaxInstruction(Layout, *cast<MCRelaxableFragment>(I));
-      break;
-    case MCFragment::FT_Dwarf:
-      RelaxedFrag = relaxDwarfLineAddr(Layout,
-                                       *cast<MCDwarfLineAddrFragment>(I));
-      break;
-    case MCFragment::FT_DwarfFrame:
-      RelaxedFrag =
-        relaxDwarfCallFrameFragment(Layout,
-                                    *cast<MCDwarfCallFrameFragment>(I));
-      break;
-    case MCFragment::FT_LEB:
-      RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
-      break;
+    if (!relaxFragment(Layout, *I)) {
+      MaxReach = std::max(MaxReach, getRelaxationReach(Layout, *I));
+      continue;
+    }
+
+    WasRelaxed = true;
+    Worklist.push_back(I);
+    while (!Worklist.empty()) {
+      MCFragment *Relaxed = Worklist.pop_back_val();
+      Layout.invalidateFragmentsFrom(Relaxed);
+      uint64_t Offset = Layout.getFragmentOffset(Relaxed);
+
+      for (MCFragment *J = Relaxed->getPrevNode();
+           J && Offset - Layout.getFragmentOffset(J) <= MaxReach;
+           J = J->getPrevNode())
+        if (relaxFragment(Layout, *J))
+          Worklist.push_back(J);
+
+      // Fragments after the sweep position are checked when we get to them.
+      for (MCFragment *J = Relaxed->getNextNode();
+           J && J->getLayoutOrder() <= I->getLayoutOrder() &&
+           Layout.getFragmentOffset(J) - Offset <= MaxReach;
+           J = J->getNextNode())
+        if (relaxFragment(Layout, *J))
+          Worklist.push_back(J);
     }
-    if (RelaxedFrag && !FirstRelaxedFragment)
-      FirstRelaxedFragment = I;
-  }
-  if (FirstRelaxedFragment) {
-    Layout.invalidateFragmentsFrom(FirstRelaxedFragment);
-    return true;
   }
-  return false;
+  return WasRelaxed;
 }
 
 bool MCAssembler::layoutOnce(MCAsmLayout &Layout) {
@@ -110,25 +110,29 @@ MCSymbol *MCContext::GetOrCreateSymbol(StringRef Name) {
   assert(!Name.empty() && "Normal symbols cannot be unnamed!");
 
   // Do the lookup and get the entire StringMapEntry.  We want access to the
-  // key if we are creating the entry.
-  StringMapEntry<MCSymbol*> &Entry = Symbols.GetOrCreateValue(Name);
+  // key if we are creating the entry.  The hash is reused for the UsedNames
+  // lookup if the symbol is new.
+  unsigned FullHashValue = StringMapImpl::hash(Name);
+  StringMapEntry<MCSymbol*> &Entry =
+    Symbols.GetOrCreateValue(Name, FullHashValue, (MCSymbol*)0);
   MCSymbol *Sym = Entry.getValue();
 
   if (Sym)
     return Sym;
 
-  Sym = CreateSymbol(Name);
+  Sym = CreateSymbol(Name, FullHashValue);
   Entry.setValue(Sym);
   return Sym;
 }
 
-MCSymbol *MCContext::CreateSymbol(StringRef Name) {
+MCSymbol *MCContext::CreateSymbol(StringRef Name, unsigned FullHashValue) {
   // Determine whether this is an assembler temporary or normal label, if used.
   bool isTemporary = false;
   if (AllowTemporaryLabels)
     isTemporary = Name.startswith(MAI.getPrivateGlobalPrefix());
 
-  StringMapEntry<bool> *NameEntry = &UsedNames.GetOrCreateValue(Name);
+  StringMapEntry<bool> *NameEntry =
+    &UsedNames.GetOrCreateValue(Name, FullHashValue, false);
   if (NameEntry->getValue()) {
     assert(isTemporary && "Cannot rename non temporary symbols");
     SmallString<128> NewName = Name;
@@ -157,7 +161,7 @@ MCSymbol *MCContext::CreateTempSymbol() {
   SmallString<128> NameSV;
   raw_svector_ostream(NameSV)
     << MAI.getPrivateGlobalPrefix() << "tmp" << NextUniqueID++;
-  return CreateSymbol(NameSV);
+  return CreateSymbol(NameSV, StringMapImpl::hash(NameSV));
 }
 
 unsigned MCContext::NextInstance(int64_t LocalLabelVal) {
@@ -263,6 +267,27 @@ getELFSection(StringRef Section, unsigned Type, unsigned Flags,
   return Result;
 }
 
+void MCContext::renameELFSection(const MCSectionELF *Section, StringRef Name) {
+  StringRef OldName = Section->getSectionName();
+  if (OldName == Name)
+    return;
+
+  if (ELFUniquingMap == 0)
+    ELFUniquingMap = new ELFUniqueMapTy();
+  ELFUniqueMapTy &Map = *(ELFUniqueMapTy*)ELFUniquingMap;
+
+  StringMapEntry<const MCSectionELF*> &Entry = Map.GetOrCreateValue(Name);
+  assert(!Entry.getValue() && "Section name is already in use!");
+  Entry.setValue(Section);
+
+  // The old entry owns the storage OldName refers to, so point the section at
+  // the new key before dropping it.
+  const_cast<MCSectionELF*>(Section)->SectionName = Entry.getKey();
+  ELFUniqueMapTy::iterator I = Map.find(OldName);
+  if (I != Map.end() && I->getValue() == Section)
+    Map.erase(I);
+}
+
 const MCSectionELF *MCContext::CreateELFGroupSection() {
   MCSectionELF *Result =
     new (*this) MCSectionELF(".group", ELF::SHT_GROUP, 0,
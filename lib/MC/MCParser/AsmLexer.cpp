@@ -93,7 +93,11 @@ AsmToken AsmLexer::LexFloatLiteral() {
 
 /// LexIdentifier: [a-zA-Z_.][a-zA-Z0-9_$.@]*
 static bool IsIdentifierChar(char c) {
-  return isalnum(c) || c == '_' || c == '$' || c == '.' || c == '@';
+  // Spelled out rather than using isalnum, which goes through the locale
+  // tables and shows up when lexing large inputs.
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') ||
+         c == '_' || c == '$' || c == '.' || c == '@';
 }
 AsmToken AsmLexer::LexIdentifier() {
   // Check for floating point literals.
@@ -146,12 +150,15 @@ AsmToken AsmLexer::LexSlash() {
 AsmToken AsmLexer::LexLineComment() {
   // FIXME: This is broken if we happen to a comment at the end of a file, which
   // was .included, and which doesn't end with a newline.
-  int CurChar = getNextChar();
-  while (CurChar != '\n' && CurChar != '\r' && CurChar != EOF)
-    CurChar = getNextChar();
+  // Scan for the end of the line directly; only the nul at the end of the
+  // buffer needs the EOF handling in getNextChar.
+  const char *BufEnd = CurBuf->getBufferEnd();
+  while (*CurPtr != '\n' && *CurPtr != '\r' && CurPtr != BufEnd)
+    ++CurPtr;
 
-  if (CurChar == EOF)
+  if (CurPtr == BufEnd)
     return AsmToken(AsmToken::Eof, StringRef(CurPtr, 0));
+  ++CurPtr;
   return AsmToken(AsmToken::EndOfStatement, StringRef(CurPtr, 0));
 }
 
@@ -390,8 +397,11 @@ bool AsmLexer::isAtStartOfComment(char Char) {
 }
 
 bool AsmLexer::isAtStatementSeparator(const char *Ptr) {
-  return strncmp(Ptr, MAI.getSeparatorString(),
-                 strlen(MAI.getSeparatorString())) == 0;
+  // This is asked for every token, so reject on the first character before
+  // doing the full comparison.
+  const char *Separator = MAI.getSeparatorString();
+  return Ptr[0] == Separator[0] &&
+         strncmp(Ptr, Separator, strlen(Separator)) == 0;
 }
 
 AsmToken AsmLexer::LexToken() {
@@ -435,7 +445,10 @@ AsmToken AsmLexer::LexToken() {
   case ' ':
   case '\t':
     if (SkipSpace) {
-      // Ignore whitespace.
+      // Ignore whitespace, skipping a whole run of it at once rather than
+      // recursing per character.
+      while (*CurPtr == ' ' || *CurPtr == '\t')
+        ++CurPtr;
       return LexToken();
     } else {
       int len = 1;
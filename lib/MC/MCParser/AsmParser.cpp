@@ -57,17 +57,132 @@ typedef std::vector<MCAsmMacroArgument> MCAsmMacroArguments;
 typedef std::pair<StringRef, MCAsmMacroArgument> MCAsmMacroParameter;
 typedef std::vector<MCAsmMacroParameter> MCAsmMacroParameters;
 
+/// \brief A run of literal text from a macro body together with the
+/// substitution that follows it.
+struct MCAsmMacroBodyPiece {
+  enum SubstitutionKind {
+    NoSubstitution, ///< Just the literal text.
+    Parameter,      ///< \foo => the value of parameter Index.
+    ArgumentCount,  ///< $n => the number of arguments.
+    Argument        ///< $[0-9] => argument Index, if it was given.
+  };
+
+  StringRef Text;
+  SubstitutionKind Kind;
+  unsigned Index;
+
+  MCAsmMacroBodyPiece(StringRef T, SubstitutionKind K, unsigned I)
+    : Text(T), Kind(K), Index(I) {}
+};
+typedef std::vector<MCAsmMacroBodyPiece> MCAsmMacroBodyPieces;
+
+// FIXME: This is mostly duplicated from the function in AsmLexer.cpp. The
+// difference being that that function accepts '@' as part of identifiers and
+// we can't do that. AsmLexer.cpp should probably be changed to handle
+// '@' as a special case when needed.
+static bool isIdentifierChar(char c) {
+  return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' ||
+         c == '.';
+}
+
+/// splitMacroBody - Split a macro body into literal text and substitutions.
+/// A macro without parameters is handled differently on Darwin: gas accepts
+/// no arguments and does no substitutions, but $0, $1, etc. are expanded.
+static void splitMacroBody(StringRef Body,
+                           const MCAsmMacroParameters &Parameters,
+                           MCAsmMacroBodyPieces &Pieces) {
+  unsigned NParameters = Parameters.size();
+  std::size_t End = Body.size(), Start = 0, Pos = 0;
+  while (Pos < End) {
+    if (!NParameters) {
+      // This macro has no parameters, look for $0, $1, etc.
+      if (Body[Pos] != '$' || Pos + 1 == End) {
+        ++Pos;
+        continue;
+      }
+
+      char Next = Body[Pos + 1];
+      if (Next == '$')
+        // $$ => $
+        Pieces.push_back(MCAsmMacroBodyPiece(Body.slice(Start, Pos + 1),
+                                             MCAsmMacroBodyPiece::NoSubstitution,
+                                             0));
+      else if (Next == 'n')
+        Pieces.push_back(MCAsmMacroBodyPiece(Body.slice(Start, Pos),
+                                             MCAsmMacroBodyPiece::ArgumentCount,
+                                             0));
+      else if (isdigit(static_cast<unsigned char>(Next)))
+        Pieces.push_back(MCAsmMacroBodyPiece(Body.slice(Start, Pos),
+                                             MCAsmMacroBodyPiece::Argument,
+                                             Next - '0'));
+      else {
+        ++Pos;
+        continue;
+      }
+      Pos += 2;
+      Start = Pos;
+      continue;
+    }
+
+    // This macro has parameters, look for \foo, \bar, etc.
+    if (Body[Pos] != '\\' || Pos + 1 == End) {
+      ++Pos;
+      continue;
+    }
+
+    std::size_t I = Pos + 1;
+    while (isIdentifierChar(Body[I]) && I + 1 != End)
+      ++I;
+
+    StringRef Argument = Body.slice(Pos + 1, I);
+    unsigned Index = 0;
+    for (; Index < NParameters; ++Index)
+      if (Parameters[Index].first == Argument)
+        break;
+
+    if (Index != NParameters) {
+      Pieces.push_back(MCAsmMacroBodyPiece(Body.slice(Start, Pos),
+                                           MCAsmMacroBodyPiece::Parameter,
+                                           Index));
+      Pos += 1 + Argument.size();
+      Start = Pos;
+    } else if (Body[Pos+1] == '(' && Body[Pos+2] == ')') {
+      // \() is an empty separator.
+      Pieces.push_back(MCAsmMacroBodyPiece(Body.slice(Start, Pos),
+                                           MCAsmMacroBodyPiece::NoSubstitution,
+                                           0));
+      Pos += 3;
+      Start = Pos;
+    } else {
+      // Not a parameter; the escape is copied through as it is.
+      Pos = I;
+    }
+  }
+
+  if (Start < End)
+    Pieces.push_back(MCAsmMacroBodyPiece(Body.slice(Start, End),
+                                         MCAsmMacroBodyPiece::NoSubstitution,
+                                         0));
+}
+
 struct MCAsmMacro {
   StringRef Name;
   StringRef Body;
   MCAsmMacroParameters Parameters;
 
+  /// Pieces - The body split at its substitutions, computed once when the
+  /// macro is defined so that instantiations don't rescan the body text.
+  MCAsmMacroBodyPieces Pieces;
+
 public:
   MCAsmMacro(StringRef N, StringRef B, const MCAsmMacroParameters &P) :
-    Name(N), Body(B), Parameters(P) {}
+    Name(N), Body(B), Parameters(P) {
+    splitMacroBody(Body, Parameters, Pieces);
+  }
 
   MCAsmMacro(const MCAsmMacro& Other)
-    : Name(Other.Name), Body(Other.Body), Parameters(Other.Parameters) {}
+    : Name(Other.Name), Body(Other.Body), Parameters(Other.Parameters),
+      Pieces(Other.Pieces) {}
 };
 
 /// \brief Helper class for storing information about an active macro
@@ -241,7 +356,8 @@ private:
 
   void CheckForBadMacro(SMLoc DirectiveLoc, StringRef Name, StringRef Body,
                         MCAsmMacroParameters Parameters);
-  bool expandMacro(raw_svector_ostream &OS, StringRef Body,
+  bool expandMacro(raw_svector_ostream &OS,
+                   const MCAsmMacroBodyPieces &Pieces,
                    const MCAsmMacroParameters &Parameters,
                    const MCAsmMacroArguments &A,
                    const SMLoc &L);
@@ -1632,16 +1748,8 @@ void AsmParser::DiagHandler(const SMDiagnostic &Diag, void *Context) {
     NewDiag.print(0, OS);
 }
 
-// FIXME: This is mostly duplicated from the function in AsmLexer.cpp. The
-// difference being that that function accepts '@' as part of identifiers and
-// we can't do that. AsmLexer.cpp should probably be changed to handle
-// '@' as a special case when needed.
-static bool isIdentifierChar(char c) {
-  return isalnum(static_cast<unsigned char>(c)) || c == '_' || c == '$' ||
-         c == '.';
-}
-
-bool AsmParser::expandMacro(raw_svector_ostream &OS, StringRef Body,
+bool AsmParser::expandMacro(raw_svector_ostream &OS,
+                            const MCAsmMacroBodyPieces &Pieces,
                             const MCAsmMacroParameters &Parameters,
                             const MCAsmMacroArguments &A,
                             const SMLoc &L) {
@@ -1649,95 +1757,38 @@ bool AsmParser::expandMacro(raw_svector_ostream &OS, StringRef Body,
   if (NParameters != 0 && NParameters != A.size())
     return Error(L, "Wrong number of arguments");
 
-  // A macro without parameters is handled differently on Darwin:
-  // gas accepts no arguments and does no substitutions
-  while (!Body.empty()) {
-    // Scan for the next substitution.
-    std::size_t End = Body.size(), Pos = 0;
-    for (; Pos != End; ++Pos) {
-      // Check for a substitution or escape.
-      if (!NParameters) {
-        // This macro has no parameters, look for $0, $1, etc.
-        if (Body[Pos] != '$' || Pos + 1 == End)
-          continue;
+  for (MCAsmMacroBodyPieces::const_iterator PI = Pieces.begin(),
+         PE = Pieces.end(); PI != PE; ++PI) {
+    OS << PI->Text;
 
-        char Next = Body[Pos + 1];
-        if (Next == '$' || Next == 'n' ||
-            isdigit(static_cast<unsigned char>(Next)))
-          break;
-      } else {
-        // This macro has parameters, look for \foo, \bar, etc.
-        if (Body[Pos] == '\\' && Pos + 1 != End)
-          break;
-      }
-    }
-
-    // Add the prefix.
-    OS << Body.slice(0, Pos);
-
-    // Check if we reached the end.
-    if (Pos == End)
+    switch (PI->Kind) {
+    case MCAsmMacroBodyPiece::NoSubstitution:
       break;
 
-    if (!NParameters) {
-      switch (Body[Pos+1]) {
-        // $$ => $
-      case '$':
-        OS << '$';
-        break;
+    case MCAsmMacroBodyPiece::ArgumentCount:
+      OS << A.size();
+      break;
 
-        // $n => number of arguments
-      case 'n':
-        OS << A.size();
+    case MCAsmMacroBodyPiece::Argument:
+      // Missing arguments are ignored.
+      if (PI->Index >= A.size())
         break;
 
-        // $[0-9] => argument
-      default: {
-        // Missing arguments are ignored.
-        unsigned Index = Body[Pos+1] - '0';
-        if (Index >= A.size())
-          break;
+      // Otherwise substitute with the token values, with spaces eliminated.
+      for (MCAsmMacroArgument::const_iterator it = A[PI->Index].begin(),
+             ie = A[PI->Index].end(); it != ie; ++it)
+        OS << it->getString();
+      break;
 
-        // Otherwise substitute with the token values, with spaces eliminated.
-        for (MCAsmMacroArgument::const_iterator it = A[Index].begin(),
-               ie = A[Index].end(); it != ie; ++it)
+    case MCAsmMacroBodyPiece::Parameter:
+      for (MCAsmMacroArgument::const_iterator it = A[PI->Index].begin(),
+             ie = A[PI->Index].end(); it != ie; ++it)
+        if (it->getKind() == AsmToken::String)
+          OS << it->getStringContents();
+        else
           OS << it->getString();
-        break;
-      }
-      }
-      Pos += 2;
-    } else {
-      unsigned I = Pos + 1;
-      while (isIdentifierChar(Body[I]) && I + 1 != End)
-        ++I;
-
-      const char *Begin = Body.data() + Pos +1;
-      StringRef Argument(Begin, I - (Pos +1));
-      unsigned Index = 0;
-      for (; Index < NParameters; ++Index)
-        if (Parameters[Index].first == Argument)
-          break;
-
-      if (Index == NParameters) {
-          if (Body[Pos+1] == '(' && Body[Pos+2] == ')')
-            Pos += 3;
-          else {
-            OS << '\\' << Argument;
-            Pos = I;
-          }
-      } else {
-        for (MCAsmMacroArgument::const_iterator it = A[Index].begin(),
-               ie = A[Index].end(); it != ie; ++it)
-          if (it->getKind() == AsmToken::String)
-            OS << it->getStringContents();
-          else
-            OS << it->getString();
-
-        Pos += 1 + Argument.size();
-      }
+      break;
     }
-    // Update the scan point.
-    Body = Body.substr(Pos);
   }
 
   return false;
@@ -1865,6 +1916,7 @@ bool AsmParser::ParseMacroArguments(const MCAsmMacro *M, MCAsmMacroArguments &A)
   // Argument delimiter is initially unknown. It will be set by
   // ParseMacroArgument()
   AsmToken::TokenKind ArgumentDelimiter = AsmToken::Eof;
+  A.reserve(NParameters);
 
   // Parse two kinds of macro invocations:
   // - macros defined without any parameters accept an arbitrary number of them
@@ -1876,9 +1928,11 @@ bool AsmParser::ParseMacroArguments(const MCAsmMacro *M, MCAsmMacroArguments &A)
     if (ParseMacroArgument(MA, ArgumentDelimiter))
       return true;
 
-    if (!MA.empty() || !NParameters)
-      A.push_back(MA);
-    else if (NParameters) {
+    if (!MA.empty() || !NParameters) {
+      // Hand the tokens over rather than copying them.
+      A.push_back(MCAsmMacroArgument());
+      A.back().swap(MA);
+    } else if (NParameters) {
       if (!M->Parameters[Parameter].second.empty())
         A.push_back(M->Parameters[Parameter].second);
     }
@@ -1940,10 +1994,9 @@ bool AsmParser::HandleMacroEntry(const MCAsmMacro *M, SMLoc NameLoc) {
   // Macro instantiation is lexical, unfortunately. We construct a new buffer
   // to hold the macro body with substitutions.
   SmallString<256> Buf;
-  StringRef Body = M->Body;
   raw_svector_ostream OS(Buf);
 
-  if (expandMacro(OS, Body, M->Parameters, A, getTok().getLoc()))
+  if (expandMacro(OS, M->Pieces, M->Parameters, A, getTok().getLoc()))
     return true;
 
   // We include the .endmacro in the buffer as our cue to exit the macro
@@ -3877,12 +3930,20 @@ bool AsmParser::ParseDirectiveRept(SMLoc DirectiveLoc) {
   // Macro instantiation is lexical, unfortunately. We construct a new buffer
   // to hold the macro body with substitutions.
   SmallString<256> Buf;
-  MCAsmMacroParameters Parameters;
-  MCAsmMacroArguments A;
   raw_svector_ostream OS(Buf);
-  while (Count--) {
-    if (expandMacro(OS, M->Body, Parameters, A, getTok().getLoc()))
+  if (Count) {
+    // Without arguments every repetition expands to the same text, so expand
+    // the body once and copy it.
+    SmallString<256> Once;
+    raw_svector_ostream OnceOS(Once);
+    MCAsmMacroParameters Parameters;
+    MCAsmMacroArguments A;
+    if (expandMacro(OnceOS, M->Pieces, Parameters, A, getTok().getLoc()))
       return true;
+    StringRef Expansion = OnceOS.str();
+    OS.reserveExtraSpace(Expansion.size() * Count);
+    while (Count--)
+      OS << Expansion;
   }
   InstantiateMacroLikeBody(M, DirectiveLoc, OS);
 
@@ -3922,11 +3983,14 @@ bool AsmParser::ParseDirectiveIrp(SMLoc DirectiveLoc) {
   SmallString<256> Buf;
   raw_svector_ostream OS(Buf);
 
+  MCAsmMacroBodyPieces Pieces;
+  splitMacroBody(M->Body, Parameters, Pieces);
+
   for (MCAsmMacroArguments::iterator i = A.begin(), e = A.end(); i != e; ++i) {
     MCAsmMacroArguments Args;
     Args.push_back(*i);
 
-    if (expandMacro(OS, M->Body, Parameters, Args, getTok().getLoc()))
+    if (expandMacro(OS, Pieces, Parameters, Args, getTok().getLoc()))
       return true;
   }
 
@@ -3971,6 +4035,9 @@ bool AsmParser::ParseDirectiveIrpc(SMLoc DirectiveLoc) {
   SmallString<256> Buf;
   raw_svector_ostream OS(Buf);
 
+  MCAsmMacroBodyPieces Pieces;
+  splitMacroBody(M->Body, Parameters, Pieces);
+
   StringRef Values = A.front().front().getString();
   std::size_t I, End = Values.size();
   for (I = 0; I < End; ++I) {
@@ -3980,7 +4047,7 @@ bool AsmParser::ParseDirectiveIrpc(SMLoc DirectiveLoc) {
     MCAsmMacroArguments Args;
     Args.push_back(Arg);
 
-    if (expandMacro(OS, M->Body, Parameters, Args, getTok().getLoc()))
+    if (expandMacro(OS, Pieces, Parameters, Args, getTok().getLoc()))
       return true;
   }
 
@@ -781,6 +781,22 @@ void MachObjectWriter::WriteObject(MCAssembler &Asm,
   unsigned SectionDataPadding = OffsetToAlignment(SectionDataFileSize, 4);
   SectionDataFileSize += SectionDataPadding;
 
+  // The layout is known now, so let the stream make room for all of it.
+  uint64_t NumRelocations = 0;
+  for (DenseMap<const MCSectionData*,
+                std::vector<macho::RelocationEntry> >::const_iterator
+         it = Relocations.begin(), ie = Relocations.end(); it != ie; ++it)
+    NumRelocations += it->second.size();
+  uint64_t ObjectSize = SectionDataStart + SectionDataFileSize +
+                        NumRelocations * macho::RelocationInfoSize +
+                        NumDataRegions * 8;
+  if (NumSymbols)
+    ObjectSize += Asm.indirect_symbol_size() * 4 +
+                  NumSymbols * (is64Bit() ? macho::Nlist64Size :
+                                            macho::Nlist32Size) +
+                  StringTable.size();
+  OS.reserveExtraSpace(ObjectSize);
+
   // Write the prolog, starting with the header and load command...
   WriteHeader(NumLoadCommands, LoadCommandsSize,
               Asm.getSubsectionsViaSymbols());
@@ -851,9 +867,7 @@ void MachObjectWriter::WriteObject(MCAssembler &Asm,
          ie = Asm.end(); it != ie; ++it) {
     Asm.writeSectionData(it, Layout);
 
-    uint64_t Pad = getPaddingSize(it, Layout);
-    for (unsigned int i = 0; i < Pad; ++i)
-      Write8(0);
+    WriteZeros(getPaddingSize(it, Layout));
   }
 
   // Write the extra padding.
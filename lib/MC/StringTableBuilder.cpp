@@ -0,0 +1,66 @@
+//===-- StringTableBuilder.cpp - String table building utility ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/MC/StringTableBuilder.h"
+#include "llvm/ADT/STLExtras.h"
+#include <vector>
+
+using namespace llvm;
+
+/// compareBySuffix - Order strings by their reversed contents, largest first.
+/// This puts every string right after the strings it is a suffix of.
+static int compareBySuffix(const void *A, const void *B) {
+  StringRef NameA = *static_cast<const StringRef *>(A);
+  StringRef NameB = *static_cast<const StringRef *>(B);
+  size_t SizeA = NameA.size();
+  size_t SizeB = NameB.size();
+  size_t Len = std::min(SizeA, SizeB);
+  for (size_t I = 0; I < Len; ++I) {
+    char CA = NameA[SizeA - I - 1];
+    char CB = NameB[SizeB - I - 1];
+    if (CA != CB)
+      return CB - CA;
+  }
+  if (SizeA == SizeB)
+    return 0;
+  return SizeA < SizeB ? 1 : -1;
+}
+
+void StringTableBuilder::finalize() {
+  std::vector<StringRef> Strings;
+  Strings.reserve(StringIndexMap.size());
+  for (StringMap<size_t>::iterator I = StringIndexMap.begin(),
+         E = StringIndexMap.end(); I != E; ++I)
+    Strings.push_back(I->getKey());
+
+  array_pod_sort(Strings.begin(), Strings.end(), compareBySuffix);
+
+  // The first entry of a string table holds a null character.
+  StringTable += '\x00';
+
+  StringRef Previous;
+  for (std::vector<StringRef>::iterator I = Strings.begin(), E = Strings.end();
+       I != E; ++I) {
+    StringRef S = *I;
+    if (Previous.endswith(S)) {
+      StringIndexMap[S] = StringTable.size() - 1 - S.size();
+      continue;
+    }
+
+    StringIndexMap[S] = StringTable.size();
+    StringTable += S;
+    StringTable += '\x00';
+    Previous = S;
+  }
+}
+
+void StringTableBuilder::clear() {
+  StringTable.clear();
+  StringIndexMap.clear();
+}
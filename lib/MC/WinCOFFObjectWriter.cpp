@@ -820,6 +820,11 @@ void WinCOFFObjectWriter::WriteObject(MCAssembler &Asm,
 
   Header.TimeDateStamp = sys::TimeValue::now().toEpochTime();
 
+  // The layout is known now, so let the stream make room for all of it.
+  OS.reserveExtraSpace(uint64_t(Header.PointerToSymbolTable) +
+                       Header.NumberOfSymbols * COFF::SymbolSize +
+                       Strings.Data.size());
+
   // Write it all to disk...
   WriteFileHeader(Header);
 
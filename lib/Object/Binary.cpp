@@ -97,7 +97,8 @@ error_code object::createBinary(MemoryBuffer *Source,
 
 error_code object::createBinary(StringRef Path, OwningPtr<Binary> &Result) {
   OwningPtr<MemoryBuffer> File;
-  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Path, File))
+  if (error_code ec = MemoryBuffer::getFileOrSTDIN(Path, File, -1,
+                                                   MemoryBuffer::MH_WillNeed))
     return ec;
   return createBinary(File.take(), Result);
 }
@@ -65,8 +65,11 @@ ObjectFile *ObjectFile::createObjectFile(MemoryBuffer *Object) {
 }
 
 ObjectFile *ObjectFile::createObjectFile(StringRef ObjectPath) {
+  // Object files are read all over: headers, symbol and string tables,
+  // sections and relocations.  Get the whole file coming in.
   OwningPtr<MemoryBuffer> File;
-  if (MemoryBuffer::getFile(ObjectPath, File))
+  if (MemoryBuffer::getFile(ObjectPath, File, -1, true,
+                            MemoryBuffer::MH_WillNeed))
     return NULL;
   return createObjectFile(File.take());
 }
@@ -56,6 +56,23 @@ sys::cas_flag sys::CompareAndSwap(volatile sys::cas_flag* ptr,
 #endif
 }
 
+void *sys::CompareAndSwap(void *volatile *ptr,
+                          void *new_value,
+                          void *old_value) {
+#if LLVM_HAS_ATOMICS == 0
+  void *result = *ptr;
+  if (result == old_value)
+    *ptr = new_value;
+  return result;
+#elif defined(GNU_ATOMICS)
+  return __sync_val_compare_and_swap(ptr, old_value, new_value);
+#elif defined(_MSC_VER)
+  return InterlockedCompareExchangePointer(ptr, new_value, old_value);
+#else
+#  error No compare-and-swap implementation for your platform!
+#endif
+}
+
 sys::cas_flag sys::AtomicIncrement(volatile sys::cas_flag* ptr) {
 #if LLVM_HAS_ATOMICS == 0
   ++(*ptr);
@@ -18,6 +18,11 @@
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
 #if LLVM_ENABLE_ZLIB == 1 && HAVE_ZLIB_H
 #include <zlib.h>
 #endif
@@ -65,6 +70,136 @@ zlib::Status zlib::compress(StringRef InputBuffer,
   return Res;
 }
 
+namespace {
+/// DeflateBlocks - The blocks that compressInParallel compresses, and their
+/// results.
+struct DeflateBlocks {
+  StringRef Input;
+  size_t BlockSize;
+  int Level;
+  std::vector<std::string> Output;
+  std::vector<uLong> Checksums;
+  std::vector<int> Results;
+};
+}
+
+/// deflateBlock - Compress one block of a DeflateBlocks into raw deflate
+/// data, ending on a byte boundary so that the blocks can be concatenated.
+static void deflateBlock(void *UserData, unsigned Index) {
+  DeflateBlocks &D = *static_cast<DeflateBlocks *>(UserData);
+  size_t Begin = size_t(Index) * D.BlockSize;
+  StringRef Block = D.Input.substr(Begin, D.BlockSize);
+  bool Last = Begin + Block.size() == D.Input.size();
+  D.Checksums[Index] = ::adler32(::adler32(0, Z_NULL, 0),
+                                 (const Bytef *)Block.data(), Block.size());
+
+  z_stream Strm;
+  memset(&Strm, 0, sizeof(Strm));
+  // The zlib header and checksum are written once for the whole stream.
+  int Res = ::deflateInit2(&Strm, D.Level, Z_DEFLATED, -MAX_WBITS, 8,
+                           Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK) {
+    D.Results[Index] = Res;
+    return;
+  }
+  // Let the block refer back into the previous one, as it would if the
+  // input were compressed in one go.
+  if (Begin) {
+    size_t DictSize = std::min<size_t>(Begin, 1 << MAX_WBITS);
+    ::deflateSetDictionary(&Strm,
+                           (const Bytef *)D.Input.data() + Begin - DictSize,
+                           DictSize);
+  }
+
+  // Every block but the last ends with a sync flush, which leaves the
+  // deflate stream open and byte aligned.
+  int Flush = Last ? Z_FINISH : Z_SYNC_FLUSH;
+  std::string &Out = D.Output[Index];
+  size_t Used = 0;
+  size_t Room = ::deflateBound(&Strm, Block.size()) + 16;
+  Strm.next_in = (Bytef *)Block.data();
+  Strm.avail_in = Block.size();
+  while (1) {
+    Out.resize(Used + Room);
+    Strm.next_out = (Bytef *)&Out[Used];
+    Strm.avail_out = Room;
+    Res = ::deflate(&Strm, Flush);
+    Used = Out.size() - Strm.avail_out;
+    if (Res == Z_STREAM_END || (!Last && Res == Z_OK && Strm.avail_out)) {
+      Res = Z_OK;
+      break;
+    }
+    if (Res != Z_OK && Res != Z_BUF_ERROR)
+      break;
+    // Out of room; carry on with a bigger buffer.
+    Room = Out.size();
+  }
+  Out.resize(Used);
+  ::deflateEnd(&Strm);
+  D.Results[Index] = Res;
+}
+
+zlib::Status zlib::compressInParallel(StringRef InputBuffer,
+                                      OwningPtr<MemoryBuffer> &CompressedBuffer,
+                                      CompressionLevel Level, size_t BlockSize,
+                                      unsigned NumThreads) {
+  if (BlockSize == 0 || InputBuffer.size() <= BlockSize)
+    return compress(InputBuffer, CompressedBuffer, Level);
+  size_t NumBlocks = (InputBuffer.size() + BlockSize - 1) / BlockSize;
+  if (NumBlocks != unsigned(NumBlocks))
+    return StatusInvalidArg;
+  if (NumThreads == 0)
+    NumThreads = llvm_get_hardware_concurrency();
+
+  DeflateBlocks D;
+  D.Input = InputBuffer;
+  D.BlockSize = BlockSize;
+  D.Level = encodeZlibCompressionLevel(Level);
+  D.Output.resize(NumBlocks);
+  D.Checksums.resize(NumBlocks);
+  D.Results.resize(NumBlocks);
+  llvm_execute_in_parallel(deflateBlock, &D, NumBlocks, NumThreads);
+  for (size_t i = 0; i != NumBlocks; ++i)
+    if (D.Results[i] != Z_OK)
+      return encodeZlibReturnValue(D.Results[i]);
+
+  // The zlib header: deflate with a 32KB window, and the same hint about the
+  // compression level that zlib would give.
+  unsigned LevelHint;
+  if (D.Level == Z_DEFAULT_COMPRESSION || D.Level == 6)
+    LevelHint = 2;
+  else if (D.Level < 2)
+    LevelHint = 0;
+  else if (D.Level < 6)
+    LevelHint = 1;
+  else
+    LevelHint = 3;
+  unsigned Header = (0x78 << 8) | (LevelHint << 6);
+  if (Header % 31)
+    Header += 31 - Header % 31;
+
+  uLong Checksum = D.Checksums[0];
+  for (size_t i = 1; i != NumBlocks; ++i) {
+    size_t Len = std::min(BlockSize, InputBuffer.size() - i * BlockSize);
+    Checksum = ::adler32_combine(Checksum, D.Checksums[i], Len);
+  }
+
+  std::string Result;
+  Result += char(Header >> 8);
+  Result += char(Header);
+  for (size_t i = 0; i != NumBlocks; ++i) {
+    Result += D.Output[i];
+    std::string().swap(D.Output[i]);
+  }
+  for (int Shift = 24; Shift >= 0; Shift -= 8)
+    Result += char(Checksum >> Shift);
+
+  CompressedBuffer.reset(MemoryBuffer::getMemBufferCopy(Result));
+  // Tell MSan that memory initialized by zlib is valid.
+  __msan_unpoison(CompressedBuffer->getBufferStart(), Result.size());
+  return StatusOK;
+}
+
 zlib::Status zlib::uncompress(StringRef InputBuffer,
                               OwningPtr<MemoryBuffer> &UncompressedBuffer,
                               size_t UncompressedSize) {
@@ -88,6 +223,12 @@ zlib::Status zlib::compress(StringRef InputBuffer,
                             CompressionLevel Level) {
   return zlib::StatusUnsupported;
 }
+zlib::Status zlib::compressInParallel(StringRef InputBuffer,
+                                      OwningPtr<MemoryBuffer> &CompressedBuffer,
+                                      CompressionLevel Level, size_t BlockSize,
+                                      unsigned NumThreads) {
+  return zlib::StatusUnsupported;
+}
 zlib::Status zlib::uncompress(StringRef InputBuffer,
                               OwningPtr<MemoryBuffer> &UncompressedBuffer,
                               size_t UncompressedSize) {
@@ -0,0 +1,127 @@
+//===- ConcurrentAllocator.cpp - Allocators shared by threads -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements RecyclingSlabAllocator and ThreadLocalArena.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ConcurrentAllocator.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MutexGuard.h"
+
+using namespace llvm;
+
+//===----------------------------------------------------------------------===//
+// RecyclingSlabAllocator implementation
+//===----------------------------------------------------------------------===//
+
+RecyclingSlabAllocator::RecyclingSlabAllocator(size_t SlabSize,
+                                               size_t MaxFreeBytes)
+    : SlabSize(SlabSize), MaxFreeBytes(MaxFreeBytes), FreeBytes(0) {
+  for (unsigned i = 0; i != NumSizeClasses; ++i)
+    FreeLists[i] = 0;
+}
+
+RecyclingSlabAllocator::~RecyclingSlabAllocator() {
+  ReleaseFreeSlabs();
+}
+
+int RecyclingSlabAllocator::getSizeClass(size_t Size) const {
+  for (unsigned i = 0; i != NumSizeClasses; ++i)
+    if (Size == SlabSize << i)
+      return i;
+  return -1;
+}
+
+MemSlab *RecyclingSlabAllocator::Allocate(size_t Size) {
+  int Class = getSizeClass(Size);
+  if (Class >= 0) {
+    MutexGuard Guard(Lock);
+    if (MemSlab *Slab = FreeLists[Class]) {
+      FreeLists[Class] = Slab->NextPtr;
+      FreeBytes -= Size;
+      Slab->NextPtr = 0;
+      return Slab;
+    }
+  }
+  return Malloc.Allocate(Size);
+}
+
+void RecyclingSlabAllocator::Deallocate(MemSlab *Slab) {
+  int Class = getSizeClass(Slab->Size);
+  if (Class >= 0) {
+    MutexGuard Guard(Lock);
+    if (FreeBytes + Slab->Size <= MaxFreeBytes) {
+      Slab->NextPtr = FreeLists[Class];
+      FreeLists[Class] = Slab;
+      FreeBytes += Slab->Size;
+      return;
+    }
+  }
+  Malloc.Deallocate(Slab);
+}
+
+size_t RecyclingSlabAllocator::getFreeBytes() {
+  MutexGuard Guard(Lock);
+  return FreeBytes;
+}
+
+void RecyclingSlabAllocator::ReleaseFreeSlabs() {
+  MutexGuard Guard(Lock);
+  for (unsigned i = 0; i != NumSizeClasses; ++i) {
+    while (MemSlab *Slab = FreeLists[i]) {
+      FreeLists[i] = Slab->NextPtr;
+      Malloc.Deallocate(Slab);
+    }
+  }
+  FreeBytes = 0;
+}
+
+static ManagedStatic<RecyclingSlabAllocator> GlobalPool;
+
+RecyclingSlabAllocator &RecyclingSlabAllocator::getGlobalPool() {
+  return *GlobalPool;
+}
+
+//===----------------------------------------------------------------------===//
+// ThreadLocalArena implementation
+//===----------------------------------------------------------------------===//
+
+ThreadLocalArena::ThreadLocalArena(RecyclingSlabAllocator &Pool)
+    : SlabPool(Pool) {}
+
+ThreadLocalArena::~ThreadLocalArena() {
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    delete Allocators[i];
+}
+
+BumpPtrAllocator &ThreadLocalArena::createThreadAllocator() {
+  size_t SlabSize = SlabPool.getSlabSize();
+  BumpPtrAllocator *A = new BumpPtrAllocator(SlabSize, SlabSize, SlabPool);
+  {
+    MutexGuard Guard(Lock);
+    Allocators.push_back(A);
+  }
+  Current.set(A);
+  return *A;
+}
+
+void ThreadLocalArena::Reset() {
+  MutexGuard Guard(Lock);
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    Allocators[i]->Reset();
+}
+
+size_t ThreadLocalArena::getTotalMemory() {
+  MutexGuard Guard(Lock);
+  size_t TotalMemory = 0;
+  for (unsigned i = 0, e = Allocators.size(); i != e; ++i)
+    TotalMemory += Allocators[i]->getTotalMemory();
+  return TotalMemory;
+}
@@ -22,6 +22,7 @@
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
 #include <cassert>
 #include <cerrno>
 #include <cstdio>
@@ -51,6 +52,8 @@ using namespace llvm;
 
 MemoryBuffer::~MemoryBuffer() { }
 
+void MemoryBuffer::prefetch(size_t Offset, size_t Length) const { }
+
 /// init - Initialize this MemoryBuffer as a reference to externally allocated
 /// memory, memory that we know is already null terminated.
 void MemoryBuffer::init(const char *BufStart, const char *BufEnd,
@@ -168,18 +171,20 @@ MemoryBuffer *MemoryBuffer::getNewMemBuffer(size_t Size, StringRef BufferName) {
 /// returns an empty buffer.
 error_code MemoryBuffer::getFileOrSTDIN(StringRef Filename,
                                         OwningPtr<MemoryBuffer> &result,
-                                        int64_t FileSize) {
+                                        int64_t FileSize,
+                                        unsigned MapHints) {
   if (Filename == "-")
     return getSTDIN(result);
-  return getFile(Filename, result, FileSize);
+  return getFile(Filename, result, FileSize, true, MapHints);
 }
 
 error_code MemoryBuffer::getFileOrSTDIN(const char *Filename,
                                         OwningPtr<MemoryBuffer> &result,
-                                        int64_t FileSize) {
+                                        int64_t FileSize,
+                                        unsigned MapHints) {
   if (strcmp(Filename, "-") == 0)
     return getSTDIN(result);
-  return getFile(Filename, result, FileSize);
+  return getFile(Filename, result, FileSize, true, MapHints);
 }
 
 //===----------------------------------------------------------------------===//
@@ -205,17 +210,48 @@ class MemoryBufferMMapFile : public MemoryBuffer {
     return MFR.const_data() + (Offset - getLegalMapOffset(Offset));
   }
 
+  /// getMapOffset - Return the offset into the mapping of Offset into the
+  /// buffer.
+  uint64_t getMapOffset(size_t Offset) const {
+    return (getBufferStart() - MFR.const_data()) + Offset;
+  }
+
+  void applyHints(unsigned MapHints) {
+    typedef sys::fs::mapped_file_region Region;
+    // The hints are only advice; there is nothing to do if one fails.
+    if (MapHints & MH_Sequential)
+      MFR.advise(Region::sequential, getMapOffset(0), getBufferSize());
+    if (MapHints & MH_Random)
+      MFR.advise(Region::random, getMapOffset(0), getBufferSize());
+    if (MapHints & MH_HugePages)
+      MFR.advise(Region::hugepage, getMapOffset(0), getBufferSize());
+    if ((MapHints & MH_WillNeed) && !(MapHints & MH_Populate))
+      MFR.advise(Region::willneed, getMapOffset(0), getBufferSize());
+  }
+
 public:
   MemoryBufferMMapFile(bool RequiresNullTerminator, int FD, uint64_t Len,
-                       uint64_t Offset, error_code EC)
+                       uint64_t Offset, unsigned MapHints, error_code &EC)
       : MFR(FD, false, sys::fs::mapped_file_region::readonly,
-            getLegalMapSize(Len, Offset), getLegalMapOffset(Offset), EC) {
+            getLegalMapSize(Len, Offset), getLegalMapOffset(Offset),
+            (MapHints & MH_Populate) != 0, EC) {
     if (!EC) {
       const char *Start = getStart(Len, Offset);
       init(Start, Start + Len, RequiresNullTerminator);
+      if (MapHints && Len)
+        applyHints(MapHints);
     }
   }
 
+  virtual void prefetch(size_t Offset, size_t Length) const LLVM_OVERRIDE {
+    if (Offset >= getBufferSize())
+      return;
+    Length = std::min(Length, getBufferSize() - Offset);
+    if (Length)
+      MFR.advise(sys::fs::mapped_file_region::willneed, getMapOffset(Offset),
+                 Length);
+  }
+
   virtual const char *getBufferIdentifier() const LLVM_OVERRIDE {
     // The name is stored after the class itself.
     return reinterpret_cast<const char *>(this + 1);
@@ -251,17 +287,19 @@ static error_code getMemoryBufferForStream(int FD,
 error_code MemoryBuffer::getFile(StringRef Filename,
                                  OwningPtr<MemoryBuffer> &result,
                                  int64_t FileSize,
-                                 bool RequiresNullTerminator) {
+                                 bool RequiresNullTerminator,
+                                 unsigned MapHints) {
   // Ensure the path is null terminated.
   SmallString<256> PathBuf(Filename.begin(), Filename.end());
   return MemoryBuffer::getFile(PathBuf.c_str(), result, FileSize,
-                               RequiresNullTerminator);
+                               RequiresNullTerminator, MapHints);
 }
 
 error_code MemoryBuffer::getFile(const char *Filename,
                                  OwningPtr<MemoryBuffer> &result,
                                  int64_t FileSize,
-                                 bool RequiresNullTerminator) {
+                                 bool RequiresNullTerminator,
+                                 unsigned MapHints) {
   // FIXME: Review if this check is unnecessary on windows as well.
 #ifdef LLVM_ON_WIN32
   // First check that the "file" is not a directory
@@ -282,7 +320,7 @@ error_code MemoryBuffer::getFile(const char *Filename,
     return error_code(errno, posix_category());
 
   error_code ret = getOpenFile(FD, Filename, result, FileSize, FileSize,
-                               0, RequiresNullTerminator);
+                               0, RequiresNullTerminator, MapHints);
   close(FD);
   return ret;
 }
@@ -334,7 +372,8 @@ error_code MemoryBuffer::getOpenFile(int FD, const char *Filename,
                                      OwningPtr<MemoryBuffer> &result,
                                      uint64_t FileSize, uint64_t MapSize,
                                      int64_t Offset,
-                                     bool RequiresNullTerminator) {
+                                     bool RequiresNullTerminator,
+                                     unsigned MapHints) {
   static int PageSize = sys::process::get_self()->page_size();
 
   // Default is to map the full file.
@@ -364,7 +403,7 @@ error_code MemoryBuffer::getOpenFile(int FD, const char *Filename,
                     PageSize)) {
     error_code EC;
     result.reset(new (NamedBufferAlloc(Filename)) MemoryBufferMMapFile(
-        RequiresNullTerminator, FD, MapSize, Offset, EC));
+        RequiresNullTerminator, FD, MapSize, Offset, MapHints, EC));
     if (!EC)
       return error_code::success();
   }
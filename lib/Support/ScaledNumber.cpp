@@ -0,0 +1,223 @@
+//===- lib/Support/ScaledNumber.cpp - Scaled integer arithmetic -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements ScaledNumber arithmetic.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ScaledNumber.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace llvm;
+
+ScaledNumber ScaledNumber::get(uint64_t Digits, int32_t Scale) {
+  if (!Digits)
+    return ScaledNumber();
+
+  if (Scale > MaxScale) {
+    // Use the leading zeros of the mantissa before saturating.
+    uint32_t Shift = Scale - MaxScale;
+    if (Shift > CountLeadingZeros_64(Digits))
+      return getLargest();
+    return ScaledNumber(Digits << Shift, MaxScale);
+  }
+
+  if (Scale < MinScale) {
+    uint32_t Shift = MinScale - Scale;
+    if (Shift >= 64)
+      return ScaledNumber();
+    return get(Digits >> Shift, MinScale);
+  }
+
+  return ScaledNumber(Digits, Scale);
+}
+
+ScaledNumber ScaledNumber::getFraction(uint64_t N, uint64_t D) {
+  assert(D && "Division by zero!");
+  return ScaledNumber(N) / ScaledNumber(D);
+}
+
+uint64_t ScaledNumber::toInt() const {
+  if (!Digits)
+    return 0;
+  if (Scale >= 0) {
+    if (Scale >= 64 || Digits > (UINT64_MAX >> Scale))
+      return UINT64_MAX;
+    return Digits << Scale;
+  }
+  if (-Scale >= 64)
+    return 0;
+  return Digits >> -Scale;
+}
+
+int ScaledNumber::compare(const ScaledNumber &X) const {
+  if (isZero())
+    return X.isZero() ? 0 : -1;
+  if (X.isZero())
+    return 1;
+
+  // Compare the positions of the most significant bits first.
+  int32_t LMSB = Scale + 63 - int32_t(CountLeadingZeros_64(Digits));
+  int32_t RMSB = X.Scale + 63 - int32_t(CountLeadingZeros_64(X.Digits));
+  if (LMSB != RMSB)
+    return LMSB < RMSB ? -1 : 1;
+
+  // Same magnitude, so the mantissa with the larger scale has room to be
+  // shifted onto the other one's scale.
+  uint64_t L = Digits, R = X.Digits;
+  if (Scale > X.Scale)
+    L <<= Scale - X.Scale;
+  else
+    R <<= X.Scale - Scale;
+  return L < R ? -1 : L > R;
+}
+
+ScaledNumber &ScaledNumber::operator+=(const ScaledNumber &X) {
+  if (X.isZero())
+    return *this;
+  if (isZero())
+    return *this = X;
+
+  // Normalize both operands so that no precision is lost on the larger one.
+  uint64_t LD = Digits, RD = X.Digits;
+  int32_t LS = Scale, RS = X.Scale;
+  unsigned LZ = CountLeadingZeros_64(LD), RZ = CountLeadingZeros_64(RD);
+  LD <<= LZ; LS -= LZ;
+  RD <<= RZ; RS -= RZ;
+  if (LS < RS) {
+    std::swap(LD, RD);
+    std::swap(LS, RS);
+  }
+
+  uint32_t Shift = LS - RS;
+  if (Shift >= 64)
+    return *this = get(LD, LS);
+
+  RD >>= Shift;
+  uint64_t Sum = LD + RD;
+  if (Sum < LD) {
+    // Carry out of the top bit.
+    Sum = (Sum >> 1) | (UINT64_C(1) << 63);
+    ++LS;
+  }
+  return *this = get(Sum, LS);
+}
+
+ScaledNumber &ScaledNumber::operator-=(const ScaledNumber &X) {
+  if (X.isZero())
+    return *this;
+  if (compare(X) <= 0)
+    return *this = ScaledNumber();
+
+  uint64_t LD = Digits, RD = X.Digits;
+  int32_t LS = Scale, RS = X.Scale;
+  unsigned LZ = CountLeadingZeros_64(LD), RZ = CountLeadingZeros_64(RD);
+  LD <<= LZ; LS -= LZ;
+  RD <<= RZ; RS -= RZ;
+
+  // The larger value has the larger normalized scale.
+  uint32_t Shift = LS - RS;
+  if (Shift >= 64)
+    return *this;
+  return *this = get(LD - (RD >> Shift), LS);
+}
+
+ScaledNumber &ScaledNumber::operator*=(const ScaledNumber &X) {
+  if (isZero() || X.isZero())
+    return *this = ScaledNumber();
+
+  // Compute the full 128-bit product Upper:Lower.
+  const uint64_t Mask = UINT32_MAX;
+  uint64_t L = Digits, R = X.Digits;
+  uint64_t P0 = (L & Mask) * (R & Mask);
+  uint64_t P1 = (L & Mask) * (R >> 32);
+  uint64_t P2 = (L >> 32) * (R & Mask);
+  uint64_t P3 = (L >> 32) * (R >> 32);
+  uint64_t Mid = (P0 >> 32) + (P1 & Mask) + (P2 & Mask);
+  uint64_t Upper = P3 + (P1 >> 32) + (P2 >> 32) + (Mid >> 32);
+  uint64_t Lower = (Mid << 32) | (P0 & Mask);
+
+  int32_t S = int32_t(Scale) + X.Scale;
+  if (!Upper)
+    return *this = get(Lower, S);
+
+  // Keep the top 64 bits, rounding to nearest.
+  unsigned Shift = 64 - CountLeadingZeros_64(Upper);
+  uint64_t D = Shift == 64 ? Upper : (Upper << (64 - Shift)) | (Lower >> Shift);
+  if ((Lower >> (Shift - 1)) & 1)
+    if (++D == 0) {
+      D = UINT64_C(1) << 63;
+      ++Shift;
+    }
+  return *this = get(D, S + Shift);
+}
+
+ScaledNumber &ScaledNumber::operator/=(const ScaledNumber &X) {
+  if (isZero())
+    return *this;
+  if (X.isZero())
+    return *this = getLargest();
+
+  uint64_t Dividend = Digits, Divisor = X.Digits;
+  int32_t S = int32_t(Scale) - X.Scale;
+
+  // Make the divisor as small and the dividend as large as possible.
+  unsigned TZ = CountTrailingZeros_64(Divisor);
+  Divisor >>= TZ;
+  S -= TZ;
+  if (Divisor == 1)
+    return *this = get(Dividend, S);
+  unsigned LZ = CountLeadingZeros_64(Dividend);
+  Dividend <<= LZ;
+  S -= LZ;
+
+  // Long division until the quotient has 64 significant bits.
+  uint64_t Quotient = Dividend / Divisor;
+  Dividend %= Divisor;
+  while (!(Quotient >> 63) && Dividend) {
+    bool Overflow = Dividend >> 63;
+    Dividend <<= 1;
+    Quotient <<= 1;
+    --S;
+    if (Overflow || Divisor <= Dividend) {
+      Quotient |= 1;
+      Dividend -= Divisor;
+    }
+  }
+
+  // Round to nearest.
+  if (Dividend && Dividend >= Divisor - Divisor / 2)
+    if (++Quotient == 0) {
+      Quotient = UINT64_C(1) << 63;
+      ++S;
+    }
+  return *this = get(Quotient, S);
+}
+
+void ScaledNumber::print(raw_ostream &OS) const {
+  OS << std::ldexp(double(Digits), Scale);
+}
+
+void ScaledNumber::dump() const {
+  print(dbgs());
+  dbgs() << "\n";
+}
+
+namespace llvm {
+
+raw_ostream &operator<<(raw_ostream &OS, const ScaledNumber &X) {
+  X.print(OS);
+  return OS;
+}
+
+}
@@ -28,9 +28,11 @@
 #include "llvm/Support/Format.h"
 #include "llvm/Support/ManagedStatic.h"
 #include "llvm/Support/Mutex.h"
+#include "llvm/Support/ThreadLocal.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstring>
+#include <map>
 using namespace llvm;
 
 // CreateInfoOutputFile - Return a file stream to print our output on.
@@ -44,26 +46,55 @@ Enabled(
     "stats",
     cl::desc("Enable statistics output from program (available with Asserts)"));
 
+/// -stats-json - Print the statistics as JSON rather than as a text table.
+///
+static cl::opt<bool>
+StatsAsJSON("stats-json", cl::desc("Display statistics as json data"));
+
+bool Statistic::ScopesEnabled = false;
+
+/// -stats-per-function - Also attribute statistics to the StatisticScope that
+/// was active when they were updated; the pass managers open one per function.
+///
+static cl::opt<bool, true>
+PerFunction("stats-per-function",
+            cl::desc("Also report statistics for each function (use with "
+                     "-stats)"),
+            cl::location(Statistic::ScopesEnabled));
 
 namespace {
 /// StatisticInfo - This class is used in a ManagedStatic so that it is created
 /// on demand (when the first statistic is bumped) and destroyed only when
 /// llvm_shutdown is called.  We print statistics from the destructor.
 class StatisticInfo {
-  std::vector<const Statistic*> Stats;
+  std::vector<Statistic*> Stats;
+
+  /// ScopedStats - For each scope name, the amount each statistic changed
+  /// while that scope was the innermost active one.
+  typedef std::map<const Statistic*, int64_t> ScopeValues;
+  std::map<std::string, ScopeValues> ScopedStats;
+
   friend void llvm::PrintStatistics();
   friend void llvm::PrintStatistics(raw_ostream &OS);
+  friend void llvm::PrintStatisticsJSON(raw_ostream &OS);
 public:
   ~StatisticInfo();
 
-  void addStatistic(const Statistic *S) {
+  void addStatistic(Statistic *S) {
     Stats.push_back(S);
   }
+
+  void addToScope(StringRef Scope, const Statistic *S, int64_t Delta) {
+    ScopedStats[Scope][S] += Delta;
+  }
+
+  void reset();
 };
 }
 
 static ManagedStatic<StatisticInfo> StatInfo;
 static ManagedStatic<sys::SmartMutex<true> > StatLock;
+static ManagedStatic<sys::ThreadLocal<const StatisticScope> > CurrentScope;
 
 /// RegisterStatistic - The first time a statistic is bumped, this method is
 /// called.
@@ -84,6 +115,40 @@ void Statistic::RegisterStatistic() {
   }
 }
 
+/// addToCurrentScope - Record a change of Delta against the innermost active
+/// StatisticScope of this thread, if there is one.
+void Statistic::addToCurrentScope(int64_t Delta) {
+  const StatisticScope *Scope = CurrentScope->get();
+  if (!Scope || !Enabled)
+    return;
+
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  StatInfo->addToScope(Scope->getName(), this, Delta);
+}
+
+StatisticScope::StatisticScope(StringRef ScopeName)
+  : Parent(0), Active(Statistic::ScopesEnabled) {
+  if (!Active)
+    return;
+  Name = ScopeName;
+  Parent = CurrentScope->get();
+  CurrentScope->set(this);
+}
+
+StatisticScope::~StatisticScope() {
+  if (Active)
+    CurrentScope->set(Parent);
+}
+
+void StatisticInfo::reset() {
+  for (size_t i = 0, e = Stats.size(); i != e; ++i) {
+    Stats[i]->Value = 0;
+    Stats[i]->Initialized = false;
+  }
+  Stats.clear();
+  ScopedStats.clear();
+}
+
 namespace {
 
 struct NameCompare {
@@ -94,10 +159,66 @@ struct NameCompare {
     // Secondary key is the description.
     return std::strcmp(LHS->getDesc(), RHS->getDesc()) < 0;
   }
+
+  bool operator()(const std::pair<const Statistic*, int64_t> &LHS,
+                  const std::pair<const Statistic*, int64_t> &RHS) const {
+    return (*this)(LHS.first, RHS.first);
+  }
 };
 
 }
 
+/// getSortedScopeValues - Return the values recorded for one scope, sorted
+/// like the totals.
+static std::vector<std::pair<const Statistic*, int64_t> >
+getSortedScopeValues(const std::map<const Statistic*, int64_t> &Values) {
+  std::vector<std::pair<const Statistic*, int64_t> >
+    Sorted(Values.begin(), Values.end());
+  std::stable_sort(Sorted.begin(), Sorted.end(), NameCompare());
+  return Sorted;
+}
+
+/// printJSONString - Print Str as a quoted JSON string.
+static void printJSONString(raw_ostream &OS, StringRef Str) {
+  OS << '"';
+  for (StringRef::iterator I = Str.begin(), E = Str.end(); I != E; ++I) {
+    unsigned char C = *I;
+    if (C == '"' || C == '\\')
+      OS << '\\' << C;
+    else if (C < 0x20)
+      OS << format("\\u%04x", C);
+    else
+      OS << C;
+  }
+  OS << '"';
+}
+
+/// getJSONKey - Return the "<DEBUG_TYPE>.<variable name>" key of S.  Keys are
+/// not unique: several files may define a statistic with the same variable
+/// name under one DEBUG_TYPE.
+static std::string getJSONKey(const Statistic *S) {
+  return std::string(S->getName()) + "." + S->getVarName();
+}
+
+/// JSONValues - Statistic values by JSON key, with the values of statistics
+/// that share a key added up, in the order they are printed.
+typedef std::map<std::string, int64_t> JSONValues;
+
+/// printJSONValues - Print Values as the members of a JSON object, each on a
+/// line of its own with the given indentation.
+static void printJSONValues(raw_ostream &OS, const JSONValues &Values,
+                            unsigned Indent) {
+  const char *Delim = "\n";
+  for (JSONValues::const_iterator I = Values.begin(), E = Values.end();
+       I != E; ++I) {
+    OS << Delim;
+    OS.indent(Indent);
+    printJSONString(OS, I->first);
+    OS << ": " << I->second;
+    Delim = ",\n";
+  }
+}
+
 // Print information when destroyed, iff command line option is specified.
 StatisticInfo::~StatisticInfo() {
   llvm::PrintStatistics();
@@ -111,7 +232,14 @@ bool llvm::AreStatisticsEnabled() {
   return Enabled;
 }
 
+void llvm::EnableScopedStatistics() {
+  PerFunction.setValue(true);
+}
+
 void llvm::PrintStatistics(raw_ostream &OS) {
+  if (StatsAsJSON)
+    return PrintStatisticsJSON(OS);
+
   StatisticInfo &Stats = *StatInfo;
 
   // Figure out how long the biggest Value and Name fields are.
@@ -138,11 +266,61 @@ void llvm::PrintStatistics(raw_ostream &OS) {
                  MaxNameLen, Stats.Stats[i]->getName(),
                  Stats.Stats[i]->getDesc());
 
+  // Print the values attributed to each function, if any.
+  for (std::map<std::string, StatisticInfo::ScopeValues>::const_iterator
+         I = Stats.ScopedStats.begin(), E = Stats.ScopedStats.end();
+       I != E; ++I) {
+    OS << "\n" << I->first << ":\n";
+    std::vector<std::pair<const Statistic*, int64_t> > Values =
+      getSortedScopeValues(I->second);
+    for (size_t i = 0, e = Values.size(); i != e; ++i)
+      OS << format("%*lld %-*s - %s\n",
+                   MaxValLen, (long long)Values[i].second,
+                   MaxNameLen, Values[i].first->getName(),
+                   Values[i].first->getDesc());
+  }
+
   OS << '\n';  // Flush the output stream.
   OS.flush();
 
 }
 
+void llvm::PrintStatisticsJSON(raw_ostream &OS) {
+  StatisticInfo &Stats = *StatInfo;
+
+  JSONValues Totals;
+  for (size_t i = 0, e = Stats.Stats.size(); i != e; ++i)
+    Totals[getJSONKey(Stats.Stats[i])] += Stats.Stats[i]->getValue();
+
+  OS << "{\n  \"statistics\": {";
+  printJSONValues(OS, Totals, 4);
+  OS << "\n  },\n  \"functions\": {";
+
+  const char *Delim = "\n";
+  for (std::map<std::string, StatisticInfo::ScopeValues>::const_iterator
+         I = Stats.ScopedStats.begin(), E = Stats.ScopedStats.end();
+       I != E; ++I) {
+    OS << Delim << "    ";
+    printJSONString(OS, I->first);
+    OS << ": {";
+
+    JSONValues Values;
+    for (StatisticInfo::ScopeValues::const_iterator VI = I->second.begin(),
+           VE = I->second.end(); VI != VE; ++VI)
+      Values[getJSONKey(VI->first)] += VI->second;
+    printJSONValues(OS, Values, 6);
+    OS << "\n    }";
+    Delim = ",\n";
+  }
+  OS << "\n  }\n}\n";
+  OS.flush();
+}
+
+void llvm::ResetStatistics() {
+  sys::SmartScopedLock<true> Writer(*StatLock);
+  StatInfo->reset();
+}
+
 void llvm::PrintStatistics() {
 #if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
   StatisticInfo &Stats = *StatInfo;
@@ -40,13 +40,16 @@ void StringMapImpl::init(unsigned InitSize) {
   NumItems = 0;
   NumTombstones = 0;
   
-  TheTable = (StringMapEntryBase **)calloc(NumBuckets+1,
-                                           sizeof(StringMapEntryBase **) +
-                                           sizeof(unsigned));
+  TheTable = (StringMapBucket *)calloc(NumBuckets+1, sizeof(StringMapBucket));
 
   // Allocate one extra bucket, set it to look filled so the iterators stop at
   // end.
-  TheTable[NumBuckets] = (StringMapEntryBase*)2;
+  TheTable[NumBuckets].Item = (StringMapEntryBase*)2;
+}
+
+/// hash - Return the hash value StringMap uses for Key.
+unsigned StringMapImpl::hash(StringRef Key) {
+  return HashString(Key);
 }
 
 
@@ -54,38 +57,38 @@ void StringMapImpl::init(unsigned InitSize) {
 /// up in.  If it already exists as a key in the map, the Item pointer for the
 /// specified bucket will be non-null.  Otherwise, it will be null.  In either
 /// case, the FullHashValue field of the bucket will be set to the hash value
-/// of the string.
-unsigned StringMapImpl::LookupBucketFor(StringRef Name) {
+/// of the string.  FullHashValue must be hash(Name).
+unsigned StringMapImpl::LookupBucketFor(StringRef Name,
+                                        unsigned FullHashValue) {
   unsigned HTSize = NumBuckets;
   if (HTSize == 0) {  // Hash table unallocated so far?
     init(16);
     HTSize = NumBuckets;
   }
-  unsigned FullHashValue = HashString(Name);
   unsigned BucketNo = FullHashValue & (HTSize-1);
-  unsigned *HashTable = (unsigned *)(TheTable + NumBuckets + 1);
 
   unsigned ProbeAmt = 1;
   int FirstTombstone = -1;
   while (1) {
-    StringMapEntryBase *BucketItem = TheTable[BucketNo];
+    StringMapBucket &Bucket = TheTable[BucketNo];
+    StringMapEntryBase *BucketItem = Bucket.Item;
     // If we found an empty bucket, this key isn't in the table yet, return it.
     if (LLVM_LIKELY(BucketItem == 0)) {
       // If we found a tombstone, we want to reuse the tombstone instead of an
       // empty bucket.  This reduces probing.
       if (FirstTombstone != -1) {
-        HashTable[FirstTombstone] = FullHashValue;
+        TheTable[FirstTombstone].FullHashValue = FullHashValue;
         return FirstTombstone;
       }
       
-      HashTable[BucketNo] = FullHashValue;
+      Bucket.FullHashValue = FullHashValue;
       return BucketNo;
     }
     
     if (BucketItem == getTombstoneVal()) {
       // Skip over tombstones.  However, remember the first one we see.
       if (FirstTombstone == -1) FirstTombstone = BucketNo;
-    } else if (LLVM_LIKELY(HashTable[BucketNo] == FullHashValue)) {
+    } else if (LLVM_LIKELY(Bucket.FullHashValue == FullHashValue)) {
       // If the full hash value matches, check deeply for a match.  The common
       // case here is that we are only looking at the buckets (for item info
       // being non-null and for the full hash value) not at the items.  This
@@ -112,24 +115,23 @@ unsigned StringMapImpl::LookupBucketFor(StringRef Name) {
 
 /// FindKey - Look up the bucket that contains the specified key. If it exists
 /// in the map, return the bucket number of the key.  Otherwise return -1.
-/// This does not modify the map.
-int StringMapImpl::FindKey(StringRef Key) const {
+/// This does not modify the map.  FullHashValue must be hash(Key).
+int StringMapImpl::FindKey(StringRef Key, unsigned FullHashValue) const {
   unsigned HTSize = NumBuckets;
   if (HTSize == 0) return -1;  // Really empty table?
-  unsigned FullHashValue = HashString(Key);
   unsigned BucketNo = FullHashValue & (HTSize-1);
-  unsigned *HashTable = (unsigned *)(TheTable + NumBuckets + 1);
 
   unsigned ProbeAmt = 1;
   while (1) {
-    StringMapEntryBase *BucketItem = TheTable[BucketNo];
+    const StringMapBucket &Bucket = TheTable[BucketNo];
+    StringMapEntryBase *BucketItem = Bucket.Item;
     // If we found an empty bucket, this key isn't in the table yet, return.
     if (LLVM_LIKELY(BucketItem == 0))
       return -1;
     
     if (BucketItem == getTombstoneVal()) {
       // Ignore tombstones.
-    } else if (LLVM_LIKELY(HashTable[BucketNo] == FullHashValue)) {
+    } else if (LLVM_LIKELY(Bucket.FullHashValue == FullHashValue)) {
       // If the full hash value matches, check deeply for a match.  The common
       // case here is that we are only looking at the buckets (for item info
       // being non-null and for the full hash value) not at the items.  This
@@ -168,8 +170,8 @@ StringMapEntryBase *StringMapImpl::RemoveKey(StringRef Key) {
   int Bucket = FindKey(Key);
   if (Bucket == -1) return 0;
   
-  StringMapEntryBase *Result = TheTable[Bucket];
-  TheTable[Bucket] = getTombstoneVal();
+  StringMapEntryBase *Result = TheTable[Bucket].Item;
+  TheTable[Bucket].Item = getTombstoneVal();
   --NumItems;
   ++NumTombstones;
   assert(NumItems + NumTombstones <= NumBuckets);
@@ -183,7 +185,6 @@ StringMapEntryBase *StringMapImpl::RemoveKey(StringRef Key) {
 /// the appropriate mod-of-hashtable-size.
 void StringMapImpl::RehashTable() {
   unsigned NewSize;
-  unsigned *HashTable = (unsigned *)(TheTable + NumBuckets + 1);
 
   // If the hash table is now more than 3/4 full, or if fewer than 1/8 of
   // the buckets are empty (meaning that many are filled with tombstones),
@@ -198,23 +199,19 @@ void StringMapImpl::RehashTable() {
 
   // Allocate one extra bucket which will always be non-empty.  This allows the
   // iterators to stop at end.
-  StringMapEntryBase **NewTableArray =
-    (StringMapEntryBase **)calloc(NewSize+1, sizeof(StringMapEntryBase *) +
-                                             sizeof(unsigned));
-  unsigned *NewHashArray = (unsigned *)(NewTableArray + NewSize + 1);
-  NewTableArray[NewSize] = (StringMapEntryBase*)2;
+  StringMapBucket *NewTableArray =
+    (StringMapBucket *)calloc(NewSize+1, sizeof(StringMapBucket));
+  NewTableArray[NewSize].Item = (StringMapEntryBase*)2;
 
   // Rehash all the items into their new buckets.  Luckily :) we already have
   // the hash values available, so we don't have to rehash any strings.
   for (unsigned I = 0, E = NumBuckets; I != E; ++I) {
-    StringMapEntryBase *Bucket = TheTable[I];
-    if (Bucket && Bucket != getTombstoneVal()) {
+    const StringMapBucket &Bucket = TheTable[I];
+    if (Bucket.Item && Bucket.Item != getTombstoneVal()) {
       // Fast case, bucket available.
-      unsigned FullHash = HashTable[I];
-      unsigned NewBucket = FullHash & (NewSize-1);
-      if (NewTableArray[NewBucket] == 0) {
-        NewTableArray[FullHash & (NewSize-1)] = Bucket;
-        NewHashArray[FullHash & (NewSize-1)] = FullHash;
+      unsigned NewBucket = Bucket.FullHashValue & (NewSize-1);
+      if (NewTableArray[NewBucket].Item == 0) {
+        NewTableArray[NewBucket] = Bucket;
         continue;
       }
       
@@ -222,11 +219,10 @@ void StringMapImpl::RehashTable() {
       unsigned ProbeSize = 1;
       do {
         NewBucket = (NewBucket + ProbeSize++) & (NewSize-1);
-      } while (NewTableArray[NewBucket]);
+      } while (NewTableArray[NewBucket].Item);
       
       // Finally found a slot.  Fill it in.
       NewTableArray[NewBucket] = Bucket;
-      NewHashArray[NewBucket] = FullHash;
     }
   }
   
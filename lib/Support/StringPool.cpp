@@ -23,13 +23,15 @@ StringPool::~StringPool() {
 }
 
 PooledStringPtr StringPool::intern(StringRef Key) {
-  table_t::iterator I = InternTable.find(Key);
+  // Hash the key once for both the lookup and the insertion.
+  unsigned FullHashValue = table_t::hash(Key);
+  table_t::iterator I = InternTable.find(Key, FullHashValue);
   if (I != InternTable.end())
     return PooledStringPtr(&*I);
   
   entry_t *S = entry_t::Create(Key.begin(), Key.end());
   S->getValue().Pool = this;
-  InternTable.insert(S);
+  InternTable.insert(S, FullHashValue);
   
   return PooledStringPtr(S);
 }
@@ -16,6 +16,7 @@
 #include "llvm/Support/Atomic.h"
 #include "llvm/Support/Mutex.h"
 #include <cassert>
+#include <vector>
 
 using namespace llvm;
 
@@ -63,8 +64,32 @@ void llvm::llvm_release_global_lock() {
   if (multithreaded_mode) global_lock->release();
 }
 
+namespace {
+/// ParallelWorkInfo - The state shared by the threads running an
+/// llvm_execute_in_parallel call.
+struct ParallelWorkInfo {
+  void (*UserFn)(void *, unsigned);
+  void *UserData;
+  unsigned NumTasks;
+  volatile sys::cas_flag NextTask;
+};
+}
+
+/// RunParallelTasks - Claim and run tasks until there are none left.
+static void RunParallelTasks(ParallelWorkInfo &Info) {
+  while (true) {
+    unsigned Task = sys::AtomicIncrement(&Info.NextTask) - 1;
+    if (Task >= Info.NumTasks)
+      return;
+    Info.UserFn(Info.UserData, Task);
+  }
+}
+
 #if LLVM_ENABLE_THREADS != 0 && defined(HAVE_PTHREAD_H)
 #include <pthread.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h>
+#endif
 
 struct ThreadInfo {
   void (*UserFn)(void *);
@@ -102,6 +127,43 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
  error:
   ::pthread_attr_destroy(&Attr);
 }
+
+static void *ExecuteInParallel_Dispatch(void *Arg) {
+  RunParallelTasks(*reinterpret_cast<ParallelWorkInfo*>(Arg));
+  return 0;
+}
+
+void llvm::llvm_execute_in_parallel(void (*Fn)(void*, unsigned),
+                                    void *UserData, unsigned NumTasks,
+                                    unsigned NumThreads) {
+  ParallelWorkInfo Info = { Fn, UserData, NumTasks, 0 };
+  if (NumThreads > NumTasks)
+    NumThreads = NumTasks;
+
+  // Start the helper threads.  If one can't be created, the threads that
+  // did start (and this one) simply pick up its share of the work.
+  std::vector<pthread_t> Threads;
+  for (unsigned i = 1; i < NumThreads; ++i) {
+    pthread_t Thread;
+    if (::pthread_create(&Thread, 0, ExecuteInParallel_Dispatch, &Info) != 0)
+      break;
+    Threads.push_back(Thread);
+  }
+
+  RunParallelTasks(Info);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i)
+    ::pthread_join(Threads[i], 0);
+}
+
+unsigned llvm::llvm_get_hardware_concurrency() {
+#if defined(HAVE_UNISTD_H) && defined(_SC_NPROCESSORS_ONLN)
+  long NumCPUs = ::sysconf(_SC_NPROCESSORS_ONLN);
+  if (NumCPUs > 0)
+    return static_cast<unsigned>(NumCPUs);
+#endif
+  return 1;
+}
 #elif LLVM_ENABLE_THREADS!=0 && defined(LLVM_ON_WIN32)
 #include "Windows/Windows.h"
 #include <process.h>
@@ -136,6 +198,41 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
     ::CloseHandle(hThread);
   }
 }
+
+static unsigned __stdcall ParallelCallback(void *param) {
+  RunParallelTasks(*reinterpret_cast<ParallelWorkInfo*>(param));
+  return 0;
+}
+
+void llvm::llvm_execute_in_parallel(void (*Fn)(void*, unsigned),
+                                    void *UserData, unsigned NumTasks,
+                                    unsigned NumThreads) {
+  ParallelWorkInfo Info = { Fn, UserData, NumTasks, 0 };
+  if (NumThreads > NumTasks)
+    NumThreads = NumTasks;
+
+  std::vector<HANDLE> Threads;
+  for (unsigned i = 1; i < NumThreads; ++i) {
+    HANDLE hThread = (HANDLE)::_beginthreadex(NULL, 0, ParallelCallback,
+                                              &Info, 0, NULL);
+    if (!hThread)
+      break;
+    Threads.push_back(hThread);
+  }
+
+  RunParallelTasks(Info);
+
+  for (unsigned i = 0, e = Threads.size(); i != e; ++i) {
+    (void)::WaitForSingleObject(Threads[i], INFINITE);
+    ::CloseHandle(Threads[i]);
+  }
+}
+
+unsigned llvm::llvm_get_hardware_concurrency() {
+  SYSTEM_INFO SysInfo;
+  ::GetSystemInfo(&SysInfo);
+  return SysInfo.dwNumberOfProcessors ? SysInfo.dwNumberOfProcessors : 1;
+}
 #else
 // Support for non-Win32, non-pthread implementation.
 void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
@@ -144,4 +241,16 @@ void llvm::llvm_execute_on_thread(void (*Fn)(void*), void *UserData,
   Fn(UserData);
 }
 
+void llvm::llvm_execute_in_parallel(void (*Fn)(void*, unsigned),
+                                    void *UserData, unsigned NumTasks,
+                                    unsigned NumThreads) {
+  (void) NumThreads;
+  ParallelWorkInfo Info = { Fn, UserData, NumTasks, 0 };
+  RunParallelTasks(Info);
+}
+
+unsigned llvm::llvm_get_hardware_concurrency() {
+  return 1;
+}
+
 #endif
@@ -18,10 +18,12 @@
 #include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
 #include "llvm/Support/system_error.h"
+#include <algorithm>
 #include <cctype>
 #include <cerrno>
 #include <sys/stat.h>
@@ -425,7 +427,8 @@ void format_object_base::home() {
 /// if no error occurred.
 raw_fd_ostream::raw_fd_ostream(const char *Filename, std::string &ErrorInfo,
                                unsigned Flags)
-  : Error(false), UseAtomicWrites(false), pos(0)
+  : Error(false), UseAtomicWrites(false), pos(0), CanMap(false),
+    WasUnbuffered(false), Mapping(0)
 {
   assert(Filename != 0 && "Filename is null");
   // Verify that we don't have both "append" and "excl".
@@ -461,6 +464,25 @@ raw_fd_ostream::raw_fd_ostream(const char *Filename, std::string &ErrorInfo,
   if (Flags & F_Excl)
     OpenFlags |= O_EXCL;
 
+#ifdef LLVM_ON_UNIX
+  // A regular file can only be mapped for writing if it is open for reading
+  // too.  Don't do this for anything else: opening a FIFO for reading and
+  // writing, for instance, no longer waits for a reader.
+  struct stat FileInfo;
+  if ((Flags & F_Map) && !(Flags & F_Append) &&
+      (::stat(Filename, &FileInfo) == 0 ? S_ISREG(FileInfo.st_mode)
+                                        : errno == ENOENT)) {
+    while ((FD = open(Filename, (OpenFlags & ~O_WRONLY) | O_RDWR, 0664)) < 0)
+      if (errno != EINTR)
+        break;
+    if (FD >= 0) {
+      CanMap = true;
+      ShouldClose = true;
+      return;
+    }
+  }
+#endif
+
   while ((FD = open(Filename, OpenFlags, 0664)) < 0) {
     if (errno != EINTR) {
       ErrorInfo = "Error opening output file '" + std::string(Filename) + "'";
@@ -477,7 +499,8 @@ raw_fd_ostream::raw_fd_ostream(const char *Filename, std::string &ErrorInfo,
 /// ShouldClose is true, this closes the file when the stream is destroyed.
 raw_fd_ostream::raw_fd_ostream(int fd, bool shouldClose, bool unbuffered)
   : raw_ostream(unbuffered), FD(fd),
-    ShouldClose(shouldClose), Error(false), UseAtomicWrites(false) {
+    ShouldClose(shouldClose), Error(false), UseAtomicWrites(false),
+    CanMap(false), WasUnbuffered(false), Mapping(0) {
 #ifdef O_BINARY
   // Setting STDOUT and STDERR to binary mode is necessary in Win32
   // to avoid undesirable linefeed conversion.
@@ -496,6 +519,8 @@ raw_fd_ostream::raw_fd_ostream(int fd, bool shouldClose, bool unbuffered)
 raw_fd_ostream::~raw_fd_ostream() {
   if (FD >= 0) {
     flush();
+    if (Mapping)
+      endMapping();
     if (ShouldClose)
       while (::close(FD) != 0)
         if (errno != EINTR) {
@@ -523,6 +548,37 @@ raw_fd_ostream::~raw_fd_ostream() {
 
 void raw_fd_ostream::write_impl(const char *Ptr, size_t Size) {
   assert(FD >= 0 && "File already closed.");
+
+  if (Mapping) {
+    // Copy the bytes into the mapping, unless they were written into it
+    // through the buffer in the first place.
+    char *Dest = Mapping->data() + (pos - MapStart);
+    size_t Len = std::min<uint64_t>(Size, MapEnd - pos);
+    if (Ptr != Dest)
+      memcpy(Dest, Ptr, Len);
+    pos += Len;
+    Ptr += Len;
+    Size -= Len;
+
+    bool BufferIsMapped = getBufferStart() >= Mapping->const_data() &&
+                          getBufferStart() < Mapping->const_data() +
+                                             Mapping->size();
+    if (pos != MapEnd) {
+      assert(Size == 0 && "Unwritten bytes with room left in the mapping!");
+      if (BufferIsMapped)
+        SetBuffer(Dest + Len, MapEnd - pos);
+      return;
+    }
+
+    // The mapping is full.  Go back to an ordinary buffer (the caller may
+    // expect to be able to write to one) and write the rest normally.
+    if (BufferIsMapped)
+      SetBufferSize(std::max<size_t>(preferred_buffer_size(), 64));
+    endMapping();
+    if (Size == 0)
+      return;
+  }
+
   pos += Size;
 
   do {
@@ -575,6 +631,8 @@ void raw_fd_ostream::close() {
   assert(ShouldClose);
   ShouldClose = false;
   flush();
+  if (Mapping)
+    endMapping();
   while (::close(FD) != 0)
     if (errno != EINTR) {
       error_detected();
@@ -585,12 +643,100 @@ void raw_fd_ostream::close() {
 
 uint64_t raw_fd_ostream::seek(uint64_t off) {
   flush();
+  if (Mapping)
+    endMapping();
   pos = ::lseek(FD, off, SEEK_SET);
   if (pos != off)
     error_detected();
   return pos;
 }
 
+bool raw_fd_ostream::supportsSeeking() const {
+  if (FD < 0)
+    return false;
+#if defined(F_GETFL) && defined(O_APPEND)
+  // Writes to a file opened for appending ignore the file position.
+  int Flags = ::fcntl(FD, F_GETFL);
+  if (Flags == -1 || (Flags & O_APPEND))
+    return false;
+#endif
+  return ::lseek(FD, 0, SEEK_CUR) != (off_t)-1;
+}
+
+const uint64_t raw_fd_ostream::MinMappedSize;
+
+void raw_fd_ostream::reserveExtraSpace(uint64_t ExtraSize) {
+#ifndef HAVE_POSIX_FALLOCATE
+  // Without a way to allocate the blocks up front, running out of space would
+  // fault a store into the mapping rather than fail a write.
+  (void)ExtraSize;
+  return;
+#else
+  if (!CanMap || Mapping || FD < 0 || ExtraSize < MinMappedSize)
+    return;
+  flush();
+
+  struct stat FileInfo;
+  if (fstat(FD, &FileInfo) != 0)
+    return;
+  SizeBeforeMapping = FileInfo.st_size;
+
+  // Mappings have to start on an allocation boundary, so map a little of
+  // what was already written as well.
+  uint64_t Alignment = sys::fs::mapped_file_region::alignment();
+  MapStart = pos & ~(Alignment - 1);
+  MapEnd = pos + ExtraSize;
+
+  // Allocate the blocks as well as growing the file, so that a full disk is
+  // reported here and the output is written with write(2) instead, rather
+  // than raising SIGBUS on a store into the mapping.
+  if (MapEnd > SizeBeforeMapping &&
+      ::posix_fallocate(FD, SizeBeforeMapping,
+                        MapEnd - SizeBeforeMapping) != 0) {
+    if (::ftruncate(FD, SizeBeforeMapping) != 0)
+      error_detected();
+    return;
+  }
+
+  error_code EC;
+  Mapping = new sys::fs::mapped_file_region(
+      FD, false, sys::fs::mapped_file_region::readwrite, MapEnd - MapStart,
+      MapStart, EC);
+  if (EC) {
+    delete Mapping;
+    Mapping = 0;
+    if (MapEnd > SizeBeforeMapping &&
+        ::ftruncate(FD, SizeBeforeMapping) != 0)
+      error_detected();
+    return;
+  }
+
+  WasUnbuffered = GetBufferSize() == 0;
+  SetBuffer(Mapping->data() + (pos - MapStart), ExtraSize);
+#endif
+}
+
+void raw_fd_ostream::endMapping() {
+  assert(GetNumBytesInBuffer() == 0 && "Unwritten bytes in the mapping!");
+  const char *BufferStart = getBufferStart();
+  if (BufferStart >= Mapping->const_data() &&
+      BufferStart < Mapping->const_data() + Mapping->size()) {
+    if (WasUnbuffered)
+      SetUnbuffered();
+    else
+      SetBuffered();
+  }
+
+  delete Mapping;
+  Mapping = 0;
+
+  // Give back the space that was reserved but not written, and carry on
+  // writing from the end of the output.
+  if (::ftruncate(FD, std::max(SizeBeforeMapping, pos)) != 0 ||
+      ::lseek(FD, pos, SEEK_SET) != off_t(pos))
+    error_detected();
+}
+
 size_t raw_fd_ostream::preferred_buffer_size() const {
 #if !defined(_MSC_VER) && !defined(__MINGW32__) && !defined(__minix)
   // Windows and Minix have no st_blksize.
@@ -759,6 +905,13 @@ void raw_svector_ostream::write_impl(const char *Ptr, size_t Size) {
   SetBuffer(OS.end(), OS.capacity() - OS.size());
 }
 
+void raw_svector_ostream::reserveExtraSpace(uint64_t ExtraSize) {
+  // Commit the buffered bytes so that the buffer can be moved.
+  flush();
+  OS.reserve(OS.size() + ExtraSize);
+  SetBuffer(OS.end(), OS.capacity() - OS.size());
+}
+
 uint64_t raw_svector_ostream::current_pos() const {
    return OS.size();
 }
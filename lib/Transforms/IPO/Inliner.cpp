@@ -18,6 +18,7 @@
 #include "llvm/ADT/SmallPtrSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/CallGraph.h"
+#include "llvm/Analysis/CounterProfile.h"
 #include "llvm/Analysis/InlineCost.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Instructions.h"
@@ -50,16 +51,23 @@ static cl::opt<int>
 HintThreshold("inlinehint-threshold", cl::Hidden, cl::init(325),
               cl::desc("Threshold for inlining functions with inline hint"));
 
+static cl::opt<unsigned>
+HotCalleePercent("inline-hot-callee-percent", cl::Hidden, cl::init(1),
+                 cl::desc("Treat callees entered at least this percentage as "
+                          "often as the most frequently entered function of a "
+                          "profile as if they had an inline hint"));
+
 // Threshold to use when optsize is specified (and there is no -inline-limit).
 const int OptSizeThreshold = 75;
 
 Inliner::Inliner(char &ID) 
-  : CallGraphSCCPass(ID), InlineThreshold(InlineLimit), InsertLifetime(true) {}
+  : CallGraphSCCPass(ID), InlineThreshold(InlineLimit), InsertLifetime(true),
+    MaxEntryCount(0) {}
 
 Inliner::Inliner(char &ID, int Threshold, bool InsertLifetime)
   : CallGraphSCCPass(ID), InlineThreshold(InlineLimit.getNumOccurrences() > 0 ?
                                           InlineLimit : Threshold),
-    InsertLifetime(InsertLifetime) {}
+    InsertLifetime(InsertLifetime), MaxEntryCount(0) {}
 
 /// getAnalysisUsage - For this class, we declare that we require and preserve
 /// the call graph.  If the derived class implements this method, it should
@@ -254,6 +262,23 @@ unsigned Inliner::getInlineThreshold(CallSite CS) const {
                                                Attribute::MinSize))
     thres = HintThreshold;
 
+  // With a profile, a callee that the profiled run never entered is inlined
+  // only where that does not grow the code much, and a hot callee is treated
+  // as if it had an inline hint.
+  ValueMap<const Function *, uint64_t, EntryCountsConfig>::const_iterator EC =
+    Callee ? EntryCounts.find(Callee) : EntryCounts.end();
+  if (EC != EntryCounts.end()) {
+    if (EC->second == 0) {
+      if (!(InlineLimit.getNumOccurrences() > 0) && OptSizeThreshold < thres)
+        thres = OptSizeThreshold;
+    } else if (EC->second * 100 >= MaxEntryCount * HotCalleePercent &&
+               HintThreshold > thres &&
+               !Caller->getAttributes().hasAttribute(
+                 AttributeSet::FunctionIndex, Attribute::MinSize)) {
+      thres = HintThreshold;
+    }
+  }
+
   return thres;
 }
 
@@ -480,7 +505,9 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
         if (!shouldInline(CS))
           continue;
 
-        // Attempt to inline the function.
+        // Attempt to inline the function. What inlining does is attributed to
+        // the caller with -stats-per-function.
+        StatisticScope CallerStats(Caller->getName());
         if (!InlineCallIfPossible(CS, InlineInfo, InlinedArrayAllocas,
                                   InlineHistoryID, InsertLifetime))
           continue;
@@ -544,9 +571,23 @@ bool Inliner::runOnSCC(CallGraphSCC &SCC) {
   return Changed;
 }
 
+bool Inliner::doInitialization(CallGraph &CG) {
+  EntryCounts.clear();
+  MaxEntryCount = 0;
+  DenseMap<const Function *, uint64_t> Counts;
+  getFunctionEntryCounts(CG.getModule(), Counts);
+  for (DenseMap<const Function *, uint64_t>::const_iterator
+       I = Counts.begin(), E = Counts.end(); I != E; ++I) {
+    EntryCounts[I->first] = I->second;
+    MaxEntryCount = std::max(MaxEntryCount, I->second);
+  }
+  return false;
+}
+
 // doFinalization - Remove now-dead linkonce functions at the end of
 // processing to avoid breaking the SCC traversal.
 bool Inliner::doFinalization(CallGraph &CG) {
+  EntryCounts.clear();
   return removeDeadFunctions(CG);
 }
 
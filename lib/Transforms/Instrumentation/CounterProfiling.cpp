@@ -0,0 +1,306 @@
+//===- CounterProfiling.cpp - Counter-based profile guided optimization ---===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the two halves of counter-based profile guided
+// optimization:
+//
+// * -insert-counter-profiling gives every function an array of 64-bit
+//   counters, one for the entry into the function and one for each successor
+//   of a conditional branch or switch, and registers the arrays with the
+//   profiling runtime, which writes them out as an indexed profile when the
+//   program exits.  Profiles of several runs are combined with llvm-profdata.
+//
+// * -counter-profile-use reads an indexed profile back, turns the edge counts
+//   into branch_weights metadata for BranchProbabilityInfo and records the
+//   entry count of each function for the inliner.
+//
+// Both passes have to see the same CFG, so they must run at the same point of
+// the pipeline.  A function whose CFG has changed since it was profiled is
+// detected by its hash and left alone.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "counter-profiling"
+#include "llvm/Transforms/Instrumentation.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/CounterProfile.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+#include <algorithm>
+using namespace llvm;
+
+STATISTIC(NumCountersInserted, "Number of profile counters inserted");
+STATISTIC(NumFunctionsAnnotated, "Number of functions given profile data");
+STATISTIC(NumFunctionsMismatched,
+          "Number of functions whose profile does not match their CFG");
+STATISTIC(NumBranchesAnnotated, "Number of branches given profile weights");
+
+static cl::opt<std::string>
+CounterProfileFile("counter-profile-file", cl::init(""),
+                   cl::value_desc("filename"),
+                   cl::desc("Indexed profile read by -counter-profile-use"),
+                   cl::Hidden);
+
+//===----------------------------------------------------------------------===//
+// Instrumentation
+//===----------------------------------------------------------------------===//
+
+namespace {
+  class CounterProfiler : public ModulePass {
+    GlobalVariable *instrumentFunction(Function &F);
+
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    CounterProfiler() : ModulePass(ID) {
+      initializeCounterProfilerPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnModule(Module &M);
+
+    virtual const char *getPassName() const {
+      return "Counter Profiler";
+    }
+  };
+}
+
+char CounterProfiler::ID = 0;
+INITIALIZE_PASS(CounterProfiler, "insert-counter-profiling",
+                "Insert instrumentation for counter profiling", false, false)
+
+ModulePass *llvm::createCounterProfilerPass() { return new CounterProfiler(); }
+
+/// incrementCounter - Insert code before InsertPos that adds one to counter
+/// Index of Counters.
+static void incrementCounter(Instruction *InsertPos, GlobalVariable *Counters,
+                             unsigned Index) {
+  IRBuilder<> Builder(InsertPos);
+  Value *Addr = Builder.CreateConstInBoundsGEP2_64(Counters, 0, Index);
+  Value *Count = Builder.CreateLoad(Addr, "prof.count");
+  Builder.CreateStore(Builder.CreateAdd(Count, Builder.getInt64(1)), Addr);
+}
+
+/// instrumentFunction - Count the entries into F and the edges returned by
+/// getCounterProfileEdges, and return the counter array.
+GlobalVariable *CounterProfiler::instrumentFunction(Function &F) {
+  SmallVector<CounterProfileEdge, 16> Edges;
+  getCounterProfileEdges(F, Edges);
+
+  Type *CountersTy =
+    ArrayType::get(Type::getInt64Ty(F.getContext()), Edges.size() + 1);
+  GlobalVariable *Counters =
+    new GlobalVariable(*F.getParent(), CountersTy, false,
+                       GlobalValue::PrivateLinkage,
+                       Constant::getNullValue(CountersTy),
+                       "__llvm_prof_counters_" + F.getName());
+
+  // Leave the static allocas at the top of the entry block.
+  BasicBlock::iterator InsertPos = F.getEntryBlock().getFirstInsertionPt();
+  while (isa<AllocaInst>(InsertPos))
+    ++InsertPos;
+  incrementCounter(InsertPos, Counters, 0);
+
+  for (unsigned i = 0, e = Edges.size(); i != e; ++i) {
+    TerminatorInst *TI = Edges[i].first;
+    unsigned SuccNum = Edges[i].second;
+    // The successor of a non-critical edge out of a multi-way branch has no
+    // other predecessor, so the counter can go there; otherwise the edge gets
+    // a block of its own.
+    BasicBlock *Dest = TI->getSuccessor(SuccNum);
+    if (isCriticalEdge(TI, SuccNum))
+      Dest = SplitCriticalEdge(TI, SuccNum, this);
+    assert(Dest && "Could not split a critical edge!");
+    incrementCounter(Dest->getFirstInsertionPt(), Counters, i + 1);
+  }
+
+  NumCountersInserted += Edges.size() + 1;
+  return Counters;
+}
+
+bool CounterProfiler::runOnModule(Module &M) {
+  LLVMContext &Ctx = M.getContext();
+  Type *Int8PtrTy = Type::getInt8PtrTy(Ctx);
+  Type *Int32Ty = Type::getInt32Ty(Ctx);
+  Type *Int64Ty = Type::getInt64Ty(Ctx);
+
+  // The runtime's view of a function, see runtime/libprofile.
+  StructType *FunctionTy =
+    StructType::get(Int8PtrTy, Int64Ty, Int32Ty, Type::getInt64PtrTy(Ctx),
+                    (Type *)0);
+
+  std::vector<Constant *> Records;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration() || F->hasAvailableExternallyLinkage())
+      continue;
+
+    // The hash must describe the CFG before edges are split.
+    uint64_t Hash = getCounterProfileHash(*F);
+    std::string Name = getCounterProfileName(*F);
+    GlobalVariable *Counters = instrumentFunction(*F);
+
+    Constant *NameInit = ConstantDataArray::getString(Ctx, Name);
+    GlobalVariable *NameVar =
+      new GlobalVariable(M, NameInit->getType(), true,
+                         GlobalValue::PrivateLinkage, NameInit,
+                         "__llvm_prof_name_" + F->getName());
+    NameVar->setUnnamedAddr(true);
+
+    uint64_t NumCounters =
+      cast<ArrayType>(Counters->getType()->getElementType())->getNumElements();
+    Constant *Fields[] = {
+      ConstantExpr::getPointerCast(NameVar, Int8PtrTy),
+      ConstantInt::get(Int64Ty, Hash),
+      ConstantInt::get(Int32Ty, NumCounters),
+      ConstantExpr::getPointerCast(Counters, Type::getInt64PtrTy(Ctx))
+    };
+    Records.push_back(ConstantStruct::get(FunctionTy, Fields));
+  }
+  if (Records.empty())
+    return false;
+
+  ArrayType *TableTy = ArrayType::get(FunctionTy, Records.size());
+  GlobalVariable *Table =
+    new GlobalVariable(M, TableTy, true, GlobalValue::PrivateLinkage,
+                       ConstantArray::get(TableTy, Records),
+                       "__llvm_prof_functions");
+
+  // Register the table from a constructor, so that every module of the
+  // program is counted whether or not it defines main.
+  Function *RegisterFn =
+    Function::Create(FunctionType::get(Type::getVoidTy(Ctx), false),
+                     GlobalValue::InternalLinkage, "__llvm_prof_register", &M);
+  Constant *RuntimeFn =
+    M.getOrInsertFunction("llvm_register_counter_profile",
+                          Type::getVoidTy(Ctx),
+                          PointerType::getUnqual(FunctionTy), Int32Ty,
+                          (Type *)0);
+  IRBuilder<> Builder(BasicBlock::Create(Ctx, "entry", RegisterFn));
+  Builder.CreateCall2(RuntimeFn,
+                      Builder.CreateConstInBoundsGEP2_64(Table, 0, 0),
+                      Builder.getInt32(Records.size()));
+  Builder.CreateRetVoid();
+  appendToGlobalCtors(M, RegisterFn, 0);
+  return true;
+}
+
+//===----------------------------------------------------------------------===//
+// Profile use
+//===----------------------------------------------------------------------===//
+
+namespace {
+  class CounterProfileUse : public ModulePass {
+    /// Filename - The profile to read; defaults to -counter-profile-file.
+    std::string Filename;
+
+    bool annotateFunction(Function &F, const std::vector<uint64_t> &Counts);
+
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    explicit CounterProfileUse(StringRef Name = "")
+      : ModulePass(ID),
+        Filename(Name.empty() ? StringRef(CounterProfileFile) : Name) {
+      initializeCounterProfileUsePass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool runOnModule(Module &M);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.setPreservesCFG();
+    }
+
+    virtual const char *getPassName() const {
+      return "Counter Profile Use";
+    }
+  };
+}
+
+char CounterProfileUse::ID = 0;
+INITIALIZE_PASS(CounterProfileUse, "counter-profile-use",
+                "Apply an indexed counter profile", false, false)
+
+ModulePass *llvm::createCounterProfileUsePass(StringRef Filename) {
+  return new CounterProfileUse(Filename);
+}
+
+/// annotateFunction - Attach the entry count and branch weights in Counts,
+/// which is laid out as getCounterProfileEdges describes, to F.
+bool CounterProfileUse::annotateFunction(Function &F,
+                                         const std::vector<uint64_t> &Counts) {
+  SmallVector<CounterProfileEdge, 16> Edges;
+  getCounterProfileEdges(F, Edges);
+  if (Counts.size() != Edges.size() + 1) {
+    ++NumFunctionsMismatched;
+    return false;
+  }
+
+  setFunctionEntryCount(F, Counts[0]);
+  ++NumFunctionsAnnotated;
+
+  MDBuilder MDB(F.getContext());
+  // The edges of one terminator are consecutive.
+  for (unsigned Begin = 0, e = Edges.size(); Begin != e; ) {
+    TerminatorInst *TI = Edges[Begin].first;
+    unsigned End = Begin + TI->getNumSuccessors();
+    uint64_t MaxCount = *std::max_element(Counts.begin() + Begin + 1,
+                                          Counts.begin() + End + 1);
+    if (MaxCount != 0) {
+      // branch_weights are 32-bit; scale large counts down uniformly.
+      uint64_t Scale = MaxCount / UINT32_MAX + 1;
+      SmallVector<uint32_t, 4> Weights;
+      for (unsigned i = Begin; i != End; ++i)
+        Weights.push_back(Counts[i + 1] / Scale);
+      TI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(Weights));
+      ++NumBranchesAnnotated;
+    }
+    Begin = End;
+  }
+  return true;
+}
+
+bool CounterProfileUse::runOnModule(Module &M) {
+  if (Filename.empty())
+    report_fatal_error("No counter profile given; use -counter-profile-file");
+  std::string ErrorMsg;
+  OwningPtr<CounterProfileReader> Reader(
+    CounterProfileReader::create(Filename, ErrorMsg));
+  if (!Reader)
+    report_fatal_error("Could not read counter profile: " + ErrorMsg);
+
+  bool Changed = false;
+  std::vector<uint64_t> Counts;
+  for (Module::iterator F = M.begin(), E = M.end(); F != E; ++F) {
+    if (F->isDeclaration())
+      continue;
+    uint64_t Hash;
+    if (!Reader->findFunction(getCounterProfileName(*F), Hash, Counts))
+      continue;
+    if (Hash != getCounterProfileHash(*F)) {
+      DEBUG(dbgs() << "Profile of " << F->getName()
+                   << " does not match its CFG; ignoring it\n");
+      ++NumFunctionsMismatched;
+      continue;
+    }
+    Changed |= annotateFunction(*F, Counts);
+  }
+  return Changed;
+}
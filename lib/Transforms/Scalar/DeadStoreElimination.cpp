@@ -25,6 +25,8 @@
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
+#include "llvm/Analysis/PostDominators.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -33,6 +35,7 @@
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/IntrinsicInst.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Target/TargetLibraryInfo.h"
 #include "llvm/Transforms/Utils/Local.h"
@@ -41,21 +44,39 @@ using namespace llvm;
 STATISTIC(NumFastStores, "Number of stores deleted");
 STATISTIC(NumFastOther , "Number of other instrs removed");
 
+// With MemorySSA, a store looks for dead stores up its chain of defining
+// accesses rather than only in its own block, and deletes an earlier store
+// it completely overwrites when it post-dominates it.
+static cl::opt<bool>
+EnableMemorySSA("enable-dse-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Use MemorySSA instead of MemoryDependenceAnalysis "
+                         "in DSE"));
+
+// Limit for the number of defs to walk up from a store with MemorySSA.
+static const unsigned MemorySSAScanLimit = 100;
+
 namespace {
   struct DSE : public FunctionPass {
     AliasAnalysis *AA;
     MemoryDependenceAnalysis *MD;
+    MemorySSA *MSSA;
     DominatorTree *DT;
+    PostDominatorTree *PDT;
     const TargetLibraryInfo *TLI;
 
     static char ID; // Pass identification, replacement for typeid
-    DSE() : FunctionPass(ID), AA(0), MD(0), DT(0) {
+    DSE() : FunctionPass(ID), AA(0), MD(0), MSSA(0), DT(0), PDT(0) {
       initializeDSEPass(*PassRegistry::getPassRegistry());
     }
 
     virtual bool runOnFunction(Function &F) {
       AA = &getAnalysis<AliasAnalysis>();
-      MD = &getAnalysis<MemoryDependenceAnalysis>();
+      if (EnableMemorySSA) {
+        MSSA = &getAnalysis<MemorySSA>();
+        PDT = &getAnalysis<PostDominatorTree>();
+      } else {
+        MD = &getAnalysis<MemoryDependenceAnalysis>();
+      }
       DT = &getAnalysis<DominatorTree>();
       TLI = AA->getTargetLibraryInfo();
 
@@ -64,13 +85,15 @@ namespace {
         // Only check non-dead blocks.  Dead blocks may have strange pointer
         // cycles that will confuse alias analysis.
         if (DT->isReachableFromEntry(I))
-          Changed |= runOnBasicBlock(*I);
+          Changed |= MSSA ? runOnBasicBlockMemorySSA(*I) : runOnBasicBlock(*I);
 
-      AA = 0; MD = 0; DT = 0;
+      AA = 0; MD = 0; MSSA = 0; DT = 0; PDT = 0;
       return Changed;
     }
 
     bool runOnBasicBlock(BasicBlock &BB);
+    bool runOnBasicBlockMemorySSA(BasicBlock &BB);
+    bool eliminateDeadStoresAbove(Instruction *Inst);
     bool HandleFree(CallInst *F);
     bool handleEndBlock(BasicBlock &BB);
     void RemoveAccessedObjects(const AliasAnalysis::Location &LoadedLoc,
@@ -80,10 +103,17 @@ namespace {
       AU.setPreservesCFG();
       AU.addRequired<DominatorTree>();
       AU.addRequired<AliasAnalysis>();
-      AU.addRequired<MemoryDependenceAnalysis>();
+      if (EnableMemorySSA) {
+        AU.addRequired<MemorySSA>();
+        AU.addRequired<PostDominatorTree>();
+        AU.addPreserved<MemorySSA>();
+        AU.addPreserved<PostDominatorTree>();
+      } else {
+        AU.addRequired<MemoryDependenceAnalysis>();
+        AU.addPreserved<MemoryDependenceAnalysis>();
+      }
       AU.addPreserved<AliasAnalysis>();
       AU.addPreserved<DominatorTree>();
-      AU.addPreserved<MemoryDependenceAnalysis>();
     }
   };
 }
@@ -92,6 +122,8 @@ char DSE::ID = 0;
 INITIALIZE_PASS_BEGIN(DSE, "dse", "Dead Store Elimination", false, false)
 INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(MemoryDependenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(MemorySSA)
+INITIALIZE_PASS_DEPENDENCY(PostDominatorTree)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
 INITIALIZE_PASS_END(DSE, "dse", "Dead Store Elimination", false, false)
 
@@ -108,7 +140,8 @@ FunctionPass *llvm::createDeadStoreEliminationPass() { return new DSE(); }
 /// If ValueSet is non-null, remove any deleted instructions from it as well.
 ///
 static void DeleteDeadInstruction(Instruction *I,
-                                  MemoryDependenceAnalysis &MD,
+                                  MemoryDependenceAnalysis *MD,
+                                  MemorySSA *MSSA,
                                   const TargetLibraryInfo *TLI,
                                   SmallSetVector<Value*, 16> *ValueSet = 0) {
   SmallVector<Instruction*, 32> NowDeadInsts;
@@ -124,7 +157,8 @@ static void DeleteDeadInstruction(Instruction *I,
     // This instruction is dead, zap it, in stages.  Start by removing it from
     // MemDep, which needs to know the operands and needs it to be in the
     // function.
-    MD.removeInstruction(DeadInst);
+    if (MD) MD->removeInstruction(DeadInst);
+    if (MSSA) MSSA->removeInstruction(DeadInst);
 
     for (unsigned op = 0, e = DeadInst->getNumOperands(); op != e; ++op) {
       Value *Op = DeadInst->getOperand(op);
@@ -525,7 +559,7 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
           // in case we need it.
           WeakVH NextInst(BBI);
 
-          DeleteDeadInstruction(SI, *MD, TLI);
+          DeleteDeadInstruction(SI, MD, MSSA, TLI);
 
           if (NextInst == 0)  // Next instruction deleted.
             BBI = BB.begin();
@@ -572,7 +606,7 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
                 << *DepWrite << "\n  KILLER: " << *Inst << '\n');
 
           // Delete the store and now-dead instructions that feed it.
-          DeleteDeadInstruction(DepWrite, *MD, TLI);
+          DeleteDeadInstruction(DepWrite, MD, MSSA, TLI);
           ++NumFastStores;
           MadeChange = true;
 
@@ -636,6 +670,110 @@ bool DSE::runOnBasicBlock(BasicBlock &BB) {
   return MadeChange;
 }
 
+/// runOnBasicBlockMemorySSA - Remove the stores that the writes in BB make
+/// dead, using MemorySSA to find them.
+bool DSE::runOnBasicBlockMemorySSA(BasicBlock &BB) {
+  bool MadeChange = false;
+
+  // Deleting a store can delete the instructions that fed it, so hold the
+  // writes of the block in value handles.
+  SmallVector<WeakVH, 16> Writes;
+  for (BasicBlock::iterator I = BB.begin(), E = BB.end(); I != E; ++I)
+    if (hasMemoryWrite(I, TLI))
+      Writes.push_back(WeakVH(I));
+
+  for (unsigned i = 0, e = Writes.size(); i != e; ++i)
+    if (Value *V = Writes[i])
+      MadeChange |= eliminateDeadStoresAbove(cast<Instruction>(V));
+
+  // If this block ends in a return, unwind, or unreachable, all allocas are
+  // dead at its end, which means stores to them are also dead.
+  if (BB.getTerminator()->getNumSuccessors() == 0)
+    MadeChange |= handleEndBlock(BB);
+
+  return MadeChange;
+}
+
+/// eliminateDeadStoresAbove - Walk up the defs above the write Inst and
+/// delete the stores it completely overwrites.  The walk stops at a phi, at a
+/// def whose memory state may flow into a phi, and at anything that may read
+/// the location Inst writes, so every def passed lies on each path to Inst.
+bool DSE::eliminateDeadStoresAbove(Instruction *Inst) {
+  MemoryUseOrDef *InstMA = MSSA->getMemoryAccess(Inst);
+  AliasAnalysis::Location Loc = getLocForWrite(Inst, *AA);
+  if (!InstMA || Loc.Ptr == 0)
+    return false;
+
+  // If we're storing the same value back to a pointer that we loaded from and
+  // nothing wrote the pointer in between, then the store can be removed.
+  if (StoreInst *SI = dyn_cast<StoreInst>(Inst)) {
+    LoadInst *DepLoad = dyn_cast<LoadInst>(SI->getValueOperand());
+    if (DepLoad && SI->getPointerOperand() == DepLoad->getPointerOperand() &&
+        isRemovable(SI)) {
+      MemorySSAWalker *Walker = MSSA->getWalker();
+      MemoryAccess *LoadClobber = Walker->getClobberingMemoryAccess(DepLoad);
+      if (LoadClobber &&
+          LoadClobber == Walker->getClobberingMemoryAccess(
+                           InstMA->getDefiningAccess(), Loc)) {
+        DEBUG(dbgs() << "DSE: Remove Store Of Load from same pointer:\n  "
+                     << "LOAD: " << *DepLoad << "\n  STORE: " << *SI << '\n');
+        DeleteDeadInstruction(SI, MD, MSSA, TLI);
+        ++NumFastStores;
+        return true;
+      }
+    }
+  }
+
+  MemoryAccess *Cur = InstMA->getDefiningAccess();
+  for (unsigned Budget = MemorySSAScanLimit; Budget; --Budget) {
+    MemoryDef *Def = dyn_cast<MemoryDef>(Cur);
+    if (!Def)
+      break;
+
+    // Anything that reads the memory state this def leaves, up to Inst, may
+    // observe what it wrote.
+    for (MemoryAccess::user_iterator UI = Def->user_begin(),
+         UE = Def->user_end(); UI != UE; ++UI) {
+      if (isa<MemoryPhi>(*UI))
+        return false;
+      if (MemoryUse *MU = dyn_cast<MemoryUse>(*UI))
+        if (AA->getModRefInfo(MU->getMemoryInst(), Loc) & AliasAnalysis::Ref)
+          return false;
+    }
+
+    Instruction *DepWrite = Def->getMemoryInst();
+    Cur = Def->getDefiningAccess();
+
+    // If we find a write that is a) removable (i.e., non-volatile), b) is
+    // completely obliterated by the store to 'Loc', c) which we know that
+    // 'Inst' doesn't load from, and d) after which 'Inst' always executes,
+    // then we can remove it.
+    AliasAnalysis::Location DepLoc = getLocForWrite(DepWrite, *AA);
+    if (DepLoc.Ptr && isRemovable(DepWrite) &&
+        !isPossibleSelfRead(Inst, Loc, DepWrite, *AA) &&
+        PDT->dominates(Inst->getParent(), DepWrite->getParent())) {
+      int64_t InstWriteOffset, DepWriteOffset;
+      if (isOverwrite(Loc, DepLoc, *AA, DepWriteOffset, InstWriteOffset) ==
+          OverwriteComplete) {
+        DEBUG(dbgs() << "DSE: Remove Dead Store:\n  DEAD: "
+              << *DepWrite << "\n  KILLER: " << *Inst << '\n');
+        // The deletion may take defs above with it, so stop here.  Writes
+        // are visited top-down, so DepWrite already removed the stores that
+        // it overwrote itself.
+        DeleteDeadInstruction(DepWrite, MD, MSSA, TLI);
+        ++NumFastStores;
+        return true;
+      }
+    }
+
+    // Can't look past this instruction if it might read 'Loc'.
+    if (AA->getModRefInfo(DepWrite, Loc) & AliasAnalysis::Ref)
+      break;
+  }
+
+  return false;
+}
+
 /// Find all blocks that will unconditionally lead to the block BB and append
 /// them to F.
 static void FindUnconditionalPreds(SmallVectorImpl<BasicBlock *> &Blocks,
@@ -682,7 +820,7 @@ bool DSE::HandleFree(CallInst *F) {
       Instruction *Next = llvm::next(BasicBlock::iterator(Dependency));
 
       // DCE instructions only used to calculate that store
-      DeleteDeadInstruction(Dependency, *MD, TLI);
+      DeleteDeadInstruction(Dependency, MD, MSSA, TLI);
       ++NumFastStores;
       MadeChange = true;
 
@@ -782,7 +920,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
               dbgs() << '\n');
 
         // DCE instructions only used to calculate that store.
-        DeleteDeadInstruction(Dead, *MD, TLI, &DeadStackObjects);
+        DeleteDeadInstruction(Dead, MD, MSSA, TLI, &DeadStackObjects);
         ++NumFastStores;
         MadeChange = true;
         continue;
@@ -792,7 +930,7 @@ bool DSE::handleEndBlock(BasicBlock &BB) {
     // Remove any dead non-memory-mutating instructions.
     if (isInstructionTriviallyDead(BBI, TLI)) {
       Instruction *Inst = BBI++;
-      DeleteDeadInstruction(Inst, *MD, TLI, &DeadStackObjects);
+      DeleteDeadInstruction(Inst, MD, MSSA, TLI, &DeadStackObjects);
       ++NumFastOther;
       MadeChange = true;
       continue;
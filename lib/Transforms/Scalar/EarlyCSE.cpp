@@ -19,9 +19,11 @@
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/IR/DataLayout.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/RecyclingAllocator.h"
 #include "llvm/Target/TargetLibraryInfo.h"
@@ -34,6 +36,13 @@ STATISTIC(NumCSE,      "Number of instructions CSE'd");
 STATISTIC(NumCSELoad,  "Number of load instructions CSE'd");
 STATISTIC(NumCSECall,  "Number of call instructions CSE'd");
 STATISTIC(NumDSE,      "Number of trivial dead stores removed");
+STATISTIC(NumCSEMemorySSA,
+          "Number of loads and calls CSE'd across generations by MemorySSA");
+
+static cl::opt<bool>
+EnableMemorySSA("enable-earlycse-memoryssa", cl::init(false), cl::Hidden,
+  cl::desc("Use MemorySSA to CSE loads and calls separated by unrelated "
+           "writes"));
 
 static unsigned getHash(const void *V) {
   return DenseMapInfo<const void*>::getHashValue(V);
@@ -275,6 +284,7 @@ public:
   const DataLayout *TD;
   const TargetLibraryInfo *TLI;
   DominatorTree *DT;
+  MemorySSA *MSSA;
   typedef RecyclingAllocator<BumpPtrAllocator,
                       ScopedHashTableVal<SimpleValue, Value*> > AllocatorTy;
   typedef ScopedHashTable<SimpleValue, Value*, DenseMapInfo<SimpleValue>,
@@ -384,11 +394,15 @@ private:
   };
 
   bool processNode(DomTreeNode *Node);
+  bool isSameMemoryGeneration(Instruction *Earlier, Instruction *Later);
+  void eraseInstruction(Instruction *I);
 
   // This transformation requires dominator postdominator info
   virtual void getAnalysisUsage(AnalysisUsage &AU) const {
     AU.addRequired<DominatorTree>();
     AU.addRequired<TargetLibraryInfo>();
+    if (EnableMemorySSA)
+      AU.addRequired<MemorySSA>();
     AU.setPreservesCFG();
   }
 };
@@ -404,8 +418,28 @@ FunctionPass *llvm::createEarlyCSEPass() {
 INITIALIZE_PASS_BEGIN(EarlyCSE, "early-cse", "Early CSE", false, false)
 INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfo)
+INITIALIZE_PASS_DEPENDENCY(MemorySSA)
 INITIALIZE_PASS_END(EarlyCSE, "early-cse", "Early CSE", false, false)
 
+/// isSameMemoryGeneration - Return true if no write between the load or call
+/// Earlier and the load or call Later, which it dominates, can change what
+/// Later reads.  This holds when the access clobbering Later dominates Earlier.
+bool EarlyCSE::isSameMemoryGeneration(Instruction *Earlier,
+                                      Instruction *Later) {
+  if (!MSSA)
+    return false;
+  MemoryAccess *EarlierMA = MSSA->getMemoryAccess(Earlier);
+  MemoryAccess *Clobber = MSSA->getWalker()->getClobberingMemoryAccess(Later);
+  return EarlierMA && Clobber && MSSA->dominates(Clobber, EarlierMA);
+}
+
+/// eraseInstruction - Erase I, first removing it from MemorySSA if in use.
+void EarlyCSE::eraseInstruction(Instruction *I) {
+  if (MSSA)
+    MSSA->removeInstruction(I);
+  I->eraseFromParent();
+}
+
 bool EarlyCSE::processNode(DomTreeNode *Node) {
   BasicBlock *BB = Node->getBlock();
 
@@ -434,7 +468,7 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
     // Dead instructions should just be removed.
     if (isInstructionTriviallyDead(Inst, TLI)) {
       DEBUG(dbgs() << "EarlyCSE DCE: " << *Inst << '\n');
-      Inst->eraseFromParent();
+      eraseInstruction(Inst);
       Changed = true;
       ++NumSimplify;
       continue;
@@ -445,7 +479,7 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
     if (Value *V = SimplifyInstruction(Inst, TD, TLI, DT)) {
       DEBUG(dbgs() << "EarlyCSE Simplify: " << *Inst << "  to: " << *V << '\n');
       Inst->replaceAllUsesWith(V);
-      Inst->eraseFromParent();
+      eraseInstruction(Inst);
       Changed = true;
       ++NumSimplify;
       continue;
@@ -457,7 +491,7 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
       if (Value *V = AvailableValues->lookup(Inst)) {
         DEBUG(dbgs() << "EarlyCSE CSE: " << *Inst << "  to: " << *V << '\n');
         Inst->replaceAllUsesWith(V);
-        Inst->eraseFromParent();
+        eraseInstruction(Inst);
         Changed = true;
         ++NumCSE;
         continue;
@@ -477,14 +511,24 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
       }
 
       // If we have an available version of this load, and if it is the right
-      // generation, replace this instruction.
+      // generation, replace this instruction.  With MemorySSA, an earlier load
+      // of an older generation may still be good if nothing written since
+      // aliases this one.
       std::pair<Value*, unsigned> InVal =
         AvailableLoads->lookup(Inst->getOperand(0));
+      if (InVal.first != 0 && InVal.second != CurrentGeneration &&
+          isa<LoadInst>(InVal.first) &&
+          cast<LoadInst>(InVal.first)->getPointerOperand() ==
+            LI->getPointerOperand() &&
+          isSameMemoryGeneration(cast<LoadInst>(InVal.first), Inst)) {
+        InVal.second = CurrentGeneration;
+        ++NumCSEMemorySSA;
+      }
       if (InVal.first != 0 && InVal.second == CurrentGeneration) {
         DEBUG(dbgs() << "EarlyCSE CSE LOAD: " << *Inst << "  to: "
               << *InVal.first << '\n');
         if (!Inst->use_empty()) Inst->replaceAllUsesWith(InVal.first);
-        Inst->eraseFromParent();
+        eraseInstruction(Inst);
         Changed = true;
         ++NumCSELoad;
         continue;
@@ -506,11 +550,16 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
       // If we have an available version of this call, and if it is the right
       // generation, replace this instruction.
       std::pair<Value*, unsigned> InVal = AvailableCalls->lookup(Inst);
+      if (InVal.first != 0 && InVal.second != CurrentGeneration &&
+          isSameMemoryGeneration(cast<Instruction>(InVal.first), Inst)) {
+        InVal.second = CurrentGeneration;
+        ++NumCSEMemorySSA;
+      }
       if (InVal.first != 0 && InVal.second == CurrentGeneration) {
         DEBUG(dbgs() << "EarlyCSE CSE CALL: " << *Inst << "  to: "
                      << *InVal.first << '\n');
         if (!Inst->use_empty()) Inst->replaceAllUsesWith(InVal.first);
-        Inst->eraseFromParent();
+        eraseInstruction(Inst);
         Changed = true;
         ++NumCSECall;
         continue;
@@ -535,7 +584,7 @@ bool EarlyCSE::processNode(DomTreeNode *Node) {
             LastStore->getPointerOperand() == SI->getPointerOperand()) {
           DEBUG(dbgs() << "EarlyCSE DEAD STORE: " << *LastStore << "  due to: "
                        << *Inst << '\n');
-          LastStore->eraseFromParent();
+          eraseInstruction(LastStore);
           Changed = true;
           ++NumDSE;
           LastStore = 0;
@@ -567,6 +616,7 @@ bool EarlyCSE::runOnFunction(Function &F) {
   TD = getAnalysisIfAvailable<DataLayout>();
   TLI = &getAnalysis<TargetLibraryInfo>();
   DT = &getAnalysis<DominatorTree>();
+  MSSA = EnableMemorySSA ? &getAnalysis<MemorySSA>() : 0;
 
   // Tables that the pass uses when walking the domtree.
   ScopedHTType AVTable;
@@ -29,6 +29,7 @@
 #include "llvm/Analysis/Loads.h"
 #include "llvm/Analysis/MemoryBuiltins.h"
 #include "llvm/Analysis/MemoryDependenceAnalysis.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/PHITransAddr.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Assembly/Writer.h"
@@ -60,6 +61,14 @@ static cl::opt<bool> EnablePRE("enable-pre",
                                cl::init(true), cl::Hidden);
 static cl::opt<bool> EnableLoadPRE("enable-load-pre", cl::init(true));
 
+// With MemorySSA, a load is numbered by its address and the access that
+// clobbers it, so redundant loads fall out of ordinary value numbering and
+// stores forward to the loads they clobber.  Load PRE is not done.
+static cl::opt<bool>
+EnableMemorySSA("enable-gvn-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Use MemorySSA instead of MemoryDependenceAnalysis "
+                         "for loads in GVN"));
+
 // Maximum allowed recursion depth.
 static cl::opt<uint32_t>
 MaxRecurseDepth("max-recurse-depth", cl::Hidden, cl::init(1000), cl::ZeroOrMore,
@@ -120,6 +129,7 @@ namespace {
     uint32_t lookup(Value *V) const;
     uint32_t lookup_or_add_cmp(unsigned Opcode, CmpInst::Predicate Pred,
                                Value *LHS, Value *RHS);
+    uint32_t lookup_or_add_load(LoadInst *LI, const MemoryAccess *Clobber);
     void add(Value *V, uint32_t num);
     void clear();
     void erase(Value *v);
@@ -472,6 +482,22 @@ uint32_t ValueTable::lookup_or_add_cmp(unsigned Opcode,
   return e;
 }
 
+/// lookup_or_add_load - Returns the value number of a load whose memory is
+/// clobbered by the MemorySSA access Clobber.  Loads of the same type from
+/// equal addresses with the same clobber read the same value.
+uint32_t ValueTable::lookup_or_add_load(LoadInst *LI,
+                                        const MemoryAccess *Clobber) {
+  Expression exp;
+  exp.type = LI->getType();
+  exp.opcode = LI->getOpcode();
+  exp.varargs.push_back(lookup_or_add(LI->getPointerOperand()));
+  exp.varargs.push_back(Clobber->getID());
+  uint32_t& e = expressionNumbering[exp];
+  if (!e) e = nextValueNumber++;
+  valueNumbering[LI] = e;
+  return e;
+}
+
 /// clear - Remove all entries from the ValueTable.
 void ValueTable::clear() {
   valueNumbering.clear();
@@ -571,6 +597,7 @@ namespace {
   class GVN : public FunctionPass {
     bool NoLoads;
     MemoryDependenceAnalysis *MD;
+    MemorySSA *MSSA;
     DominatorTree *DT;
     const DataLayout *TD;
     const TargetLibraryInfo *TLI;
@@ -596,7 +623,7 @@ namespace {
   public:
     static char ID; // Pass identification, replacement for typeid
     explicit GVN(bool noloads = false)
-        : FunctionPass(ID), NoLoads(noloads), MD(0) {
+        : FunctionPass(ID), NoLoads(noloads), MD(0), MSSA(0) {
       initializeGVNPass(*PassRegistry::getPassRegistry());
     }
 
@@ -664,8 +691,12 @@ namespace {
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.addRequired<DominatorTree>();
       AU.addRequired<TargetLibraryInfo>();
-      if (!NoLoads)
-        AU.addRequired<MemoryDependenceAnalysis>();
+      if (!NoLoads) {
+        if (EnableMemorySSA)
+          AU.addRequired<MemorySSA>();
+        else
+          AU.addRequired<MemoryDependenceAnalysis>();
+      }
       AU.addRequired<AliasAnalysis>();
 
       AU.addPreserved<DominatorTree>();
@@ -675,6 +706,7 @@ namespace {
 
     // Helper fuctions of redundant load elimination 
     bool processLoad(LoadInst *L);
+    bool processLoadMemorySSA(LoadInst *L);
     bool processNonLocalLoad(LoadInst *L);
     void AnalyzeLoadAvailability(LoadInst *LI, LoadDepVect &Deps, 
                                  AvailValInBlkVect &ValuesPerBlock,
@@ -707,6 +739,7 @@ FunctionPass *llvm::createGVNPass(bool NoLoads) {
 
 INITIALIZE_PASS_BEGIN(GVN, "gvn", "Global Value Numbering", false, false)
 INITIALIZE_PASS_DEPENDENCY(MemoryDependenceAnalysis)
+INITIALIZE_PASS_DEPENDENCY(MemorySSA)
 INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfo)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
@@ -1765,6 +1798,8 @@ static void patchAndReplaceAllUsesWith(Instruction *I, Value *Repl) {
 /// processLoad - Attempt to eliminate a load, first by eliminating it
 /// locally, and then attempting non-local elimination if that fails.
 bool GVN::processLoad(LoadInst *L) {
+  if (MSSA)
+    return processLoadMemorySSA(L);
   if (!MD)
     return false;
 
@@ -1952,6 +1987,64 @@ bool GVN::processLoad(LoadInst *L) {
   return false;
 }
 
+/// processLoadMemorySSA - Attempt to eliminate a load using MemorySSA: forward
+/// the value of the store or memory intrinsic that clobbers it, or replace it
+/// with a dominating load of the same address with the same clobber.
+bool GVN::processLoadMemorySSA(LoadInst *L) {
+  if (!L->isSimple())
+    return false;
+
+  if (L->use_empty()) {
+    markInstructionForDeletion(L);
+    return true;
+  }
+
+  MemoryAccess *Clobber = MSSA->getWalker()->getClobberingMemoryAccess(L);
+  if (!Clobber)
+    return false;
+
+  Value *AvailVal = 0;
+  if (MemoryDef *Def = dyn_cast<MemoryDef>(Clobber)) {
+    Instruction *DepInst = Def->getMemoryInst();
+    if (StoreInst *DepSI = dyn_cast<StoreInst>(DepInst)) {
+      if (TD) {
+        int Offset = AnalyzeLoadFromClobberingStore(L->getType(),
+                                                    L->getPointerOperand(),
+                                                    DepSI, *TD);
+        if (Offset != -1)
+          AvailVal = GetStoreValueForLoad(DepSI->getValueOperand(), Offset,
+                                          L->getType(), L, *TD);
+      } else if (DepSI->getPointerOperand() == L->getPointerOperand() &&
+                 DepSI->getValueOperand()->getType() == L->getType()) {
+        AvailVal = DepSI->getValueOperand();
+      }
+    } else if (MemIntrinsic *DepMI = dyn_cast<MemIntrinsic>(DepInst)) {
+      if (TD) {
+        int Offset = AnalyzeLoadFromClobberingMemInst(L->getType(),
+                                                      L->getPointerOperand(),
+                                                      DepMI, *TD);
+        if (Offset != -1)
+          AvailVal = GetMemInstValueForLoad(DepMI, Offset, L->getType(), L,
+                                            *TD);
+      }
+    }
+  }
+
+  if (!AvailVal) {
+    uint32_t Num = VN.lookup_or_add_load(L, Clobber);
+    AvailVal = findLeader(L->getParent(), Num);
+    if (!AvailVal)
+      return false;
+  }
+
+  DEBUG(dbgs() << "GVN MEMORYSSA LOAD: " << *L << "  to: " << *AvailVal
+               << '\n');
+  patchAndReplaceAllUsesWith(L, AvailVal);
+  markInstructionForDeletion(L);
+  ++NumGVNLoad;
+  return true;
+}
+
 // findLeader - In order to find a leader for a given value number at a
 // specific basic block, we first obtain the list of all Values for that number,
 // and then scan the list to find one whose block dominates the block in
@@ -2270,8 +2363,14 @@ bool GVN::processInstruction(Instruction *I) {
 
 /// runOnFunction - This is the main transformation entry point for a function.
 bool GVN::runOnFunction(Function& F) {
-  if (!NoLoads)
-    MD = &getAnalysis<MemoryDependenceAnalysis>();
+  MD = 0;
+  MSSA = 0;
+  if (!NoLoads) {
+    if (EnableMemorySSA)
+      MSSA = &getAnalysis<MemorySSA>();
+    else
+      MD = &getAnalysis<MemoryDependenceAnalysis>();
+  }
   DT = &getAnalysis<DominatorTree>();
   TD = getAnalysisIfAvailable<DataLayout>();
   TLI = &getAnalysis<TargetLibraryInfo>();
@@ -2293,6 +2392,11 @@ bool GVN::runOnFunction(Function& F) {
     Changed |= removedBlock;
   }
 
+  // MemorySSA does not follow instructions into the blocks they were merged
+  // into, so start it over.
+  if (MSSA && Changed)
+    MSSA->recalculate();
+
   unsigned Iteration = 0;
   while (ShouldContinue) {
     DEBUG(dbgs() << "GVN iteration: " << Iteration << "\n");
@@ -2348,6 +2452,7 @@ bool GVN::processBlock(BasicBlock *BB) {
          E = InstrsToErase.end(); I != E; ++I) {
       DEBUG(dbgs() << "GVN removed: " << **I << '\n');
       if (MD) MD->removeInstruction(*I);
+      if (MSSA) MSSA->removeInstruction(*I);
       DEBUG(verifyRemoved(*I));
       (*I)->eraseFromParent();
     }
@@ -2553,6 +2658,7 @@ bool GVN::splitCriticalEdges() {
     SplitCriticalEdge(Edge.first, Edge.second, this);
   } while (!toSplit.empty());
   if (MD) MD->invalidateCachedPredecessors();
+  if (MSSA) MSSA->recalculate();
   return true;
 }
 
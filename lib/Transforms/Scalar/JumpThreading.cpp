@@ -20,6 +20,7 @@
 #include "llvm/ADT/SmallSet.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/ConstantFolding.h"
+#include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LazyValueInfo.h"
 #include "llvm/Analysis/Loads.h"
@@ -78,6 +79,7 @@ namespace {
     DataLayout *TD;
     TargetLibraryInfo *TLI;
     LazyValueInfo *LVI;
+    DominatorTree *DT;  // Kept up to date if available, null otherwise.
 #ifdef NDEBUG
     SmallPtrSet<BasicBlock*, 16> LoopHeaders;
 #else
@@ -109,6 +111,7 @@ namespace {
     virtual void getAnalysisUsage(AnalysisUsage &AU) const {
       AU.addRequired<LazyValueInfo>();
       AU.addPreserved<LazyValueInfo>();
+      AU.addPreserved<DominatorTree>();
       AU.addRequired<TargetLibraryInfo>();
     }
 
@@ -129,6 +132,9 @@ namespace {
     bool ProcessBranchOnXOR(BinaryOperator *BO);
 
     bool SimplifyPartiallyRedundantLoad(LoadInst *LI);
+
+    void RemoveDeadSuccessorEdges(BasicBlock *BB,
+                                  const SmallVectorImpl<BasicBlock*> &OldSuccs);
   };
 }
 
@@ -150,6 +156,7 @@ bool JumpThreading::runOnFunction(Function &F) {
   TD = getAnalysisIfAvailable<DataLayout>();
   TLI = &getAnalysis<TargetLibraryInfo>();
   LVI = &getAnalysis<LazyValueInfo>();
+  DT = getAnalysisIfAvailable<DominatorTree>();
 
   FindLoopHeaders(F);
 
@@ -197,8 +204,17 @@ bool JumpThreading::runOnFunction(Function &F) {
         // awesome, but it allows us to use AssertingVH to prevent nasty
         // dangling pointer issues within LazyValueInfo.
         LVI->eraseBlock(BB);
+        DomTreeNode *BBNode = DT ? DT->getNode(BB) : 0;
+        DomTreeNode *SuccNode = DT ? DT->getNode(Succ) : 0;
         if (TryToSimplifyUncondBranchFromEmptyBlock(BB)) {
           Changed = true;
+          // The predecessors of BB now branch to Succ, so if BB dominated
+          // Succ, BB's immediate dominator does now.  Nothing else changes.
+          if (BBNode) {
+            if (SuccNode->getIDom() == BBNode)
+              DT->changeImmediateDominator(SuccNode, BBNode->getIDom());
+            DT->eraseNode(BB);
+          }
           // If we deleted BB and BB was the header of a loop, then the
           // successor is now the header of the loop.
           BB = Succ;
@@ -657,7 +673,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
       // will need to move BB back to the entry position.
       bool isEntry = SinglePred == &SinglePred->getParent()->getEntryBlock();
       LVI->eraseBlock(SinglePred);
-      MergeBasicBlockIntoOnlyPred(BB);
+      MergeBasicBlockIntoOnlyPred(BB, this);
 
       if (isEntry && BB != &BB->getParent()->getEntryBlock())
         BB->moveBefore(&BB->getParent()->getEntryBlock());
@@ -705,6 +721,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
 
     // Fold the branch/switch.
     TerminatorInst *BBTerm = BB->getTerminator();
+    SmallVector<BasicBlock*, 4> OldSuccs(succ_begin(BB), succ_end(BB));
     for (unsigned i = 0, e = BBTerm->getNumSuccessors(); i != e; ++i) {
       if (i == BestSucc) continue;
       BBTerm->getSuccessor(i)->removePredecessor(BB, true);
@@ -714,6 +731,7 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
           << "' folding undef terminator: " << *BBTerm << '\n');
     BranchInst::Create(BBTerm->getSuccessor(BestSucc), BBTerm);
     BBTerm->eraseFromParent();
+    RemoveDeadSuccessorEdges(BB, OldSuccs);
     return true;
   }
 
@@ -724,7 +742,9 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
     DEBUG(dbgs() << "  In block '" << BB->getName()
           << "' folding terminator: " << *BB->getTerminator() << '\n');
     ++NumFolds;
+    SmallVector<BasicBlock*, 4> OldSuccs(succ_begin(BB), succ_end(BB));
     ConstantFoldTerminator(BB, true);
+    RemoveDeadSuccessorEdges(BB, OldSuccs);
     return true;
   }
 
@@ -769,9 +789,11 @@ bool JumpThreading::ProcessBlock(BasicBlock *BB) {
         if (PI == PE) {
           unsigned ToRemove = Baseline == LazyValueInfo::True ? 1 : 0;
           unsigned ToKeep = Baseline == LazyValueInfo::True ? 0 : 1;
+          SmallVector<BasicBlock*, 2> OldSuccs(succ_begin(BB), succ_end(BB));
           CondBr->getSuccessor(ToRemove)->removePredecessor(BB, true);
           BranchInst::Create(CondBr->getSuccessor(ToKeep), CondBr);
           CondBr->eraseFromParent();
+          RemoveDeadSuccessorEdges(BB, OldSuccs);
           return true;
         }
       }
@@ -1461,6 +1483,15 @@ bool JumpThreading::ThreadEdge(BasicBlock *BB,
       PredTerm->setSuccessor(i, NewBB);
     }
 
+  if (DT) {
+    DominatorTree::UpdateType Updates[] = {
+      DominatorTree::UpdateType(DominatorTree::Delete, PredBB, BB),
+      DominatorTree::UpdateType(DominatorTree::Insert, PredBB, NewBB),
+      DominatorTree::UpdateType(DominatorTree::Insert, NewBB, SuccBB)
+    };
+    DT->applyUpdates(Updates);
+  }
+
   // At this point, the IR is fully up to date and consistent.  Do a quick scan
   // over the new instructions and zap any that are constants or dead.  This
   // frequently happens because of phi translation.
@@ -1611,8 +1642,34 @@ bool JumpThreading::DuplicateCondBranchOnPHIIntoPred(BasicBlock *BB,
   // Remove the unconditional branch at the end of the PredBB block.
   OldPredBranch->eraseFromParent();
 
+  // PredBB now branches where BB does.
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 4> Updates;
+    Updates.push_back(DominatorTree::UpdateType(DominatorTree::Delete,
+                                                PredBB, BB));
+    for (succ_iterator SI = succ_begin(PredBB), SE = succ_end(PredBB);
+         SI != SE; ++SI)
+      Updates.push_back(DominatorTree::UpdateType(DominatorTree::Insert,
+                                                  PredBB, *SI));
+    DT->applyUpdates(Updates);
+  }
+
   ++NumDupes;
   return true;
 }
 
-
+/// RemoveDeadSuccessorEdges - The terminator of BB was folded, and its
+/// successors used to be OldSuccs.  Tell the dominator tree about the edges
+/// that are gone.
+void JumpThreading::RemoveDeadSuccessorEdges(BasicBlock *BB,
+                                const SmallVectorImpl<BasicBlock*> &OldSuccs) {
+  if (!DT)
+    return;
+  SmallPtrSet<BasicBlock*, 4> Seen(succ_begin(BB), succ_end(BB));
+  SmallVector<DominatorTree::UpdateType, 4> Updates;
+  for (unsigned i = 0, e = OldSuccs.size(); i != e; ++i)
+    if (Seen.insert(OldSuccs[i]))
+      Updates.push_back(DominatorTree::UpdateType(DominatorTree::Delete, BB,
+                                                  OldSuccs[i]));
+  DT->applyUpdates(Updates);
+}
@@ -39,6 +39,7 @@
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/LoopInfo.h"
 #include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/DataLayout.h"
@@ -67,6 +68,14 @@ static cl::opt<bool>
 DisablePromotion("disable-licm-promotion", cl::Hidden,
                  cl::desc("Disable memory promotion in LICM pass"));
 
+// With MemorySSA, a load is invariant if the access clobbering it is outside
+// the loop, and a read-only call if its defining access is.  Promotion still
+// uses the alias sets and rebuilds MemorySSA when it changes the loop.
+static cl::opt<bool>
+EnableMemorySSA("enable-licm-memoryssa", cl::init(false), cl::Hidden,
+                cl::desc("Use MemorySSA to find invariant loads and calls in "
+                         "LICM"));
+
 namespace {
   struct LICM : public LoopPass {
     static char ID; // Pass identification, replacement for typeid
@@ -89,6 +98,10 @@ namespace {
       AU.addPreserved("scalar-evolution");
       AU.addPreservedID(LoopSimplifyID);
       AU.addRequired<TargetLibraryInfo>();
+      if (EnableMemorySSA) {
+        AU.addRequired<MemorySSA>();
+        AU.addPreserved<MemorySSA>();
+      }
     }
 
     using llvm::Pass::doFinalization;
@@ -102,6 +115,7 @@ namespace {
     AliasAnalysis *AA;       // Current AliasAnalysis information
     LoopInfo      *LI;       // Current LoopInfo
     DominatorTree *DT;       // Dominator Tree for the current Loop.
+    MemorySSA     *MSSA;     // MemorySSA, if enabled; kept up to date.
 
     DataLayout *TD;          // DataLayout for constant folding.
     TargetLibraryInfo *TLI;  // TargetLibraryInfo for constant folding.
@@ -178,6 +192,22 @@ namespace {
       return CurAST->getAliasSetForPointer(V, Size, TBAAInfo).isMod();
     }
 
+    /// accessInvalidatedByLoop - Return true if the memory that I reads may
+    /// be changed in the loop, according to MemorySSA.
+    bool accessInvalidatedByLoop(Instruction *I);
+
+    /// getHoistedDefiningAccess - Return the MemorySSA access that the load
+    /// or call I reads after it is hoisted to the preheader.
+    MemoryAccess *getHoistedDefiningAccess(Instruction &I);
+
+    /// eraseInstruction - Erase I, first removing it from the alias sets and
+    /// from MemorySSA.
+    void eraseInstruction(Instruction &I) {
+      CurAST->deleteValue(&I);
+      if (MSSA) MSSA->removeInstruction(&I);
+      I.eraseFromParent();
+    }
+
     bool canSinkOrHoistInst(Instruction &I);
     bool isNotUsedInLoop(Instruction &I);
 
@@ -191,6 +221,7 @@ char LICM::ID = 0;
 INITIALIZE_PASS_BEGIN(LICM, "licm", "Loop Invariant Code Motion", false, false)
 INITIALIZE_PASS_DEPENDENCY(DominatorTree)
 INITIALIZE_PASS_DEPENDENCY(LoopInfo)
+INITIALIZE_PASS_DEPENDENCY(MemorySSA)
 INITIALIZE_PASS_DEPENDENCY(LoopSimplify)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfo)
 INITIALIZE_AG_DEPENDENCY(AliasAnalysis)
@@ -209,6 +240,7 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
   LI = &getAnalysis<LoopInfo>();
   AA = &getAnalysis<AliasAnalysis>();
   DT = &getAnalysis<DominatorTree>();
+  MSSA = EnableMemorySSA ? &getAnalysis<MemorySSA>() : 0;
 
   TD = getAnalysisIfAvailable<DataLayout>();
   TLI = &getAnalysis<TargetLibraryInfo>();
@@ -277,9 +309,17 @@ bool LICM::runOnLoop(Loop *L, LPPassManager &LPM) {
     SmallVector<Instruction *, 8> InsertPts;
 
     // Loop over all of the alias sets in the tracker object.
+    bool ChangedBeforePromotion = Changed;
+    Changed = false;
     for (AliasSetTracker::iterator I = CurAST->begin(), E = CurAST->end();
          I != E; ++I)
       PromoteAliasSet(*I, ExitBlocks, InsertPts);
+
+    // Promotion rewrites loads and stores throughout the loop and adds stores
+    // on the exits, which MemorySSA cannot follow incrementally.
+    if (MSSA && Changed)
+      MSSA->recalculate();
+    Changed |= ChangedBeforePromotion;
   }
 
   // Clear out loops state information for the next iteration
@@ -325,8 +365,7 @@ void LICM::SinkRegion(DomTreeNode *N) {
     if (isInstructionTriviallyDead(&I, TLI)) {
       DEBUG(dbgs() << "LICM deleting dead inst: " << I << '\n');
       ++II;
-      CurAST->deleteValue(&I);
-      I.eraseFromParent();
+      eraseInstruction(I);
       Changed = true;
       continue;
     }
@@ -336,7 +375,11 @@ void LICM::SinkRegion(DomTreeNode *N) {
     // outside of the loop.  In this case, it doesn't even matter if the
     // operands of the instruction are loop invariant.
     //
-    if (isNotUsedInLoop(I) && canSinkOrHoistInst(I)) {
+    // With MemorySSA, loads and calls are only hoisted: a sunk instruction
+    // may be cloned into several exits, and MemorySSA cannot give the copies
+    // accesses of their own.
+    if (isNotUsedInLoop(I) && canSinkOrHoistInst(I) &&
+        !(MSSA && MSSA->getMemoryAccess(&I))) {
       ++II;
       sink(I);
     }
@@ -367,9 +410,8 @@ void LICM::HoistRegion(DomTreeNode *N) {
       if (Constant *C = ConstantFoldInstruction(&I, TD, TLI)) {
         DEBUG(dbgs() << "LICM folding inst: " << I << "  --> " << *C << '\n');
         CurAST->copyValue(&I, C);
-        CurAST->deleteValue(&I);
         I.replaceAllUsesWith(C);
-        I.eraseFromParent();
+        eraseInstruction(I);
         continue;
       }
 
@@ -404,6 +446,8 @@ bool LICM::canSinkOrHoistInst(Instruction &I) {
       return true;
 
     // Don't hoist loads which have may-aliased stores in loop.
+    if (MSSA)
+      return !accessInvalidatedByLoop(LI);
     uint64_t Size = 0;
     if (LI->getType()->isSized())
       Size = AA->getTypeStoreSize(LI->getType());
@@ -418,6 +462,8 @@ bool LICM::canSinkOrHoistInst(Instruction &I) {
     AliasAnalysis::ModRefBehavior Behavior = AA->getModRefBehavior(CI);
     if (Behavior == AliasAnalysis::DoesNotAccessMemory)
       return true;
+    if (AliasAnalysis::onlyReadsMemory(Behavior) && MSSA)
+      return !accessInvalidatedByLoop(CI);
     if (AliasAnalysis::onlyReadsMemory(Behavior)) {
       // If this call only reads from memory and there are no writes to memory
       // in the loop, we can hoist or sink the call as appropriate.
@@ -450,6 +496,36 @@ bool LICM::canSinkOrHoistInst(Instruction &I) {
   return isSafeToExecuteUnconditionally(I);
 }
 
+/// accessInvalidatedByLoop - Return true if the memory that the load or
+/// read-only call I reads may be changed in the loop.  The access clobbering
+/// I dominates it, so if it is outside the loop it dominates the preheader too.
+bool LICM::accessInvalidatedByLoop(Instruction *I) {
+  MemoryAccess *Clobber = MSSA->getWalker()->getClobberingMemoryAccess(I);
+  if (!Clobber)
+    return true;
+  return !MSSA->isLiveOnEntryDef(Clobber) &&
+         CurLoop->contains(Clobber->getBlock());
+}
+
+/// getHoistedDefiningAccess - Return the access that the load or call I reads
+/// once hoisted to the end of the preheader.  Normally this is the access that
+/// clobbers I, which is outside the loop.  Loads of constant memory may be
+/// hoisted past clobbers in the loop; they read the state entering the loop,
+/// which is what the header's phi receives from the preheader.
+MemoryAccess *LICM::getHoistedDefiningAccess(Instruction &I) {
+  MemoryAccess *Clobber = MSSA->getWalker()->getClobberingMemoryAccess(&I);
+  if (MSSA->isLiveOnEntryDef(Clobber) ||
+      !CurLoop->contains(Clobber->getBlock()))
+    return Clobber;
+
+  MemoryPhi *Phi = MSSA->getMemoryAccess(CurLoop->getHeader());
+  assert(Phi && "Loop with a def has no phi in its header!");
+  for (unsigned i = 0, e = Phi->getNumIncomingValues(); i != e; ++i)
+    if (Phi->getIncomingBlock(i) == Preheader)
+      return Phi->getIncomingValue(i);
+  llvm_unreachable("Preheader is not a predecessor of the header!");
+}
+
 /// isNotUsedInLoop - Return true if the only users of this instruction are
 /// outside of the loop.  If this is true, we can sink the instruction to the
 /// exit blocks of the loop.
@@ -602,6 +678,9 @@ void LICM::hoist(Instruction &I) {
         << I << "\n");
 
   // Move the new node to the Preheader, before its terminator.
+  if (MSSA)
+    if (MemoryUse *MU = dyn_cast_or_null<MemoryUse>(MSSA->getMemoryAccess(&I)))
+      MSSA->moveUseToBlockEnd(MU, Preheader, getHoistedDefiningAccess(I));
   I.moveBefore(Preheader->getTerminator());
 
   if (isa<LoadInst>(I)) ++NumMovedLoads;
@@ -209,7 +209,7 @@ namespace {
     void EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
                                         BasicBlock *TrueDest,
                                         BasicBlock *FalseDest,
-                                        Instruction *InsertPt);
+                                        BranchInst *OldBranch, Loop *L);
 
     void SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L);
     void RemoveBlockIfDead(BasicBlock *BB,
@@ -388,7 +388,6 @@ bool LoopUnswitch::runOnLoop(Loop *L, LPPassManager &LPM_Ref) {
   LPM = &LPM_Ref;
   DT = getAnalysisIfAvailable<DominatorTree>();
   currentLoop = L;
-  Function *F = currentLoop->getHeader()->getParent();
   bool Changed = false;
   do {
     assert(currentLoop->isLCSSAForm(*DT));
@@ -396,11 +395,6 @@ bool LoopUnswitch::runOnLoop(Loop *L, LPPassManager &LPM_Ref) {
     Changed |= processCurrentLoop();
   } while(redoLoop);
 
-  if (Changed) {
-    // FIXME: Reconstruct dom info, because it is not preserved properly.
-    if (DT)
-      DT->runOnFunction(*F);
-  }
   return Changed;
 }
 
@@ -678,12 +672,15 @@ static Loop *CloneLoop(Loop *L, Loop *PL, ValueToValueMapTy &VM,
 }
 
 /// EmitPreheaderBranchOnCondition - Emit a conditional branch on two values
-/// if LIC == Val, branch to TrueDst, otherwise branch to FalseDest.  Insert the
-/// code immediately before InsertPt.
+/// if LIC == Val, branch to TrueDst, otherwise branch to FalseDest.  The new
+/// branch replaces the unconditional branch OldBranch.
 void LoopUnswitch::EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
                                                   BasicBlock *TrueDest,
                                                   BasicBlock *FalseDest,
-                                                  Instruction *InsertPt) {
+                                                  BranchInst *OldBranch,
+                                                  Loop *L) {
+  assert(OldBranch->isUnconditional() && "Preheader is not split correctly");
+  Instruction *InsertPt = OldBranch;
   // Insert a conditional branch on LIC to the two preheaders.  The original
   // code is the true version and the new code is the false version.
   Value *BranchVal = LIC;
@@ -697,6 +694,27 @@ void LoopUnswitch::EmitPreheaderBranchOnCondition(Value *LIC, Constant *Val,
   // Insert the new branch.
   BranchInst *BI = BranchInst::Create(TrueDest, FalseDest, BranchVal, InsertPt);
 
+  // Remove the old branch, so the block has a single terminator again.
+  BasicBlock *OldBranchParent = OldBranch->getParent();
+  BasicBlock *OldBranchSucc = OldBranch->getSuccessor(0);
+  LPM->deleteSimpleAnalysisValue(OldBranch, L);
+  OldBranch->eraseFromParent();
+
+  if (DT) {
+    SmallVector<DominatorTree::UpdateType, 3> Updates;
+    if (TrueDest != OldBranchSucc)
+      Updates.push_back(DominatorTree::UpdateType(DominatorTree::Insert,
+                                                  OldBranchParent, TrueDest));
+    if (FalseDest != OldBranchSucc)
+      Updates.push_back(DominatorTree::UpdateType(DominatorTree::Insert,
+                                                  OldBranchParent, FalseDest));
+    if (TrueDest != OldBranchSucc && FalseDest != OldBranchSucc)
+      Updates.push_back(DominatorTree::UpdateType(DominatorTree::Delete,
+                                                  OldBranchParent,
+                                                  OldBranchSucc));
+    DT->applyUpdates(Updates);
+  }
+
   // If either edge is critical, split it. This helps preserve LoopSimplify
   // form for enclosing loops.
   SplitCriticalEdge(BI, 0, this, false, false, true);
@@ -735,9 +753,7 @@ void LoopUnswitch::UnswitchTrivialCondition(Loop *L, Value *Cond,
   // Okay, now we have a position to branch from and a position to branch to,
   // insert the new conditional branch.
   EmitPreheaderBranchOnCondition(Cond, Val, NewExit, NewPH,
-                                 loopPreheader->getTerminator());
-  LPM->deleteSimpleAnalysisValue(loopPreheader->getTerminator(), L);
-  loopPreheader->getTerminator()->eraseFromParent();
+                          cast<BranchInst>(loopPreheader->getTerminator()), L);
 
   // We need to reprocess this loop, it could be unswitched again.
   redoLoop = true;
@@ -889,9 +905,8 @@ void LoopUnswitch::UnswitchNontrivialCondition(Value *LIC, Constant *Val,
          "Preheader splitting did not work correctly!");
 
   // Emit the new branch that selects between the two versions of this loop.
-  EmitPreheaderBranchOnCondition(LIC, Val, NewBlocks[0], LoopBlocks[0], OldBR);
-  LPM->deleteSimpleAnalysisValue(OldBR, L);
-  OldBR->eraseFromParent();
+  EmitPreheaderBranchOnCondition(LIC, Val, NewBlocks[0], LoopBlocks[0], OldBR,
+                                 L);
 
   LoopProcessWorklist.push_back(NewLoop);
   redoLoop = true;
@@ -1180,10 +1195,7 @@ void LoopUnswitch::RewriteLoopBodyWithConditionConstant(Loop *L, Value *LIC,
          PHINode *PN = dyn_cast<PHINode>(II); ++II)
       PN->setIncomingValue(PN->getBasicBlockIndex(Switch),
                            UndefValue::get(PN->getType()));
-    // Tell the domtree about the new block. We don't fully update the
-    // domtree here -- instead we force it to do a full recomputation
-    // after the pass is complete -- but we do need to inform it of
-    // new blocks.
+    // Abort is reached only from NewSISucc; nothing else changes.
     if (DT)
       DT->addNewBlock(Abort, NewSISucc);
   }
@@ -1251,6 +1263,17 @@ void LoopUnswitch::SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L) {
         // entries coming from Pred instead of Succ.
         Succ->replaceAllUsesWith(Pred);
 
+        // Pred dominates Succ, so it takes over Succ's children.
+        if (DT)
+          if (DomTreeNode *SuccNode = DT->getNode(Succ)) {
+            DomTreeNode *PredNode = DT->getNode(Pred);
+            SmallVector<DomTreeNode*, 8> Children(SuccNode->begin(),
+                                                 SuccNode->end());
+            for (unsigned i = 0, e = Children.size(); i != e; ++i)
+              DT->changeImmediateDominator(Children[i], PredNode);
+            DT->eraseNode(Succ);
+          }
+
         // Move all of the successor contents from Succ to Pred.
         Pred->getInstList().splice(BI, Succ->getInstList(), Succ->begin(),
                                    Succ->end());
@@ -1274,12 +1297,15 @@ void LoopUnswitch::SimplifyCode(std::vector<Instruction*> &Worklist, Loop *L) {
         DEBUG(dbgs() << "Folded branch: " << *BI);
         BasicBlock *DeadSucc = BI->getSuccessor(CB->getZExtValue());
         BasicBlock *LiveSucc = BI->getSuccessor(!CB->getZExtValue());
-        DeadSucc->removePredecessor(BI->getParent(), true);
+        BasicBlock *BIParent = BI->getParent();
+        DeadSucc->removePredecessor(BIParent, true);
         Worklist.push_back(BranchInst::Create(LiveSucc, BI));
         LPM->deleteSimpleAnalysisValue(BI, L);
         BI->eraseFromParent();
         RemoveFromWorklist(BI, Worklist);
         ++NumSimplify;
+        if (DT && DeadSucc != LiveSucc)
+          DT->deleteEdge(BIParent, DeadSucc);
 
         RemoveBlockIfDead(DeadSucc, Worklist, L);
       }
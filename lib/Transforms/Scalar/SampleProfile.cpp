@@ -0,0 +1,251 @@
+//===- SampleProfile.cpp - Incorporate sample profiles into the IR --------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements the SampleProfileLoader pass, which reads a profile
+// collected by a sampling profiler (such as Linux perf) and annotates the
+// conditional branches of each profiled function with branch_weights
+// metadata.  BranchProbabilityInfo picks the weights up from there, so the
+// optimizer sees the hotness of the profiled run without an instrumented
+// build.
+//
+// The profile is a text file with one section per function:
+//
+//    function_name:total_samples:head_samples
+//    offset: samples
+//    offset: samples
+//    ...
+//
+// where each offset is a source line relative to the line that declares the
+// function, so that a profile survives edits elsewhere in the file.  Samples
+// are matched to instructions through their DebugLoc, and the weight of a
+// basic block is the largest sample count among its instructions.  The
+// llvm-perf2prof tool builds this file from 'perf script' output.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "sample-profile"
+#include "llvm/Transforms/Scalar.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/DebugInfo.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Debug.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <cctype>
+using namespace llvm;
+
+STATISTIC(NumProfiledFunctions, "Number of functions with a sample profile");
+STATISTIC(NumAnnotatedBranches, "Number of branches given sample weights");
+
+static cl::opt<std::string>
+SampleProfileFile("sample-profile-file", cl::init(""),
+                  cl::value_desc("filename"),
+                  cl::desc("Profile file loaded by -sample-profile"),
+                  cl::Hidden);
+
+namespace {
+  /// FunctionSamples - The samples collected for one function.  BodySamples
+  /// maps a line offset from the start of the function to the number of
+  /// samples taken on that line.
+  struct FunctionSamples {
+    unsigned TotalSamples;
+    unsigned TotalHeadSamples;
+    DenseMap<unsigned, unsigned> BodySamples;
+
+    FunctionSamples() : TotalSamples(0), TotalHeadSamples(0) {}
+  };
+
+  class SampleProfileLoader : public FunctionPass {
+    /// Filename - The profile to read; defaults to -sample-profile-file.
+    std::string Filename;
+
+    /// Profiles - The samples of every function in the profile, by name.
+    StringMap<FunctionSamples> Profiles;
+
+    void loadProfile();
+    unsigned getHeaderLine(Function &F) const;
+    unsigned getBlockWeight(BasicBlock &BB, unsigned HeaderLine,
+                            const FunctionSamples &Samples) const;
+
+  public:
+    static char ID; // Pass identification, replacement for typeid
+    explicit SampleProfileLoader(StringRef Name = "")
+      : FunctionPass(ID),
+        Filename(Name.empty() ? StringRef(SampleProfileFile) : Name) {
+      initializeSampleProfileLoaderPass(*PassRegistry::getPassRegistry());
+    }
+
+    virtual bool doInitialization(Module &M);
+    virtual bool runOnFunction(Function &F);
+
+    virtual void getAnalysisUsage(AnalysisUsage &AU) const {
+      AU.setPreservesCFG();
+    }
+  };
+}
+
+char SampleProfileLoader::ID = 0;
+INITIALIZE_PASS(SampleProfileLoader, "sample-profile",
+                "Sample Profile loader", false, false)
+
+FunctionPass *llvm::createSampleProfileLoaderPass(StringRef Name) {
+  return new SampleProfileLoader(Name);
+}
+
+/// loadProfile - Parse the profile in Filename into Profiles.  A malformed
+/// profile is a fatal error: silently dropping part of it would lead to
+/// misleading branch weights.
+void SampleProfileLoader::loadProfile() {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFile(Filename, Buffer))
+    report_fatal_error("Could not open sample profile '" + Filename + "': " +
+                       EC.message());
+
+  FunctionSamples *Current = 0;
+  StringRef Rest = Buffer->getBuffer();
+  for (unsigned LineNo = 1; !Rest.empty(); ++LineNo) {
+    std::pair<StringRef, StringRef> Split = Rest.split('\n');
+    StringRef Line = Split.first.trim();
+    Rest = Split.second;
+    if (Line.empty() || Line[0] == '#')
+      continue;
+
+    // A body line is 'offset: samples'.  Function names may contain ':'
+    // themselves, so tell the two kinds of line apart by the leading digit.
+    if (isdigit(static_cast<unsigned char>(Line[0]))) {
+      std::pair<StringRef, StringRef> Fields = Line.split(':');
+      unsigned Offset, Count;
+      if (!Current || Fields.first.trim().getAsInteger(10, Offset) ||
+          Fields.second.trim().getAsInteger(10, Count))
+        report_fatal_error(Filename + ":" + Twine(LineNo) +
+                           ": malformed sample line '" + Line + "'");
+      Current->BodySamples[Offset] += Count;
+      continue;
+    }
+
+    // A header line is 'function_name:total_samples:head_samples'.
+    std::pair<StringRef, StringRef> Head = Line.rsplit(':');
+    std::pair<StringRef, StringRef> Total = Head.first.rsplit(':');
+    unsigned TotalSamples, HeadSamples;
+    if (Total.first.empty() || Total.second.getAsInteger(10, TotalSamples) ||
+        Head.second.getAsInteger(10, HeadSamples))
+      report_fatal_error(Filename + ":" + Twine(LineNo) +
+                         ": malformed function header '" + Line + "'");
+    Current = &Profiles[Total.first];
+    Current->TotalSamples += TotalSamples;
+    Current->TotalHeadSamples += HeadSamples;
+  }
+
+  DEBUG(dbgs() << "Read sample profile for " << Profiles.size()
+               << " functions from " << Filename << "\n");
+}
+
+bool SampleProfileLoader::doInitialization(Module &M) {
+  if (Filename.empty())
+    report_fatal_error("No sample profile given; use -sample-profile-file");
+  Profiles.clear();
+  loadProfile();
+  return false;
+}
+
+/// getHeaderLine - Return the line of the subprogram that describes F, which
+/// is the line every offset in the profile is relative to, or 0 if F has no
+/// debug information.
+unsigned SampleProfileLoader::getHeaderLine(Function &F) const {
+  LLVMContext &Ctx = F.getContext();
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    for (BasicBlock::iterator I = BB->begin(), IE = BB->end(); I != IE; ++I) {
+      DebugLoc DL = I->getDebugLoc();
+      if (DL.isUnknown())
+        continue;
+      DISubprogram SP = getDISubprogram(DL.getScope(Ctx));
+      if (SP.Verify() && SP.describes(&F))
+        return SP.getLineNumber();
+    }
+  return 0;
+}
+
+/// getBlockWeight - Return the largest sample count among the instructions
+/// of BB.  Instructions inlined from another function carry that function's
+/// lines, which have no meaning relative to HeaderLine, so they are ignored.
+unsigned
+SampleProfileLoader::getBlockWeight(BasicBlock &BB, unsigned HeaderLine,
+                                    const FunctionSamples &Samples) const {
+  LLVMContext &Ctx = BB.getContext();
+  unsigned Weight = 0;
+  for (BasicBlock::iterator I = BB.begin(), E = BB.end(); I != E; ++I) {
+    DebugLoc DL = I->getDebugLoc();
+    if (DL.isUnknown() || DL.getInlinedAt(Ctx) || DL.getLine() < HeaderLine)
+      continue;
+    unsigned Count = Samples.BodySamples.lookup(DL.getLine() - HeaderLine);
+    Weight = std::max(Weight, Count);
+  }
+  return Weight;
+}
+
+bool SampleProfileLoader::runOnFunction(Function &F) {
+  StringMap<FunctionSamples>::const_iterator PI = Profiles.find(F.getName());
+  if (PI == Profiles.end())
+    return false;
+  const FunctionSamples &Samples = PI->getValue();
+
+  unsigned HeaderLine = getHeaderLine(F);
+  if (!HeaderLine)
+    return false;
+  ++NumProfiledFunctions;
+
+  DenseMap<BasicBlock *, unsigned> BlockWeights;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB)
+    BlockWeights[BB] = getBlockWeight(*BB, HeaderLine, Samples);
+
+  // Weigh every edge out of a branch or switch by the samples taken in its
+  // destination, which is the closest the profile gets to edge counts.
+  MDBuilder MDB(F.getContext());
+  bool Changed = false;
+  for (Function::iterator BB = F.begin(), E = F.end(); BB != E; ++BB) {
+    TerminatorInst *TI = BB->getTerminator();
+    if (TI->getNumSuccessors() < 2 ||
+        (!isa<BranchInst>(TI) && !isa<SwitchInst>(TI)))
+      continue;
+
+    SmallVector<uint32_t, 4> Weights;
+    bool AnySamples = false;
+    for (unsigned i = 0, e = TI->getNumSuccessors(); i != e; ++i) {
+      unsigned Weight = BlockWeights.lookup(TI->getSuccessor(i));
+      AnySamples |= Weight != 0;
+      // A successor without samples is cold, not impossible.
+      Weights.push_back(std::max(1U, Weight));
+    }
+    if (!AnySamples)
+      continue;
+
+    TI->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(Weights));
+    ++NumAnnotatedBranches;
+    Changed = true;
+  }
+
+  DEBUG(dbgs() << "Annotated " << F.getName() << " from its sample profile ("
+               << Samples.TotalSamples << " samples)\n");
+  return Changed;
+}
@@ -508,12 +508,20 @@ void llvm::MergeBasicBlockIntoOnlyPred(BasicBlock *DestBB, Pass *P) {
   PredBB->getTerminator()->eraseFromParent();
   DestBB->getInstList().splice(DestBB->begin(), PredBB->getInstList());
 
+  bool ReplacedEntry = false;
+  DominatorTree *DT = 0;
   if (P) {
-    DominatorTree *DT = P->getAnalysisIfAvailable<DominatorTree>();
+    DT = P->getAnalysisIfAvailable<DominatorTree>();
     if (DT) {
-      BasicBlock *PredBBIDom = DT->getNode(PredBB)->getIDom()->getBlock();
-      DT->changeImmediateDominator(DestBB, PredBBIDom);
-      DT->eraseNode(PredBB);
+      if (DomTreeNode *PredNode = DT->getNode(PredBB)) {
+        if (DomTreeNode *PredBBIDom = PredNode->getIDom()) {
+          DT->changeImmediateDominator(DT->getNode(DestBB), PredBBIDom);
+          DT->eraseNode(PredBB);
+        } else {
+          // DestBB becomes the entry block, which is the root of the tree.
+          ReplacedEntry = true;
+        }
+      }
     }
     ProfileInfo *PI = P->getAnalysisIfAvailable<ProfileInfo>();
     if (PI) {
@@ -522,7 +530,13 @@ void llvm::MergeBasicBlockIntoOnlyPred(BasicBlock *DestBB, Pass *P) {
     }
   }
   // Nuke BB.
+  Function *F = DestBB->getParent();
   PredBB->eraseFromParent();
+
+  if (ReplacedEntry) {
+    DestBB->moveBefore(&F->getEntryBlock());
+    DT->getBase().recalculate(*F);
+  }
 }
 
 /// CanPropagatePredecessorsForPHIs - Return true if we can fold BB, an
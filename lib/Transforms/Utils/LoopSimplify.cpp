@@ -48,6 +48,7 @@
 #include "llvm/Analysis/Dominators.h"
 #include "llvm/Analysis/InstructionSimplify.h"
 #include "llvm/Analysis/LoopPass.h"
+#include "llvm/Analysis/MemorySSA.h"
 #include "llvm/Analysis/ScalarEvolution.h"
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Function.h"
@@ -91,6 +92,7 @@ namespace {
       AU.addPreserved<AliasAnalysis>();
       AU.addPreserved<ScalarEvolution>();
       AU.addPreserved<DependenceAnalysis>();
+      AU.addPreserved<MemorySSA>();
       AU.addPreservedID(BreakCriticalEdgesID);  // No critical edges added.
     }
 
@@ -135,6 +137,12 @@ bool LoopSimplify::runOnLoop(Loop *l, LPPassManager &LPM) {
 
   Changed |= ProcessLoop(L, LPM);
 
+  // New blocks have no memory accesses or phis; rebuild MemorySSA rather than
+  // invalidate it, so loop passes using it can share one LPPassManager.
+  if (Changed)
+    if (MemorySSA *MSSA = getAnalysisIfAvailable<MemorySSA>())
+      MSSA->recalculate();
+
   return Changed;
 }
 
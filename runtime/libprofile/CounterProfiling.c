@@ -0,0 +1,162 @@
+/*===-- CounterProfiling.c - Support library for counter profiling --------===*\
+|*
+|*                     The LLVM Compiler Infrastructure
+|*
+|* This file is distributed under the University of Illinois Open Source
+|* License. See LICENSE.TXT for details.
+|*
+|*===----------------------------------------------------------------------===*|
+|*
+|* This file implements the call back routines for the counter profiling
+|* instrumentation pass.  Every instrumented module registers its functions
+|* from a constructor, and at exit the counters of all of them are written to
+|* a single indexed profile, in the format documented in
+|* llvm/Analysis/CounterProfile.h.  The file is default.profdata unless the
+|* LLVM_PROFILE_FILE environment variable names another one.
+|*
+\*===----------------------------------------------------------------------===*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* CounterProfileFunction - Must match the records emitted by the
+ * -insert-counter-profiling pass.
+ */
+typedef struct {
+  const char *Name;
+  uint64_t Hash;
+  uint32_t NumCounters;
+  uint64_t *Counters;
+} CounterProfileFunction;
+
+typedef struct CounterProfileModule {
+  struct CounterProfileModule *Next;
+  CounterProfileFunction *Functions;
+  uint32_t NumFunctions;
+} CounterProfileModule;
+
+static CounterProfileModule *Modules = 0;
+
+static const uint64_t Magic = 0xff6c70726f666463ULL;
+static const uint64_t Version = 1;
+
+/* write_word - Write V to F as a little-endian 64-bit word. */
+static int write_word(FILE *F, uint64_t V) {
+  unsigned char Bytes[8];
+  unsigned i;
+  for (i = 0; i != 8; ++i)
+    Bytes[i] = (unsigned char)(V >> (i * 8));
+  return fwrite(Bytes, 1, 8, F) == 8;
+}
+
+static int compare_functions(const void *L, const void *R) {
+  const CounterProfileFunction *LF = *(const CounterProfileFunction *const *)L;
+  const CounterProfileFunction *RF = *(const CounterProfileFunction *const *)R;
+  return strcmp(LF->Name, RF->Name);
+}
+
+/* CounterProfAtExitHandler - Write the counters of every registered function
+ * out, summing the counters of functions that were registered twice (an
+ * inline function emitted in several modules, say).
+ */
+static void CounterProfAtExitHandler(void) {
+  const char *OutputFilename = getenv("LLVM_PROFILE_FILE");
+  CounterProfileFunction **Functions;
+  CounterProfileModule *M;
+  uint64_t NumFunctions = 0, Unique = 0, NamesSize = 0, NumCounters = 0;
+  uint64_t NameOffset = 0, CounterOffset = 0, i, j, k;
+  FILE *F;
+
+  for (M = Modules; M; M = M->Next)
+    NumFunctions += M->NumFunctions;
+  Functions = (CounterProfileFunction **)malloc(
+      (NumFunctions ? NumFunctions : 1) * sizeof(CounterProfileFunction *));
+  if (!Functions)
+    return;
+  for (M = Modules, j = 0; M; M = M->Next)
+    for (i = 0; i != M->NumFunctions; ++i)
+      Functions[j++] = &M->Functions[i];
+  qsort(Functions, NumFunctions, sizeof(CounterProfileFunction *),
+        compare_functions);
+
+  /* Fold duplicates into their first occurrence. */
+  for (i = 0; i != NumFunctions; ++i) {
+    CounterProfileFunction *Fn = Functions[i];
+    if (Unique && !strcmp(Functions[Unique - 1]->Name, Fn->Name)) {
+      CounterProfileFunction *First = Functions[Unique - 1];
+      if (First->Hash != Fn->Hash || First->NumCounters != Fn->NumCounters) {
+        fprintf(stderr, "LLVM profiling runtime: ignoring conflicting "
+                "profile of '%s'\n", Fn->Name);
+        continue;
+      }
+      for (k = 0; k != Fn->NumCounters; ++k)
+        First->Counters[k] += Fn->Counters[k];
+      continue;
+    }
+    Functions[Unique++] = Fn;
+    NamesSize += strlen(Fn->Name);
+    NumCounters += Fn->NumCounters;
+  }
+
+  if (!OutputFilename || !*OutputFilename)
+    OutputFilename = "default.profdata";
+  F = fopen(OutputFilename, "wb");
+  if (!F) {
+    fprintf(stderr, "LLVM profiling runtime: while opening '%s': ",
+            OutputFilename);
+    perror("");
+    free(Functions);
+    return;
+  }
+
+  write_word(F, Magic);
+  write_word(F, Version);
+  write_word(F, Unique);
+  write_word(F, (NamesSize + 7) & ~(uint64_t)7);
+  write_word(F, NumCounters);
+
+  for (i = 0; i != Unique; ++i) {
+    uint64_t NameSize = strlen(Functions[i]->Name);
+    write_word(F, NameOffset);
+    write_word(F, NameSize);
+    write_word(F, Functions[i]->Hash);
+    write_word(F, Functions[i]->NumCounters);
+    write_word(F, CounterOffset);
+    NameOffset += NameSize;
+    CounterOffset += Functions[i]->NumCounters;
+  }
+
+  for (i = 0; i != Unique; ++i)
+    fputs(Functions[i]->Name, F);
+  for (; NamesSize & 7; ++NamesSize)
+    fputc(' ', F);
+
+  for (i = 0; i != Unique; ++i)
+    for (j = 0; j != Functions[i]->NumCounters; ++j)
+      write_word(F, Functions[i]->Counters[j]);
+
+  if (ferror(F))
+    fprintf(stderr, "LLVM profiling runtime: error writing '%s'\n",
+            OutputFilename);
+  fclose(F);
+  free(Functions);
+}
+
+/* llvm_register_counter_profile - Called by the constructor of every module
+ * instrumented for counter profiling.
+ */
+void llvm_register_counter_profile(CounterProfileFunction *Functions,
+                                   uint32_t NumFunctions) {
+  CounterProfileModule *M =
+    (CounterProfileModule *)malloc(sizeof(CounterProfileModule));
+  if (!M)
+    return;
+  if (!Modules)
+    atexit(CounterProfAtExitHandler);
+  M->Next = Modules;
+  M->Functions = Functions;
+  M->NumFunctions = NumFunctions;
+  Modules = M;
+}
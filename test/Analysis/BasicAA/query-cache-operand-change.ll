@@ -0,0 +1,24 @@
+; RUN: opt < %s -basicaa -aa-eval -instcombine -gvn -S | FileCheck %s
+; RUN: opt < %s -basicaa -basicaa-query-cache=false -aa-eval -instcombine -gvn \
+; RUN:   -S | FileCheck %s
+
+; The evaluator finds that %q and %r may alias.  Instcombine then changes the
+; index of %q from %k to %i in place, after which they don't.  A MayAlias
+; result cached before instcombine ran is still correct, just conservative:
+; answered from it, GVN misses forwarding the store to the load and keeps
+; "ret i32 %v".
+
+target datalayout = "e-p:64:64:64-i32:32:32-i64:64:64"
+
+define i32 @test(i32* %p, i64 %i) {
+; CHECK: @test
+; CHECK: ret i32 1
+  %k = xor i64 %i, 0
+  %q = getelementptr i32* %p, i64 %k
+  %i1 = add i64 %i, 1
+  %r = getelementptr i32* %p, i64 %i1
+  store i32 1, i32* %q
+  store i32 2, i32* %r
+  %v = load i32* %q
+  ret i32 %v
+}
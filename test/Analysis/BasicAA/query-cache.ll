@@ -0,0 +1,17 @@
+; RUN: opt < %s -basicaa -aa-eval -print-alias-sets -disable-output -stats 2>&1 \
+; RUN:   | FileCheck %s
+; REQUIRES: asserts
+; The alias set tracker repeats queries already made by the evaluator, which
+; are answered from the cross-pass query cache.
+
+; CHECK: 4 basicaa - Number of alias queries answered from the cache
+; CHECK: 3 basicaa - Number of alias queries not in the cache
+
+define void @test(i32* %p, i32 %i) {
+  %a = alloca i32
+  %b = getelementptr i32* %p, i32 %i
+  store i32 0, i32* %a
+  store i32 1, i32* %b
+  store i32 2, i32* %p
+  ret void
+}
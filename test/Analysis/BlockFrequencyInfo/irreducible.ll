@@ -0,0 +1,85 @@
+; RUN: opt < %s -analyze -block-freq | FileCheck %s
+
+; Two blocks that branch to each other, each entered from outside the loop.
+; Either way in, the loop runs until a 50% exit is taken, so both blocks run
+; as often as the entry on average.
+define void @irreducible(i1 %x, i1 %y, i1 %z) {
+; CHECK: Printing analysis {{.*}} for function 'irreducible'
+; CHECK: entry = 1024
+entry:
+  br i1 %x, label %left, label %right
+
+; CHECK: left = 1024
+left:
+  br i1 %y, label %right, label %exit
+
+; CHECK: right = 1024
+right:
+  br i1 %z, label %left, label %exit
+
+; CHECK: exit = 1024
+exit:
+  ret void
+}
+
+; Nested loops multiply their trip counts.
+define void @nested(i32 %n) {
+; CHECK: Printing analysis {{.*}} for function 'nested'
+; CHECK: entry = 1024
+entry:
+  br label %outer
+
+; CHECK: outer = 32768
+outer:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %outer.latch ]
+  br label %inner
+
+; CHECK: inner = 1048576
+inner:
+  %j = phi i32 [ 0, %outer ], [ %j.next, %inner ]
+  %j.next = add i32 %j, 1
+  %j.cmp = icmp slt i32 %j.next, %n
+  br i1 %j.cmp, label %inner, label %outer.latch
+
+; CHECK: outer.latch = 32768
+outer.latch:
+  %i.next = add i32 %i, 1
+  %i.cmp = icmp slt i32 %i.next, %n
+  br i1 %i.cmp, label %outer, label %exit
+
+; CHECK: exit = 1024
+exit:
+  ret void
+}
+
+; A state machine: every state jumps back to the dispatch block, and one
+; state can also jump straight into another.
+define void @state_machine(i32 %s0, i1 %cond) {
+; CHECK: Printing analysis {{.*}} for function 'state_machine'
+; CHECK: entry = 1024
+entry:
+  br label %dispatch
+
+; CHECK: dispatch = 32512
+dispatch:
+  %s = phi i32 [ %s0, %entry ], [ 1, %a ], [ 2, %b ], [ 0, %c ]
+  switch i32 %s, label %exit [ i32 0, label %a
+                               i32 1, label %b
+                               i32 2, label %c ]
+
+; CHECK: a = 10496
+a:
+  br label %dispatch
+
+; CHECK: b = 15744
+b:
+  br label %dispatch
+
+; CHECK: c = 10496
+c:
+  br i1 %cond, label %dispatch, label %b
+
+; CHECK: exit = 1024
+exit:
+  ret void
+}
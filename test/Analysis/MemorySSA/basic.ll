@@ -0,0 +1,64 @@
+; RUN: opt < %s -basicaa -memoryssa -analyze -verify-memoryssa | FileCheck %s
+
+define i32 @straight(i32* noalias %a, i32* noalias %b) {
+; CHECK: Printing analysis 'Memory SSA' for function 'straight'
+entry:
+; CHECK: 1 = MemoryDef(liveOnEntry)
+; CHECK-NEXT: store i32 0, i32* %a
+  store i32 0, i32* %a
+; CHECK: 2 = MemoryDef(1)
+; CHECK-NEXT: store i32 1, i32* %b
+  store i32 1, i32* %b
+; CHECK: MemoryUse(2)
+; CHECK-NEXT: %x = load i32* %a
+  %x = load i32* %a
+  ret i32 %x
+}
+
+define i32 @diamond(i1 %c, i32* %a, i32* %b) {
+; CHECK: Printing analysis 'Memory SSA' for function 'diamond'
+entry:
+; CHECK: 1 = MemoryDef(liveOnEntry)
+  store i32 0, i32* %a
+  br i1 %c, label %left, label %right
+
+left:
+; CHECK: 2 = MemoryDef(1)
+  store i32 1, i32* %b
+  br label %join
+
+right:
+  br label %join
+
+join:
+; CHECK: join:
+; CHECK: 3 = MemoryPhi({%right,1},{%left,2})
+; CHECK-NEXT: MemoryUse(3)
+; CHECK-NEXT: %x = load i32* %a
+  %x = load i32* %a
+  ret i32 %x
+}
+
+define void @loop(i32* %a, i32 %n) {
+; CHECK: Printing analysis 'Memory SSA' for function 'loop'
+entry:
+  br label %body
+
+body:
+; CHECK: body:
+; CHECK: 1 = MemoryPhi({%body,2},{%entry,liveOnEntry})
+; CHECK: MemoryUse(1)
+; CHECK-NEXT: %v = load i32* %a
+; CHECK: 2 = MemoryDef(1)
+; CHECK-NEXT: store i32 %v1, i32* %a
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %v = load i32* %a
+  %v1 = add i32 %v, 1
+  store i32 %v1, i32* %a
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %body
+
+exit:
+  ret void
+}
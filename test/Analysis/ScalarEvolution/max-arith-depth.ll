@@ -0,0 +1,17 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s
+; RUN: opt < %s -analyze -scalar-evolution \
+; RUN:   -scalar-evolution-max-arith-depth=0 | FileCheck %s -check-prefix=LIMIT
+; Past the arithmetic depth limit, the operands of nested adds and multiplies
+; are still sorted and their constants folded, but they are no longer
+; flattened or combined.
+
+define i32 @test1(i32 %a) {
+; CHECK: %m = mul i32 %y, -1
+; CHECK-NEXT: -->  (-1 + (-2 * %a))
+; LIMIT: %m = mul i32 %y, -1
+; LIMIT-NEXT: -->  (-1 + (-1 * (2 * %a)))
+  %x = shl i32 %a, 1
+  %y = add i32 %x, 1
+  %m = mul i32 %y, -1
+  ret i32 %m
+}
@@ -0,0 +1,29 @@
+; RUN: opt < %s -analyze -scalar-evolution | FileCheck %s
+; RUN: opt < %s -analyze -scalar-evolution -scev-addops-inline-threshold=2 \
+; RUN:   -scev-mulops-inline-threshold=2 | FileCheck %s -check-prefix=LIMIT
+; Nested adds and multiplies are flattened into their parent only while both
+; operand lists stay within the thresholds.  The nested expression is the
+; second operand, so that it is not already flattened when the instruction
+; chain is walked.
+
+define i32 @add(i32 %a, i32 %b, i32 %c, i32 %d) {
+; CHECK: %s3 = add i32 %d, %s2
+; CHECK-NEXT: -->  (%a + %b + %c + %d)
+; LIMIT: %s3 = add i32 %d, %s2
+; LIMIT-NEXT: -->  ((%a + %b + %c) + %d)
+  %s1 = add i32 %a, %b
+  %s2 = add i32 %s1, %c
+  %s3 = add i32 %d, %s2
+  ret i32 %s3
+}
+
+define i32 @mul(i32 %a, i32 %b, i32 %c, i32 %d) {
+; CHECK: %m3 = mul i32 %d, %m2
+; CHECK-NEXT: -->  (%a * %b * %c * %d)
+; LIMIT: %m3 = mul i32 %d, %m2
+; LIMIT-NEXT: -->  ((%a * %b * %c) * %d)
+  %m1 = mul i32 %a, %b
+  %m2 = mul i32 %m1, %c
+  %m3 = mul i32 %d, %m2
+  ret i32 %m3
+}
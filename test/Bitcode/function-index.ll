@@ -0,0 +1,30 @@
+; RUN: llvm-as < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=BC
+; RUN: llvm-as < %s | llvm-dis | FileCheck %s
+; RUN: llvm-as -disable-bc-function-index < %s | llvm-dis | FileCheck %s
+; RUN: llvm-as -disable-bc-function-index < %s | llvm-bcanalyzer -dump | FileCheck %s -check-prefix=NOINDEX
+
+; The module records where its function bodies are, so lazy loading doesn't
+; have to skip over each of them.
+
+; BC: <FNINDEXOFFSET
+; BC: <FUNCTION_BLOCK
+; BC: <FUNCTION_BLOCK
+; BC: <FNINDEX
+; BC: </MODULE_BLOCK>
+
+; NOINDEX-NOT: FNINDEX
+
+; CHECK: define i32 @a()
+; CHECK-NEXT: ret i32 1
+define i32 @a() {
+  ret i32 1
+}
+
+declare i32 @decl()
+
+; CHECK: define i32 @b()
+; CHECK-NEXT: %r = call i32 @a()
+define i32 @b() {
+  %r = call i32 @a()
+  ret i32 %r
+}
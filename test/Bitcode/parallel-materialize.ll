@@ -0,0 +1,57 @@
+; RUN: llvm-as < %s | opt -S -bitcode-materialize-threads=4 | FileCheck %s
+; RUN: llvm-as < %s | opt -S -bitcode-materialize-threads=0 | FileCheck %s
+; RUN: llvm-as -disable-bc-function-index < %s | \
+; RUN:   opt -S -bitcode-materialize-threads=3 | FileCheck %s
+
+; Function blocks decoded on several threads must produce the same module as
+; reading them one at a time, including references to functions and blocks
+; that come later in the file.
+
+; CHECK: @addr = global i8* blockaddress(@second, %target)
+@addr = global i8* blockaddress(@second, %target)
+@str = private constant [4 x i8] c"abc\00"
+
+; CHECK: define i32 @first(i32 %x)
+; CHECK-NEXT: entry:
+; CHECK-NEXT: %sum = add i32 %x, 42
+; CHECK-NEXT: %call = call i32 @third(i32 %sum), !dbg.extra !0
+; CHECK-NEXT: br label %exit
+; CHECK: exit:
+; CHECK-NEXT: ret i32 %call
+define i32 @first(i32 %x) {
+entry:
+  %sum = add i32 %x, 42
+  %call = call i32 @third(i32 %sum), !dbg.extra !0
+  br label %exit
+
+exit:
+  ret i32 %call
+}
+
+; CHECK: define i8* @second(i1 %c)
+; CHECK: indirectbr i8* blockaddress(@second, %target), [label %target]
+; CHECK: target:
+; CHECK-NEXT: ret i8* getelementptr inbounds ([4 x i8]* @str, i32 0, i32 0)
+define i8* @second(i1 %c) {
+  indirectbr i8* blockaddress(@second, %target), [label %target]
+
+target:
+  ret i8* getelementptr inbounds ([4 x i8]* @str, i32 0, i32 0)
+}
+
+; CHECK: define i32 @third(i32 %y)
+; CHECK-NEXT: %neg = sub i32 0, %y
+; CHECK-NEXT: call void @llvm.dbg.value(metadata !{i32 %neg}, i64 0, metadata !1)
+; CHECK-NEXT: ret i32 %neg
+define i32 @third(i32 %y) {
+  %neg = sub i32 0, %y
+  call void @llvm.dbg.value(metadata !{i32 %neg}, i64 0, metadata !1)
+  ret i32 %neg
+}
+
+declare void @llvm.dbg.value(metadata, i64, metadata) nounwind readnone
+
+; CHECK: !0 = metadata !{metadata !"extra"}
+; CHECK: !1 = metadata !{i32 7}
+!0 = metadata !{metadata !"extra"}
+!1 = metadata !{i32 7}
@@ -0,0 +1,58 @@
+; RUN: llvm-as < %s | cat > %t.buffered.bc
+; RUN: llvm-as %s -o %t.file.bc
+; RUN: llvm-as -bitcode-writer-threads=4 %s -o %t.parallel.bc
+; RUN: llvm-as -bitcode-writer-threads=3 < %s | cat > %t.parallel-buffered.bc
+; RUN: llvm-as -bitcode-writer-threads=2 -bitcode-file-flush-threshold=4 %s \
+; RUN:   -o %t.flushed.bc
+; RUN: cmp %t.buffered.bc %t.file.bc
+; RUN: cmp %t.buffered.bc %t.parallel.bc
+; RUN: cmp %t.buffered.bc %t.parallel-buffered.bc
+; RUN: cmp %t.buffered.bc %t.flushed.bc
+; RUN: llvm-dis < %t.flushed.bc | FileCheck %s
+
+; Writing straight to a file, encoding function blocks on several threads, or
+; both, must produce exactly the bitcode that is built up in memory.
+
+@g = global i32 0
+
+; CHECK: define i32 @f1(i32 %a)
+; CHECK-NEXT: %b = add i32 %a, 1
+define i32 @f1(i32 %a) {
+  %b = add i32 %a, 1
+  ret i32 %b
+}
+
+; CHECK: define void @f2()
+; CHECK-NEXT: store i32 7, i32* @g
+define void @f2() {
+  store i32 7, i32* @g
+  ret void
+}
+
+; CHECK: define i32 @f3(i32 %x)
+; CHECK: %r = call i32 @f1(i32 %x), !extra !0
+define i32 @f3(i32 %x) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %next, %loop ]
+  %next = add i32 %i, 1
+  %done = icmp eq i32 %next, 10
+  br i1 %done, label %exit, label %loop
+
+exit:
+  %r = call i32 @f1(i32 %x), !extra !0
+  ret i32 %r
+}
+
+declare void @decl()
+
+; CHECK: define double @f4(double %d)
+; CHECK-NEXT: %m = fmul double %d, 2.500000e+00
+define double @f4(double %d) {
+  %m = fmul double %d, 2.5
+  ret double %m
+}
+
+!0 = metadata !{metadata !"extra"}
@@ -0,0 +1,51 @@
+; RUN: llc -O0 -mtriple=x86_64-unknown-linux-gnu -filetype=obj %s -o %t.o
+; RUN: llvm-perf2prof -binary=%t.o %p/../Inputs/perf2prof-roundtrip.script -o %t.prof
+; RUN: FileCheck %s -check-prefix=PROF < %t.prof
+; RUN: opt < %s -sample-profile -sample-profile-file=%t.prof -S | FileCheck %s
+
+; The converter and the sample profile loader must agree on the line that
+; offsets are measured from. @branch is declared on line 1 but its first
+; instruction is on line 3, so offsets taken from any other base line would
+; land on the wrong blocks.
+
+; PROF:      branch:11:1
+; PROF-NEXT: 2: 1
+; PROF-NEXT: 3: 9
+; PROF-NEXT: 4: 1
+
+; CHECK: br i1 %cmp, label %if.then, label %if.end, !dbg !{{[0-9]+}}, !prof ![[BRANCH:[0-9]+]]
+; CHECK: ![[BRANCH]] = metadata !{metadata !"branch_weights", i32 9, i32 1}
+
+define i32 @branch(i32 %x) {
+entry:
+  %cmp = icmp sgt i32 %x, 0, !dbg !10
+  br i1 %cmp, label %if.then, label %if.end, !dbg !10
+
+if.then:
+  %mul = mul nsw i32 %x, 3, !dbg !11
+  br label %return, !dbg !11
+
+if.end:
+  %sub = sub nsw i32 0, %x, !dbg !12
+  br label %return, !dbg !12
+
+return:
+  %retval = phi i32 [ %mul, %if.then ], [ %sub, %if.end ]
+  ret i32 %retval, !dbg !13
+}
+
+!llvm.dbg.cu = !{!0}
+
+!0 = metadata !{i32 786449, i32 12, metadata !1, metadata !"clang version 3.3", i1 true, metadata !"", i32 0, metadata !2, metadata !2, metadata !3, metadata !2, metadata !2, metadata !""} ; [ DW_TAG_compile_unit ] [/tmp/branch.c] [DW_LANG_C99]
+!1 = metadata !{metadata !"branch.c", metadata !"/tmp"}
+!2 = metadata !{i32 0}
+!3 = metadata !{metadata !4}
+!4 = metadata !{i32 786478, metadata !1, metadata !5, metadata !"branch", metadata !"branch", metadata !"", i32 1, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32)* @branch, null, null, metadata !2, i32 2} ; [ DW_TAG_subprogram ] [line 1] [def] [scope 2] [branch]
+!5 = metadata !{i32 786473, metadata !1}          ; [ DW_TAG_file_type ] [/tmp/branch.c]
+!6 = metadata !{i32 786453, i32 0, metadata !"", i32 0, i32 0, i64 0, i64 0, i64 0, i32 0, null, metadata !7, i32 0, i32 0} ; [ DW_TAG_subroutine_type ] [line 0, size 0, align 0, offset 0] [from ]
+!7 = metadata !{metadata !8, metadata !8}
+!8 = metadata !{i32 786468, null, metadata !"int", null, i32 0, i64 32, i64 32, i64 0, i32 0, i32 5} ; [ DW_TAG_base_type ] [int] [line 0, size 32, align 32, offset 0, enc DW_ATE_signed]
+!10 = metadata !{i32 3, i32 0, metadata !4, null}
+!11 = metadata !{i32 4, i32 0, metadata !4, null}
+!12 = metadata !{i32 5, i32 0, metadata !4, null}
+!13 = metadata !{i32 6, i32 0, metadata !4, null}
@@ -0,0 +1,18 @@
+; RUN: %lli -discard-value-names %s > /dev/null
+
+@counter = global i32 0
+
+define i32 @main() {
+entry:
+  br label %loop
+
+loop:
+  %old = load i32* @counter
+  %new = add i32 %old, 1
+  store i32 %new, i32* @counter
+  %done = icmp eq i32 %new, 3
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 0
+}
@@ -0,0 +1,51 @@
+; RUN: opt < %s -insert-counter-profiling -S | FileCheck %s
+
+; Each function gets one counter for its entry and one for each successor of
+; its conditional branches and switches, and the module registers them all
+; from a constructor.
+
+; CHECK: @__llvm_prof_counters_branch = private global [3 x i64] zeroinitializer
+; CHECK: @__llvm_prof_name_branch = private unnamed_addr constant [7 x i8] c"branch\00"
+; CHECK: @__llvm_prof_counters_local = private global [1 x i64] zeroinitializer
+; CHECK: @__llvm_prof_name_local = private unnamed_addr constant [14 x i8] c"<stdin>:local\00"
+; CHECK: @__llvm_prof_functions = private constant [2 x { i8*, i64, i32, i64* }]
+; CHECK: @llvm.global_ctors = appending global {{.*}} @__llvm_prof_register
+
+define i32 @branch(i32 %x) {
+; CHECK: @branch
+; CHECK: entry:
+; CHECK: load i64* getelementptr inbounds ([3 x i64]* @__llvm_prof_counters_branch, i64 0, i64 0)
+; CHECK: br i1 %cmp, label %then, label %entry.merge_crit_edge
+entry:
+  %cmp = icmp sgt i32 %x, 0
+  br i1 %cmp, label %then, label %merge
+
+; The edge to merge is critical and gets a block of its own.
+; CHECK: entry.merge_crit_edge:
+; CHECK: load i64* getelementptr inbounds ([3 x i64]* @__llvm_prof_counters_branch, i64 0, i64 2)
+; CHECK: br label %merge
+
+; The edge to then is not critical, so its counter goes in then.
+; CHECK: then:
+; CHECK: load i64* getelementptr inbounds ([3 x i64]* @__llvm_prof_counters_branch, i64 0, i64 1)
+then:
+  br label %merge
+
+; CHECK: merge:
+; CHECK-NEXT: phi
+; CHECK-NEXT: ret i32
+merge:
+  %r = phi i32 [ 1, %then ], [ 0, %entry ]
+  ret i32 %r
+}
+
+; Local functions are named after their module, so that statics of different
+; modules do not share a profile.
+define internal void @local() {
+  ret void
+}
+
+declare void @external()
+
+; CHECK: define internal void @__llvm_prof_register()
+; CHECK: call void @llvm_register_counter_profile({ i8*, i64, i32, i64* }* getelementptr inbounds ([2 x { i8*, i64, i32, i64* }]* @__llvm_prof_functions, i64 0, i64 0), i32 2)
@@ -0,0 +1,86 @@
+; RUN: llvm-profdata merge %S/Inputs/use.proftext -o %t.profdata
+; RUN: opt < %s -counter-profile-use -counter-profile-file=%t.profdata -S | FileCheck %s
+; RUN: opt < %s -counter-profile-use -counter-profile-file=%t.profdata -analyze -branch-prob | FileCheck %s -check-prefix=PROB
+
+; Check that the edge counts of a profile become branch weights and that the
+; entry counts are recorded for the inliner.
+
+define internal i32 @pick(i32 %i) {
+; CHECK: @pick
+; CHECK: br i1 %c, label %rare, label %common, !prof ![[PICK:[0-9]+]]
+; PROB: Printing analysis 'Branch Probability Analysis' for function 'pick':
+; PROB: edge entry -> rare probability is 100 / 1000 = 10%
+; PROB: edge entry -> common probability is 900 / 1000 = 90%
+entry:
+  %r = srem i32 %i, 10
+  %c = icmp eq i32 %r, 0
+  br i1 %c, label %rare, label %common
+
+rare:
+  br label %done
+
+common:
+  br label %done
+
+done:
+  %v = phi i32 [ 7, %rare ], [ 1, %common ]
+  ret i32 %v
+}
+
+define i32 @select(i32 %x) {
+; CHECK: @select
+; CHECK: switch i32 %x, label %other [
+; CHECK: ], !prof ![[SELECT:[0-9]+]]
+entry:
+  switch i32 %x, label %other [
+    i32 0, label %zero
+    i32 1, label %one
+  ]
+
+zero:
+  ret i32 10
+
+one:
+  ret i32 11
+
+other:
+  ret i32 12
+}
+
+; Counts that do not fit in 32 bits are scaled down together.
+define i32 @big(i1 %c) {
+; CHECK: @big
+; CHECK: br i1 %c, label %a, label %b, !prof ![[BIG:[0-9]+]]
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  ret i32 0
+
+b:
+  ret i32 1
+}
+
+; The profile of stale was taken when it had a different CFG, so it is
+; ignored.
+define i32 @stale(i1 %c) {
+; CHECK: @stale
+; CHECK: br i1 %c, label %a, label %b{{$}}
+entry:
+  br i1 %c, label %a, label %b
+
+a:
+  ret i32 0
+
+b:
+  ret i32 1
+}
+
+; CHECK: !llvm.function_entry_counts = !{![[E1:[0-9]+]], ![[E2:[0-9]+]], ![[E3:[0-9]+]]}
+; CHECK-DAG: ![[E1]] = metadata !{i32 (i32)* @pick, i64 1000}
+; CHECK-DAG: ![[E2]] = metadata !{i32 (i32)* @select, i64 60}
+; CHECK-DAG: ![[E3]] = metadata !{i32 (i1)* @big, i64 17179869184}
+; CHECK-DAG: ![[PICK]] = metadata !{metadata !"branch_weights", i32 100, i32 900}
+; CHECK-DAG: ![[SELECT]] = metadata !{metadata !"branch_weights", i32 10, i32 20, i32 30}
+; 1073741823 and 3221225471, a quarter of the counts:
+; CHECK-DAG: ![[BIG]] = metadata !{metadata !"branch_weights", i32 1073741823, i32 -1073741825}
@@ -0,0 +1,81 @@
+# A macro-heavy input for measuring how fast llvm-mc parses assembly. Raise
+# the .rept count to turn it into a benchmark; -show-throughput reports the
+# input size, the amount of text parsed after macro expansion and MB/s.
+
+# RUN: llvm-mc -triple x86_64-pc-linux-gnu -filetype=obj -show-throughput %s \
+# RUN:   -o %t 2> %t.err
+# RUN: FileCheck --check-prefix=THROUGHPUT %s < %t.err
+# RUN: llvm-readobj -s %t | FileCheck %s
+# RUN: llvm-mc -triple x86_64-pc-linux-gnu %s | FileCheck --check-prefix=ASM %s
+
+# THROUGHPUT: {{[0-9.]+}} MB input, {{[0-9.]+}} MB parsed in {{[0-9.]+}} s: {{[0-9.]+}} MB/s input, {{[0-9.]+}} MB/s parsed
+
+# CHECK:      Name: .text
+# CHECK-NEXT: Type: SHT_PROGBITS
+# CHECK-NEXT: Flags [
+# CHECK-NEXT:   SHF_ALLOC
+# CHECK-NEXT:   SHF_EXECINSTR
+# CHECK-NEXT: ]
+# CHECK-NEXT: Address: 0x0
+# CHECK-NEXT: Offset:
+# CHECK-NEXT: Size: 11192
+
+# ASM:      movq	24(%rdi), %rax
+# ASM:      addq	$1, %rax
+# ASM:      movq	%rax, 24(%rdi)
+# ASM:      movq	32(%rsi), %rcx
+# ASM:      pushq	%rax
+# ASM:      popq	%rax
+# ASM:      pushq	%rbx
+# ASM:      popq	%rbx
+# ASM:      pushq	%rcx
+# ASM:      popq	%rcx
+# ASM:      movq	80(%rdi), %rax
+# ASM:      movq	88(%rsi), %rcx
+# ASM:      leaq	16(%rsp), %rsp
+# ASM:      leaq	16(%rsp), %rsp
+# ASM:      movl	$0, %eax
+# ASM:      movl	$1, %eax
+# ASM:      movl	$2, %eax
+# ASM:      movl	$3, %eax
+# ASM:      testl	%eax, %eax
+
+	.text
+	.macro	load_add_store base, off, reg, imm
+	movq	\off(\base), \reg	# load
+	addq	$\imm, \reg
+	movq	\reg, \off(\base)	// store back
+	.endm
+
+	.macro	push_pop reg
+	pushq	%r\reg
+	popq	%r\()\reg
+	.endm
+
+	.macro	set_eax
+	.irpc	i, 0123
+	movl	$\i, %eax
+	.endr
+	.endm
+
+	.macro	block n, scale=8
+	load_add_store %rdi, \n*\scale, %rax, 1
+	load_add_store %rsi, \n*\scale+8, %rcx, 2
+	.irp	r, ax, bx, cx
+	push_pop \r
+	.endr
+	.endm
+
+	.rept	100
+1:
+	block	3
+	block	5, 16
+	.rept	2
+	leaq	16(%rsp), %rsp
+	.endr
+	set_eax
+	testl	%eax, %eax ; jne 1b
+	.p2align	4, 0x90
+	.byte	1, 2, 3, 4
+	.long	1b - .
+	.endr
@@ -0,0 +1,78 @@
+// RUN: llvm-mc -filetype=obj -compress-debug-sections -triple x86_64-pc-linux-gnu -g < %s -o %t
+// RUN: llvm-readobj -s -sd %t | FileCheck %s
+// RUN: llvm-dwarfdump -debug-dump=str %t | FileCheck --check-prefix=STR %s
+// RUN: llvm-dwarfdump -debug-dump=line %t | FileCheck --check-prefix=LINE %s
+// REQUIRES: zlib
+
+// Debug sections that get smaller are renamed to .zdebug_* and hold the
+// GNU "ZLIB" header: the magic followed by the 64-bit big-endian size of the
+// uncompressed contents. Relocations still apply to the uncompressed data.
+
+// CHECK:      Name: .zdebug_str
+// CHECK:      SectionData (
+// CHECK-NEXT:   0000: 5A4C4942 00000000 000002D6
+// CHECK:      Name: .zdebug_line
+// CHECK:      SectionData (
+// CHECK-NEXT:   0000: 5A4C4942 00000000
+// CHECK:      Name: .rela.zdebug_line
+
+// Too small to benefit, so left alone.
+// CHECK:      Name: .debug_abbrev
+
+// STR: .debug_str contents:
+// STR: "a long string that compresses well, number 0"
+// STR: "a long string that compresses well, number 15"
+
+// LINE: .debug_line contents:
+// LINE: 0x0000000000000000 {{ *}}[[@LINE+2]] {{ *}}0 {{ *}}1 {{ *}}0 is_stmt
+f:
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+  nop
+
+  .section .debug_str,"MS",@progbits,1
+  .asciz "a long string that compresses well, number 0"
+  .asciz "a long string that compresses well, number 1"
+  .asciz "a long string that compresses well, number 2"
+  .asciz "a long string that compresses well, number 3"
+  .asciz "a long string that compresses well, number 4"
+  .asciz "a long string that compresses well, number 5"
+  .asciz "a long string that compresses well, number 6"
+  .asciz "a long string that compresses well, number 7"
+  .asciz "a long string that compresses well, number 8"
+  .asciz "a long string that compresses well, number 9"
+  .asciz "a long string that compresses well, number 10"
+  .asciz "a long string that compresses well, number 11"
+  .asciz "a long string that compresses well, number 12"
+  .asciz "a long string that compresses well, number 13"
+  .asciz "a long string that compresses well, number 14"
+  .asciz "a long string that compresses well, number 15"
@@ -0,0 +1,29 @@
+// RUN: llvm-mc -filetype=obj -triple i686-pc-linux-gnu %s -o - | llvm-readobj -symbols -s -sd | FileCheck %s
+
+// Symbol names that are a suffix of another name share its bytes in .strtab.
+
+	.text
+	.globl	foobar
+	.align	16, 0x90
+	.type	foobar,@function
+foobar:
+	pushl	%ebp
+	movl	%esp, %ebp
+	subl	$8, %esp
+	calll	foo
+	calll	bar
+	addl	$8, %esp
+	popl	%ebp
+	retl
+.Ltmp3:
+	.size	foobar, .Ltmp3-foobar
+
+// CHECK:      Name: .strtab
+// CHECK:      SectionData (
+// CHECK-NEXT:   0000: 00666F6F 62617200 666F6F00 |.foobar.foo.|
+// CHECK-NEXT: )
+
+// CHECK:      Symbol {
+// CHECK:        Name: foobar (1)
+// CHECK:        Name: bar (4)
+// CHECK:        Name: foo (8)
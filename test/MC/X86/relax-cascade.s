@@ -0,0 +1,29 @@
+// RUN: llvm-mc -filetype=obj -triple x86_64-pc-linux-gnu %s -o - \
+// RUN:   | llvm-readobj -s | FileCheck %s
+
+// A chain of 8001 short jumps, each reaching across the next one by exactly
+// the distance a short jump can cover. The last jump is too far for a short
+// encoding, and relaxing it pushes every jump before it out of range in
+// turn. Relaxation must handle this without a full pass over the section
+// per jump; this file doubles as a benchmark for that.
+
+// Every jump ends up as a 5 byte jmp rel32:
+// 5 + 4000 * (2 * 125 + 2 * 5) + 1000 + 1 = 1041006 bytes.
+
+// CHECK:      Name: .text
+// CHECK-NOT:  Name:
+// CHECK:      Size: 1041006
+
+	.text
+	jmp	1f
+	.rept	4000
+	.fill	125, 1, 0x90
+	jmp	2f
+1:
+	.fill	125, 1, 0x90
+	jmp	1f
+2:
+	.endr
+	.fill	1000, 1, 0x90
+1:
+	ret
@@ -0,0 +1,28 @@
+; RUN: opt -S -discard-value-names < %s | FileCheck %s
+; RUN: llvm-as < %s | opt -S -discard-value-names | FileCheck %s
+
+; Local value and block names are dropped; global names are kept.
+
+@counter = global i32 0
+
+; CHECK: @counter = global i32 0
+; CHECK: define i32 @main()
+; CHECK-NOT: %loop
+; CHECK-NOT: %old
+; CHECK-NOT: %done
+; CHECK: ret i32 0
+
+define i32 @main() {
+entry:
+  br label %loop
+
+loop:
+  %old = load i32* @counter
+  %new = add i32 %old, 1
+  store i32 %new, i32* @counter
+  %done = icmp eq i32 %new, 3
+  br i1 %done, label %exit, label %loop
+
+exit:
+  ret i32 0
+}
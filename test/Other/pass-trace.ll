@@ -0,0 +1,26 @@
+; RUN: opt -instcombine -loop-rotate -pass-trace-file=%t.json -disable-output < %s
+; RUN: FileCheck %s < %t.json
+
+; Each pass execution is a complete event, tagged with the IR unit it ran on,
+; and the passes run on a function are nested in a region for that function.
+
+; CHECK: {"traceEvents":[
+; CHECK-DAG: {"name":"Combine redundant instructions","cat":"function","ph":"X",{{.*}}"args":{"unit":"foo","heap_start":{{[0-9]+}},"heap_delta":{{-?[0-9]+}}}}
+; CHECK-DAG: {"name":"Rotate Loops","cat":"loop",{{.*}}"args":{"unit":"loop",
+; CHECK-DAG: {"name":"foo","cat":"function",
+; CHECK-DAG: {"name":"Function Pass Manager","cat":"module",
+; CHECK: ],"displayTimeUnit":"ms"}
+
+define void @foo(i32 %n) {
+entry:
+  br label %loop
+
+loop:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %loop ]
+  %i.next = add i32 %i, 1
+  %c = icmp slt i32 %i.next, %n
+  br i1 %c, label %loop, label %exit
+
+exit:
+  ret void
+}
@@ -0,0 +1,50 @@
+; RUN: opt < %s -correlated-propagation -S | FileCheck %s
+; RUN: opt < %s -correlated-propagation -lvi-max-block-value-steps=0 -S | FileCheck %s -check-prefix=NOBUDGET
+; RUN: opt < %s -jump-threading -lvi-max-block-value-steps=0 -disable-output
+
+; A query that runs out of solver steps gives up with an overdefined result
+; instead of folding anything.
+
+define i1 @test1(i32 %a) {
+entry:
+  %c = icmp eq i32 %a, 7
+  br i1 %c, label %bb1, label %exit
+
+bb1:
+  br label %bb2
+
+bb2:
+; CHECK: bb2:
+; CHECK-NEXT: ret i1 true
+; NOBUDGET: bb2:
+; NOBUDGET-NEXT: %r = icmp eq i32 %a, 7
+  %r = icmp eq i32 %a, 7
+  ret i1 %r
+
+exit:
+  ret i1 false
+}
+
+define i32 @test2(i32 %a) {
+entry:
+  switch i32 %a, label %default [
+    i32 1, label %next
+    i32 2, label %next
+  ]
+
+next:
+  %b = add i32 %a, 1
+  br label %check
+
+check:
+; NOBUDGET: check:
+; NOBUDGET-NEXT: %c = icmp ult i32 %b, 4
+  %c = icmp ult i32 %b, 4
+  br i1 %c, label %yes, label %default
+
+yes:
+  ret i32 %b
+
+default:
+  ret i32 0
+}
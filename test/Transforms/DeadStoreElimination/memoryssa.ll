@@ -0,0 +1,87 @@
+; RUN: opt < %s -basicaa -dse -enable-dse-memoryssa -verify-memoryssa -S | FileCheck %s
+
+; The first store is overwritten on every path before anything reads it.
+; The load in %left reads different memory.
+define void @cross_block(i1 %c, i32* noalias %a, i32* noalias %b) {
+; CHECK: @cross_block
+; CHECK-NOT: store i32 1
+; CHECK: store i32 3, i32* %a
+entry:
+  store i32 1, i32* %a
+  br i1 %c, label %left, label %join
+
+left:
+  %x = load i32* %b
+  br label %join
+
+join:
+  store i32 3, i32* %a
+  ret void
+}
+
+; The load in %left may read the first store.
+define i32 @read_between(i1 %c, i32* noalias %a) {
+; CHECK: @read_between
+; CHECK: store i32 1, i32* %a
+; CHECK: store i32 3, i32* %a
+entry:
+  store i32 1, i32* %a
+  br i1 %c, label %left, label %join
+
+left:
+  %x = load i32* %a
+  br label %join
+
+join:
+  %r = phi i32 [ %x, %left ], [ 0, %entry ]
+  store i32 3, i32* %a
+  ret i32 %r
+}
+
+; The later store does not execute on every path from the earlier one.
+define void @not_postdominated(i1 %c, i32* %a) {
+; CHECK: @not_postdominated
+; CHECK: store i32 1, i32* %a
+; CHECK: store i32 3, i32* %a
+entry:
+  store i32 1, i32* %a
+  br i1 %c, label %left, label %exit
+
+left:
+  store i32 3, i32* %a
+  br label %exit
+
+exit:
+  ret void
+}
+
+; Storing back a loaded value with no write in between is a no-op.
+define void @store_of_load(i32* noalias %a, i32* noalias %b) {
+; CHECK: @store_of_load
+; CHECK-NEXT: entry:
+; CHECK-NEXT: store i32 2, i32* %b
+; CHECK-NEXT: ret void
+entry:
+  %x = load i32* %a
+  store i32 2, i32* %b
+  store i32 %x, i32* %a
+  ret void
+}
+
+; A store on one path makes a MemoryPhi at %join, which ends the walk, so the
+; first store is conservatively kept.
+define void @through_phi(i1 %c, i32* noalias %a, i32* noalias %b) {
+; CHECK: @through_phi
+; CHECK: store i32 1, i32* %a
+entry:
+  store i32 1, i32* %a
+  br i1 %c, label %left, label %join
+
+left:
+  store i32 2, i32* %b
+  br label %join
+
+join:
+  store i32 3, i32* %a
+  ret void
+}
@@ -0,0 +1,29 @@
+; RUN: opt < %s -basicaa -early-cse -enable-earlycse-memoryssa -verify-memoryssa -S | FileCheck %s
+
+; Loads separated by a store to a different object are redundant.
+define i32 @noalias_store(i32* noalias %a, i32* noalias %b) {
+; CHECK: @noalias_store
+; CHECK: %x = load i32* %a
+; CHECK-NOT: load
+; CHECK: %sum = add i32 %x, %x
+entry:
+  %x = load i32* %a
+  store i32 5, i32* %b
+  %y = load i32* %a
+  %sum = add i32 %x, %y
+  ret i32 %sum
+}
+
+; A store through a may-alias pointer clobbers the load.
+define i32 @clobbered(i32* %a, i32* %b) {
+; CHECK: @clobbered
+; CHECK: %x = load i32* %a
+; CHECK: %y = load i32* %a
+; CHECK: %sum = add i32 %x, %y
+entry:
+  %x = load i32* %a
+  store i32 5, i32* %b
+  %y = load i32* %a
+  %sum = add i32 %x, %y
+  ret i32 %sum
+}
@@ -0,0 +1,70 @@
+; RUN: opt < %s -basicaa -gvn -enable-gvn-memoryssa -verify-memoryssa -S | FileCheck %s
+
+; Loads separated by a store to a different object are redundant.
+define i32 @noalias_store(i32* noalias %a, i32* noalias %b) {
+; CHECK: @noalias_store
+; CHECK: %x = load i32* %a
+; CHECK-NOT: load
+; CHECK: %sum = add i32 %x, %x
+entry:
+  %x = load i32* %a
+  store i32 5, i32* %b
+  %y = load i32* %a
+  %sum = add i32 %x, %y
+  ret i32 %sum
+}
+
+; Store forwarding across blocks and an unrelated store.
+define i32 @forward(i1 %c, i32* noalias %a, i32* noalias %b) {
+; CHECK: @forward
+; CHECK: join:
+; CHECK-NOT: load
+; CHECK: ret i32 7
+entry:
+  store i32 7, i32* %a
+  br i1 %c, label %left, label %join
+
+left:
+  store i32 1, i32* %b
+  br label %join
+
+join:
+  %x = load i32* %a
+  ret i32 %x
+}
+
+; A store through a may-alias pointer clobbers the load.
+define i32 @clobbered(i32* %a, i32* %b) {
+; CHECK: @clobbered
+; CHECK: %x = load i32* %a
+; CHECK: %y = load i32* %a
+; CHECK: %sum = add i32 %x, %y
+entry:
+  %x = load i32* %a
+  store i32 5, i32* %b
+  %y = load i32* %a
+  %sum = add i32 %x, %y
+  ret i32 %sum
+}
+
+; The loop writes only %b, so the load in it equals the one before it.
+define i32 @loop(i32* noalias %a, i32* noalias %b, i32 %n) {
+; CHECK: @loop
+; CHECK: body:
+; CHECK-NOT: load
+; CHECK: store i32 %x, i32* %b
+entry:
+  %x = load i32* %a
+  br label %body
+
+body:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %y = load i32* %a
+  store i32 %y, i32* %b
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %body
+
+exit:
+  ret i32 %x
+}
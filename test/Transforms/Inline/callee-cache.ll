@@ -0,0 +1,46 @@
+; RUN: opt < %s -inline -S | FileCheck %s
+; RUN: opt < %s -inline -inline-cost-callee-cache=false -S | FileCheck %s
+; Call sites that pass nothing to simplify share the analysis of the callee
+; body, but only when they start from the same cost and threshold.
+
+declare void @g(i32)
+
+define i32 @callee(i32 %a, i32 %b) {
+  %x1 = mul i32 %a, %b
+  %x2 = add i32 %x1, %a
+  %x3 = mul i32 %x2, %b
+  %x4 = add i32 %x3, %a
+  %x5 = mul i32 %x4, %b
+  %x6 = add i32 %x5, %a
+  %x7 = mul i32 %x6, %b
+  %x8 = add i32 %x7, %a
+  call void @g(i32 %x8)
+  call void @g(i32 %x4)
+  call void @g(i32 %x2)
+  call void @g(i32 %x6)
+  ret i32 %x8
+}
+
+define i32 @caller1(i32 %a, i32 %b) {
+; CHECK: @caller1
+; CHECK-NOT: call i32 @callee
+; CHECK: ret
+  %r = call i32 @callee(i32 %a, i32 %b)
+  ret i32 %r
+}
+
+define i32 @caller2(i32 %a, i32 %b) optsize {
+; CHECK: @caller2
+; CHECK: call i32 @callee
+; CHECK: ret
+  %r = call i32 @callee(i32 %a, i32 %b)
+  ret i32 %r
+}
+
+define i32 @caller3(i32 %b, i32 %a) {
+; CHECK: @caller3
+; CHECK-NOT: call i32 @callee
+; CHECK: ret
+  %r = call i32 @callee(i32 %a, i32 %b)
+  ret i32 %r
+}
@@ -0,0 +1,240 @@
+; RUN: opt < %s -inline -S | FileCheck %s
+; RUN: opt < %s -inline -inline-hot-callee-percent=101 -S | FileCheck %s -check-prefix=NOHOT
+
+; With entry counts from a profile, a hot callee gets the inline hint threshold
+; and a callee that the profiled run never entered gets the optsize one.
+
+define i32 @hot(i32 %a, i32 %b) {
+entry:
+  %v0 = xor i32 %a, %b
+  %v1 = mul i32 %v0, %b
+  %v2 = xor i32 %v1, %b
+  %v3 = mul i32 %v2, %b
+  %v4 = xor i32 %v3, %b
+  %v5 = mul i32 %v4, %b
+  %v6 = xor i32 %v5, %b
+  %v7 = mul i32 %v6, %b
+  %v8 = xor i32 %v7, %b
+  %v9 = mul i32 %v8, %b
+  %v10 = xor i32 %v9, %b
+  %v11 = mul i32 %v10, %b
+  %v12 = xor i32 %v11, %b
+  %v13 = mul i32 %v12, %b
+  %v14 = xor i32 %v13, %b
+  %v15 = mul i32 %v14, %b
+  %v16 = xor i32 %v15, %b
+  %v17 = mul i32 %v16, %b
+  %v18 = xor i32 %v17, %b
+  %v19 = mul i32 %v18, %b
+  %v20 = xor i32 %v19, %b
+  %v21 = mul i32 %v20, %b
+  %v22 = xor i32 %v21, %b
+  %v23 = mul i32 %v22, %b
+  %v24 = xor i32 %v23, %b
+  %v25 = mul i32 %v24, %b
+  %v26 = xor i32 %v25, %b
+  %v27 = mul i32 %v26, %b
+  %v28 = xor i32 %v27, %b
+  %v29 = mul i32 %v28, %b
+  %v30 = xor i32 %v29, %b
+  %v31 = mul i32 %v30, %b
+  %v32 = xor i32 %v31, %b
+  %v33 = mul i32 %v32, %b
+  %v34 = xor i32 %v33, %b
+  %v35 = mul i32 %v34, %b
+  %v36 = xor i32 %v35, %b
+  %v37 = mul i32 %v36, %b
+  %v38 = xor i32 %v37, %b
+  %v39 = mul i32 %v38, %b
+  %v40 = xor i32 %v39, %b
+  %v41 = mul i32 %v40, %b
+  %v42 = xor i32 %v41, %b
+  %v43 = mul i32 %v42, %b
+  %v44 = xor i32 %v43, %b
+  %v45 = mul i32 %v44, %b
+  %v46 = xor i32 %v45, %b
+  %v47 = mul i32 %v46, %b
+  %v48 = xor i32 %v47, %b
+  %v49 = mul i32 %v48, %b
+  %v50 = xor i32 %v49, %b
+  %v51 = mul i32 %v50, %b
+  %v52 = xor i32 %v51, %b
+  %v53 = mul i32 %v52, %b
+  %v54 = xor i32 %v53, %b
+  %v55 = mul i32 %v54, %b
+  %v56 = xor i32 %v55, %b
+  %v57 = mul i32 %v56, %b
+  %v58 = xor i32 %v57, %b
+  %v59 = mul i32 %v58, %b
+  %v60 = xor i32 %v59, %b
+  %v61 = mul i32 %v60, %b
+  %v62 = xor i32 %v61, %b
+  %v63 = mul i32 %v62, %b
+  %v64 = xor i32 %v63, %b
+  %v65 = mul i32 %v64, %b
+  %v66 = xor i32 %v65, %b
+  %v67 = mul i32 %v66, %b
+  %v68 = xor i32 %v67, %b
+  %v69 = mul i32 %v68, %b
+  %v70 = xor i32 %v69, %b
+  %v71 = mul i32 %v70, %b
+  %v72 = xor i32 %v71, %b
+  %v73 = mul i32 %v72, %b
+  %v74 = xor i32 %v73, %b
+  %v75 = mul i32 %v74, %b
+  %v76 = xor i32 %v75, %b
+  %v77 = mul i32 %v76, %b
+  %v78 = xor i32 %v77, %b
+  %v79 = mul i32 %v78, %b
+  ret i32 %v79
+}
+
+define i32 @cold(i32 %a, i32 %b) {
+entry:
+  %v0 = xor i32 %a, %b
+  %v1 = mul i32 %v0, %b
+  %v2 = xor i32 %v1, %b
+  %v3 = mul i32 %v2, %b
+  %v4 = xor i32 %v3, %b
+  %v5 = mul i32 %v4, %b
+  %v6 = xor i32 %v5, %b
+  %v7 = mul i32 %v6, %b
+  %v8 = xor i32 %v7, %b
+  %v9 = mul i32 %v8, %b
+  %v10 = xor i32 %v9, %b
+  %v11 = mul i32 %v10, %b
+  %v12 = xor i32 %v11, %b
+  %v13 = mul i32 %v12, %b
+  %v14 = xor i32 %v13, %b
+  %v15 = mul i32 %v14, %b
+  %v16 = xor i32 %v15, %b
+  %v17 = mul i32 %v16, %b
+  %v18 = xor i32 %v17, %b
+  %v19 = mul i32 %v18, %b
+  %v20 = xor i32 %v19, %b
+  %v21 = mul i32 %v20, %b
+  %v22 = xor i32 %v21, %b
+  %v23 = mul i32 %v22, %b
+  %v24 = xor i32 %v23, %b
+  %v25 = mul i32 %v24, %b
+  %v26 = xor i32 %v25, %b
+  %v27 = mul i32 %v26, %b
+  %v28 = xor i32 %v27, %b
+  %v29 = mul i32 %v28, %b
+  %v30 = xor i32 %v29, %b
+  %v31 = mul i32 %v30, %b
+  %v32 = xor i32 %v31, %b
+  %v33 = mul i32 %v32, %b
+  %v34 = xor i32 %v33, %b
+  %v35 = mul i32 %v34, %b
+  %v36 = xor i32 %v35, %b
+  %v37 = mul i32 %v36, %b
+  %v38 = xor i32 %v37, %b
+  %v39 = mul i32 %v38, %b
+  ret i32 %v39
+}
+
+define i32 @unprofiled(i32 %a, i32 %b) {
+entry:
+  %v0 = xor i32 %a, %b
+  %v1 = mul i32 %v0, %b
+  %v2 = xor i32 %v1, %b
+  %v3 = mul i32 %v2, %b
+  %v4 = xor i32 %v3, %b
+  %v5 = mul i32 %v4, %b
+  %v6 = xor i32 %v5, %b
+  %v7 = mul i32 %v6, %b
+  %v8 = xor i32 %v7, %b
+  %v9 = mul i32 %v8, %b
+  %v10 = xor i32 %v9, %b
+  %v11 = mul i32 %v10, %b
+  %v12 = xor i32 %v11, %b
+  %v13 = mul i32 %v12, %b
+  %v14 = xor i32 %v13, %b
+  %v15 = mul i32 %v14, %b
+  %v16 = xor i32 %v15, %b
+  %v17 = mul i32 %v16, %b
+  %v18 = xor i32 %v17, %b
+  %v19 = mul i32 %v18, %b
+  %v20 = xor i32 %v19, %b
+  %v21 = mul i32 %v20, %b
+  %v22 = xor i32 %v21, %b
+  %v23 = mul i32 %v22, %b
+  %v24 = xor i32 %v23, %b
+  %v25 = mul i32 %v24, %b
+  %v26 = xor i32 %v25, %b
+  %v27 = mul i32 %v26, %b
+  %v28 = xor i32 %v27, %b
+  %v29 = mul i32 %v28, %b
+  %v30 = xor i32 %v29, %b
+  %v31 = mul i32 %v30, %b
+  %v32 = xor i32 %v31, %b
+  %v33 = mul i32 %v32, %b
+  %v34 = xor i32 %v33, %b
+  %v35 = mul i32 %v34, %b
+  %v36 = xor i32 %v35, %b
+  %v37 = mul i32 %v36, %b
+  %v38 = xor i32 %v37, %b
+  %v39 = mul i32 %v38, %b
+  %v40 = xor i32 %v39, %b
+  %v41 = mul i32 %v40, %b
+  %v42 = xor i32 %v41, %b
+  %v43 = mul i32 %v42, %b
+  %v44 = xor i32 %v43, %b
+  %v45 = mul i32 %v44, %b
+  %v46 = xor i32 %v45, %b
+  %v47 = mul i32 %v46, %b
+  %v48 = xor i32 %v47, %b
+  %v49 = mul i32 %v48, %b
+  %v50 = xor i32 %v49, %b
+  %v51 = mul i32 %v50, %b
+  %v52 = xor i32 %v51, %b
+  %v53 = mul i32 %v52, %b
+  %v54 = xor i32 %v53, %b
+  %v55 = mul i32 %v54, %b
+  %v56 = xor i32 %v55, %b
+  %v57 = mul i32 %v56, %b
+  %v58 = xor i32 %v57, %b
+  %v59 = mul i32 %v58, %b
+  %v60 = xor i32 %v59, %b
+  %v61 = mul i32 %v60, %b
+  %v62 = xor i32 %v61, %b
+  %v63 = mul i32 %v62, %b
+  %v64 = xor i32 %v63, %b
+  %v65 = mul i32 %v64, %b
+  %v66 = xor i32 %v65, %b
+  %v67 = mul i32 %v66, %b
+  %v68 = xor i32 %v67, %b
+  %v69 = mul i32 %v68, %b
+  %v70 = xor i32 %v69, %b
+  %v71 = mul i32 %v70, %b
+  %v72 = xor i32 %v71, %b
+  %v73 = mul i32 %v72, %b
+  %v74 = xor i32 %v73, %b
+  %v75 = mul i32 %v74, %b
+  %v76 = xor i32 %v75, %b
+  %v77 = mul i32 %v76, %b
+  %v78 = xor i32 %v77, %b
+  %v79 = mul i32 %v78, %b
+  ret i32 %v79
+}
+
+define i32 @caller(i32 %a, i32 %b) {
+; CHECK: @caller
+; CHECK-NOT: call i32 @hot
+; CHECK: call i32 @cold
+; CHECK: call i32 @unprofiled
+; NOHOT: @caller
+; NOHOT: call i32 @hot
+; NOHOT: call i32 @cold
+  %x = call i32 @hot(i32 %a, i32 %b)
+  %y = call i32 @cold(i32 %x, i32 %b)
+  %z = call i32 @unprofiled(i32 %y, i32 %b)
+  ret i32 %z
+}
+
+!llvm.function_entry_counts = !{!0, !1, !2}
+
+!0 = metadata !{i32 (i32, i32)* @hot, i64 1000}
+!1 = metadata !{i32 (i32, i32)* @cold, i64 0}
+!2 = metadata !{i32 (i32, i32)* @caller, i64 1}
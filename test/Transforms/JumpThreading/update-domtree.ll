@@ -0,0 +1,63 @@
+; RUN: opt < %s -domtree -jump-threading -verify-dom-updates -S | FileCheck %s
+; Check that jump threading keeps an existing dominator tree up to date as it
+; threads edges and folds branches, rather than dropping it.
+
+declare i32 @f1()
+declare i32 @f2()
+declare void @f3()
+
+define i32 @test1(i1 %cond) {
+; CHECK: @test1
+entry:
+  br i1 %cond, label %T1, label %F1
+
+T1:
+  %v1 = call i32 @f1()
+  br label %Merge
+
+F1:
+  %v2 = call i32 @f2()
+  br label %Merge
+
+Merge:
+  %A = phi i1 [true, %T1], [false, %F1]
+  %B = phi i32 [%v1, %T1], [%v2, %F1]
+  br i1 %A, label %T2, label %F2
+
+T2:
+; CHECK: T2:
+; CHECK: ret i32 %v1
+  call void @f3()
+  ret i32 %B
+
+F2:
+; CHECK: F2:
+; CHECK: ret i32 %v2
+  ret i32 %B
+}
+
+define i32 @test2(i1 %cond) {
+; CHECK: @test2
+; CHECK-NOT: br i1 true
+entry:
+  br i1 true, label %A, label %B
+
+A:
+  %v1 = call i32 @f1()
+  br label %C
+
+B:
+  %v2 = call i32 @f2()
+  br label %C
+
+C:
+  %p = phi i32 [%v1, %A], [%v2, %B]
+  br i1 %cond, label %D, label %E
+
+D:
+  ret i32 %p
+
+E:
+  call void @f3()
+  br label %D
+}
@@ -0,0 +1,77 @@
+; RUN: opt < %s -basicaa -licm -enable-licm-memoryssa -verify-memoryssa -S | FileCheck %s
+
+; The loop only writes %b, so the load of %a is invariant.
+define void @hoist(i32* noalias %a, i32* noalias %b, i32 %n) {
+; CHECK: @hoist
+; CHECK: entry:
+; CHECK-NEXT: %x = load i32* %a
+; CHECK: body:
+; CHECK-NOT: load
+entry:
+  br label %body
+
+body:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %x = load i32* %a
+  %p = getelementptr i32* %b, i32 %i
+  store i32 %x, i32* %p
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %body
+
+exit:
+  ret void
+}
+
+; The load of %a may be changed by the store through %b in the loop.
+define void @no_hoist(i32* %a, i32* %b, i32 %n) {
+; CHECK: @no_hoist
+; CHECK: body:
+; CHECK: %x = load i32* %a
+entry:
+  br label %body
+
+body:
+  %i = phi i32 [ 0, %entry ], [ %i.next, %body ]
+  %x = load i32* %a
+  %p = getelementptr i32* %b, i32 %i
+  store i32 %x, i32* %p
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %exit, label %body
+
+exit:
+  ret void
+}
+
+; Hoisting out of the inner loop and then out of the outer one.
+define void @nested(i32* noalias %a, i32* noalias %b, i32 %n) {
+; CHECK: @nested
+; CHECK: entry:
+; CHECK-NEXT: %x = load i32* %a
+; CHECK: outer:
+; CHECK-NOT: load
+entry:
+  br label %outer
+
+outer:
+  %j = phi i32 [ 0, %entry ], [ %j.next, %outer.latch ]
+  br label %inner
+
+inner:
+  %i = phi i32 [ 0, %outer ], [ %i.next, %inner ]
+  %x = load i32* %a
+  %p = getelementptr i32* %b, i32 %i
+  store i32 %x, i32* %p
+  %i.next = add i32 %i, 1
+  %done = icmp eq i32 %i.next, %n
+  br i1 %done, label %outer.latch, label %inner
+
+outer.latch:
+  %j.next = add i32 %j, 1
+  %outer.done = icmp eq i32 %j.next, %n
+  br i1 %outer.done, label %exit, label %outer
+
+exit:
+  ret void
+}
@@ -0,0 +1,82 @@
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/branch.prof -S | FileCheck %s
+; RUN: opt < %s -sample-profile -sample-profile-file=%S/Inputs/branch.prof -analyze -branch-prob | FileCheck %s -check-prefix=PROB
+
+; Check that the samples of each line are turned into branch weights.  The
+; functions come from:
+;
+;  1  int branch(int x) {
+;  2    if (x > 0)
+;  3      return x * 3;
+;  4    return -x;
+;  5  }
+;  6
+;  7  int cold(int x) {
+;  8    if (x)
+;  9      return 1;
+; 10    return 2;
+; 11  }
+
+define i32 @branch(i32 %x) {
+; CHECK: @branch
+; CHECK: br i1 %cmp, label %if.then, label %if.end, !dbg !{{[0-9]+}}, !prof ![[BRANCH:[0-9]+]]
+; PROB: edge entry -> if.then probability is 900 / 1000 = 90%
+; PROB: edge entry -> if.end probability is 100 / 1000 = 10%
+entry:
+  %cmp = icmp sgt i32 %x, 0, !dbg !10
+  br i1 %cmp, label %if.then, label %if.end, !dbg !10
+
+if.then:
+  %mul = mul nsw i32 %x, 3, !dbg !11
+  br label %return, !dbg !11
+
+if.end:
+  %sub = sub nsw i32 0, %x, !dbg !12
+  br label %return, !dbg !12
+
+return:
+  %retval = phi i32 [ %mul, %if.then ], [ %sub, %if.end ]
+  ret i32 %retval, !dbg !13
+}
+
+; None of the samples of cold fall in the successors of its branch, so the
+; branch is left alone.
+define i32 @cold(i32 %x) {
+; CHECK: @cold
+; CHECK: br i1 %tobool, label %if.then, label %if.end, !dbg !{{[0-9]+}}{{$}}
+entry:
+  %tobool = icmp ne i32 %x, 0, !dbg !14
+  br i1 %tobool, label %if.then, label %if.end, !dbg !14
+
+if.then:
+  br label %return, !dbg !15
+
+if.end:
+  br label %return, !dbg !16
+
+return:
+  %retval = phi i32 [ 1, %if.then ], [ 2, %if.end ]
+  ret i32 %retval, !dbg !17
+}
+
+; CHECK: ![[BRANCH]] = metadata !{metadata !"branch_weights", i32 900, i32 100}
+
+!llvm.dbg.cu = !{!0}
+
+!0 = metadata !{i32 786449, i32 12, metadata !1, metadata !"clang version 3.3", i1 true, metadata !"", i32 0, metadata !2, metadata !2, metadata !3, metadata !2, metadata !2, metadata !""} ; [ DW_TAG_compile_unit ] [/tmp/branch.c] [DW_LANG_C99]
+!1 = metadata !{metadata !"branch.c", metadata !"/tmp"}
+!2 = metadata !{i32 0}
+!3 = metadata !{metadata !4, metadata !9}
+!4 = metadata !{i32 786478, metadata !1, metadata !5, metadata !"branch", metadata !"branch", metadata !"", i32 1, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32)* @branch, null, null, metadata !2, i32 1} ; [ DW_TAG_subprogram ] [line 1] [def] [branch]
+!5 = metadata !{i32 786473, metadata !1}          ; [ DW_TAG_file_type ] [/tmp/branch.c]
+!6 = metadata !{i32 786453, i32 0, metadata !"", i32 0, i32 0, i64 0, i64 0, i64 0, i32 0, null, metadata !7, i32 0, i32 0} ; [ DW_TAG_subroutine_type ] [line 0, size 0, align 0, offset 0] [from ]
+!7 = metadata !{metadata !8, metadata !8}
+!8 = metadata !{i32 786468, null, metadata !"int", null, i32 0, i64 32, i64 32, i64 0, i32 0, i32 5} ; [ DW_TAG_base_type ] [int] [line 0, size 32, align 32, offset 0, enc DW_ATE_signed]
+!9 = metadata !{i32 786478, metadata !1, metadata !5, metadata !"cold", metadata !"cold", metadata !"", i32 7, metadata !6, i1 false, i1 true, i32 0, i32 0, null, i32 256, i1 true, i32 (i32)* @cold, null, null, metadata !2, i32 7} ; [ DW_TAG_subprogram ] [line 7] [def] [cold]
+!10 = metadata !{i32 2, i32 0, metadata !4, null}
+!11 = metadata !{i32 3, i32 0, metadata !4, null}
+!12 = metadata !{i32 4, i32 0, metadata !4, null}
+!13 = metadata !{i32 5, i32 0, metadata !4, null}
+!14 = metadata !{i32 8, i32 0, metadata !9, null}
+!15 = metadata !{i32 9, i32 0, metadata !9, null}
+!16 = metadata !{i32 10, i32 0, metadata !9, null}
+!17 = metadata !{i32 11, i32 0, metadata !9, null}
@@ -77,6 +77,10 @@ DisableSimplifyLibCalls("disable-simplify-libcalls",
                         cl::desc("Disable simplify-libcalls"),
                         cl::init(false));
 
+static cl::opt<bool>
+DiscardValueNames("discard-value-names",
+                  cl::desc("Discard names from values other than globals"));
+
 static int compileModule(char**, LLVMContext&);
 
 // GetFileNameRoot - Helper function to get the basename of a filename.
@@ -145,7 +149,7 @@ static tool_output_file *GetOutputStream(const char *TargetName,
   // Open the file.
   std::string error;
   unsigned OpenFlags = 0;
-  if (Binary) OpenFlags |= raw_fd_ostream::F_Binary;
+  if (Binary) OpenFlags |= raw_fd_ostream::F_Binary | raw_fd_ostream::F_Map;
   tool_output_file *FDOut = new tool_output_file(OutputFilename.c_str(), error,
                                                  OpenFlags);
   if (!error.empty()) {
@@ -189,6 +193,8 @@ int main(int argc, char **argv) {
 
   cl::ParseCommandLineOptions(argc, argv, "llvm system compiler\n");
 
+  Context.setDiscardValueNames(DiscardValueNames);
+
   // Compile the module TimeCompilations times to give better compile time
   // metrics.
   for (unsigned I = TimeCompilations; I; --I)
@@ -279,6 +285,7 @@ static int compileModule(char **argv, LLVMContext &Context) {
   Options.PositionIndependentExecutable = EnablePIE;
   Options.EnableSegmentedStacks = SegmentedStacks;
   Options.UseInitArray = UseInitArray;
+  Options.CompressDebugSections = CompressDebugSections;
   Options.SSPBufferSize = SSPBufferSize;
 
   OwningPtr<TargetMachine>
@@ -156,6 +156,8 @@ static const char *GetCodeName(unsigned CodeID, unsigned BlockID,
     case bitc::MODULE_CODE_ALIAS:       return "ALIAS";
     case bitc::MODULE_CODE_PURGEVALS:   return "PURGEVALS";
     case bitc::MODULE_CODE_GCNAME:      return "GCNAME";
+    case bitc::MODULE_CODE_FNINDEXOFFSET: return "FNINDEXOFFSET";
+    case bitc::MODULE_CODE_FNINDEX:     return "FNINDEX";
     }
   case bitc::PARAMATTR_BLOCK_ID:
     switch (CodeID) {
@@ -28,6 +28,7 @@
 #include "llvm/MC/MCTargetAsmParser.h"
 #include "llvm/Support/CommandLine.h"
 #include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/Format.h"
 #include "llvm/Support/FormattedStream.h"
 #include "llvm/Support/Host.h"
 #include "llvm/Support/ManagedStatic.h"
@@ -37,6 +38,7 @@
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/Timer.h"
 #include "llvm/Support/ToolOutputFile.h"
 using namespace llvm;
 
@@ -70,6 +72,10 @@ DisableCFI("disable-cfi", cl::desc("Do not use .cfi_* directives"));
 static cl::opt<bool>
 NoExecStack("mc-no-exec-stack", cl::desc("File doesn't need an exec stack"));
 
+static cl::opt<bool>
+CompressDebugSections("compress-debug-sections",
+                      cl::desc("Compress DWARF debug sections"));
+
 enum OutputFileType {
   OFT_Null,
   OFT_AssemblyFile,
@@ -146,6 +152,11 @@ static cl::opt<bool>
 NoInitialTextSection("n", cl::desc("Don't assume assembly file starts "
                                    "in the text section"));
 
+static cl::opt<bool>
+ShowThroughput("show-throughput",
+               cl::desc("Print the amount of assembly parsed and the "
+                        "throughput to stderr"));
+
 static cl::opt<bool>
 SaveTempLabels("L", cl::desc("Don't discard temporary labels"));
 
@@ -211,7 +222,8 @@ static tool_output_file *GetOutputStream() {
 
   std::string Err;
   tool_output_file *Out = new tool_output_file(OutputFilename.c_str(), Err,
-                                               raw_fd_ostream::F_Binary);
+                                               raw_fd_ostream::F_Binary |
+                                               raw_fd_ostream::F_Map);
   if (!Err.empty()) {
     errs() << Err << '\n';
     delete Out;
@@ -332,8 +344,28 @@ static int AssembleInput(const char *ProgName, const Target *TheTarget,
   Parser->setShowParsedOperands(ShowInstOperands);
   Parser->setTargetParser(*TAP.get());
 
+  TimeRecord Elapsed = TimeRecord::getCurrentTime(false);
   int Res = Parser->Run(NoInitialTextSection);
 
+  if (ShowThroughput) {
+    Elapsed -= TimeRecord::getCurrentTime(true);
+    double Seconds = -Elapsed.getWallTime();
+
+    // Everything the lexer saw: the input, included files and the text of
+    // every macro instantiation.
+    uint64_t InputBytes = SrcMgr.getMemoryBuffer(0)->getBufferSize();
+    uint64_t ParsedBytes = 0;
+    for (unsigned i = 0, e = SrcMgr.getNumBuffers(); i != e; ++i)
+      ParsedBytes += SrcMgr.getMemoryBuffer(i)->getBufferSize();
+
+    errs() << ProgName << ": "
+           << format("%.2f MB input, %.2f MB parsed in %.3f s: ",
+                     InputBytes / 1e6, ParsedBytes / 1e6, Seconds)
+           << format("%.1f MB/s input, %.1f MB/s parsed\n",
+                     Seconds > 0 ? InputBytes / 1e6 / Seconds : 0.0,
+                     Seconds > 0 ? ParsedBytes / 1e6 / Seconds : 0.0);
+  }
+
   return Res;
 }
 
@@ -382,6 +414,9 @@ int main(int argc, char **argv) {
   llvm::OwningPtr<MCAsmInfo> MAI(TheTarget->createMCAsmInfo(TripleName));
   assert(MAI && "Unable to create target asm info!");
 
+  if (CompressDebugSections)
+    MAI->setCompressDebugSections(true);
+
   llvm::OwningPtr<MCRegisterInfo> MRI(TheTarget->createMCRegInfo(TripleName));
   assert(MRI && "Unable to create target register info!");
 
@@ -0,0 +1,223 @@
+//===-- llvm-perf2prof.cpp - Convert perf samples to a sample profile -----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program reads the instruction addresses sampled by Linux perf, as
+// printed by 'perf script -F ip', symbolizes them against the DWARF line
+// table of the profiled binary and writes the text profile read by the
+// -sample-profile pass:
+//
+//    function_name:total_samples:head_samples
+//    offset: samples
+//    ...
+//
+// Offsets are relative to the line the function is declared on, its
+// DW_AT_decl_line, which is the line of its DISubprogram that the
+// -sample-profile pass uses.  Samples taken in inlined code are charged to the
+// call site in the function they were inlined into.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace object;
+
+static cl::opt<std::string>
+InputFilename(cl::Positional, cl::desc("<perf script output>"),
+              cl::init("-"));
+
+static cl::opt<std::string>
+BinaryFilename("binary", cl::Required,
+               cl::desc("The profiled binary, with debug line tables"),
+               cl::value_desc("filename"));
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"),
+               cl::init("-"));
+
+namespace {
+  /// FunctionSymbol - The extent of a function in the symbol table.
+  struct FunctionSymbol {
+    uint64_t End;
+    StringRef Name;
+  };
+
+  /// FunctionProfile - The samples accumulated for one function.
+  struct FunctionProfile {
+    unsigned TotalSamples;
+    unsigned HeadSamples;
+    std::map<unsigned, unsigned> BodySamples;
+
+    FunctionProfile() : TotalSamples(0), HeadSamples(0) {}
+  };
+}
+
+/// FunctionMap - Function symbols of the binary, keyed by start address.
+typedef std::map<uint64_t, FunctionSymbol> FunctionMap;
+
+static bool error(error_code EC, StringRef Context) {
+  if (!EC)
+    return false;
+  errs() << "llvm-perf2prof: " << Context << ": " << EC.message() << "\n";
+  return true;
+}
+
+static void collectFunctions(const ObjectFile &Obj, FunctionMap &Functions) {
+  error_code EC;
+  for (symbol_iterator SI = Obj.begin_symbols(), SE = Obj.end_symbols();
+       SI != SE; SI.increment(EC)) {
+    if (error(EC, BinaryFilename))
+      return;
+    SymbolRef::Type Type;
+    uint64_t Address, Size;
+    StringRef Name;
+    if (SI->getType(Type) || Type != SymbolRef::ST_Function ||
+        SI->getAddress(Address) || Address == UnknownAddressOrSize ||
+        SI->getSize(Size) || Size == UnknownAddressOrSize || Size == 0 ||
+        SI->getName(Name))
+      continue;
+    FunctionSymbol FS = { Address + Size, Name };
+    Functions.insert(std::make_pair(Address, FS));
+  }
+}
+
+/// parseAddress - Read the first token of a 'perf script -F ip' line, which
+/// is the sampled address in hex with or without a leading 0x.
+static bool parseAddress(StringRef Line, uint64_t &Address) {
+  StringRef Token = Line.ltrim().split(' ').first.split('\t').first;
+  if (Token.startswith("0x"))
+    Token = Token.substr(2);
+  return !Token.empty() && !Token.getAsInteger(16, Address);
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  cl::ParseCommandLineOptions(argc, argv,
+                              "perf samples to sample profile converter\n");
+
+  OwningPtr<MemoryBuffer> BinaryBuffer;
+  if (error(MemoryBuffer::getFile(BinaryFilename, BinaryBuffer),
+            BinaryFilename))
+    return 1;
+  OwningPtr<ObjectFile> Obj(
+    ObjectFile::createObjectFile(BinaryBuffer.take()));
+  if (!Obj) {
+    errs() << "llvm-perf2prof: " << BinaryFilename
+           << ": Unknown object file format\n";
+    return 1;
+  }
+  OwningPtr<DIContext> DICtx(DIContext::getDWARFContext(Obj.get()));
+
+  FunctionMap Functions;
+  collectFunctions(*Obj, Functions);
+
+  OwningPtr<MemoryBuffer> Input;
+  if (error(MemoryBuffer::getFileOrSTDIN(InputFilename, Input), InputFilename))
+    return 1;
+
+  StringMap<FunctionProfile> Profiles;
+  // HeaderLines - The line each function's offsets are relative to, by start
+  // address: the declaration line of its subprogram, which is what the
+  // sample profile loader uses too.  0 for functions without debug info.
+  std::map<uint64_t, unsigned> HeaderLines;
+  unsigned NumSamples = 0, NumDropped = 0;
+
+  StringRef Rest = Input->getBuffer();
+  while (!Rest.empty()) {
+    std::pair<StringRef, StringRef> Split = Rest.split('\n');
+    Rest = Split.second;
+    uint64_t Address;
+    if (!parseAddress(Split.first, Address))
+      continue;
+    ++NumSamples;
+
+    FunctionMap::const_iterator FI = Functions.upper_bound(Address);
+    if (FI == Functions.begin() || (--FI, Address >= FI->second.End)) {
+      ++NumDropped;
+      continue;
+    }
+    uint64_t Start = FI->first;
+
+    std::map<uint64_t, unsigned>::iterator HI = HeaderLines.find(Start);
+    if (HI == HeaderLines.end()) {
+      // The outermost frame at the start address is the function itself.
+      DIInliningInfo StartFrames = DICtx->getInliningInfoForAddress(
+        Start, DILineInfoSpecifier(DILineInfoSpecifier::FunctionName));
+      unsigned N = StartFrames.getNumberOfFrames();
+      HI = HeaderLines.insert(std::make_pair(
+        Start, N ? StartFrames.getFrame(N - 1).getStartLine() : 0)).first;
+    }
+    unsigned HeaderLine = HI->second;
+
+    // The outermost frame is the one in the function that owns the symbol;
+    // for inlined code its line is that of the call site.
+    DIInliningInfo Frames = DICtx->getInliningInfoForAddress(Address);
+    unsigned Line = Frames.getNumberOfFrames() ?
+      Frames.getFrame(Frames.getNumberOfFrames() - 1).getLine() :
+      DICtx->getLineInfoForAddress(Address).getLine();
+    if (!HeaderLine || Line < HeaderLine) {
+      ++NumDropped;
+      continue;
+    }
+
+    FunctionProfile &Profile = Profiles[FI->second.Name];
+    ++Profile.TotalSamples;
+    if (Address == Start)
+      ++Profile.HeadSamples;
+    ++Profile.BodySamples[Line - HeaderLine];
+  }
+
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo);
+  if (!ErrorInfo.empty()) {
+    errs() << "llvm-perf2prof: " << ErrorInfo << "\n";
+    return 1;
+  }
+
+  // Emit functions in name order so that the output is stable.
+  std::vector<StringRef> Names;
+  for (StringMap<FunctionProfile>::const_iterator I = Profiles.begin(),
+       E = Profiles.end(); I != E; ++I)
+    Names.push_back(I->getKey());
+  std::sort(Names.begin(), Names.end());
+
+  for (unsigned i = 0, e = Names.size(); i != e; ++i) {
+    const FunctionProfile &Profile = Profiles[Names[i]];
+    Out.os() << Names[i] << ':' << Profile.TotalSamples << ':'
+             << Profile.HeadSamples << '\n';
+    for (std::map<unsigned, unsigned>::const_iterator
+         I = Profile.BodySamples.begin(), E = Profile.BodySamples.end();
+         I != E; ++I)
+      Out.os() << I->first << ": " << I->second << '\n';
+  }
+  Out.keep();
+
+  if (NumDropped)
+    errs() << "llvm-perf2prof: " << NumDropped << " of " << NumSamples
+           << " samples could not be attributed to a function\n";
+  return 0;
+}
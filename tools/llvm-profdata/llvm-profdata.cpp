@@ -0,0 +1,228 @@
+//===-- llvm-profdata.cpp - Counter profile manipulation tool -------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// llvm-profdata merges the indexed profiles written by programs built with
+// -insert-counter-profiling and prints them as text:
+//
+//   llvm-profdata merge <profiles...> -o <output> [-text]
+//   llvm-profdata show <profile>
+//
+// Any input can also be in the text format, which is one record per function:
+//
+//   function_name
+//   hash
+//   number_of_counters
+//   counter
+//   ...
+//
+// with records separated by blank lines and '#' starting a comment line.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/CounterProfile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ManagedStatic.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/PrettyStackTrace.h"
+#include "llvm/Support/Signals.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/system_error.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string>
+InputFilenames(cl::Positional, cl::desc("<profiles>"), cl::OneOrMore);
+
+static cl::opt<std::string>
+OutputFilename("o", cl::desc("Output filename"), cl::value_desc("filename"),
+               cl::init("-"));
+
+static cl::opt<bool>
+TextOutput("text", cl::desc("Write the merged profile as text"));
+
+static const char *ProgramName = "llvm-profdata";
+
+static void printRecord(raw_ostream &OS, const CounterProfileRecord &Record) {
+  OS << Record.Name << "\n" << Record.Hash << "\n"
+     << Record.Counts.size() << "\n";
+  for (unsigned i = 0, e = Record.Counts.size(); i != e; ++i)
+    OS << Record.Counts[i] << "\n";
+  OS << "\n";
+}
+
+namespace {
+/// TextProfileParser - Reads records in the text format one at a time.
+class TextProfileParser {
+  StringRef Rest;
+  unsigned LineNo;
+
+  /// nextLine - Return the next line that is neither blank nor a comment,
+  /// or an empty string at the end of the input.
+  StringRef nextLine() {
+    while (!Rest.empty()) {
+      std::pair<StringRef, StringRef> Split = Rest.split('\n');
+      Rest = Split.second;
+      ++LineNo;
+      StringRef Line = Split.first.trim();
+      if (!Line.empty() && Line[0] != '#')
+        return Line;
+    }
+    return StringRef();
+  }
+
+  bool nextNumber(uint64_t &N, std::string &ErrorMsg) {
+    StringRef Line = nextLine();
+    if (Line.empty() || Line.getAsInteger(10, N)) {
+      ErrorMsg = "line " + utostr(LineNo) + ": expected a number";
+      return false;
+    }
+    return true;
+  }
+
+public:
+  explicit TextProfileParser(StringRef Buffer) : Rest(Buffer), LineNo(0) {}
+
+  /// readRecord - Read the next record.  Return false at the end of the
+  /// input or, with ErrorMsg set, on a malformed record.
+  bool readRecord(CounterProfileRecord &Record, std::string &ErrorMsg) {
+    StringRef Name = nextLine();
+    if (Name.empty())
+      return false;
+    uint64_t NumCounters;
+    if (!nextNumber(Record.Hash, ErrorMsg) ||
+        !nextNumber(NumCounters, ErrorMsg))
+      return false;
+    Record.Name = Name;
+    Record.Counts.resize(NumCounters);
+    for (uint64_t i = 0; i != NumCounters; ++i)
+      if (!nextNumber(Record.Counts[i], ErrorMsg))
+        return false;
+    return true;
+  }
+};
+}
+
+/// readProfile - Pass every record of the profile in Filename, indexed or
+/// text, to Writer.  Return false after reporting an error.
+static bool readProfile(StringRef Filename, CounterProfileWriter &Writer) {
+  OwningPtr<MemoryBuffer> Buffer;
+  if (error_code EC = MemoryBuffer::getFileOrSTDIN(Filename, Buffer)) {
+    errs() << ProgramName << ": " << Filename << ": " << EC.message() << "\n";
+    return false;
+  }
+
+  std::string ErrorMsg;
+  CounterProfileRecord Record;
+  if (CounterProfileReader::hasIndexedMagic(*Buffer)) {
+    OwningPtr<CounterProfileReader> Reader(
+      CounterProfileReader::create(Buffer.take(), ErrorMsg));
+    if (!Reader) {
+      errs() << ProgramName << ": " << Filename << ": " << ErrorMsg << "\n";
+      return false;
+    }
+    for (uint64_t I = 0, E = Reader->getNumFunctions(); I != E; ++I) {
+      Reader->getRecord(I, Record);
+      if (!Writer.addRecord(Record))
+        errs() << ProgramName << ": " << Filename << ": warning: profile of '"
+               << Record.Name << "' does not match earlier inputs, ignored\n";
+    }
+    return true;
+  }
+
+  TextProfileParser Parser(Buffer->getBuffer());
+  while (Parser.readRecord(Record, ErrorMsg))
+    if (!Writer.addRecord(Record))
+      errs() << ProgramName << ": " << Filename << ": warning: profile of '"
+             << Record.Name << "' does not match earlier inputs, ignored\n";
+  if (!ErrorMsg.empty()) {
+    errs() << ProgramName << ": " << Filename << ": " << ErrorMsg << "\n";
+    return false;
+  }
+  return true;
+}
+
+static int mergeMain(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "merge counter profiles\n");
+
+  CounterProfileWriter Writer;
+  for (unsigned i = 0, e = InputFilenames.size(); i != e; ++i)
+    if (!readProfile(InputFilenames[i], Writer))
+      return 1;
+
+  std::string ErrorInfo;
+  tool_output_file Out(OutputFilename.c_str(), ErrorInfo,
+                       TextOutput ? 0 : raw_fd_ostream::F_Binary);
+  if (!ErrorInfo.empty()) {
+    errs() << ProgramName << ": " << ErrorInfo << "\n";
+    return 1;
+  }
+
+  if (TextOutput) {
+    for (CounterProfileWriter::const_iterator I = Writer.begin(),
+         E = Writer.end(); I != E; ++I)
+      printRecord(Out.os(), I->second);
+  } else {
+    Writer.write(Out.os());
+  }
+  Out.keep();
+  return 0;
+}
+
+static int showMain(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "print a counter profile\n");
+  if (InputFilenames.size() != 1) {
+    errs() << ProgramName << ": show takes exactly one profile\n";
+    return 1;
+  }
+
+  std::string ErrorMsg;
+  OwningPtr<CounterProfileReader> Reader(
+    CounterProfileReader::create(InputFilenames[0], ErrorMsg));
+  if (!Reader) {
+    errs() << ProgramName << ": " << ErrorMsg << "\n";
+    return 1;
+  }
+
+  CounterProfileRecord Record;
+  for (uint64_t I = 0, E = Reader->getNumFunctions(); I != E; ++I) {
+    Reader->getRecord(I, Record);
+    printRecord(outs(), Record);
+  }
+  return 0;
+}
+
+int main(int argc, char **argv) {
+  sys::PrintStackTraceOnErrorSignal();
+  PrettyStackTraceProgram X(argc, argv);
+  llvm_shutdown_obj Y;  // Call llvm_shutdown() on exit.
+
+  // Each command parses the rest of the command line on its own.
+  if (argc > 1) {
+    int (*Command)(int, char **) = 0;
+    if (!strcmp(argv[1], "merge"))
+      Command = mergeMain;
+    else if (!strcmp(argv[1], "show"))
+      Command = showMain;
+    if (Command) {
+      std::string Name = std::string(argv[0]) + " " + argv[1];
+      argv[1] = const_cast<char *>(Name.c_str());
+      return Command(argc - 1, argv + 1);
+    }
+  }
+
+  errs() << "usage: " << ProgramName << " <merge|show> [options] <profiles>\n";
+  return 1;
+}
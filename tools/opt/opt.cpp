@@ -157,6 +157,10 @@ DefaultDataLayout("default-data-layout",
           cl::desc("data layout string to use if not specified by module"),
           cl::value_desc("layout-string"), cl::init(""));
 
+static cl::opt<bool>
+DiscardValueNames("discard-value-names",
+                  cl::desc("Discard names from values other than globals"));
+
 // ---------- Define Printers for module and function passes ------------
 namespace {
 
@@ -509,6 +513,7 @@ static TargetOptions GetTargetOptions() {
   Options.PositionIndependentExecutable = EnablePIE;
   Options.EnableSegmentedStacks = SegmentedStacks;
   Options.UseInitArray = UseInitArray;
+  Options.CompressDebugSections = CompressDebugSections;
   Options.SSPBufferSize = SSPBufferSize;
   return Options;
 }
@@ -586,6 +591,8 @@ int main(int argc, char **argv) {
     return 1;
   }
 
+  Context.setDiscardValueNames(DiscardValueNames);
+
   SMDiagnostic Err;
 
   // Load the input module...
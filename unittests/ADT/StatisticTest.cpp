@@ -0,0 +1,129 @@
+//===- llvm/unittest/ADT/StatisticTest.cpp - Statistic unit tests ---------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#define DEBUG_TYPE "unittest"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Support/raw_ostream.h"
+#include "gtest/gtest.h"
+using namespace llvm;
+
+STATISTIC(Counter, "Counts things");
+STATISTIC(Counter2, "Counts other things");
+
+namespace other {
+// Has the same "unittest.Counter" key as ::Counter, like statistics with the
+// same name in two files with the same DEBUG_TYPE.
+STATISTIC(Counter, "Counts things elsewhere");
+}
+
+namespace {
+
+static std::string printJSON() {
+  std::string JSON;
+  raw_string_ostream OS(JSON);
+  PrintStatisticsJSON(OS);
+  return OS.str();
+}
+
+TEST(StatisticTest, EmptyJSON) {
+  ResetStatistics();
+  EXPECT_EQ("{\n"
+            "  \"statistics\": {\n"
+            "  },\n"
+            "  \"functions\": {\n"
+            "  }\n"
+            "}\n", printJSON());
+}
+
+#if !defined(NDEBUG) || defined(LLVM_ENABLE_STATS)
+TEST(StatisticTest, Count) {
+  EnableStatistics();
+  ResetStatistics();
+
+  EXPECT_EQ(0u, Counter);
+  ++Counter;
+  EXPECT_EQ(1u, Counter);
+  EXPECT_EQ(1u, Counter++);
+  EXPECT_EQ(2u, Counter);
+  Counter += 3;
+  EXPECT_EQ(5u, Counter);
+  EXPECT_EQ(5u, Counter--);
+  Counter -= 2;
+  EXPECT_EQ(2u, Counter);
+
+  ResetStatistics();
+  EXPECT_EQ(0u, Counter);
+}
+
+TEST(StatisticTest, ScopesAndJSON) {
+  EnableStatistics();
+  EnableScopedStatistics();
+  ResetStatistics();
+
+  {
+    StatisticScope Outer("foo");
+    ++Counter;
+    {
+      StatisticScope Inner("b\"a\\r");
+      Counter2 += 2;
+      ++Counter;
+    }
+    ++Counter;
+  }
+  // Outside of any scope only the totals change.
+  ++Counter;
+
+  EXPECT_EQ("{\n"
+            "  \"statistics\": {\n"
+            "    \"unittest.Counter\": 4,\n"
+            "    \"unittest.Counter2\": 2\n"
+            "  },\n"
+            "  \"functions\": {\n"
+            "    \"b\\\"a\\\\r\": {\n"
+            "      \"unittest.Counter\": 1,\n"
+            "      \"unittest.Counter2\": 2\n"
+            "    },\n"
+            "    \"foo\": {\n"
+            "      \"unittest.Counter\": 2\n"
+            "    }\n"
+            "  }\n"
+            "}\n", printJSON());
+
+  ResetStatistics();
+}
+
+TEST(StatisticTest, SharedJSONKey) {
+  EnableStatistics();
+  EnableScopedStatistics();
+  ResetStatistics();
+
+  {
+    StatisticScope Scope("foo");
+    Counter += 2;
+    other::Counter += 3;
+  }
+  ++other::Counter;
+
+  // Statistics with the same key are printed once, with their values added.
+  EXPECT_EQ("{\n"
+            "  \"statistics\": {\n"
+            "    \"unittest.Counter\": 6\n"
+            "  },\n"
+            "  \"functions\": {\n"
+            "    \"foo\": {\n"
+            "      \"unittest.Counter\": 5\n"
+            "    }\n"
+            "  }\n"
+            "}\n", printJSON());
+
+  ResetStatistics();
+}
+#endif
+
+} // end anonymous namespace
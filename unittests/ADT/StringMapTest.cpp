@@ -220,4 +220,41 @@ TEST_F(StringMapTest, InsertTest) {
   assertSingleItemMap();
 }
 
+// Test the lookup methods that take a precomputed hash value.
+TEST_F(StringMapTest, PrehashedLookupTest) {
+  unsigned Hash = StringMapImpl::hash(testKeyStr);
+  EXPECT_EQ(Hash, StringMapImpl::hash(StringRef(testKeyFirst, testKeyLength)));
+
+  EXPECT_TRUE(testMap.find(testKey, Hash) == testMap.end());
+  testMap.GetOrCreateValue(testKey, Hash, testValue);
+  assertSingleItemMap();
+  EXPECT_EQ(testValue, testMap.find(testKeyStr, Hash)->second);
+
+  // An existing entry is returned unchanged.
+  EXPECT_EQ(testValue, testMap.GetOrCreateValue(testKey, Hash, 7u).second);
+
+  // The same hash finds the key in another map.
+  StringMap<uint32_t> otherMap;
+  EXPECT_TRUE(otherMap.insert(
+      StringMap<uint32_t>::value_type::Create(
+          testKeyFirst, testKeyFirst + testKeyLength,
+          otherMap.getAllocator(), 3u), Hash));
+  EXPECT_EQ(3u, otherMap.lookup(testKey));
+  EXPECT_EQ(3u, otherMap.find(testKey, Hash)->second);
+
+  // Hashes survive rehashing.
+  for (int i = 0; i < 100; ++i) {
+    std::stringstream ss;
+    ss << "key_" << i;
+    otherMap[ss.str()] = i;
+  }
+  EXPECT_EQ(3u, otherMap.find(testKey, Hash)->second);
+  for (int i = 0; i < 100; ++i) {
+    std::stringstream ss;
+    ss << "key_" << i;
+    EXPECT_EQ(uint32_t(i),
+              otherMap.find(ss.str(), StringMapImpl::hash(ss.str()))->second);
+  }
+}
+
 } // end anonymous namespace
@@ -0,0 +1,184 @@
+//===- llvm/unittest/ADT/SwissMapTest.cpp - SwissMap unit tests -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// The DenseMap-compatible interface is covered by the typed tests in
+// DenseMapTest.cpp.  These tests exercise probing, deletion and growth.
+//
+//===----------------------------------------------------------------------===//
+
+#include "gtest/gtest.h"
+#include "llvm/ADT/SwissMap.h"
+#include <map>
+#include <string>
+
+using namespace llvm;
+
+namespace {
+
+// Hashes every key to the same value, so every lookup has to walk the whole
+// probe sequence and compare keys.
+struct CollidingMapInfo {
+  static inline unsigned getEmptyKey() { return ~0U; }
+  static inline unsigned getTombstoneKey() { return ~0U - 1; }
+  static unsigned getHashValue(const unsigned &) { return 42; }
+  static bool isEqual(const unsigned &LHS, const unsigned &RHS) {
+    return LHS == RHS;
+  }
+};
+
+// Key traits that allows lookup with either an unsigned or char* key;
+// In the latter case, "a" == 0, "b" == 1 and so on.
+struct TestSwissMapInfo {
+  static unsigned getHashValue(const unsigned &Val) { return Val * 37U; }
+  static unsigned getHashValue(const char *Val) {
+    return (unsigned)(Val[0] - 'a') * 37U;
+  }
+  static bool isEqual(const unsigned &LHS, const unsigned &RHS) {
+    return LHS == RHS;
+  }
+  static bool isEqual(const char *LHS, const unsigned &RHS) {
+    return (unsigned)(LHS[0] - 'a') == RHS;
+  }
+};
+
+// Keys without empty or tombstone values work.
+struct StringMapInfo {
+  static unsigned getHashValue(const std::string &Val) {
+    return HashString(Val);
+  }
+  static bool isEqual(const std::string &LHS, const std::string &RHS) {
+    return LHS == RHS;
+  }
+  static unsigned HashString(const std::string &Str) {
+    unsigned Result = 0;
+    for (unsigned i = 0, e = Str.size(); i != e; ++i)
+      Result = Result * 33 + (unsigned char)Str[i];
+    return Result;
+  }
+};
+
+TEST(SwissMapTest, FindAsTest) {
+  SwissMap<unsigned, unsigned, TestSwissMapInfo> map;
+  map[0] = 1;
+  map[1] = 2;
+  map[2] = 3;
+
+  EXPECT_EQ(3u, map.size());
+  EXPECT_EQ(1u, map.find_as("a")->second);
+  EXPECT_EQ(2u, map.find_as("b")->second);
+  EXPECT_EQ(3u, map.find_as("c")->second);
+  EXPECT_TRUE(map.find_as("d") == map.end());
+}
+
+TEST(SwissMapTest, GrowTest) {
+  SwissMap<unsigned, unsigned> map;
+  const void *Buckets = map.getPointerIntoBucketsArray();
+  for (unsigned i = 0; i != 10000; ++i)
+    map[i] = i * 2;
+  EXPECT_NE(Buckets, map.getPointerIntoBucketsArray());
+
+  EXPECT_EQ(10000u, map.size());
+  for (unsigned i = 0; i != 10000; ++i) {
+    ASSERT_TRUE(map.count(i));
+    EXPECT_EQ(i * 2, map.lookup(i));
+  }
+  EXPECT_FALSE(map.count(10000));
+
+  unsigned Visited = 0;
+  for (SwissMap<unsigned, unsigned>::iterator I = map.begin(), E = map.end();
+       I != E; ++I, ++Visited)
+    EXPECT_EQ(I->first * 2, I->second);
+  EXPECT_EQ(10000u, Visited);
+}
+
+TEST(SwissMapTest, ResizeTest) {
+  SwissMap<unsigned, unsigned> map;
+  map.resize(1000);
+  EXPECT_LE(1000u * sizeof(std::pair<unsigned, unsigned>),
+            map.getMemorySize());
+
+  // Filling the requested buckets at the maximum load factor must not move
+  // them.
+  const void *Buckets = map.getPointerIntoBucketsArray();
+  for (unsigned i = 0; i != 800; ++i)
+    map[i] = i;
+  EXPECT_EQ(Buckets, map.getPointerIntoBucketsArray());
+}
+
+TEST(SwissMapTest, CollisionTest) {
+  SwissMap<unsigned, unsigned, CollidingMapInfo> map;
+  for (unsigned i = 0; i != 200; ++i)
+    EXPECT_TRUE(map.insert(std::make_pair(i, i + 1)).second);
+  EXPECT_FALSE(map.insert(std::make_pair(7u, 0u)).second);
+
+  for (unsigned i = 0; i != 200; i += 2)
+    EXPECT_TRUE(map.erase(i));
+  EXPECT_FALSE(map.erase(0));
+  EXPECT_EQ(100u, map.size());
+
+  for (unsigned i = 0; i != 200; ++i) {
+    if (i % 2)
+      EXPECT_EQ(i + 1, map.lookup(i));
+    else
+      EXPECT_FALSE(map.count(i));
+  }
+}
+
+// Repeatedly inserting and erasing keys leaves deleted buckets behind.  The
+// map must reclaim them rather than growing or running out of empty buckets
+// to end its probe sequences.
+TEST(SwissMapTest, ChurnTest) {
+  SwissMap<unsigned, unsigned> map;
+  std::map<unsigned, unsigned> Ref;
+  unsigned Seed = 1;
+  for (unsigned i = 0; i != 100000; ++i) {
+    Seed = Seed * 1103515245 + 12345;
+    unsigned Key = (Seed >> 16) % 512;
+    if (Seed & 0x100) {
+      map[Key] = i;
+      Ref[Key] = i;
+    } else {
+      EXPECT_EQ(Ref.erase(Key) != 0, map.erase(Key));
+    }
+  }
+
+  EXPECT_EQ(Ref.size(), map.size());
+  EXPECT_GE(2048u * sizeof(std::pair<unsigned, unsigned>),
+            map.getMemorySize());
+  for (std::map<unsigned, unsigned>::iterator I = Ref.begin(), E = Ref.end();
+       I != E; ++I)
+    EXPECT_EQ(I->second, map.lookup(I->first));
+}
+
+TEST(SwissMapTest, StringKeyTest) {
+  SwissMap<std::string, unsigned, StringMapInfo> map;
+  map["foo"] = 1;
+  map["bar"] = 2;
+  map.erase("foo");
+  map["baz"] = 3;
+
+  EXPECT_EQ(2u, map.size());
+  EXPECT_FALSE(map.count("foo"));
+  EXPECT_EQ(2u, map.lookup("bar"));
+  EXPECT_EQ(3u, map.lookup("baz"));
+
+  SwissMap<std::string, unsigned, StringMapInfo> copy;
+  copy["qux"] = 4;
+  copy = map;
+  EXPECT_EQ(2u, copy.size());
+  EXPECT_FALSE(copy.count("qux"));
+  EXPECT_EQ(3u, copy.lookup("baz"));
+
+  map.clear();
+  EXPECT_TRUE(map.empty());
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_EQ(2u, copy.size());
+}
+
+}
@@ -87,6 +87,45 @@ TEST_F(ScalarEvolutionsTest, SCEVUnknownRAUW) {
   EXPECT_EQ(cast<SCEVUnknown>(M2->getOperand(1))->getValue(), V0);
 }
 
+TEST_F(ScalarEvolutionsTest, LoopCacheUsers) {
+  Type *Ty = Type::getInt32Ty(Context);
+  SmallVector<Type *, 2> Types;
+  Types.append(2, Ty);
+  FunctionType *FTy = FunctionType::get(Type::getVoidTy(Context), Types, false);
+  Function *F = cast<Function>(M.getOrInsertFunction("f", FTy));
+  BasicBlock *BB = BasicBlock::Create(Context, "entry", F);
+  Function::arg_iterator AI = F->arg_begin();
+  Value *A = &*AI++;
+  Value *B = &*AI++;
+  Instruction *Sum = BinaryOperator::CreateAdd(A, B, "sum", BB);
+  ReturnInst::Create(Context, 0, BB);
+
+  // Create a ScalarEvolution and "run" it so that it gets initialized.
+  PM.add(&SE);
+  PM.run(M);
+
+  Loop L;
+  const_cast<std::vector<BasicBlock*>&>(L.getBlocks()).push_back(BB);
+
+  // Repeated queries against the loop record each expression once.
+  const SCEV *SA = SE.getSCEV(A);
+  const SCEV *SSum = SE.getSCEV(Sum);
+  EXPECT_TRUE(SE.isLoopInvariant(SA, &L));
+  SE.isLoopInvariant(SSum, &L);
+  SE.getSCEVAtScope(SSum, &L);
+  SE.getSCEVAtScope(SSum, &L);
+  SE.isLoopInvariant(SSum, &L);
+  EXPECT_EQ(2u, SE.getNumLoopCacheUsers(&L));
+
+  // Forgetting a value drops its expression from the index...
+  SE.forgetValue(Sum);
+  EXPECT_EQ(1u, SE.getNumLoopCacheUsers(&L));
+
+  // ...and forgetting the loop drops the whole entry.
+  SE.forgetLoop(&L);
+  EXPECT_EQ(0u, SE.getNumLoopCacheUsers(&L));
+}
+
 TEST_F(ScalarEvolutionsTest, SCEVMultiplyAddRecs) {
   Type *Ty = Type::getInt32Ty(Context);
   SmallVector<Type *, 10> Types;
@@ -14,6 +14,7 @@
 #include "llvm/IR/Constants.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Metadata.h"
 #include "llvm/IR/Module.h"
 #include "llvm/PassManager.h"
 #include "llvm/Support/MemoryBuffer.h"
@@ -61,5 +62,156 @@ TEST(BitReaderTest, MaterializeFunctionsForBlockAddr) { // PR11677
   passes.run(*m);
 }
 
+static Module *makeManyFunctionsModule(unsigned NumFunctions) {
+  Module *Mod = new Module("test-index", getGlobalContext());
+  Type *Int32Ty = Type::getInt32Ty(Mod->getContext());
+  FunctionType *FuncTy = FunctionType::get(Int32Ty, false);
+  for (unsigned i = 0; i != NumFunctions; ++i) {
+    Function *Func = Function::Create(FuncTy, GlobalValue::ExternalLinkage,
+                                      "f" + Twine(i), Mod);
+    BasicBlock *Entry = BasicBlock::Create(Mod->getContext(), "entry", Func);
+    ReturnInst::Create(Mod->getContext(), ConstantInt::get(Int32Ty, i), Entry);
+  }
+  return Mod;
+}
+
+TEST(BitReaderTest, MaterializeOneFunctionThroughIndex) {
+  SmallString<1024> Mem;
+  {
+    OwningPtr<Module> Mod(makeManyFunctionsModule(20));
+    raw_svector_ostream OS(Mem);
+    WriteBitcodeToFile(Mod.get(), OS);
+  }
+
+  MemoryBuffer *Buffer = MemoryBuffer::getMemBuffer(Mem.str(), "test", false);
+  std::string ErrMsg;
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, getGlobalContext(),
+                                           &ErrMsg));
+  ASSERT_TRUE(M.get() != 0) << ErrMsg;
+
+  // Every body is found up front, but only the one asked for is read.
+  Function *F13 = M->getFunction("f13");
+  ASSERT_TRUE(F13 != 0);
+  for (Module::iterator I = M->begin(), E = M->end(); I != E; ++I)
+    EXPECT_TRUE(I->isMaterializable());
+
+  EXPECT_FALSE(F13->Materialize(&ErrMsg)) << ErrMsg;
+  EXPECT_FALSE(F13->isDeclaration());
+  ReturnInst *Ret = cast<ReturnInst>(F13->getEntryBlock().getTerminator());
+  EXPECT_EQ(13U, cast<ConstantInt>(Ret->getReturnValue())->getZExtValue());
+  EXPECT_TRUE(M->getFunction("f12")->isMaterializable());
+
+  EXPECT_FALSE(M->MaterializeAll(&ErrMsg)) << ErrMsg;
+  for (unsigned i = 0; i != 20; ++i) {
+    Function *F = M->getFunction(("f" + Twine(i)).str());
+    Ret = cast<ReturnInst>(F->getEntryBlock().getTerminator());
+    EXPECT_EQ(i, cast<ConstantInt>(Ret->getReturnValue())->getZExtValue());
+  }
+}
+
+TEST(BitReaderTest, MaterializeMetadataOnDemand) {
+  SmallString<1024> Mem;
+  {
+    OwningPtr<Module> Mod(makeManyFunctionsModule(3));
+    LLVMContext &Ctx = Mod->getContext();
+    for (unsigned i = 0; i != 3; ++i) {
+      Function *F = Mod->getFunction(("f" + Twine(i)).str());
+      Value *Ops[] = { MDString::get(Ctx, ("node" + Twine(i)).str()),
+                       MDNode::get(Ctx, MDString::get(Ctx, "inner")) };
+      F->getEntryBlock().getTerminator()->setMetadata("test",
+                                                      MDNode::get(Ctx, Ops));
+    }
+    Mod->getOrInsertNamedMetadata("named")->addOperand(
+      MDNode::get(Ctx, MDString::get(Ctx, "named-op")));
+    raw_svector_ostream OS(Mem);
+    WriteBitcodeToFile(Mod.get(), OS);
+  }
+
+  MemoryBuffer *Buffer = MemoryBuffer::getMemBuffer(Mem.str(), "test", false);
+  std::string ErrMsg;
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, getGlobalContext(),
+                                           &ErrMsg));
+  ASSERT_TRUE(M.get() != 0) << ErrMsg;
+
+  // Named metadata is available straight away.
+  NamedMDNode *Named = M->getNamedMetadata("named");
+  ASSERT_TRUE(Named != 0);
+  ASSERT_EQ(1U, Named->getNumOperands());
+  EXPECT_EQ("named-op",
+            cast<MDString>(Named->getOperand(0)->getOperand(0))->getString());
+
+  // The nodes a function refers to are read with it, operands and all.
+  Function *F1 = M->getFunction("f1");
+  EXPECT_FALSE(F1->Materialize(&ErrMsg)) << ErrMsg;
+  MDNode *N = F1->getEntryBlock().getTerminator()->getMetadata("test");
+  ASSERT_TRUE(N != 0);
+  EXPECT_EQ("node1", cast<MDString>(N->getOperand(0))->getString());
+  MDNode *Inner = cast<MDNode>(N->getOperand(1));
+  EXPECT_EQ("inner", cast<MDString>(Inner->getOperand(0))->getString());
+
+  // Nodes shared with functions read later are still uniqued.
+  EXPECT_FALSE(M->MaterializeAll(&ErrMsg)) << ErrMsg;
+  MDNode *N0 = M->getFunction("f0")->getEntryBlock().getTerminator()
+                 ->getMetadata("test");
+  ASSERT_TRUE(N0 != 0);
+  EXPECT_EQ("node0", cast<MDString>(N0->getOperand(0))->getString());
+  EXPECT_EQ(Inner, N0->getOperand(1));
+}
+
+static void writeNamedMetadataModule(SmallVectorImpl<char> &Mem) {
+  OwningPtr<Module> Mod(makeManyFunctionsModule(1));
+  LLVMContext &Ctx = Mod->getContext();
+  MDNode *Shared = MDNode::get(Ctx, MDString::get(Ctx, "shared"));
+  Mod->getFunction("f0")->getEntryBlock().getTerminator()->setMetadata(
+    "test", Shared);
+  NamedMDNode *Named = Mod->getOrInsertNamedMetadata("named");
+  Named->addOperand(Shared);
+  Named->addOperand(MDNode::get(Ctx, MDString::get(Ctx, "only-named")));
+  raw_svector_ostream OS(Mem);
+  WriteBitcodeToFile(Mod.get(), OS);
+}
+
+TEST(BitReaderTest, MaterializeNamedMetadataOnAccess) {
+  SmallString<1024> Mem;
+  writeNamedMetadataModule(Mem);
+
+  MemoryBuffer *Buffer = MemoryBuffer::getMemBuffer(Mem.str(), "test", false);
+  std::string ErrMsg;
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, getGlobalContext(),
+                                           &ErrMsg));
+  ASSERT_TRUE(M.get() != 0) << ErrMsg;
+
+  // Reading a function first does not disturb the named node, whose
+  // operands are only added when they are asked for.
+  Function *F0 = M->getFunction("f0");
+  EXPECT_FALSE(F0->Materialize(&ErrMsg)) << ErrMsg;
+  MDNode *Shared = F0->getEntryBlock().getTerminator()->getMetadata("test");
+  ASSERT_TRUE(Shared != 0);
+
+  NamedMDNode *Named = M->getNamedMetadata("named");
+  ASSERT_TRUE(Named != 0);
+  ASSERT_EQ(2U, Named->getNumOperands());
+  EXPECT_EQ(Shared, Named->getOperand(0));
+  EXPECT_EQ("only-named",
+            cast<MDString>(Named->getOperand(1)->getOperand(0))->getString());
+}
+
+TEST(BitReaderTest, MaterializeAllReadsNamedMetadata) {
+  SmallString<1024> Mem;
+  writeNamedMetadataModule(Mem);
+
+  MemoryBuffer *Buffer = MemoryBuffer::getMemBuffer(Mem.str(), "test", false);
+  std::string ErrMsg;
+  OwningPtr<Module> M(getLazyBitcodeModule(Buffer, getGlobalContext(),
+                                           &ErrMsg));
+  ASSERT_TRUE(M.get() != 0) << ErrMsg;
+
+  // The operands must be in place before the materializer goes away.
+  EXPECT_FALSE(M->MaterializeAllPermanently(&ErrMsg)) << ErrMsg;
+  NamedMDNode *Named = M->getNamedMetadata("named");
+  ASSERT_TRUE(Named != 0);
+  EXPECT_EQ(2U, Named->getNumOperands());
+}
+
 }
 }
@@ -196,6 +196,96 @@ namespace llvm {
       Passes.add(P);
       Passes.run(*M);
     }
+
+    // Build a function whose blocks all end in a switch on %x that defaults to
+    // %exit, so that edges can be added and removed as switch cases.
+    Function *makeSwitchFunction(Module &M, unsigned NumBlocks) {
+      LLVMContext &C = M.getContext();
+      IntegerType *I32 = Type::getInt32Ty(C);
+      FunctionType *FTy = FunctionType::get(Type::getVoidTy(C), I32, false);
+      Function *F = Function::Create(FTy, Function::ExternalLinkage, "f", &M);
+      Value *X = F->arg_begin();
+      std::vector<BasicBlock*> Blocks;
+      for (unsigned i = 0; i != NumBlocks; ++i)
+        Blocks.push_back(BasicBlock::Create(C, "", F));
+      BasicBlock *Exit = BasicBlock::Create(C, "exit", F);
+      ReturnInst::Create(C, Exit);
+      for (unsigned i = 0; i != NumBlocks; ++i) {
+        SwitchInst *SI = SwitchInst::Create(X, Exit, 2, Blocks[i]);
+        // A chain with a few forward and backward edges to start with.
+        if (i + 1 != NumBlocks)
+          SI->addCase(ConstantInt::get(I32, i + 1), Blocks[i + 1]);
+        if (i % 3 == 2)
+          SI->addCase(ConstantInt::get(I32, i / 2), Blocks[i / 2]);
+      }
+      return F;
+    }
+
+    // Flip the edge From->To, returning the update that describes it.
+    DominatorTreeBase<BasicBlock>::UpdateType
+    flipEdge(BasicBlock *From, BasicBlock *To, unsigned ToIndex) {
+      typedef DominatorTreeBase<BasicBlock> DomTree;
+      SwitchInst *SI = cast<SwitchInst>(From->getTerminator());
+      ConstantInt *Val = ConstantInt::get(Type::getInt32Ty(From->getContext()),
+                                          ToIndex);
+      SwitchInst::CaseIt It = SI->findCaseValue(Val);
+      if (It != SI->case_default()) {
+        SI->removeCase(It);
+        return DomTree::UpdateType(DomTree::Delete, From, To);
+      }
+      SI->addCase(Val, To);
+      return DomTree::UpdateType(DomTree::Insert, From, To);
+    }
+
+    TEST(DominatorTree, IncrementalUpdates) {
+      typedef DominatorTreeBase<BasicBlock> DomTree;
+      const unsigned NumBlocks = 16;
+      LLVMContext C;
+      Module M("updates", C);
+      Function *F = makeSwitchFunction(M, NumBlocks);
+      std::vector<BasicBlock*> Blocks;
+      for (Function::iterator I = F->begin(), E = F->end(); I != E; ++I)
+        Blocks.push_back(I);
+
+      DomTree DT(false), PDT(true);
+      DT.recalculate(*F);
+      PDT.recalculate(*F);
+
+      // A fixed pseudo-random sequence of single and batched edge flips.  The
+      // entry block never gets predecessors.
+      unsigned Seed = 12345;
+      for (unsigned Step = 0; Step != 200; ++Step) {
+        SmallVector<DomTree::UpdateType, 4> Updates;
+        unsigned BatchSize = Step % 4 == 3 ? 4 : 1;
+        for (unsigned i = 0; i != BatchSize; ++i) {
+          Seed = Seed * 1103515245 + 12345;
+          unsigned FromIdx = (Seed >> 8) % NumBlocks;
+          Seed = Seed * 1103515245 + 12345;
+          unsigned ToIdx = 1 + (Seed >> 8) % (NumBlocks - 1);
+          Updates.push_back(flipEdge(Blocks[FromIdx], Blocks[ToIdx], ToIdx));
+        }
+        DT.applyUpdates(Updates);
+        PDT.applyUpdates(Updates);
+
+        DomTree FreshDT(false), FreshPDT(true);
+        FreshDT.recalculate(*F);
+        FreshPDT.recalculate(*F);
+        EXPECT_FALSE(DT.compare(FreshDT)) << "dominators differ at " << Step;
+        EXPECT_FALSE(PDT.compare(FreshPDT))
+          << "post dominators differ at " << Step;
+      }
+
+      // A new block that becomes reachable through an inserted edge.
+      BasicBlock *NewBB = BasicBlock::Create(C, "new", F);
+      BranchInst::Create(Blocks[NumBlocks - 1], NewBB);
+      cast<SwitchInst>(Blocks[0]->getTerminator())->addCase(
+        ConstantInt::get(Type::getInt32Ty(C), 100), NewBB);
+      DT.insertEdge(Blocks[0], NewBB);
+      DomTree FreshDT(false);
+      FreshDT.recalculate(*F);
+      EXPECT_FALSE(DT.compare(FreshDT));
+      EXPECT_TRUE(DT.dominates(Blocks[0], NewBB));
+    }
   }
 }
 
@@ -12,6 +12,7 @@
 #include "llvm/IR/LLVMContext.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Value.h"
+#include "llvm/IR/ValueSymbolTable.h"
 #include "llvm/Support/SourceMgr.h"
 #include "gtest/gtest.h"
 using namespace llvm;
@@ -43,4 +44,37 @@ TEST(ValueTest, UsedInBasicBlock) {
   EXPECT_TRUE(F->arg_begin()->isUsedInBasicBlock(F->begin()));
 }
 
+TEST(ValueTest, DiscardValueNames) {
+  LLVMContext C;
+  C.setDiscardValueNames(true);
+
+  const char *ModuleString = "@g = global i32 0\n"
+                             "define i32 @f(i32 %x) {\n"
+                             "entry:\n"
+                             "  %y = load i32* @g\n"
+                             "  %z = add i32 %x, %y\n"
+                             "  ret i32 %z\n"
+                             "}\n";
+  SMDiagnostic Err;
+  Module *M = ParseAssemblyString(ModuleString, NULL, Err, C);
+  ASSERT_TRUE(M != NULL);
+
+  // Globals keep their names, locals lose theirs once parsing is done.
+  Function *F = M->getFunction("f");
+  ASSERT_TRUE(F != NULL);
+  EXPECT_TRUE(M->getNamedGlobal("g") != NULL);
+  EXPECT_FALSE(F->arg_begin()->hasName());
+  EXPECT_FALSE(F->begin()->hasName());
+  EXPECT_FALSE(F->begin()->begin()->hasName());
+  EXPECT_TRUE(F->getValueSymbolTable().empty());
+
+  // setName on a local is now a no-op.
+  F->arg_begin()->setName("x");
+  EXPECT_FALSE(F->arg_begin()->hasName());
+  F->setName("h");
+  EXPECT_EQ("h", F->getName());
+
+  delete M;
+}
+
 } // end anonymous namespace
@@ -17,6 +17,7 @@
 #include "llvm/Config/config.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "gtest/gtest.h"
+#include <string>
 
 using namespace llvm;
 
@@ -63,6 +64,44 @@ TEST(CompressionTest, Zlib) {
   TestZlibCompression(BinaryDataStr, zlib::DefaultCompression);
 }
 
+void TestZlibParallelCompression(StringRef Input, zlib::CompressionLevel Level,
+                                 size_t BlockSize) {
+  OwningPtr<MemoryBuffer> Compressed;
+  OwningPtr<MemoryBuffer> Uncompressed;
+  EXPECT_EQ(zlib::StatusOK,
+            zlib::compressInParallel(Input, Compressed, Level, BlockSize, 4));
+  EXPECT_EQ(zlib::StatusOK, zlib::uncompress(Compressed->getBuffer(),
+                                             Uncompressed, Input.size()));
+  EXPECT_EQ(Input.size(), Uncompressed->getBufferSize());
+  EXPECT_TRUE(Input == Uncompressed->getBuffer());
+}
+
+TEST(CompressionTest, ZlibParallel) {
+  // Text that repeats over distances longer than a block, so that blocks
+  // refer back into the previous one.
+  std::string Input;
+  for (unsigned i = 0; i != 20000; ++i)
+    Input += "line " + std::string(1, char('a' + i % 26)) + " of the input\n";
+
+  TestZlibParallelCompression(Input, zlib::DefaultCompression, 4096);
+  TestZlibParallelCompression(Input, zlib::BestSpeedCompression, 4096);
+  TestZlibParallelCompression(Input, zlib::BestSizeCompression, 50000);
+  TestZlibParallelCompression(Input, zlib::NoCompression, 4096);
+  // One block, and blocks that don't divide the input evenly.
+  TestZlibParallelCompression(Input, zlib::DefaultCompression, Input.size());
+  TestZlibParallelCompression(Input, zlib::DefaultCompression,
+                              Input.size() - 1);
+  TestZlibParallelCompression("hello, world!", zlib::DefaultCompression, 4);
+
+  // Priming each block with the one before keeps the output close in size.
+  OwningPtr<MemoryBuffer> Serial, Parallel;
+  ASSERT_EQ(zlib::StatusOK, zlib::compress(Input, Serial));
+  ASSERT_EQ(zlib::StatusOK,
+            zlib::compressInParallel(Input, Parallel,
+                                     zlib::DefaultCompression, 65536, 4));
+  EXPECT_LT(Parallel->getBufferSize(), Serial->getBufferSize() * 11 / 10);
+}
+
 #endif
 
 }
@@ -0,0 +1,145 @@
+//===- llvm/unittest/Support/ConcurrentAllocatorTest.cpp ------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ConcurrentAllocator.h"
+#include "llvm/Support/Threading.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+TEST(ConcurrentAllocatorTest, RecyclingSlabAllocatorReusesSlabs) {
+  RecyclingSlabAllocator Pool(4096);
+  MemSlab *Slab = Pool.Allocate(8192);
+  EXPECT_EQ(8192u, Slab->Size);
+  Pool.Deallocate(Slab);
+  EXPECT_EQ(8192u, Pool.getFreeBytes());
+
+  // A slab of the same size comes off the free list; other sizes do not.
+  MemSlab *Other = Pool.Allocate(4096);
+  EXPECT_NE(Slab, Other);
+  EXPECT_EQ(Slab, Pool.Allocate(8192));
+  EXPECT_EQ(0u, Pool.getFreeBytes());
+
+  // Sizes that are not a size class go straight back to malloc.
+  MemSlab *Odd = Pool.Allocate(5000);
+  Pool.Deallocate(Odd);
+  EXPECT_EQ(0u, Pool.getFreeBytes());
+
+  Pool.Deallocate(Slab);
+  Pool.Deallocate(Other);
+  EXPECT_EQ(12288u, Pool.getFreeBytes());
+  Pool.ReleaseFreeSlabs();
+  EXPECT_EQ(0u, Pool.getFreeBytes());
+}
+
+TEST(ConcurrentAllocatorTest, RecyclingSlabAllocatorLimit) {
+  RecyclingSlabAllocator Pool(4096, 8192);
+  MemSlab *Slabs[3];
+  for (unsigned i = 0; i != 3; ++i)
+    Slabs[i] = Pool.Allocate(4096);
+  for (unsigned i = 0; i != 3; ++i)
+    Pool.Deallocate(Slabs[i]);
+  EXPECT_EQ(8192u, Pool.getFreeBytes());
+}
+
+struct ArenaTask {
+  ThreadLocalArena *Arena;
+  std::vector<unsigned *> Results;
+};
+
+void FillFromArena(void *UserData, unsigned Index) {
+  ArenaTask &Task = *static_cast<ArenaTask *>(UserData);
+  // Allocate enough to need several slabs, and check that nothing overlaps.
+  unsigned *Last = 0;
+  for (unsigned i = 0; i != 1000; ++i) {
+    unsigned *P = Task.Arena->Allocate<unsigned>(4);
+    std::fill(P, P + 4, Index);
+    Last = P;
+  }
+  Task.Results[Index] = Last;
+}
+
+TEST(ConcurrentAllocatorTest, ThreadLocalArena) {
+  RecyclingSlabAllocator Pool(4096);
+  {
+    ThreadLocalArena Arena(Pool);
+    ArenaTask Task;
+    Task.Arena = &Arena;
+    Task.Results.resize(64);
+    llvm_execute_in_parallel(FillFromArena, &Task, Task.Results.size(), 8);
+    for (unsigned i = 0, e = Task.Results.size(); i != e; ++i)
+      for (unsigned j = 0; j != 4; ++j)
+        EXPECT_EQ(i, Task.Results[i][j]);
+    EXPECT_LE(64u * 1000 * 16, Arena.getTotalMemory());
+
+    // Resetting hands the slabs back to the pool for the next arena.
+    Arena.Reset();
+    EXPECT_NE(0u, Pool.getFreeBytes());
+  }
+  EXPECT_NE(0u, Pool.getFreeBytes());
+}
+
+struct Counted {
+  static volatile sys::cas_flag Live;
+  unsigned Value;
+  Counted() : Value(0) { sys::AtomicIncrement(&Live); }
+  ~Counted() { sys::AtomicDecrement(&Live); }
+  static unsigned getLive() { return Live; }
+};
+volatile sys::cas_flag Counted::Live = 0;
+
+struct SpecificTask {
+  ConcurrentSpecificBumpPtrAllocator<Counted> *Allocator;
+  std::vector<Counted *> Objects;
+};
+
+void FillFromSpecific(void *UserData, unsigned Index) {
+  SpecificTask &Task = *static_cast<SpecificTask *>(UserData);
+  // Mix in some arrays, and the occasional one larger than a slab.
+  unsigned Num = Index % 97 == 0 ? 300 : Index % 3 + 1;
+  Counted *C = Task.Allocator->Allocate(Num);
+  for (unsigned i = 0; i != Num; ++i) {
+    new (C + i) Counted();
+    C[i].Value = Index;
+  }
+  Task.Objects[Index] = C + Num - 1;
+}
+
+TEST(ConcurrentAllocatorTest, ConcurrentSpecificBumpPtrAllocator) {
+  RecyclingSlabAllocator Pool(1024);
+  ConcurrentSpecificBumpPtrAllocator<Counted> Allocator(1024, Pool);
+  SpecificTask Task;
+  Task.Allocator = &Allocator;
+  Task.Objects.resize(10000);
+  llvm_execute_in_parallel(FillFromSpecific, &Task, Task.Objects.size(), 8);
+
+  for (unsigned i = 0, e = Task.Objects.size(); i != e; ++i)
+    EXPECT_EQ(i, Task.Objects[i]->Value);
+
+  std::vector<Counted *> Sorted(Task.Objects);
+  std::sort(Sorted.begin(), Sorted.end());
+  EXPECT_TRUE(std::adjacent_find(Sorted.begin(), Sorted.end()) ==
+              Sorted.end());
+
+  EXPECT_NE(0u, Counted::getLive());
+  Allocator.DestroyAll();
+  EXPECT_EQ(0u, Counted::getLive());
+
+  // The allocator is usable again after DestroyAll.
+  new (Allocator.Allocate()) Counted();
+  EXPECT_EQ(1u, Counted::getLive());
+  Allocator.DestroyAll();
+  EXPECT_EQ(0u, Counted::getLive());
+}
+
+}
@@ -13,7 +13,16 @@
 
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/ADT/OwningPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/raw_ostream.h"
 #include "gtest/gtest.h"
+#include <fcntl.h>
+#if defined(_MSC_VER) || defined(__MINGW32__)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 using namespace llvm;
 
@@ -95,4 +104,60 @@ TEST_F(MemoryBufferTest, make_new) {
     EXPECT_EQ(0, Four->getBufferStart()[0]);
 }
 
+TEST_F(MemoryBufferTest, getFileWithMapHints) {
+  // Large enough to be memory mapped, and not a multiple of the page size so
+  // that the null terminator fits in the mapping.
+  SmallString<64> TestPath;
+  int FD;
+  ASSERT_FALSE(sys::fs::unique_file("MemoryBufferTest-%%%%%%.bin", FD,
+                                    TestPath));
+  const size_t Size = 64 * 1024 + 123;
+  {
+    raw_fd_ostream OS(FD, true);
+    for (size_t i = 0; i != Size; ++i)
+      OS << char('a' + i % 26);
+  }
+
+  const unsigned Hints[] = {
+    MemoryBuffer::MH_None,
+    MemoryBuffer::MH_Sequential | MemoryBuffer::MH_WillNeed,
+    MemoryBuffer::MH_Random | MemoryBuffer::MH_HugePages,
+    MemoryBuffer::MH_Populate
+  };
+  for (unsigned i = 0; i != sizeof(Hints) / sizeof(Hints[0]); ++i) {
+    OwningBuffer MB;
+    ASSERT_FALSE(MemoryBuffer::getFile(TestPath.c_str(), MB, -1, true,
+                                       Hints[i]));
+    ASSERT_EQ(Size, MB->getBufferSize());
+    EXPECT_EQ(MemoryBuffer::MemoryBuffer_MMap, MB->getBufferKind());
+    EXPECT_EQ('a', MB->getBufferStart()[0]);
+    EXPECT_EQ(char('a' + (Size - 1) % 26), MB->getBufferEnd()[-1]);
+    EXPECT_EQ(0, MB->getBufferEnd()[0]);
+
+    // Prefetching any range, including ones past the end, is harmless.
+    MB->prefetch(0, Size);
+    MB->prefetch(5000, 100);
+    MB->prefetch(Size - 1, 1000);
+    MB->prefetch(Size + 1, 10);
+  }
+
+  // Hints for a range of the file that is mapped at an unaligned offset.
+  OwningBuffer Part;
+  int ReadFD = ::open(TestPath.c_str(), O_RDONLY);
+  ASSERT_NE(-1, ReadFD);
+  ASSERT_FALSE(MemoryBuffer::getOpenFile(ReadFD, TestPath.c_str(), Part, Size,
+                                         32 * 1024, 1000, false,
+                                         MemoryBuffer::MH_WillNeed));
+  ::close(ReadFD);
+  EXPECT_EQ(char('a' + 1000 % 26), Part->getBufferStart()[0]);
+  Part->prefetch(100, 10000);
+
+  // Buffers that are not mapped accept prefetches too.
+  OwningBuffer Copy(MemoryBuffer::getMemBufferCopy(data));
+  Copy->prefetch(0, data.size());
+
+  bool Existed;
+  sys::fs::remove(TestPath.str(), Existed);
+}
+
 }
@@ -0,0 +1,94 @@
+//===- llvm/unittest/Support/ScaledNumberTest.cpp - ScaledNumber tests ----===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/ScaledNumber.h"
+#include "gtest/gtest.h"
+
+using namespace llvm;
+
+namespace {
+
+TEST(ScaledNumberTest, ToInt) {
+  EXPECT_EQ(0u, ScaledNumber().toInt());
+  EXPECT_EQ(7u, ScaledNumber(7).toInt());
+  EXPECT_EQ(28u, ScaledNumber(7, 2).toInt());
+  EXPECT_EQ(1u, ScaledNumber(7, -2).toInt());
+  EXPECT_EQ(0u, ScaledNumber(7, -64).toInt());
+  EXPECT_EQ(UINT64_MAX, ScaledNumber(7, 62).toInt());
+  EXPECT_EQ(UINT64_MAX, ScaledNumber::getLargest().toInt());
+}
+
+TEST(ScaledNumberTest, Compare) {
+  EXPECT_TRUE(ScaledNumber(1, 4) == ScaledNumber(16));
+  EXPECT_TRUE(ScaledNumber(3, -1) < ScaledNumber(2));
+  EXPECT_TRUE(ScaledNumber(3, -1) > ScaledNumber(1));
+  EXPECT_TRUE(ScaledNumber() < ScaledNumber(1, -1000));
+  EXPECT_TRUE(ScaledNumber(UINT64_MAX, -64) < ScaledNumber::getOne());
+  EXPECT_TRUE(ScaledNumber(UINT64_MAX) < ScaledNumber(1, 64));
+}
+
+TEST(ScaledNumberTest, Add) {
+  EXPECT_EQ(5u, (ScaledNumber(2) + ScaledNumber(3)).toInt());
+  EXPECT_EQ(UINT64_MAX, (ScaledNumber(UINT64_MAX) + ScaledNumber()).toInt());
+
+  // Carry out of the mantissa.
+  ScaledNumber Sum = ScaledNumber(UINT64_MAX) + ScaledNumber(1);
+  EXPECT_TRUE(Sum == ScaledNumber(1, 64));
+
+  // Addends far apart in magnitude.
+  EXPECT_TRUE(ScaledNumber(1, 100) + ScaledNumber(1) == ScaledNumber(1, 100));
+  EXPECT_TRUE(ScaledNumber::getLargest() + ScaledNumber::getLargest() ==
+              ScaledNumber::getLargest());
+}
+
+TEST(ScaledNumberTest, Subtract) {
+  EXPECT_EQ(1u, (ScaledNumber(3) - ScaledNumber(2)).toInt());
+  EXPECT_TRUE((ScaledNumber(2) - ScaledNumber(3)).isZero());
+  EXPECT_TRUE((ScaledNumber(2) - ScaledNumber(2)).isZero());
+  EXPECT_TRUE(ScaledNumber::getOne() - ScaledNumber::getFraction(1, 4) ==
+              ScaledNumber::getFraction(3, 4));
+}
+
+TEST(ScaledNumberTest, Multiply) {
+  EXPECT_EQ(42u, (ScaledNumber(6) * ScaledNumber(7)).toInt());
+  EXPECT_TRUE((ScaledNumber(6) * ScaledNumber()).isZero());
+
+  // The product needs more than 64 bits.
+  ScaledNumber Big = ScaledNumber(UINT64_C(1) << 40);
+  EXPECT_TRUE(Big * Big == ScaledNumber(1, 80));
+  EXPECT_TRUE(ScaledNumber(UINT64_MAX) * ScaledNumber(UINT64_MAX) <
+              ScaledNumber(1, 128));
+  EXPECT_TRUE(ScaledNumber(UINT64_MAX) * ScaledNumber(UINT64_MAX) >
+              ScaledNumber(1, 127));
+
+  // Saturation and underflow.
+  EXPECT_TRUE(ScaledNumber::getLargest() * ScaledNumber(2) ==
+              ScaledNumber::getLargest());
+  EXPECT_TRUE((ScaledNumber(1, -16000) * ScaledNumber(1, -16000)).isZero());
+}
+
+TEST(ScaledNumberTest, Divide) {
+  EXPECT_EQ(6u, (ScaledNumber(42) / ScaledNumber(7)).toInt());
+  EXPECT_TRUE(ScaledNumber(1) / ScaledNumber(4) == ScaledNumber(1, -2));
+  EXPECT_TRUE(ScaledNumber(1) / ScaledNumber() == ScaledNumber::getLargest());
+  EXPECT_TRUE((ScaledNumber() / ScaledNumber(3)).isZero());
+
+  // Rounding errors stay in the last bit.
+  ScaledNumber Third = ScaledNumber::getFraction(1, 3);
+  ScaledNumber One = Third + Third + Third;
+  EXPECT_TRUE(One > ScaledNumber(UINT64_MAX - 4, -64));
+  EXPECT_TRUE(One < ScaledNumber(1) + ScaledNumber(4, -64));
+
+  // A loop taken with probability 31/32 runs 32 times.
+  ScaledNumber Exit =
+    ScaledNumber::getOne() - ScaledNumber::getFraction(31, 32);
+  EXPECT_EQ(32u, (ScaledNumber::getOne() / Exit).toInt());
+}
+
+}
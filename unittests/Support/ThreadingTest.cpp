@@ -0,0 +1,44 @@
+//===- unittest/Support/ThreadingTest.cpp ---------------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Threading.h"
+#include "gtest/gtest.h"
+#include <vector>
+
+using namespace llvm;
+
+namespace {
+
+void RecordTask(void *UserData, unsigned Index) {
+  ++(*static_cast<std::vector<unsigned>*>(UserData))[Index];
+}
+
+TEST(ThreadingTest, ExecuteInParallelRunsEachTaskOnce) {
+  std::vector<unsigned> Counts(1000);
+  llvm_execute_in_parallel(RecordTask, &Counts, Counts.size(), 4);
+  for (unsigned i = 0, e = Counts.size(); i != e; ++i)
+    EXPECT_EQ(1U, Counts[i]) << "task " << i;
+}
+
+TEST(ThreadingTest, ExecuteInParallelMoreThreadsThanTasks) {
+  std::vector<unsigned> Counts(3);
+  llvm_execute_in_parallel(RecordTask, &Counts, Counts.size(), 16);
+  EXPECT_EQ(1U, Counts[0]);
+  EXPECT_EQ(1U, Counts[1]);
+  EXPECT_EQ(1U, Counts[2]);
+
+  // No tasks is fine too.
+  llvm_execute_in_parallel(RecordTask, 0, 0, 4);
+}
+
+TEST(ThreadingTest, HardwareConcurrency) {
+  EXPECT_LE(1U, llvm_get_hardware_concurrency());
+}
+
+} // end anonymous namespace
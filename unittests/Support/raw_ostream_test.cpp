@@ -8,8 +8,12 @@
 //===----------------------------------------------------------------------===//
 
 #include "gtest/gtest.h"
+#include "llvm/ADT/OwningPtr.h"
 #include "llvm/ADT/SmallString.h"
+#include "llvm/Config/config.h"
+#include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
 
 using namespace llvm;
@@ -143,4 +147,121 @@ TEST(raw_ostreamTest, WriteEscaped) {
   EXPECT_EQ("\\001\\010\\200", Str);
 }
 
+TEST(raw_ostreamTest, ReserveExtraSpaceSVector) {
+  SmallString<16> Str;
+  raw_svector_ostream OS(Str);
+  OS << "abc";
+  OS.reserveExtraSpace(4096);
+  EXPECT_LE(4099u, Str.capacity());
+  for (unsigned i = 0; i != 4096; ++i)
+    OS << 'x';
+  EXPECT_EQ(4099u, OS.str().size());
+  EXPECT_EQ("abcxx", OS.str().substr(0, 5));
+}
+
+/// writeWithReservation - Write Before bytes to a new file, reserve Reserve
+/// bytes, then write After more bytes, partly one at a time and partly in
+/// large blocks.  Check that the file holds exactly what was written.  Map
+/// says whether the file is opened with F_Map.
+void writeWithReservation(size_t Before, uint64_t Reserve, size_t After,
+                          bool Unbuffered, bool Map = true) {
+  SmallString<64> Path;
+  int FD;
+  ASSERT_FALSE(sys::fs::unique_file("raw_ostream_test-%%%%%%.bin", FD, Path));
+  { raw_fd_ostream Close(FD, true); }
+
+  std::string Expected;
+  for (size_t i = 0; i != Before + After; ++i)
+    Expected += char('a' + i % 26);
+
+  {
+    std::string Error;
+    raw_fd_ostream OS(Path.c_str(), Error, raw_fd_ostream::F_Binary |
+                                           (Map ? raw_fd_ostream::F_Map : 0));
+    ASSERT_EQ("", Error);
+    if (Unbuffered)
+      OS.SetUnbuffered();
+    OS << StringRef(Expected).substr(0, Before);
+    OS.reserveExtraSpace(Reserve);
+    EXPECT_EQ(Before, OS.tell());
+#ifdef HAVE_POSIX_FALLOCATE
+    // The file is grown up front to map the space for the output, and only
+    // if mapping was asked for.
+    uint64_t FileSize;
+    ASSERT_FALSE(sys::fs::file_size(Path.str(), FileSize));
+    if (Map && Reserve >= raw_fd_ostream::MinMappedSize)
+      EXPECT_EQ(Before + Reserve, FileSize);
+    else
+      EXPECT_LE(FileSize, Before);
+#endif
+    for (size_t i = Before; i < Before + After; ) {
+      if (i % 3 == 0) {
+        size_t Len = std::min<size_t>(Before + After - i, 100000);
+        OS << StringRef(Expected).substr(i, Len);
+        i += Len;
+      } else {
+        OS << Expected[i++];
+      }
+    }
+    EXPECT_EQ(Before + After, OS.tell());
+  }
+
+  OwningPtr<MemoryBuffer> Buf;
+  ASSERT_FALSE(MemoryBuffer::getFile(Path.c_str(), Buf));
+  EXPECT_EQ(Before + After, Buf->getBufferSize());
+  EXPECT_TRUE(Buf->getBuffer() == Expected);
+  Buf.reset();
+
+  bool Existed;
+  sys::fs::remove(Path.str(), Existed);
+}
+
+TEST(raw_ostreamTest, ReserveExtraSpaceFile) {
+  const uint64_t Min = raw_fd_ostream::MinMappedSize;
+  // Too small to be mapped.
+  writeWithReservation(10, 1000, 1000, false);
+  // Less written than was reserved, after an unaligned start.
+  writeWithReservation(5000, 2 * Min, Min + 100, false);
+  // Exactly what was reserved.
+  writeWithReservation(0, Min, Min, false);
+  // More than was reserved.
+  writeWithReservation(123, Min, Min + 5000, false);
+  // The stream underneath a formatted_raw_ostream is unbuffered.
+  writeWithReservation(123, Min + 10, Min + 10, true);
+  // Not opened for mapping.
+  writeWithReservation(123, Min, Min + 5000, false, false);
+}
+
+TEST(raw_ostreamTest, ReserveExtraSpaceSeek) {
+  SmallString<64> Path;
+  int FD;
+  ASSERT_FALSE(sys::fs::unique_file("raw_ostream_test-%%%%%%.bin", FD, Path));
+  { raw_fd_ostream Close(FD, true); }
+
+  const uint64_t Size = raw_fd_ostream::MinMappedSize;
+  {
+    std::string Error;
+    raw_fd_ostream OS(Path.c_str(), Error,
+                      raw_fd_ostream::F_Binary | raw_fd_ostream::F_Map);
+    ASSERT_EQ("", Error);
+    OS.reserveExtraSpace(2 * Size);
+    for (uint64_t i = 0; i != Size; ++i)
+      OS << 'x';
+    // Seeking ends the mapping and leaves the file as long as the output.
+    OS.seek(1);
+    OS << "yz";
+    EXPECT_EQ(3u, OS.tell());
+  }
+
+  OwningPtr<MemoryBuffer> Buf;
+  ASSERT_FALSE(MemoryBuffer::getFile(Path.c_str(), Buf));
+  ASSERT_EQ(Size, Buf->getBufferSize());
+  EXPECT_EQ("xyzx", Buf->getBuffer().substr(0, 4));
+  EXPECT_EQ('x', Buf->getBuffer().back());
+  Buf.reset();
+
+  bool Existed;
+  sys::fs::remove(Path.str(), Existed);
+}
+
 }
@@ -0,0 +1,188 @@
+//===- AllocBench - Benchmark allocators under several threads ------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program allocates small objects from 1 to 32 threads at once with
+// malloc, a BumpPtrAllocator shared under a mutex, a ThreadLocalArena and a
+// ConcurrentSpecificBumpPtrAllocator, and outputs the wall time each takes to
+// allocate and then release them.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Support/Allocator.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/ConcurrentAllocator.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/Mutex.h"
+#include "llvm/Support/MutexGuard.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <cstdlib>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+NumAllocs("num-allocs",
+          cl::desc("Number of objects each thread allocates"),
+          cl::init(1000000));
+
+static cl::opt<unsigned>
+MaxThreads("max-threads", cl::desc("Largest number of threads to run"),
+           cl::init(32));
+
+static cl::opt<bool>
+Verify("verify",
+       cl::desc("Run a quick verification useful for regression testing"),
+       cl::init(false));
+
+namespace {
+/// Object - About the size of an IR instruction.
+struct Object {
+  Object *Next;
+  char Data[40];
+};
+
+/// Run - The state shared by the threads of one benchmark run.
+struct Run {
+  unsigned NumThreads;
+  /// Lists - Every thread links its objects into its own list, so that they
+  /// are all touched and can be checked and freed afterwards.
+  std::vector<Object *> Lists;
+
+  sys::Mutex Lock;
+  BumpPtrAllocator *SharedBump;
+  ThreadLocalArena *Arena;
+  ConcurrentSpecificBumpPtrAllocator<Object> *Specific;
+};
+}
+
+static void initObject(Object *O, Object *&List) {
+  O->Next = List;
+  O->Data[0] = 0;
+  List = O;
+}
+
+static void allocateWithMalloc(void *UserData, unsigned Index) {
+  Run &R = *static_cast<Run *>(UserData);
+  for (unsigned i = 0; i != NumAllocs; ++i)
+    initObject(static_cast<Object *>(malloc(sizeof(Object))), R.Lists[Index]);
+}
+
+static void freeWithMalloc(void *UserData, unsigned Index) {
+  Run &R = *static_cast<Run *>(UserData);
+  for (Object *O = R.Lists[Index], *Next; O; O = Next) {
+    Next = O->Next;
+    free(O);
+  }
+}
+
+static void allocateWithSharedBump(void *UserData, unsigned Index) {
+  Run &R = *static_cast<Run *>(UserData);
+  for (unsigned i = 0; i != NumAllocs; ++i) {
+    Object *O;
+    {
+      MutexGuard Guard(R.Lock);
+      O = R.SharedBump->Allocate<Object>();
+    }
+    initObject(O, R.Lists[Index]);
+  }
+}
+
+static void allocateWithArena(void *UserData, unsigned Index) {
+  Run &R = *static_cast<Run *>(UserData);
+  for (unsigned i = 0; i != NumAllocs; ++i)
+    initObject(R.Arena->Allocate<Object>(), R.Lists[Index]);
+}
+
+static void allocateWithSpecific(void *UserData, unsigned Index) {
+  Run &R = *static_cast<Run *>(UserData);
+  for (unsigned i = 0; i != NumAllocs; ++i)
+    initObject(R.Specific->Allocate(), R.Lists[Index]);
+}
+
+/// countObjects - Return the number of objects on every list.
+static size_t countObjects(const Run &R) {
+  size_t Count = 0;
+  for (unsigned i = 0; i != R.NumThreads; ++i)
+    for (Object *O = R.Lists[i]; O; O = O->Next)
+      ++Count;
+  return Count;
+}
+
+namespace {
+enum AllocatorKind { Malloc, SharedBump, Arena, Specific };
+}
+
+static const char *const AllocatorNames[] = {
+  "malloc", "BumpPtrAllocator+mutex", "ThreadLocalArena",
+  "ConcurrentSpecificBumpPtrAllocator"
+};
+
+/// benchmark - Allocate NumAllocs objects on each of NumThreads threads with
+/// the given allocator and release them again.  Return the wall time taken.
+static double benchmark(AllocatorKind Kind, unsigned NumThreads) {
+  Run R;
+  R.NumThreads = NumThreads;
+  R.Lists.assign(NumThreads, 0);
+
+  BumpPtrAllocator Bump;
+  ThreadLocalArena LocalArena;
+  ConcurrentSpecificBumpPtrAllocator<Object> SpecificAlloc;
+  R.SharedBump = &Bump;
+  R.Arena = &LocalArena;
+  R.Specific = &SpecificAlloc;
+
+  void (*Fn)(void *, unsigned) = 0;
+  switch (Kind) {
+  case Malloc:     Fn = allocateWithMalloc; break;
+  case SharedBump: Fn = allocateWithSharedBump; break;
+  case Arena:      Fn = allocateWithArena; break;
+  case Specific:   Fn = allocateWithSpecific; break;
+  }
+
+  TimeRecord Start = TimeRecord::getCurrentTime(true);
+  llvm_execute_in_parallel(Fn, &R, NumThreads, NumThreads);
+  if (Verify && countObjects(R) != size_t(NumAllocs) * NumThreads)
+    errs() << AllocatorNames[Kind] << ": lost objects with " << NumThreads
+           << " threads\n";
+  switch (Kind) {
+  case Malloc:     llvm_execute_in_parallel(freeWithMalloc, &R, NumThreads,
+                                            NumThreads); break;
+  case SharedBump: Bump.Reset(); break;
+  case Arena:      LocalArena.Reset(); break;
+  case Specific:   SpecificAlloc.DestroyAll(); break;
+  }
+  TimeRecord End = TimeRecord::getCurrentTime(false);
+  return End.getWallTime() - Start.getWallTime();
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "allocator benchmark\n");
+  if (Verify) {
+    NumAllocs = 10000;
+    MaxThreads = 4;
+  }
+
+  outs() << "Allocating " << NumAllocs << " objects of " << sizeof(Object)
+         << " bytes per thread; " << llvm_get_hardware_concurrency()
+         << " hardware threads.\n\n";
+  outs() << format("%-36s", (const char *)"allocator");
+  for (unsigned NumThreads = 1; NumThreads <= MaxThreads; NumThreads *= 2)
+    outs() << format("%10u", NumThreads);
+  outs() << '\n';
+
+  for (unsigned K = Malloc; K <= Specific; ++K) {
+    outs() << format("%-36s", AllocatorNames[K]);
+    for (unsigned NumThreads = 1; NumThreads <= MaxThreads; NumThreads *= 2)
+      outs() << format("%10.4f", benchmark(AllocatorKind(K), NumThreads));
+    outs() << '\n';
+  }
+  return 0;
+}
@@ -0,0 +1,156 @@
+//===- HashMapBench - Benchmark DenseMap against SwissMap -----------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This program times insertion, successful and unsuccessful lookup, and
+// erasure on DenseMap and SwissMap with integer and pointer keys, and
+// outputs the run times.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SwissMap.h"
+#include "llvm/ADT/Twine.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/DataTypes.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/raw_ostream.h"
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<unsigned>
+NumKeys("num-keys", cl::desc("Number of keys to insert into each map"),
+        cl::init(1000000));
+
+static cl::opt<unsigned>
+Repeat("repeat", cl::desc("Number of times to run each benchmark"),
+       cl::init(5));
+
+static cl::opt<bool>
+Verify("verify",
+       cl::desc("Run a quick verification useful for regression testing"),
+       cl::init(false));
+
+/// Random - A small deterministic generator, so that every run and both maps
+/// see the same keys in the same order.
+class Random {
+  uint64_t State;
+public:
+  explicit Random(uint64_t Seed) : State(Seed) {}
+  uint32_t next() {
+    State = State * 6364136223846793005ULL + 1442695040888963407ULL;
+    return uint32_t(State >> 32);
+  }
+};
+
+template<typename T>
+static void shuffle(std::vector<T> &V, Random &R) {
+  for (size_t i = V.size(); i > 1; --i)
+    std::swap(V[i - 1], V[R.next() % i]);
+}
+
+namespace {
+struct Object {
+  char Data[48];
+};
+}
+
+static uint64_t Checksum = 0;
+
+template<typename MapT, typename KeyT>
+static void benchmark(TimerGroup &Group, const Twine &Name,
+                      const std::vector<KeyT> &Keys,
+                      const std::vector<KeyT> &Lookups,
+                      const std::vector<KeyT> &Missing) {
+  Timer Insert((Name + ": insert").str(), Group);
+  Timer LookupHit((Name + ": lookup-hit").str(), Group);
+  Timer LookupMiss((Name + ": lookup-miss").str(), Group);
+  Timer Erase((Name + ": erase").str(), Group);
+
+  uint64_t Sum = 0;
+  for (unsigned Iter = 0; Iter != Repeat; ++Iter) {
+    MapT Map;
+
+    Insert.startTimer();
+    for (size_t i = 0, e = Keys.size(); i != e; ++i)
+      Map.insert(std::make_pair(Keys[i], unsigned(i)));
+    Insert.stopTimer();
+
+    LookupHit.startTimer();
+    for (size_t i = 0, e = Lookups.size(); i != e; ++i)
+      Sum += Map.find(Lookups[i])->second;
+    LookupHit.stopTimer();
+
+    LookupMiss.startTimer();
+    for (size_t i = 0, e = Missing.size(); i != e; ++i)
+      Sum += Map.count(Missing[i]);
+    LookupMiss.stopTimer();
+
+    Erase.startTimer();
+    for (size_t i = 0, e = Lookups.size(); i != e; ++i)
+      Sum += Map.erase(Lookups[i]);
+    Erase.stopTimer();
+
+    if (!Map.empty())
+      errs() << Name << ": map not empty after erasing every key\n";
+  }
+  Checksum += Sum;
+}
+
+int main(int argc, char **argv) {
+  cl::ParseCommandLineOptions(argc, argv, "hash map benchmark\n");
+  if (Verify) {
+    NumKeys = 10000;
+    Repeat = 1;
+  }
+
+  Random R(42);
+
+  // Integer keys: a random permutation of a sparse range, avoiding the
+  // DenseMap empty and tombstone keys.  Keys that are not in the map come
+  // from the same distribution.
+  std::vector<unsigned> IntKeys, IntMissing;
+  for (unsigned i = 0; i != NumKeys * 2; ++i) {
+    unsigned K = (i + 1) * 2654435761U;
+    if (K >= ~0U - 1)
+      continue;
+    (IntKeys.size() < NumKeys ? IntKeys : IntMissing).push_back(K);
+  }
+  shuffle(IntKeys, R);
+  shuffle(IntMissing, R);
+  std::vector<unsigned> IntLookups(IntKeys);
+  shuffle(IntLookups, R);
+
+  // Pointer keys: addresses of consecutively allocated objects about the size
+  // of an IR instruction, as in most maps keyed by IR.
+  std::vector<Object> Objects(NumKeys * 2);
+  std::vector<Object *> PtrKeys, PtrMissing;
+  for (unsigned i = 0; i != NumKeys * 2; ++i)
+    (i < NumKeys ? PtrKeys : PtrMissing).push_back(&Objects[i]);
+  shuffle(PtrKeys, R);
+  shuffle(PtrMissing, R);
+  std::vector<Object *> PtrLookups(PtrKeys);
+  shuffle(PtrLookups, R);
+
+  {
+    TimerGroup Group("Hash map benchmark");
+    benchmark<DenseMap<unsigned, unsigned> >(Group, "DenseMap<unsigned>",
+                                             IntKeys, IntLookups, IntMissing);
+    benchmark<SwissMap<unsigned, unsigned> >(Group, "SwissMap<unsigned>",
+                                             IntKeys, IntLookups, IntMissing);
+    benchmark<DenseMap<Object *, unsigned> >(Group, "DenseMap<pointer>",
+                                             PtrKeys, PtrLookups, PtrMissing);
+    benchmark<SwissMap<Object *, unsigned> >(Group, "SwissMap<pointer>",
+                                             PtrKeys, PtrLookups, PtrMissing);
+  }
+
+  // Keep the lookups from being optimized away.
+  volatile uint64_t DontOptimizeOut = Checksum; (void)DontOptimizeOut;
+  return 0;
+}